@@ -30,6 +30,10 @@ public:
     void SetUp(void);
     void TearDown(void);
 
+    // CAMERA_V4L2_TEST_DEVICE and CAMERA_V4L2_TEST_BUFFERS override them, vivid stands in for the isp on a host
+    static std::string TestDevice();
+    static uint32_t TestBufferCount();
+
     static std::shared_ptr<HosV4L2UVC> V4L2UVC_;
     static std::shared_ptr<HosV4L2Dev> V4L2Dev_;
 
@@ -14,6 +14,8 @@
  */
 
 #include <gtest/gtest.h>
+#include <cstdlib>
+#include <vector>
 #include <v4l2_dev.h>
 #include <v4l2_uvc.h>
 
@@ -21,6 +23,26 @@
 
 using namespace testing::ext;
 namespace OHOS::Camera {
+namespace {
+constexpr const char* DEFAULT_DEVICE = "rkisp_v5";
+constexpr uint32_t DEFAULT_BUFFER_COUNT = 4;
+constexpr uint32_t MAX_BUFFER_COUNT = 32;   // 32: VIDEO_MAX_FRAME
+} // namespace
+
+std::string UtestV4L2Dev::TestDevice()
+{
+    const char* device = getenv("CAMERA_V4L2_TEST_DEVICE");
+    return device != nullptr && device[0] != '\0' ? device : DEFAULT_DEVICE;
+}
+
+// camera_v4l2_bench measures which count a stream needs
+uint32_t UtestV4L2Dev::TestBufferCount()
+{
+    const char* count = getenv("CAMERA_V4L2_TEST_BUFFERS");
+    uint32_t value = count != nullptr ? static_cast<uint32_t>(strtoul(count, nullptr, 0)) : 0;
+    return value != 0 && value <= MAX_BUFFER_COUNT ? value : DEFAULT_BUFFER_COUNT;
+}
+
 void V4L2UvcCallback(const std::string cameraId, const std::vector<DeviceControl>& control,
     const std::vector<DeviceFormat>& fromat, const bool inOut)
 {
@@ -67,7 +89,7 @@ HWTEST_F(UtestV4L2Dev, InitCamera, TestSize.Level0)
 {
     int rc = 0;
 
-    cameraIDs_.push_back("rkisp_v5");
+    cameraIDs_.push_back(TestDevice());
     rc = HosV4L2Dev::Init(cameraIDs_);
 
     EXPECT_EQ(true, rc != RC_ERROR);
@@ -79,7 +101,7 @@ HWTEST_F(UtestV4L2Dev, SetFormat, TestSize.Level0)
     constexpr uint32_t height = 480;
 
     int rc = 0;
-    std::string devname = "rkisp_v5";
+    std::string devname = TestDevice();
     DeviceFormat format = {};
 
     rc = V4L2Dev_->start(devname);
@@ -101,11 +123,11 @@ HWTEST_F(UtestV4L2Dev, SetFormat, TestSize.Level0)
 
 HWTEST_F(UtestV4L2Dev, SetBuffer, TestSize.Level0)
 {
-    constexpr uint32_t bufferCount = 4;
+    const uint32_t bufferCount = TestBufferCount();
 
-    unsigned char* addr[bufferCount];
-    std::shared_ptr<FrameSpec> buffptr[bufferCount];
-    std::string devname = "rkisp_v5";
+    std::vector<unsigned char*> addr(bufferCount, nullptr);
+    std::vector<std::shared_ptr<FrameSpec>> buffptr(bufferCount);
+    std::string devname = TestDevice();
     DeviceFormat format = {};
     unsigned int bufSize;
     int i;
@@ -127,7 +149,7 @@ HWTEST_F(UtestV4L2Dev, SetBuffer, TestSize.Level0)
         buffptr[i]->buffer_->SetUsage(1);
         buffptr[i]->bufferPoolId_ = 0;
         addr[i] = (unsigned char*)malloc(bufSize);
-        if (addr == nullptr) {
+        if (addr[i] == nullptr) {
             std::cout << " malloc buffers fail \n" << std::endl;
             break;
         }
@@ -160,7 +182,7 @@ HWTEST_F(UtestV4L2Dev, StreamStart, TestSize.Level0)
 {
     int rc = 0;
     int value;
-    std::string devname = "rkisp_v5";
+    std::string devname = TestDevice();
 
     constexpr uint32_t awbValue = 8;
 
@@ -179,7 +201,7 @@ HWTEST_F(UtestV4L2Dev, StreamStart, TestSize.Level0)
 
 HWTEST_F(UtestV4L2Dev, ReleaseAll, TestSize.Level0)
 {
-    std::string devname = "rkisp_v5";
+    std::string devname = TestDevice();
 
     V4L2Dev_->StopStream(devname);
     V4L2Dev_->ReleaseBuffers(devname);
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "v4l2_bench.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t STREAM_FRAMES = 30;
+constexpr uint32_t STREAM_WARMUP = 5;
+
+// the kernel's vivid driver unless CAMERA_V4L2_TEST_DEVICE names another node, skipped without one
+bool OpenTestDevice(V4l2StreamSession& session, V4l2BenchConfig& config)
+{
+    const char* device = getenv("CAMERA_V4L2_TEST_DEVICE");
+    if (device != nullptr && device[0] != '\0') {
+        config.device = device;
+    }
+    config.frames = STREAM_FRAMES;
+    config.warmup = STREAM_WARMUP;
+    std::string error;
+    if (!session.Open(config, error)) {
+        std::cout << error << std::endl;
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+HWTEST(UtestV4L2Stream, ParsesBufferCounts, TestSize.Level0)
+{
+    std::vector<uint32_t> counts;
+    ASSERT_TRUE(ParseBufferCounts("2-16", counts));
+    ASSERT_EQ(15u, counts.size());
+    EXPECT_EQ(2u, counts.front());
+    EXPECT_EQ(16u, counts.back());
+
+    ASSERT_TRUE(ParseBufferCounts("2,4,8", counts));
+    EXPECT_EQ((std::vector<uint32_t> {2, 4, 8}), counts);
+
+    EXPECT_FALSE(ParseBufferCounts("0", counts));
+    EXPECT_FALSE(ParseBufferCounts("8-4", counts));
+    EXPECT_FALSE(ParseBufferCounts("2,33", counts));
+    EXPECT_FALSE(ParseBufferCounts("2,,4", counts));
+    EXPECT_FALSE(ParseBufferCounts("", counts));
+}
+
+HWTEST(UtestV4L2Stream, ParsesFourccAndMemory, TestSize.Level0)
+{
+    uint32_t fourcc = 0;
+    ASSERT_TRUE(ParseFourcc("YUYV", fourcc));
+    EXPECT_EQ(static_cast<uint32_t>(V4L2_PIX_FMT_YUYV), fourcc);
+    ASSERT_TRUE(ParseFourcc("nv12", fourcc));
+    EXPECT_EQ(static_cast<uint32_t>(V4L2_PIX_FMT_NV12), fourcc);
+    EXPECT_EQ("NV12", FourccName(fourcc));
+    ASSERT_TRUE(ParseFourcc("Y16", fourcc));
+    EXPECT_EQ(static_cast<uint32_t>(V4L2_PIX_FMT_Y16), fourcc);
+    EXPECT_FALSE(ParseFourcc("NV12M", fourcc));
+
+    V4l2BenchMemory memory = V4l2BenchMemory::MMAP;
+    ASSERT_TRUE(ParseV4l2Memory("dmabuf", memory));
+    EXPECT_EQ(V4l2BenchMemory::DMABUF, memory);
+    EXPECT_STREQ("userptr", V4l2MemoryName(V4l2BenchMemory::USERPTR));
+    EXPECT_FALSE(ParseV4l2Memory("overlay", memory));
+}
+
+HWTEST(UtestV4L2Stream, CountsSequenceGaps, TestSize.Level0)
+{
+    EXPECT_EQ(0u, SequenceGap(5, 6));
+    EXPECT_EQ(3u, SequenceGap(5, 9));
+    EXPECT_EQ(0u, SequenceGap(UINT32_MAX, 0));
+    EXPECT_EQ(3u, SequenceGap(UINT32_MAX - 1, 2));
+
+    V4l2RunResult run;
+    EXPECT_DOUBLE_EQ(0.0, run.DropPercent());
+    run.frames = 90;
+    run.drops = 10;
+    EXPECT_DOUBLE_EQ(10.0, run.DropPercent());
+}
+
+// every memory mode at the shallowest, the adapter's and the deepest queue
+HWTEST(UtestV4L2Stream, StreamsEveryMemoryMode, TestSize.Level0)
+{
+    V4l2StreamSession session;
+    V4l2BenchConfig config;
+    if (!OpenTestDevice(session, config)) {
+        GTEST_SKIP() << "no " << config.device << " capture node";
+    }
+    const std::vector<uint32_t> counts = {2, 4, 16};
+    for (V4l2BenchMemory memory : config.memories) {
+        for (uint32_t count : counts) {
+            V4l2RunResult run;
+            EXPECT_TRUE(session.Run(memory, count, run)) << V4l2MemoryName(memory) << " x" << count << ": " <<
+                run.error;
+            if (run.skipped) {
+                std::cout << V4l2MemoryName(memory) << " skipped: " << run.error << std::endl;
+                break;
+            }
+            EXPECT_GE(run.granted, count);
+            EXPECT_EQ(STREAM_FRAMES, run.frames);
+            EXPECT_GT(run.fps, 0.0);
+            EXPECT_EQ(0u, run.errorFrames);
+            EXPECT_EQ(STREAM_FRAMES, run.dequeue.count);
+            if (session.Driver() == "vivid") {
+                // vivid stamps with CLOCK_MONOTONIC when it completes the frame
+                EXPECT_EQ(STREAM_FRAMES, run.captureToCallback.count);
+            }
+        }
+    }
+}
+
+// a consumer that stalls for several frame times loses frames on two buffers and fewer on eight
+HWTEST(UtestV4L2Stream, DeeperQueueRidesOutStalls, TestSize.Level0)
+{
+    constexpr uint32_t shallow = 2;
+    constexpr uint32_t deep = 8;
+    constexpr uint32_t stallEvery = 10;
+    constexpr uint32_t framePeriods = 4;
+    constexpr uint32_t usPerS = 1000000;
+
+    V4l2StreamSession session;
+    V4l2BenchConfig config;
+    config.fps = 30;    // 30: a stall of a few frame times is then long enough to measure
+    config.stallEvery = stallEvery;
+    config.stallUs = framePeriods * usPerS / config.fps;
+    if (!OpenTestDevice(session, config)) {
+        GTEST_SKIP() << "no " << config.device << " capture node";
+    }
+    V4l2RunResult shallowRun;
+    V4l2RunResult deepRun;
+    ASSERT_TRUE(session.Run(V4l2BenchMemory::MMAP, shallow, shallowRun)) << shallowRun.error;
+    ASSERT_TRUE(session.Run(V4l2BenchMemory::MMAP, deep, deepRun)) << deepRun.error;
+    if (shallowRun.granted > shallow) {
+        GTEST_SKIP() << session.Driver() << " needs at least " << shallowRun.granted << " buffers";
+    }
+    EXPECT_GT(shallowRun.drops, 0u);
+    EXPECT_LT(deepRun.drops, shallowRun.drops);
+    EXPECT_EQ(0u, shallowRun.minQueued);
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_V4L2_BENCH_H
+#define HOS_CAMERA_V4L2_BENCH_H
+
+#include <linux/videodev2.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace OHOS::Camera {
+enum class V4l2BenchMemory : uint32_t {
+    MMAP = 0,
+    USERPTR,
+    DMABUF,
+};
+
+struct V4l2BenchConfig {
+    std::string device = "vivid";           // a /dev/video path, or the driver or card name of a capture node
+    uint32_t width = 640;
+    uint32_t height = 480;
+    uint32_t pixelFormat = V4L2_PIX_FMT_YUYV;
+    uint32_t fps = 30;                      // 0: what the driver has
+    std::vector<uint32_t> bufferCounts = {2, 3, 4, 6, 8, 12, 16};
+    std::vector<V4l2BenchMemory> memories = {V4l2BenchMemory::MMAP, V4l2BenchMemory::USERPTR,
+        V4l2BenchMemory::DMABUF};
+    uint32_t frames = 300;                  // timed frames per run
+    uint32_t warmup = 15;
+    uint32_t holdUs = 0;                    // the consumer keeps every buffer this long, the pipeline's share
+    uint32_t stallEvery = 0;                // every Nth frame is held stallUs longer, a capture or a gc, 0: never
+    uint32_t stallUs = 0;
+    bool touch = false;                     // the consumer reads every byte, the cpu cost of each memory mode
+    uint32_t timeoutMs = 2000;              // a run fails when no frame comes for this long
+    std::string jsonPath;                   // the report as json as well, "-": stdout
+    double gateP99Us = 0.0;                 // fail when a run's capture to callback p99 is above, 0: no gate
+    double gateFps = 0.0;                   // fail when a run delivers fewer frames per second, 0: no gate
+    double gateDropPct = -1.0;              // fail when a run drops more, negative: no gate
+};
+
+struct LatencySummary {
+    size_t count = 0;
+    double minUs = 0.0;
+    double meanUs = 0.0;
+    double p50Us = 0.0;
+    double p90Us = 0.0;
+    double p99Us = 0.0;
+    double maxUs = 0.0;
+};
+
+// nearest rank percentiles, sorts ns
+LatencySummary SummarizeLatency(std::vector<uint64_t>& ns);
+
+struct V4l2RunResult {
+    V4l2BenchMemory memory = V4l2BenchMemory::MMAP;
+    uint32_t requested = 0;
+    uint32_t granted = 0;                   // what VIDIOC_REQBUFS gave, drivers raise it to their minimum
+    bool skipped = false;                   // the driver or the kernel has no such memory mode, see error
+    std::string error;
+    uint64_t frames = 0;
+    uint64_t drops = 0;                     // gaps in the buffer sequence numbers
+    uint64_t errorFrames = 0;               // buffers the driver flagged V4L2_BUF_FLAG_ERROR
+    double seconds = 0.0;
+    double fps = 0.0;                       // frames delivered to the callback per second
+    LatencySummary captureToCallback;       // the driver's timestamp to the callback, empty without monotonic stamps
+    LatencySummary dequeue;                 // VIDIOC_DQBUF itself
+    uint32_t minQueued = 0;                 // fewest buffers the driver still had after a dequeue, 0: it starved
+
+    double DropPercent() const
+    {
+        uint64_t total = frames + drops;
+        return total == 0 ? 0.0 : 100.0 * static_cast<double>(drops) / static_cast<double>(total);   // 100: percent
+    }
+};
+
+// dma-bufs for VIDIOC_QBUF of V4L2_MEMORY_DMABUF from a dma-heap or udmabuf, the first one the kernel has
+class V4l2DmaBufAllocator {
+public:
+    V4l2DmaBufAllocator() = default;
+    ~V4l2DmaBufAllocator();
+    V4l2DmaBufAllocator(const V4l2DmaBufAllocator&) = delete;
+    V4l2DmaBufAllocator& operator=(const V4l2DmaBufAllocator&) = delete;
+
+    bool Open(std::string& error);
+    int Alloc(size_t size);     // a dma-buf fd of at least size bytes, -1 on failure
+    const char* Name() const { return name_; }
+
+private:
+    int heapFd_ = -1;
+    int udmabufFd_ = -1;
+    const char* name_ = "none";
+};
+
+/*
+ * One capture node streamed the way the v4l2 adapter streams it: a loop thread polls, dequeues and calls
+ * back, the pipeline keeps the buffer for a while and queues it again from its own thread.
+ */
+class V4l2StreamSession {
+public:
+    V4l2StreamSession() = default;
+    ~V4l2StreamSession();
+    V4l2StreamSession(const V4l2StreamSession&) = delete;
+    V4l2StreamSession& operator=(const V4l2StreamSession&) = delete;
+
+    bool Open(const V4l2BenchConfig& config, std::string& error);
+    void Close();
+    bool Run(V4l2BenchMemory memory, uint32_t bufferCount, V4l2RunResult& result);
+
+    const std::string& Path() const { return path_; }
+    const std::string& Driver() const { return driver_; }
+    const std::string& Card() const { return card_; }
+    uint32_t Width() const { return width_; }
+    uint32_t Height() const { return height_; }
+    double NominalFps() const { return nominalFps_; }
+    bool Multiplanar() const { return type_ == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE; }
+
+private:
+    struct Plane {
+        uint8_t* addr = nullptr;
+        size_t length = 0;
+        int fd = -1;                // dma-buf
+        bool mapped = false;        // addr is an mmap of the node or of fd, not a userptr allocation
+    };
+    struct Buffer {
+        std::vector<Plane> planes;
+    };
+    struct Dequeued {
+        uint32_t index = 0;
+        uint32_t bytesUsed[VIDEO_MAX_PLANES] = {};
+    };
+
+    bool AllocBuffers(uint32_t count, std::string& error);
+    void FreeBuffers();
+    bool Queue(uint32_t index);
+    void InitBuffer(v4l2_buffer& buf, v4l2_plane* planes, uint32_t index) const;
+    void DequeueLoop(V4l2RunResult& result, std::vector<uint64_t>& captureNs, std::vector<uint64_t>& dequeueNs);
+    void ConsumeLoop();
+    void Touch(const Dequeued& frame);
+    void StopConsumer();
+
+    V4l2BenchConfig config_;
+    int fd_ = -1;
+    std::string path_;
+    std::string driver_;
+    std::string card_;
+    v4l2_buf_type type_ = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t planeCount_ = 1;
+    uint32_t sizeImage_[VIDEO_MAX_PLANES] = {};
+    double nominalFps_ = 0.0;
+
+    v4l2_memory memory_ = V4L2_MEMORY_MMAP;
+    std::vector<Buffer> buffers_;
+    V4l2DmaBufAllocator dmaBufs_;
+    bool dmaBufsOpened_ = false;
+    std::atomic<int32_t> queued_ {0};       // buffers the driver holds
+    std::atomic<bool> failed_ {false};
+
+    std::mutex lock_;
+    std::condition_variable cv_;
+    std::deque<Dequeued> pending_;          // called back, not yet queued again
+    bool stopping_ = false;
+    uint64_t consumed_ = 0;
+    uint64_t touchSum_ = 0;
+};
+
+bool ParseV4l2Memory(const std::string& name, V4l2BenchMemory& memory);
+const char* V4l2MemoryName(V4l2BenchMemory memory);
+bool ParseFourcc(const std::string& name, uint32_t& fourcc);
+std::string FourccName(uint32_t fourcc);
+// "2,4,8" or "2-16", every count from 1 to VIDEO_MAX_FRAME
+bool ParseBufferCounts(const std::string& text, std::vector<uint32_t>& counts);
+// frames the driver skipped between two sequence numbers, the counter wraps
+uint64_t SequenceGap(uint32_t previous, uint32_t current);
+// the first streaming capture node whose driver or card is name, empty when none
+std::string FindV4l2Capture(const std::string& name);
+
+// the process exit code
+int RunV4l2Benchmark(const V4l2BenchConfig& config);
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "v4l2_bench.h"
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#if __has_include(<linux/dma-heap.h>)
+#include <linux/dma-heap.h>
+#define V4L2_BENCH_DMA_HEAP 1
+#endif
+#if __has_include(<linux/udmabuf.h>)
+#include <linux/udmabuf.h>
+#define V4L2_BENCH_UDMABUF 1
+#endif
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t MAX_VIDEO_NODES = 64;
+constexpr size_t FOURCC_LENGTH = 4;
+constexpr uint32_t BITS_PER_CHAR = 8;
+const char* const DMA_HEAP_PATHS[] = {"/dev/dma_heap/system", "/dev/dma_heap/system-uncached"};
+const char* const UDMABUF_PATH = "/dev/udmabuf";
+
+bool ParseCount(const std::string& text, uint32_t& value)
+{
+    char* end = nullptr;
+    unsigned long parsed = strtoul(text.c_str(), &end, 0);
+    if (text.empty() || *end != '\0' || parsed == 0 || parsed > VIDEO_MAX_FRAME) {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+size_t PageAlign(size_t size)
+{
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (size + page - 1) / page * page;
+}
+} // namespace
+
+bool ParseV4l2Memory(const std::string& name, V4l2BenchMemory& memory)
+{
+    if (name == "mmap") {
+        memory = V4l2BenchMemory::MMAP;
+    } else if (name == "userptr") {
+        memory = V4l2BenchMemory::USERPTR;
+    } else if (name == "dmabuf") {
+        memory = V4l2BenchMemory::DMABUF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* V4l2MemoryName(V4l2BenchMemory memory)
+{
+    switch (memory) {
+        case V4l2BenchMemory::MMAP:
+            return "mmap";
+        case V4l2BenchMemory::USERPTR:
+            return "userptr";
+        default:
+            return "dmabuf";
+    }
+}
+
+// four characters as v4l2_fourcc() packs them, short names are padded with spaces like "GREY" or "Y16 "
+bool ParseFourcc(const std::string& name, uint32_t& fourcc)
+{
+    if (name.empty() || name.size() > FOURCC_LENGTH) {
+        return false;
+    }
+    fourcc = 0;
+    for (size_t i = 0; i < FOURCC_LENGTH; i++) {
+        char c = i < name.size() ? static_cast<char>(toupper(static_cast<unsigned char>(name[i]))) : ' ';
+        fourcc |= static_cast<uint32_t>(static_cast<unsigned char>(c)) << (BITS_PER_CHAR * i);
+    }
+    return true;
+}
+
+std::string FourccName(uint32_t fourcc)
+{
+    std::string name;
+    for (size_t i = 0; i < FOURCC_LENGTH; i++) {
+        char c = static_cast<char>((fourcc >> (BITS_PER_CHAR * i)) & 0xff);     // 0xff: one character
+        name += isprint(static_cast<unsigned char>(c)) ? c : '?';
+    }
+    return name;
+}
+
+bool ParseBufferCounts(const std::string& text, std::vector<uint32_t>& counts)
+{
+    counts.clear();
+    size_t dash = text.find('-');
+    if (dash != std::string::npos) {
+        uint32_t first = 0;
+        uint32_t last = 0;
+        if (!ParseCount(text.substr(0, dash), first) || !ParseCount(text.substr(dash + 1), last) || first > last) {
+            return false;
+        }
+        for (uint32_t count = first; count <= last; count++) {
+            counts.push_back(count);
+        }
+        return true;
+    }
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        uint32_t count = 0;
+        if (!ParseCount(item, count)) {
+            return false;
+        }
+        counts.push_back(count);
+    }
+    return !counts.empty();
+}
+
+uint64_t SequenceGap(uint32_t previous, uint32_t current)
+{
+    return static_cast<uint32_t>(current - previous - 1);
+}
+
+std::string FindV4l2Capture(const std::string& name)
+{
+    for (uint32_t i = 0; i < MAX_VIDEO_NODES; i++) {
+        std::string path = "/dev/video" + std::to_string(i);
+        int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        v4l2_capability cap = {};
+        bool found = false;
+        if (ioctl(fd, VIDIOC_QUERYCAP, &cap) == 0) {
+            // a node of a driver with several of them has its own caps, vivid has output and vbi nodes as well
+            uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) != 0 ? cap.device_caps : cap.capabilities;
+            bool capture = (caps & (V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_VIDEO_CAPTURE_MPLANE)) != 0 &&
+                (caps & V4L2_CAP_STREAMING) != 0;
+            found = capture && (name == reinterpret_cast<const char*>(cap.driver) ||
+                name == reinterpret_cast<const char*>(cap.card));
+        }
+        close(fd);
+        if (found) {
+            return path;
+        }
+    }
+    return "";
+}
+
+V4l2DmaBufAllocator::~V4l2DmaBufAllocator()
+{
+    if (heapFd_ >= 0) {
+        close(heapFd_);
+    }
+    if (udmabufFd_ >= 0) {
+        close(udmabufFd_);
+    }
+}
+
+// the board has the system heap, a desktop kernel usually only udmabuf
+bool V4l2DmaBufAllocator::Open(std::string& error)
+{
+#ifdef V4L2_BENCH_DMA_HEAP
+    for (const char* path : DMA_HEAP_PATHS) {
+        heapFd_ = open(path, O_RDONLY | O_CLOEXEC);
+        if (heapFd_ >= 0) {
+            name_ = path;
+            return true;
+        }
+    }
+#endif
+#ifdef V4L2_BENCH_UDMABUF
+    udmabufFd_ = open(UDMABUF_PATH, O_RDWR | O_CLOEXEC);
+    if (udmabufFd_ >= 0) {
+        name_ = UDMABUF_PATH;
+        return true;
+    }
+#endif
+    error = "no dma-buf exporter, neither /dev/dma_heap/system nor /dev/udmabuf";
+    return false;
+}
+
+int V4l2DmaBufAllocator::Alloc(size_t size)
+{
+    size = PageAlign(size);
+#ifdef V4L2_BENCH_DMA_HEAP
+    if (heapFd_ >= 0) {
+        dma_heap_allocation_data data = {};
+        data.len = size;
+        data.fd_flags = O_RDWR | O_CLOEXEC;
+        return ioctl(heapFd_, DMA_HEAP_IOCTL_ALLOC, &data) == 0 ? static_cast<int>(data.fd) : -1;
+    }
+#endif
+#ifdef V4L2_BENCH_UDMABUF
+    if (udmabufFd_ >= 0) {
+        // udmabuf wants a memfd that can no longer shrink, the dma-buf keeps the pages once it exists
+        int memfd = memfd_create("v4l2_bench", MFD_ALLOW_SEALING | MFD_CLOEXEC);
+        if (memfd < 0) {
+            return -1;
+        }
+        int fd = -1;
+        if (ftruncate(memfd, static_cast<off_t>(size)) == 0 && fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK) == 0) {
+            udmabuf_create create = {};
+            create.memfd = static_cast<uint32_t>(memfd);
+            create.flags = UDMABUF_FLAGS_CLOEXEC;
+            create.offset = 0;
+            create.size = size;
+            fd = ioctl(udmabufFd_, UDMABUF_CREATE, &create);
+        }
+        close(memfd);
+        return fd;
+    }
+#endif
+    (void)size;
+    return -1;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * camera_v4l2_bench streams a capture node the way the v4l2 adapter does and sweeps the buffer count and the
+ * memory mode, so the queue depth and the mode of a stream come from measurements. It talks plain v4l2, so
+ * the kernel's vivid driver or a v4l2loopback device with a writer stands in for the isp on any linux host:
+ *     sudo modprobe vivid
+ *     g++ -std=c++17 -O2 -Iinclude src/v4l2_bench_*.cpp -lpthread
+ * On the board -d rkisp_v5 streams the isp, the same name the adapter tests use.
+ * Exits nonzero when a run fails or a gate is missed.
+ */
+
+#include <getopt.h>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include "v4l2_bench.h"
+
+namespace {
+using namespace OHOS::Camera;
+
+enum Option : int {
+    OPT_DEVICE = 'd',
+    OPT_WIDTH = 'w',
+    OPT_HEIGHT = 'h',
+    OPT_FORMAT = 'f',
+    OPT_BUFFERS = 'b',
+    OPT_MEMORY = 'm',
+    OPT_FRAMES = 'n',
+    OPT_HELP = 256,     // 256: past the characters of the short options
+    OPT_FPS,
+    OPT_WARMUP,
+    OPT_HOLD,
+    OPT_STALL_EVERY,
+    OPT_STALL,
+    OPT_TOUCH,
+    OPT_TIMEOUT,
+    OPT_JSON,
+    OPT_GATE_P99,
+    OPT_GATE_FPS,
+    OPT_GATE_DROP,
+};
+
+const struct option OPTIONS[] = {
+    {"device", required_argument, nullptr, OPT_DEVICE},
+    {"width", required_argument, nullptr, OPT_WIDTH},
+    {"height", required_argument, nullptr, OPT_HEIGHT},
+    {"format", required_argument, nullptr, OPT_FORMAT},
+    {"buffers", required_argument, nullptr, OPT_BUFFERS},
+    {"memory", required_argument, nullptr, OPT_MEMORY},
+    {"frames", required_argument, nullptr, OPT_FRAMES},
+    {"help", no_argument, nullptr, OPT_HELP},
+    {"fps", required_argument, nullptr, OPT_FPS},
+    {"warmup", required_argument, nullptr, OPT_WARMUP},
+    {"hold-us", required_argument, nullptr, OPT_HOLD},
+    {"stall-every", required_argument, nullptr, OPT_STALL_EVERY},
+    {"stall-us", required_argument, nullptr, OPT_STALL},
+    {"touch", no_argument, nullptr, OPT_TOUCH},
+    {"timeout-ms", required_argument, nullptr, OPT_TIMEOUT},
+    {"json", required_argument, nullptr, OPT_JSON},
+    {"gate-p99-us", required_argument, nullptr, OPT_GATE_P99},
+    {"gate-fps", required_argument, nullptr, OPT_GATE_FPS},
+    {"gate-drop-pct", required_argument, nullptr, OPT_GATE_DROP},
+    {nullptr, 0, nullptr, 0},
+};
+
+void Usage(const char* name)
+{
+    printf("usage: %s [options]\n"
+        "  -d, --device D           /dev/videoN, or the driver or card name of a capture node, default vivid\n"
+        "  -w, --width N            default 640\n"
+        "  -h, --height N           default 480\n"
+        "  -f, --format F           fourcc, default YUYV\n"
+        "      --fps N              frame rate to ask for, 0 the driver's, default 30\n"
+        "  -b, --buffers L          buffer counts, \"2,4,8\" or \"2-16\", default 2,3,4,6,8,12,16\n"
+        "  -m, --memory L           mmap, userptr and dmabuf, comma separated, default all three\n"
+        "  -n, --frames N           timed frames per run, default 300\n"
+        "      --warmup N           untimed frames first, default 15\n"
+        "      --hold-us US         the consumer keeps every buffer this long before queueing it again\n"
+        "      --stall-every N      every Nth buffer is kept --stall-us longer, a still capture or a hiccup\n"
+        "      --stall-us US\n"
+        "      --touch              the consumer reads every byte of the picture\n"
+        "      --timeout-ms MS      a run fails without a frame for this long, default 2000\n"
+        "      --json FILE          the report as json as well, - for stdout\n"
+        "      --gate-p99-us US     fail when a run's capture to callback p99 is above\n"
+        "      --gate-fps FPS       fail when a run delivers fewer frames per second\n"
+        "      --gate-drop-pct P    fail when a run drops more of its frames\n", name);
+}
+
+bool ParseUnsigned(const char* text, uint32_t& value)
+{
+    char* end = nullptr;
+    unsigned long parsed = strtoul(text, &end, 0);
+    if (end == text || *end != '\0' || parsed > UINT32_MAX) {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+bool ParseMemories(const char* text, std::vector<V4l2BenchMemory>& memories)
+{
+    memories.clear();
+    std::stringstream list(text);
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        V4l2BenchMemory memory = V4l2BenchMemory::MMAP;
+        if (!ParseV4l2Memory(name, memory)) {
+            return false;
+        }
+        memories.push_back(memory);
+    }
+    return !memories.empty();
+}
+
+bool ParseOption(int opt, const char* arg, V4l2BenchConfig& config)
+{
+    switch (opt) {
+        case OPT_DEVICE: config.device = arg; return !config.device.empty();
+        case OPT_WIDTH: return ParseUnsigned(arg, config.width) && config.width != 0;
+        case OPT_HEIGHT: return ParseUnsigned(arg, config.height) && config.height != 0;
+        case OPT_FORMAT: return ParseFourcc(arg, config.pixelFormat);
+        case OPT_FPS: return ParseUnsigned(arg, config.fps);
+        case OPT_BUFFERS: return ParseBufferCounts(arg, config.bufferCounts);
+        case OPT_MEMORY: return ParseMemories(arg, config.memories);
+        case OPT_FRAMES: return ParseUnsigned(arg, config.frames) && config.frames != 0;
+        case OPT_WARMUP: return ParseUnsigned(arg, config.warmup);
+        case OPT_HOLD: return ParseUnsigned(arg, config.holdUs);
+        case OPT_STALL_EVERY: return ParseUnsigned(arg, config.stallEvery);
+        case OPT_STALL: return ParseUnsigned(arg, config.stallUs);
+        case OPT_TOUCH: config.touch = true; return true;
+        case OPT_TIMEOUT: return ParseUnsigned(arg, config.timeoutMs) && config.timeoutMs != 0;
+        case OPT_JSON: config.jsonPath = arg; return true;
+        case OPT_GATE_P99: config.gateP99Us = atof(arg); return true;
+        case OPT_GATE_FPS: config.gateFps = atof(arg); return true;
+        case OPT_GATE_DROP: config.gateDropPct = atof(arg); return true;
+        default: return false;
+    }
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    V4l2BenchConfig config;
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "d:w:h:f:b:m:n:", OPTIONS, nullptr)) != -1) {
+        if (opt == OPT_HELP) {
+            Usage(argv[0]);
+            return 0;
+        }
+        if (opt == '?') {
+            return 2;   // 2: usage error, getopt has said what was wrong
+        }
+        if (!ParseOption(opt, optarg, config)) {
+            const struct option* o = OPTIONS;
+            while (o->name != nullptr && o->val != opt) {
+                o++;
+            }
+            fprintf(stderr, "bad value \"%s\" for --%s\n", optarg != nullptr ? optarg : "", o->name);
+            return 2;
+        }
+    }
+    if (optind != argc) {
+        Usage(argv[0]);
+        return 2;
+    }
+    return RunV4l2Benchmark(config);
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "v4l2_bench.h"
+#include <cstdio>
+
+namespace OHOS::Camera {
+namespace {
+bool Measured(const V4l2RunResult& run)
+{
+    return !run.skipped && run.error.empty() && run.frames != 0;
+}
+
+// per memory mode the fewest buffers that streamed without a drop, the queue depth to configure
+std::vector<const V4l2RunResult*> PickDepths(const V4l2BenchConfig& config, const std::vector<V4l2RunResult>& runs)
+{
+    std::vector<const V4l2RunResult*> picks;
+    for (V4l2BenchMemory memory : config.memories) {
+        const V4l2RunResult* pick = nullptr;
+        for (const V4l2RunResult& run : runs) {
+            if (run.memory == memory && Measured(run) && run.drops == 0 &&
+                (pick == nullptr || run.granted < pick->granted)) {
+                pick = &run;
+            }
+        }
+        if (pick != nullptr) {
+            picks.push_back(pick);
+        }
+    }
+    return picks;
+}
+
+// of the drop free depths the mode that hands frames over soonest
+const V4l2RunResult* PickBest(const std::vector<const V4l2RunResult*>& picks)
+{
+    const V4l2RunResult* best = nullptr;
+    for (const V4l2RunResult* pick : picks) {
+        if (best == nullptr || pick->captureToCallback.p99Us < best->captureToCallback.p99Us) {
+            best = pick;
+        }
+    }
+    return best;
+}
+
+void PrintHeader(const V4l2BenchConfig& config, const V4l2StreamSession& session)
+{
+    printf("%s (%s, %s%s) %ux%u %s at %.1f fps, %u frames per run", session.Path().c_str(),
+        session.Driver().c_str(), session.Card().c_str(), session.Multiplanar() ? ", multiplanar" : "",
+        session.Width(), session.Height(), FourccName(config.pixelFormat).c_str(), session.NominalFps(),
+        config.frames);
+    if (config.holdUs != 0 || config.stallEvery != 0) {
+        printf(", held %u us", config.holdUs);
+        if (config.stallEvery != 0) {
+            printf(" and %u us more every %u", config.stallUs, config.stallEvery);
+        }
+    }
+    printf("%s\n", config.touch ? ", read by the cpu" : "");
+    printf("  %-8s %4s %4s %7s %6s %7s %8s %10s %10s %10s %9s %5s\n", "memory", "req", "got", "frames", "drops",
+        "drop%", "fps", "cb p50 us", "cb p99 us", "cb max us", "dq p99 us", "min q");
+}
+
+void PrintRun(const V4l2RunResult& run)
+{
+    if (!Measured(run)) {
+        printf("  %-8s %4u %4u  %s: %s\n", V4l2MemoryName(run.memory), run.requested, run.granted,
+            run.skipped ? "skipped" : "FAIL", run.error.c_str());
+        return;
+    }
+    printf("  %-8s %4u %4u %7llu %6llu %7.2f %8.2f %10.1f %10.1f %10.1f %9.1f %5u\n", V4l2MemoryName(run.memory),
+        run.requested, run.granted, static_cast<unsigned long long>(run.frames),
+        static_cast<unsigned long long>(run.drops), run.DropPercent(), run.fps, run.captureToCallback.p50Us,
+        run.captureToCallback.p99Us, run.captureToCallback.maxUs, run.dequeue.p99Us, run.minQueued);
+}
+
+void WriteLatency(FILE* out, const char* name, const LatencySummary& latency)
+{
+    fprintf(out, "\"%s\": {\"count\": %zu, \"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+        "\"p99\": %.3f, \"max\": %.3f}", name, latency.count, latency.minUs, latency.meanUs, latency.p50Us,
+        latency.p90Us, latency.p99Us, latency.maxUs);
+}
+
+void WriteJson(FILE* out, const V4l2BenchConfig& config, const V4l2StreamSession& session,
+    const std::vector<V4l2RunResult>& runs, const std::vector<const V4l2RunResult*>& picks, bool passed)
+{
+    fprintf(out, "{\"device\": \"%s\", \"driver\": \"%s\", \"card\": \"%s\", \"multiplanar\": %s, \"width\": %u, "
+        "\"height\": %u, \"format\": \"%s\", \"fps\": %.3f, \"frames\": %u, \"hold_us\": %u, \"stall_every\": %u, "
+        "\"stall_us\": %u, \"touch\": %s,\n \"runs\": [", session.Path().c_str(), session.Driver().c_str(),
+        session.Card().c_str(), session.Multiplanar() ? "true" : "false", session.Width(), session.Height(),
+        FourccName(config.pixelFormat).c_str(), session.NominalFps(), config.frames, config.holdUs,
+        config.stallEvery, config.stallUs, config.touch ? "true" : "false");
+    const char* separator = "\n  ";
+    for (const V4l2RunResult& run : runs) {
+        fprintf(out, "%s{\"memory\": \"%s\", \"requested\": %u, \"granted\": %u, \"skipped\": %s, \"error\": \"%s\", "
+            "\"frames\": %llu, \"drops\": %llu, \"drop_pct\": %.3f, \"error_frames\": %llu, \"fps\": %.3f, "
+            "\"min_queued\": %u, ", separator, V4l2MemoryName(run.memory), run.requested, run.granted,
+            run.skipped ? "true" : "false", run.error.c_str(), static_cast<unsigned long long>(run.frames),
+            static_cast<unsigned long long>(run.drops), run.DropPercent(),
+            static_cast<unsigned long long>(run.errorFrames), run.fps, run.minQueued);
+        WriteLatency(out, "capture_to_callback_us", run.captureToCallback);
+        fprintf(out, ", ");
+        WriteLatency(out, "dqbuf_us", run.dequeue);
+        fprintf(out, "}");
+        separator = ",\n  ";
+    }
+    fprintf(out, "],\n \"drop_free_depth\": {");
+    separator = "";
+    for (const V4l2RunResult* pick : picks) {
+        fprintf(out, "%s\"%s\": %u", separator, V4l2MemoryName(pick->memory), pick->granted);
+        separator = ", ";
+    }
+    fprintf(out, "},\n \"passed\": %s}\n", passed ? "true" : "false");
+}
+
+bool CheckGates(const V4l2BenchConfig& config, const V4l2RunResult& run)
+{
+    bool passed = true;
+    const char* name = V4l2MemoryName(run.memory);
+    if (config.gateP99Us > 0.0 && run.captureToCallback.p99Us > config.gateP99Us) {
+        fprintf(stderr, "gate: %s x%u p99 %.1f us above %.1f us\n", name, run.granted, run.captureToCallback.p99Us,
+            config.gateP99Us);
+        passed = false;
+    }
+    if (config.gateFps > 0.0 && run.fps < config.gateFps) {
+        fprintf(stderr, "gate: %s x%u %.1f frames/s below %.1f\n", name, run.granted, run.fps, config.gateFps);
+        passed = false;
+    }
+    if (config.gateDropPct >= 0.0 && run.DropPercent() > config.gateDropPct) {
+        fprintf(stderr, "gate: %s x%u dropped %.2f%% above %.2f%%\n", name, run.granted, run.DropPercent(),
+            config.gateDropPct);
+        passed = false;
+    }
+    return passed;
+}
+} // namespace
+
+int RunV4l2Benchmark(const V4l2BenchConfig& config)
+{
+    V4l2StreamSession session;
+    std::string error;
+    if (!session.Open(config, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    PrintHeader(config, session);
+
+    bool passed = true;
+    std::vector<V4l2RunResult> runs;
+    runs.reserve(config.memories.size() * config.bufferCounts.size());
+    for (V4l2BenchMemory memory : config.memories) {
+        for (uint32_t count : config.bufferCounts) {
+            runs.emplace_back();
+            V4l2RunResult& run = runs.back();
+            passed &= session.Run(memory, count, run);
+            PrintRun(run);
+            if (Measured(run)) {
+                passed &= CheckGates(config, run);
+            }
+            // a mode the driver or the kernel lacks stays so for the other depths
+            if (run.skipped) {
+                break;
+            }
+        }
+    }
+
+    std::vector<const V4l2RunResult*> picks = PickDepths(config, runs);
+    for (const V4l2RunResult* pick : picks) {
+        printf("  %s: %u buffers are the fewest without a drop\n", V4l2MemoryName(pick->memory), pick->granted);
+    }
+    const V4l2RunResult* best = PickBest(picks);
+    if (best != nullptr) {
+        printf("  pick %s with %u buffers, capture to callback p99 %.1f us\n", V4l2MemoryName(best->memory),
+            best->granted, best->captureToCallback.p99Us);
+    } else {
+        printf("  no run went without a drop\n");
+    }
+
+    if (!config.jsonPath.empty()) {
+        FILE* out = config.jsonPath == "-" ? stdout : fopen(config.jsonPath.c_str(), "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", config.jsonPath.c_str());
+            return 1;
+        }
+        WriteJson(out, config, session, runs, picks, passed);
+        if (out != stdout) {
+            fclose(out);
+        }
+    }
+    return passed ? 0 : 1;
+}
+} // namespace OHOS::Camera
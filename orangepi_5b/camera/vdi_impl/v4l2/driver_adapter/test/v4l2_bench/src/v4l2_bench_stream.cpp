@@ -0,0 +1,519 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "v4l2_bench.h"
+#include <fcntl.h>
+#include <linux/dma-buf.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+namespace OHOS::Camera {
+namespace {
+constexpr int64_t NS_PER_S = 1000000000;
+constexpr double NS_PER_US = 1000.0;
+
+int Xioctl(int fd, unsigned long request, void* arg)
+{
+    int ret = 0;
+    do {
+        ret = ioctl(fd, request, arg);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+// the clock v4l2 stamps its buffers with
+int64_t MonotonicNs()
+{
+    timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * NS_PER_S + ts.tv_nsec;
+}
+
+std::string Errno(const std::string& what)
+{
+    return what + ": " + strerror(errno);
+}
+
+v4l2_memory ToV4l2(V4l2BenchMemory memory)
+{
+    switch (memory) {
+        case V4l2BenchMemory::MMAP:
+            return V4L2_MEMORY_MMAP;
+        case V4l2BenchMemory::USERPTR:
+            return V4L2_MEMORY_USERPTR;
+        default:
+            return V4L2_MEMORY_DMABUF;
+    }
+}
+
+const char* V4l2MemoryName(v4l2_memory memory)
+{
+    switch (memory) {
+        case V4L2_MEMORY_MMAP:
+            return "mmap";
+        case V4L2_MEMORY_USERPTR:
+            return "userptr";
+        default:
+            return "dmabuf";
+    }
+}
+
+size_t PageAlign(size_t size)
+{
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (size + page - 1) / page * page;
+}
+} // namespace
+
+LatencySummary SummarizeLatency(std::vector<uint64_t>& ns)
+{
+    LatencySummary summary;
+    summary.count = ns.size();
+    if (ns.empty()) {
+        return summary;
+    }
+    std::sort(ns.begin(), ns.end());
+    auto rank = [&ns](double p) {
+        size_t r = static_cast<size_t>(p * static_cast<double>(ns.size()) + 0.999999);    // ceil, nearest rank
+        return static_cast<double>(ns[std::min(std::max<size_t>(r, 1), ns.size()) - 1]) / NS_PER_US;
+    };
+    double total = 0.0;
+    for (uint64_t v : ns) {
+        total += static_cast<double>(v);
+    }
+    summary.minUs = static_cast<double>(ns.front()) / NS_PER_US;
+    summary.meanUs = total / static_cast<double>(ns.size()) / NS_PER_US;
+    summary.p50Us = rank(0.50);     // 0.50: median
+    summary.p90Us = rank(0.90);     // 0.90: p90
+    summary.p99Us = rank(0.99);     // 0.99: p99
+    summary.maxUs = static_cast<double>(ns.back()) / NS_PER_US;
+    return summary;
+}
+
+V4l2StreamSession::~V4l2StreamSession()
+{
+    Close();
+}
+
+bool V4l2StreamSession::Open(const V4l2BenchConfig& config, std::string& error)
+{
+    Close();
+    config_ = config;
+    path_ = !config.device.empty() && config.device[0] == '/' ? config.device : FindV4l2Capture(config.device);
+    if (path_.empty()) {
+        error = "no streaming capture node of " + config.device + ", is the module loaded (modprobe vivid)?";
+        return false;
+    }
+    fd_ = open(path_.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        error = Errno("open " + path_);
+        return false;
+    }
+    v4l2_capability cap = {};
+    if (Xioctl(fd_, VIDIOC_QUERYCAP, &cap) < 0) {
+        error = Errno("VIDIOC_QUERYCAP " + path_);
+        return false;
+    }
+    driver_ = reinterpret_cast<const char*>(cap.driver);
+    card_ = reinterpret_cast<const char*>(cap.card);
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) != 0 ? cap.device_caps : cap.capabilities;
+    if ((caps & V4L2_CAP_STREAMING) == 0 ||
+        (caps & (V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_VIDEO_CAPTURE_MPLANE)) == 0) {
+        error = path_ + " is no streaming capture node";
+        return false;
+    }
+    // the rk isp nodes are multiplanar, vivid is single planar unless loaded with multiplanar=2
+    type_ = (caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE) != 0 ? V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE :
+        V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    v4l2_format fmt = {};
+    fmt.type = type_;
+    if (Multiplanar()) {
+        fmt.fmt.pix_mp.width = config.width;
+        fmt.fmt.pix_mp.height = config.height;
+        fmt.fmt.pix_mp.pixelformat = config.pixelFormat;
+        fmt.fmt.pix_mp.field = V4L2_FIELD_ANY;
+    } else {
+        fmt.fmt.pix.width = config.width;
+        fmt.fmt.pix.height = config.height;
+        fmt.fmt.pix.pixelformat = config.pixelFormat;
+        fmt.fmt.pix.field = V4L2_FIELD_ANY;
+    }
+    if (Xioctl(fd_, VIDIOC_S_FMT, &fmt) < 0) {
+        error = Errno("VIDIOC_S_FMT " + FourccName(config.pixelFormat));
+        return false;
+    }
+    uint32_t pixelFormat = Multiplanar() ? fmt.fmt.pix_mp.pixelformat : fmt.fmt.pix.pixelformat;
+    if (pixelFormat != config.pixelFormat) {
+        error = driver_ + " has no " + FourccName(config.pixelFormat) + ", it offered " + FourccName(pixelFormat);
+        return false;
+    }
+    width_ = Multiplanar() ? fmt.fmt.pix_mp.width : fmt.fmt.pix.width;
+    height_ = Multiplanar() ? fmt.fmt.pix_mp.height : fmt.fmt.pix.height;
+    planeCount_ = Multiplanar() ? std::max<uint32_t>(fmt.fmt.pix_mp.num_planes, 1) : 1;
+    for (uint32_t p = 0; p < planeCount_; p++) {
+        sizeImage_[p] = Multiplanar() ? fmt.fmt.pix_mp.plane_fmt[p].sizeimage : fmt.fmt.pix.sizeimage;
+    }
+
+    v4l2_streamparm parm = {};
+    parm.type = type_;
+    if (config.fps != 0 && Xioctl(fd_, VIDIOC_G_PARM, &parm) == 0 &&
+        (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME) != 0) {
+        parm.parm.capture.timeperframe.numerator = 1;
+        parm.parm.capture.timeperframe.denominator = config.fps;
+        Xioctl(fd_, VIDIOC_S_PARM, &parm);
+    }
+    // the driver rounds to a rate it has
+    if (Xioctl(fd_, VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.timeperframe.numerator != 0) {
+        nominalFps_ = static_cast<double>(parm.parm.capture.timeperframe.denominator) /
+            parm.parm.capture.timeperframe.numerator;
+    }
+    return true;
+}
+
+void V4l2StreamSession::Close()
+{
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+void V4l2StreamSession::InitBuffer(v4l2_buffer& buf, v4l2_plane* planes, uint32_t index) const
+{
+    buf = {};
+    buf.type = type_;
+    buf.memory = memory_;
+    buf.index = index;
+    if (Multiplanar()) {
+        memset(planes, 0, sizeof(v4l2_plane) * VIDEO_MAX_PLANES);
+        buf.m.planes = planes;
+        buf.length = planeCount_;
+    }
+}
+
+bool V4l2StreamSession::AllocBuffers(uint32_t count, std::string& error)
+{
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    buffers_.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        v4l2_buffer buf;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
+        InitBuffer(buf, planes, i);
+        if (memory_ == V4L2_MEMORY_MMAP && Xioctl(fd_, VIDIOC_QUERYBUF, &buf) < 0) {
+            error = Errno("VIDIOC_QUERYBUF");
+            return false;
+        }
+        buffers_[i].planes.resize(planeCount_);
+        for (uint32_t p = 0; p < planeCount_; p++) {
+            Plane& plane = buffers_[i].planes[p];
+            if (memory_ == V4L2_MEMORY_MMAP) {
+                plane.length = Multiplanar() ? planes[p].length : buf.length;
+                off_t offset = static_cast<off_t>(Multiplanar() ? planes[p].m.mem_offset : buf.m.offset);
+                void* addr = mmap(nullptr, plane.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset);
+                plane.addr = addr != MAP_FAILED ? static_cast<uint8_t*>(addr) : nullptr;
+                plane.mapped = plane.addr != nullptr;
+            } else if (memory_ == V4L2_MEMORY_USERPTR) {
+                // what the adapter hands in, pipeline buffers, page aligned so the driver can pin whole pages
+                plane.length = PageAlign(sizeImage_[p]);
+                void* addr = nullptr;
+                plane.addr = posix_memalign(&addr, page, plane.length) == 0 ? static_cast<uint8_t*>(addr) : nullptr;
+            } else {
+                plane.length = PageAlign(sizeImage_[p]);
+                plane.fd = dmaBufs_.Alloc(plane.length);
+                // only a consumer that reads the picture maps it
+                if (plane.fd >= 0 && config_.touch) {
+                    void* addr = mmap(nullptr, plane.length, PROT_READ, MAP_SHARED, plane.fd, 0);
+                    plane.addr = addr != MAP_FAILED ? static_cast<uint8_t*>(addr) : nullptr;
+                    plane.mapped = plane.addr != nullptr;
+                }
+            }
+            bool needsAddr = memory_ != V4L2_MEMORY_DMABUF || config_.touch;
+            if ((memory_ == V4L2_MEMORY_DMABUF && plane.fd < 0) || (needsAddr && plane.addr == nullptr)) {
+                error = Errno(std::string(V4l2MemoryName(memory_)) + " buffer " + std::to_string(i));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// the driver lets go of userptr pages and dma-bufs only on VIDIOC_REQBUFS 0, mmaps have to be gone before it
+void V4l2StreamSession::FreeBuffers()
+{
+    for (Buffer& buffer : buffers_) {
+        for (Plane& plane : buffer.planes) {
+            if (plane.mapped) {
+                munmap(plane.addr, plane.length);
+                plane.addr = nullptr;
+            }
+        }
+    }
+    v4l2_requestbuffers req = {};
+    req.count = 0;
+    req.type = type_;
+    req.memory = memory_;
+    Xioctl(fd_, VIDIOC_REQBUFS, &req);
+    for (Buffer& buffer : buffers_) {
+        for (Plane& plane : buffer.planes) {
+            if (plane.fd >= 0) {
+                close(plane.fd);
+            }
+            free(plane.addr);
+        }
+    }
+    buffers_.clear();
+}
+
+bool V4l2StreamSession::Queue(uint32_t index)
+{
+    v4l2_buffer buf;
+    v4l2_plane planes[VIDEO_MAX_PLANES];
+    InitBuffer(buf, planes, index);
+    for (uint32_t p = 0; p < planeCount_ && memory_ != V4L2_MEMORY_MMAP; p++) {
+        const Plane& plane = buffers_[index].planes[p];
+        if (Multiplanar()) {
+            planes[p].length = static_cast<uint32_t>(plane.length);
+            if (memory_ == V4L2_MEMORY_USERPTR) {
+                planes[p].m.userptr = reinterpret_cast<unsigned long>(plane.addr);
+            } else {
+                planes[p].m.fd = plane.fd;
+            }
+        } else {
+            buf.length = static_cast<uint32_t>(plane.length);
+            if (memory_ == V4L2_MEMORY_USERPTR) {
+                buf.m.userptr = reinterpret_cast<unsigned long>(plane.addr);
+            } else {
+                buf.m.fd = plane.fd;
+            }
+        }
+    }
+    // counted first, the loop thread may dequeue it before the ioctl returns
+    queued_++;
+    if (Xioctl(fd_, VIDIOC_QBUF, &buf) < 0) {
+        queued_--;
+        return false;
+    }
+    return true;
+}
+
+bool V4l2StreamSession::Run(V4l2BenchMemory memory, uint32_t bufferCount, V4l2RunResult& result)
+{
+    result = V4l2RunResult {};
+    result.memory = memory;
+    result.requested = bufferCount;
+    memory_ = ToV4l2(memory);
+    if (memory == V4l2BenchMemory::DMABUF && !dmaBufsOpened_ && !dmaBufs_.Open(result.error)) {
+        result.skipped = true;
+        return true;
+    }
+    dmaBufsOpened_ = dmaBufsOpened_ || memory == V4l2BenchMemory::DMABUF;
+
+    v4l2_requestbuffers req = {};
+    req.count = bufferCount;
+    req.type = type_;
+    req.memory = memory_;
+    if (Xioctl(fd_, VIDIOC_REQBUFS, &req) < 0) {
+        result.skipped = errno == EINVAL;
+        result.error = result.skipped ? driver_ + " has no " + V4l2MemoryName(memory) + " buffers" :
+            Errno("VIDIOC_REQBUFS");
+        return result.skipped;
+    }
+    result.granted = req.count;
+    if (req.count == 0 || !AllocBuffers(req.count, result.error)) {
+        result.error = result.error.empty() ? "VIDIOC_REQBUFS gave no buffers" : result.error;
+        FreeBuffers();
+        return false;
+    }
+
+    pending_.clear();
+    stopping_ = false;
+    consumed_ = 0;
+    queued_ = 0;
+    failed_ = false;
+    for (uint32_t i = 0; i < req.count; i++) {
+        if (!Queue(i)) {
+            result.error = Errno("VIDIOC_QBUF");
+            FreeBuffers();
+            return false;
+        }
+    }
+    int type = type_;
+    if (Xioctl(fd_, VIDIOC_STREAMON, &type) < 0) {
+        result.error = Errno("VIDIOC_STREAMON");
+        FreeBuffers();
+        return false;
+    }
+
+    std::vector<uint64_t> captureNs;
+    std::vector<uint64_t> dequeueNs;
+    std::thread consumer(&V4l2StreamSession::ConsumeLoop, this);
+    std::thread loop(&V4l2StreamSession::DequeueLoop, this, std::ref(result), std::ref(captureNs),
+        std::ref(dequeueNs));
+    loop.join();
+    StopConsumer();
+    consumer.join();
+    Xioctl(fd_, VIDIOC_STREAMOFF, &type);
+    FreeBuffers();
+
+    result.captureToCallback = SummarizeLatency(captureNs);
+    result.dequeue = SummarizeLatency(dequeueNs);
+    if (failed_ && result.error.empty()) {
+        result.error = Errno("VIDIOC_QBUF from the consumer");
+    }
+    return result.error.empty();
+}
+
+// what the adapter's stream thread does: poll, dequeue, hand the frame to the callback
+void V4l2StreamSession::DequeueLoop(V4l2RunResult& result, std::vector<uint64_t>& captureNs,
+    std::vector<uint64_t>& dequeueNs)
+{
+    uint64_t target = static_cast<uint64_t>(config_.warmup) + config_.frames;
+    uint64_t seen = 0;
+    uint32_t lastSequence = 0;
+    int64_t firstNs = 0;
+    int64_t lastNs = 0;
+    result.minQueued = result.granted;
+    captureNs.reserve(config_.frames);
+    dequeueNs.reserve(config_.frames);
+    pollfd pfd = {fd_, POLLIN, 0};
+    while (seen < target && !failed_) {
+        int ret = poll(&pfd, 1, static_cast<int>(config_.timeoutMs));
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0 || (pfd.revents & POLLERR) != 0) {
+            result.error = ret == 0 ? "no frame within " + std::to_string(config_.timeoutMs) + " ms" :
+                Errno("poll");
+            break;
+        }
+        v4l2_buffer buf;
+        v4l2_plane planes[VIDEO_MAX_PLANES];
+        InitBuffer(buf, planes, 0);
+        int64_t begin = MonotonicNs();
+        if (Xioctl(fd_, VIDIOC_DQBUF, &buf) < 0) {
+            if (errno == EAGAIN) {
+                continue;
+            }
+            result.error = Errno("VIDIOC_DQBUF");
+            break;
+        }
+        int64_t now = MonotonicNs();
+        int32_t queued = --queued_;
+
+        // from here on this is the callback
+        seen++;
+        if (seen > config_.warmup) {
+            if (result.frames == 0) {
+                firstNs = now;
+            }
+            result.frames++;
+            lastNs = now;
+            result.drops += seen > 1 ? SequenceGap(lastSequence, buf.sequence) : 0;
+            result.errorFrames += (buf.flags & V4L2_BUF_FLAG_ERROR) != 0 ? 1 : 0;
+            result.minQueued = std::min(result.minQueued, static_cast<uint32_t>(std::max(queued, 0)));
+            dequeueNs.push_back(static_cast<uint64_t>(now - begin));
+            int64_t stampNs = static_cast<int64_t>(buf.timestamp.tv_sec) * NS_PER_S +
+                static_cast<int64_t>(buf.timestamp.tv_usec) * static_cast<int64_t>(NS_PER_US);
+            if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC && stampNs <= now) {
+                captureNs.push_back(static_cast<uint64_t>(now - stampNs));
+            }
+        }
+        lastSequence = buf.sequence;
+
+        Dequeued frame;
+        frame.index = buf.index;
+        for (uint32_t p = 0; p < planeCount_; p++) {
+            frame.bytesUsed[p] = Multiplanar() ? planes[p].bytesused : buf.bytesused;
+        }
+        std::lock_guard<std::mutex> l(lock_);
+        pending_.push_back(frame);
+        cv_.notify_one();
+    }
+    result.seconds = static_cast<double>(lastNs - firstNs) / NS_PER_S;
+    result.fps = result.frames > 1 && result.seconds > 0.0 ? static_cast<double>(result.frames - 1) / result.seconds :
+        0.0;
+}
+
+// the pipeline: keeps a frame for --hold-us, longer on a stall, and queues it again
+void V4l2StreamSession::ConsumeLoop()
+{
+    for (;;) {
+        Dequeued frame;
+        {
+            std::unique_lock<std::mutex> l(lock_);
+            cv_.wait(l, [this] { return stopping_ || !pending_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            frame = pending_.front();
+            pending_.pop_front();
+        }
+        if (config_.touch) {
+            Touch(frame);
+        }
+        consumed_++;
+        uint64_t holdUs = config_.holdUs;
+        if (config_.stallEvery != 0 && consumed_ % config_.stallEvery == 0) {
+            holdUs += config_.stallUs;
+        }
+        if (holdUs != 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(holdUs));
+        }
+        if (!Queue(frame.index)) {
+            failed_ = true;
+            return;
+        }
+    }
+}
+
+// reads the picture the way a cpu node would, dma-bufs bracketed by the cache syncs they need
+void V4l2StreamSession::Touch(const Dequeued& frame)
+{
+    uint64_t sum = 0;
+    for (uint32_t p = 0; p < planeCount_; p++) {
+        const Plane& plane = buffers_[frame.index].planes[p];
+        size_t size = std::min<size_t>(frame.bytesUsed[p] != 0 ? frame.bytesUsed[p] : sizeImage_[p], plane.length);
+        dma_buf_sync sync = {DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ};
+        if (plane.fd >= 0) {
+            Xioctl(plane.fd, DMA_BUF_IOCTL_SYNC, &sync);
+        }
+        for (size_t offset = 0; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+            uint64_t word = 0;
+            memcpy(&word, plane.addr + offset, sizeof(word));
+            sum += word;
+        }
+        if (plane.fd >= 0) {
+            sync.flags = DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ;
+            Xioctl(plane.fd, DMA_BUF_IOCTL_SYNC, &sync);
+        }
+    }
+    touchSum_ += sum;
+}
+
+void V4l2StreamSession::StopConsumer()
+{
+    std::lock_guard<std::mutex> l(lock_);
+    stopping_ = true;
+    cv_.notify_all();
+}
+} // namespace OHOS::Camera
@@ -22,6 +22,9 @@ namespace OHOS::Camera {
 #define CAPTURE_PIXEL_FORMAT V4L2_PIX_FMT_YUV420
 #define VIDEO_PIXEL_FORMAT V4L2_PIX_FMT_YUV420
 
+// camera_v4l2_test_sensor in the gn args overrides it, "vivid" streams the kernel's virtual camera
+#ifndef TEST_SENSOR_NAME
 #define TEST_SENSOR_NAME "rkisp_v5"
+#endif
 } // namespace OHOS::Camera
 #endif
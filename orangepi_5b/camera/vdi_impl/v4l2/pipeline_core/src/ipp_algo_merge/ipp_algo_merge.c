@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "hilog/log.h"
+#include "ipp_algo.h"
+#include "ipp_merge_compose.h"
+#include "ipp_merge_kernels.h"
+#include "ipp_merge_pool.h"
+#include "parameter.h"
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0xD002513
+#define LOG_TAG "IppAlgoMerge"
+
+#define MAX_BUFFER_COUNT 2
+#define PARAM_VALUE_LEN 16
+#define PARAM_BASE 10
+#define DEFAULT_BLEND_WEIGHT 128
+#define BANDS_PER_THREAD 4
+#define MIN_BAND_ROWS 16
+
+static const char *PARAM_LAYOUT = "persist.camera.ippmerge.layout";     // IppMergeLayout
+static const char *PARAM_FORMAT = "persist.camera.ippmerge.format";     // IppMergeFormat
+static const char *PARAM_BLEND_WEIGHT = "persist.camera.ippmerge.blend_weight";  // of the second picture, of 256
+static const char *PARAM_THREADS = "persist.camera.ippmerge.threads";     // 0: one per big core, 1: serial
+static const char *PARAM_BAND_ROWS = "persist.camera.ippmerge.band_rows"; // 0: BANDS_PER_THREAD per thread
+
+static IppMergeLayout g_layout = IPP_MERGE_SIDE_BY_SIDE;
+static IppMergeFormat g_format = IPP_MERGE_YUYV;
+static uint32_t g_blendWeight = DEFAULT_BLEND_WEIGHT;
+static uint32_t g_threads = 0;
+static uint32_t g_bandRows = 0;
+static IppMergeScratch g_scratch = {NULL, 0};
+static IppMergePool *g_pool = NULL;
+// Process calls from several threads take turns, they share the pool and the scratch
+static pthread_mutex_t g_processLock = PTHREAD_MUTEX_INITIALIZER;
+
+// the bands of one phase of a merge, as the pool hands them out
+typedef struct {
+    IppMergePlan plan;
+    uint32_t phase;
+    uint32_t bandRows;
+    uint8_t *scratch;   // bandScratch for every pool thread
+} MergeRun;
+
+static int GetIntParam(const char *key, int defValue)
+{
+    char value[PARAM_VALUE_LEN] = {0};
+    if (GetParameter(key, "", value, sizeof(value)) <= 0) {
+        return defValue;
+    }
+    char *end = NULL;
+    long v = strtol(value, &end, PARAM_BASE);
+    return (end == value) ? defValue : (int)v;
+}
+
+// the same settings Init reads from the system parameters, for a harness that drives the plugin directly
+int IppMergeConfigure(int layout, int format, unsigned int blendWeight)
+{
+    if (layout < IPP_MERGE_SIDE_BY_SIDE || layout > IPP_MERGE_BLEND || format < IPP_MERGE_YUYV ||
+        format > IPP_MERGE_NV12) {
+        HILOG_ERROR(LOG_CORE, "ipp merge: unknown layout %{public}d or format %{public}d", layout, format);
+        return -1;
+    }
+    g_layout = (IppMergeLayout)layout;
+    g_format = (IppMergeFormat)format;
+    g_blendWeight = blendWeight;
+    return 0;
+}
+
+// the threads a frame is split over and the rows of a band, 0 for either picks it; applies from the next Start
+int IppMergeConfigureBands(unsigned int threads, unsigned int bandRows)
+{
+    if (threads > IPP_MERGE_POOL_MAX_THREADS || bandRows % IPP_MERGE_BAND_ALIGN != 0) {
+        HILOG_ERROR(LOG_CORE, "ipp merge: %{public}u threads or bands of %{public}u rows", threads, bandRows);
+        return -1;
+    }
+    g_threads = threads;
+    g_bandRows = bandRows;
+    return 0;
+}
+
+int Init(const IppAlgoMeta *meta)
+{
+    (void)meta;
+    if (IppMergeConfigure(GetIntParam(PARAM_LAYOUT, IPP_MERGE_SIDE_BY_SIDE), GetIntParam(PARAM_FORMAT, IPP_MERGE_YUYV),
+        (unsigned int)GetIntParam(PARAM_BLEND_WEIGHT, DEFAULT_BLEND_WEIGHT)) != 0 ||
+        IppMergeConfigureBands((unsigned int)GetIntParam(PARAM_THREADS, 0),
+        (unsigned int)GetIntParam(PARAM_BAND_ROWS, 0)) != 0) {
+        return -1;
+    }
+    HILOG_INFO(LOG_CORE, "ipp merge: layout %{public}d format %{public}d weight %{public}u, %{public}s kernels",
+        g_layout, g_format, g_blendWeight, IppMergeSimdName());
+    return 0;
+}
+
+// one worker per big core, the pipeline thread calling Process is the last of them
+int Start(void)
+{
+    uint32_t cpus[IPP_MERGE_POOL_MAX_THREADS];
+    uint32_t cpuCount = IppMergeBigCores(cpus, IPP_MERGE_POOL_MAX_THREADS);
+    uint32_t threads = g_threads;
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpuCount != 0 ? cpuCount : (online > 0 ? (uint32_t)online : 1);
+        threads = threads < IPP_MERGE_POOL_MAX_THREADS ? threads : IPP_MERGE_POOL_MAX_THREADS;
+    }
+    pthread_mutex_lock(&g_processLock);
+    IppMergePoolDestroy(g_pool);
+    g_pool = threads > 1 ? IppMergePoolCreate(threads, cpus, cpuCount) : NULL;
+    pthread_mutex_unlock(&g_processLock);
+    HILOG_INFO(LOG_CORE, "ipp merge: %{public}u threads on %{public}u big cores", IppMergePoolThreads(g_pool),
+        cpuCount);
+    return 0;
+}
+
+int Flush(void)
+{
+    return 0;
+}
+
+static int ToImage(const IppAlgoBuffer *buffer, IppMergeImage *image)
+{
+    if (buffer == NULL || buffer->addr == NULL) {
+        return -1;
+    }
+    image->addr = (uint8_t *)buffer->addr;
+    image->width = buffer->width;
+    image->height = buffer->height;
+    image->stride = buffer->stride;
+    image->size = buffer->size;
+    return 0;
+}
+
+static void RunMergeBand(void *context, uint32_t band, uint32_t worker)
+{
+    const MergeRun *run = (const MergeRun *)context;
+    uint32_t begin = band * run->bandRows;
+    IppMergeRunBand(&run->plan, run->phase, begin, begin + run->bandRows,
+        run->scratch + (size_t)worker * run->plan.bandScratch);
+}
+
+// the bands of the plan over the pool, or the whole picture on this thread when there is no pool
+static int RunMerge(MergeRun *run)
+{
+    uint32_t threads = IppMergePoolThreads(g_pool);
+    uint32_t height = run->plan.out.height;
+    run->bandRows = g_bandRows;
+    if (run->bandRows == 0) {
+        run->bandRows = height / (threads * BANDS_PER_THREAD) / IPP_MERGE_BAND_ALIGN * IPP_MERGE_BAND_ALIGN;
+        run->bandRows = run->bandRows > MIN_BAND_ROWS ? run->bandRows : MIN_BAND_ROWS;
+    }
+    uint32_t bands = (height + run->bandRows - 1) / run->bandRows;
+    if (g_pool == NULL || bands < 2) {   // 2: anything less is not worth waking the pool
+        threads = 1;
+        run->bandRows = height;
+        bands = 1;
+    }
+    size_t bytes = run->plan.bandScratch * threads + run->plan.sharedScratch;
+    run->scratch = bytes != 0 ? IppMergeReserveScratch(&g_scratch, bytes) : NULL;
+    if (bytes != 0 && run->scratch == NULL) {
+        return -1;
+    }
+    run->plan.shared = run->scratch != NULL ? run->scratch + run->plan.bandScratch * threads : NULL;
+    for (run->phase = 0; run->phase < run->plan.phases; run->phase++) {
+        if (bands > 1) {
+            IppMergePoolRun(g_pool, bands, RunMergeBand, run);
+        } else {
+            RunMergeBand(run, 0, 0);
+        }
+    }
+    return 0;
+}
+
+/*
+ * One input is copied to the output, two are merged by the configured layout. Without an output buffer
+ * the result goes to the first input, like the example plugin did. Every byte is the same whether the
+ * frame ran in bands on the pool or in one piece.
+ */
+int Process(IppAlgoBuffer *inBuffer[], int inBufferCount, IppAlgoBuffer *outBuffer, const IppAlgoMeta *meta)
+{
+    (void)meta;
+    IppMergeImage in[MAX_BUFFER_COUNT];
+    IppMergeImage out;
+    if (inBuffer == NULL || inBufferCount < 1 || inBufferCount > MAX_BUFFER_COUNT) {
+        HILOG_ERROR(LOG_CORE, "ipp merge: %{public}d input buffers", inBufferCount);
+        return -1;
+    }
+    for (int i = 0; i < inBufferCount; i++) {
+        if (ToImage(inBuffer[i], &in[i]) != 0) {
+            HILOG_ERROR(LOG_CORE, "ipp merge: input buffer %{public}d is null", i);
+            return -1;
+        }
+    }
+    if (outBuffer == NULL || outBuffer->addr == NULL) {
+        out = in[0];
+    } else {
+        (void)ToImage(outBuffer, &out);
+    }
+
+    pthread_mutex_lock(&g_processLock);
+    IppMergeLayout layout = inBufferCount == 1 ? IPP_MERGE_COPY : g_layout;
+    MergeRun run;
+    int ret = IppMergePlanMerge(&run.plan, layout, g_format, &out, &in[0], inBufferCount == 1 ? NULL : &in[1],
+        g_blendWeight);
+    if (ret == 0) {
+        ret = RunMerge(&run);
+    }
+    pthread_mutex_unlock(&g_processLock);
+    if (ret != 0) {
+        HILOG_ERROR(LOG_CORE, "ipp merge: layout %{public}d failed on %{public}ux%{public}u stride %{public}u",
+            g_layout, out.width, out.height, out.stride);
+    }
+    return ret;
+}
+
+int Stop(void)
+{
+    pthread_mutex_lock(&g_processLock);
+    IppMergePoolDestroy(g_pool);
+    g_pool = NULL;
+    IppMergeReleaseScratch(&g_scratch);
+    pthread_mutex_unlock(&g_processLock);
+    return 0;
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ipp_merge_compose.h"
+#include <stdlib.h>
+#include "ipp_merge_kernels.h"
+#include "securec.h"
+
+#define GEOMETRY_ALIGN 4u
+#define YUYV_BYTES_PER_PIXEL 2
+#define NV12_CHROMA_ROW_DIV 2
+#define INSET_MARGIN_DIV 16
+#define MAX_PLANES 2
+
+// one plane of a picture in the units the kernels work in
+typedef struct {
+    uint32_t rowBytes;          // bytes of a row that carry pixels, the rest of the stride is left alone
+    uint32_t rows;
+    uint32_t bytesPerPixel;     // a horizontal position in pixels to bytes
+    uint32_t rowDiv;            // a vertical position in pixels to rows
+    IppMergePairing pairing;
+} PlaneShape;
+
+static uint32_t GetPlanes(IppMergeFormat format, uint32_t width, uint32_t height, PlaneShape planes[MAX_PLANES])
+{
+    if (format == IPP_MERGE_NV12) {
+        PlaneShape luma = {width, height, 1, 1, IPP_MERGE_PAIR_LUMA};
+        PlaneShape chroma = {width, height / NV12_CHROMA_ROW_DIV, 1, NV12_CHROMA_ROW_DIV, IPP_MERGE_PAIR_UV};
+        planes[0] = luma;
+        planes[1] = chroma;
+        return MAX_PLANES;
+    }
+    PlaneShape packed = {width * YUYV_BYTES_PER_PIXEL, height, YUYV_BYTES_PER_PIXEL, 1, IPP_MERGE_PAIR_YUYV};
+    planes[0] = packed;
+    return 1;
+}
+
+static uint8_t *PlaneRow(const IppMergeImage *image, uint32_t plane, uint32_t row)
+{
+    size_t offset = plane == 0 ? 0 : (size_t)image->stride * image->height;
+    return image->addr + offset + (size_t)row * image->stride;
+}
+
+uint8_t *IppMergeReserveScratch(IppMergeScratch *scratch, size_t size)
+{
+    if (scratch == NULL) {
+        return NULL;
+    }
+    if (scratch->size < size) {
+        uint8_t *data = (uint8_t *)realloc(scratch->data, size);
+        if (data == NULL) {
+            return NULL;
+        }
+        scratch->data = data;
+        scratch->size = size;
+    }
+    return scratch->data;
+}
+
+void IppMergeReleaseScratch(IppMergeScratch *scratch)
+{
+    if (scratch != NULL) {
+        free(scratch->data);
+        scratch->data = NULL;
+        scratch->size = 0;
+    }
+}
+
+int IppMergeCheckImage(const IppMergeImage *image, IppMergeFormat format)
+{
+    if (image == NULL || image->addr == NULL || (format != IPP_MERGE_YUYV && format != IPP_MERGE_NV12) ||
+        image->width == 0 || image->height == 0 || image->width % GEOMETRY_ALIGN != 0 ||
+        image->height % GEOMETRY_ALIGN != 0) {
+        return -1;
+    }
+    PlaneShape planes[MAX_PLANES];
+    GetPlanes(format, image->width, image->height, planes);
+    size_t lumaBytes = (size_t)image->stride * image->height;
+    size_t bytes = format == IPP_MERGE_NV12 ? lumaBytes + lumaBytes / NV12_CHROMA_ROW_DIV : lumaBytes;
+    return (image->stride < planes[0].rowBytes || image->size < bytes) ? -1 : 0;
+}
+
+// out may only share its memory with an input row for row
+static int CheckPair(const IppMergeImage *out, const IppMergeImage *in, IppMergeFormat format)
+{
+    if (IppMergeCheckImage(out, format) != 0 || IppMergeCheckImage(in, format) != 0 ||
+        out->width != in->width || out->height != in->height) {
+        return -1;
+    }
+    return (out->addr == in->addr && out->stride != in->stride) ? -1 : 0;
+}
+
+static void CopyPlane(uint8_t *dst, size_t dstStride, const uint8_t *src, size_t srcStride, uint32_t rowBytes,
+    uint32_t rows)
+{
+    for (uint32_t r = 0; r < rows; r++) {
+        (void)memcpy_s(dst + r * dstStride, rowBytes, src + r * srcStride, rowBytes);
+    }
+}
+
+void IppMergeInsetOrigin(uint32_t width, uint32_t height, uint32_t *x, uint32_t *y)
+{
+    // a margin of about 1/16 of the picture, kept on the 4 pixel grid
+    *x = width / 2 - ((width / INSET_MARGIN_DIV) & ~(GEOMETRY_ALIGN - 1));
+    *y = height / 2 - ((height / INSET_MARGIN_DIV) & ~(GEOMETRY_ALIGN - 1));
+}
+
+// rows [begin, end) of the plane at half width and height, two rows are averaged into row and that is halved
+static void ShrinkRows(uint8_t *dst, size_t dstStride, const IppMergeImage *src, uint32_t plane,
+    const PlaneShape *shape, uint32_t begin, uint32_t end, uint8_t *row)
+{
+    for (uint32_t r = begin; r < end; r++) {
+        IppMergeAverageRowsSimd(row, PlaneRow(src, plane, 2 * r), PlaneRow(src, plane, 2 * r + 1), shape->rowBytes);
+        IppMergeHalveRowSimd(dst + (size_t)(r - begin) * dstStride, row, shape->rowBytes, shape->pairing);
+    }
+}
+
+int IppMergePlanMerge(IppMergePlan *plan, IppMergeLayout layout, IppMergeFormat format, const IppMergeImage *out,
+    const IppMergeImage *first, const IppMergeImage *second, uint32_t weight)
+{
+    if (plan == NULL || layout < IPP_MERGE_SIDE_BY_SIDE || layout > IPP_MERGE_COPY ||
+        CheckPair(out, first, format) != 0 || (layout != IPP_MERGE_COPY && CheckPair(out, second, format) != 0)) {
+        return -1;
+    }
+    plan->layout = layout;
+    plan->format = format;
+    plan->out = *out;
+    plan->first = *first;
+    plan->second = layout != IPP_MERGE_COPY ? *second : *first;
+    plan->weight = weight;
+    plan->phases = 1;
+    plan->bandScratch = 0;
+    plan->sharedScratch = 0;
+    plan->shared = NULL;
+
+    PlaneShape planes[MAX_PLANES];
+    uint32_t count = GetPlanes(format, out->width, out->height, planes);
+    if (layout == IPP_MERGE_SIDE_BY_SIDE && out->addr == second->addr) {
+        // the right half of an output row would overwrite the source row before it is read
+        plan->bandScratch = planes[0].rowBytes / 2;
+    } else if (layout == IPP_MERGE_PICTURE_IN_PICTURE) {
+        plan->bandScratch = planes[0].rowBytes;
+        // copying the base picture would overwrite the inset source, it is shrunk aside first
+        for (uint32_t p = 0; out->addr == second->addr && p < count; p++) {
+            plan->sharedScratch += (size_t)(planes[p].rowBytes / 2) * (planes[p].rows / 2);
+        }
+        plan->phases = plan->sharedScratch != 0 ? 2 : 1;    // 2: shrink, then compose
+    }
+    return 0;
+}
+
+static void ComposeCopy(const IppMergePlan *plan, uint32_t plane, const PlaneShape *shape, uint32_t begin,
+    uint32_t end)
+{
+    if (plan->out.addr != plan->first.addr) {
+        CopyPlane(PlaneRow(&plan->out, plane, begin), plan->out.stride, PlaneRow(&plan->first, plane, begin),
+            plan->first.stride, shape->rowBytes, end - begin);
+    }
+}
+
+static void ComposeSideBySide(const IppMergePlan *plan, uint32_t plane, const PlaneShape *shape, uint32_t begin,
+    uint32_t end, uint8_t *row)
+{
+    uint32_t half = shape->rowBytes / 2;
+    int rightInPlace = plan->out.addr == plan->second.addr;
+    for (uint32_t r = begin; r < end; r++) {
+        uint8_t *dst = PlaneRow(&plan->out, plane, r);
+        if (rightInPlace) {
+            IppMergeHalveRowSimd(row, PlaneRow(&plan->second, plane, r), shape->rowBytes, shape->pairing);
+            IppMergeHalveRowSimd(dst, PlaneRow(&plan->first, plane, r), shape->rowBytes, shape->pairing);
+            (void)memcpy_s(dst + half, half, row, half);
+        } else {
+            IppMergeHalveRowSimd(dst, PlaneRow(&plan->first, plane, r), shape->rowBytes, shape->pairing);
+            IppMergeHalveRowSimd(dst + half, PlaneRow(&plan->second, plane, r), shape->rowBytes, shape->pairing);
+        }
+    }
+}
+
+// the shrunk inset of one plane in the shared scratch
+static uint8_t *ShrunkPlane(const IppMergePlan *plan, const PlaneShape *planes, uint32_t plane)
+{
+    uint8_t *shrunk = plan->shared;
+    for (uint32_t p = 0; p < plane; p++) {
+        shrunk += (size_t)(planes[p].rowBytes / 2) * (planes[p].rows / 2);
+    }
+    return shrunk;
+}
+
+static void ComposePictureInPicture(const IppMergePlan *plan, const PlaneShape *planes, uint32_t plane,
+    uint32_t begin, uint32_t end, uint8_t *row)
+{
+    const PlaneShape *shape = &planes[plane];
+    ComposeCopy(plan, plane, shape, begin, end);
+    uint32_t x = 0;
+    uint32_t y = 0;
+    IppMergeInsetOrigin(plan->out.width, plan->out.height, &x, &y);
+    uint32_t top = y / shape->rowDiv;
+    uint32_t first = begin > top ? begin : top;
+    uint32_t last = end < top + shape->rows / 2 ? end : top + shape->rows / 2;
+    if (first >= last) {
+        return;
+    }
+    uint8_t *dst = PlaneRow(&plan->out, plane, first) + x * shape->bytesPerPixel;
+    uint32_t half = shape->rowBytes / 2;
+    if (plan->phases > 1) {
+        CopyPlane(dst, plan->out.stride, ShrunkPlane(plan, planes, plane) + (size_t)(first - top) * half, half,
+            half, last - first);
+    } else {
+        ShrinkRows(dst, plan->out.stride, &plan->second, plane, shape, first - top, last - top, row);
+    }
+}
+
+void IppMergeRunBand(const IppMergePlan *plan, uint32_t phase, uint32_t rowBegin, uint32_t rowEnd,
+    uint8_t *bandScratch)
+{
+    PlaneShape planes[MAX_PLANES];
+    uint32_t count = GetPlanes(plan->format, plan->out.width, plan->out.height, planes);
+    rowEnd = rowEnd < plan->out.height ? rowEnd : plan->out.height;
+    for (uint32_t p = 0; p < count && rowBegin < rowEnd; p++) {
+        const PlaneShape *shape = &planes[p];
+        uint32_t begin = rowBegin / shape->rowDiv;
+        uint32_t end = rowEnd / shape->rowDiv;
+        if (phase + 1 < plan->phases) {
+            // the inset source rows of the band, into the rows they shrink to
+            uint32_t half = shape->rowBytes / 2;
+            ShrinkRows(ShrunkPlane(plan, planes, p) + (size_t)(begin / 2) * half, half, &plan->second, p, shape,
+                begin / 2, end / 2, bandScratch);
+            continue;
+        }
+        switch (plan->layout) {
+            case IPP_MERGE_SIDE_BY_SIDE:
+                ComposeSideBySide(plan, p, shape, begin, end, bandScratch);
+                break;
+            case IPP_MERGE_PICTURE_IN_PICTURE:
+                ComposePictureInPicture(plan, planes, p, begin, end, bandScratch);
+                break;
+            case IPP_MERGE_BLEND:
+                for (uint32_t r = begin; r < end; r++) {
+                    IppMergeBlendRowSimd(PlaneRow(&plan->out, p, r), PlaneRow(&plan->first, p, r),
+                        PlaneRow(&plan->second, p, r), shape->rowBytes, plan->weight);
+                }
+                break;
+            default:
+                ComposeCopy(plan, p, shape, begin, end);
+                break;
+        }
+    }
+}
+
+// the whole picture as one band
+static int RunSerial(IppMergeLayout layout, IppMergeFormat format, const IppMergeImage *out,
+    const IppMergeImage *first, const IppMergeImage *second, uint32_t weight, IppMergeScratch *scratch)
+{
+    IppMergePlan plan;
+    if (IppMergePlanMerge(&plan, layout, format, out, first, second, weight) != 0) {
+        return -1;
+    }
+    size_t bytes = plan.bandScratch + plan.sharedScratch;
+    uint8_t *band = bytes != 0 ? IppMergeReserveScratch(scratch, bytes) : NULL;
+    if (bytes != 0 && band == NULL) {
+        return -1;
+    }
+    plan.shared = band != NULL ? band + plan.bandScratch : NULL;
+    for (uint32_t phase = 0; phase < plan.phases; phase++) {
+        IppMergeRunBand(&plan, phase, 0, out->height, band);
+    }
+    return 0;
+}
+
+int IppMergeCopy(const IppMergeImage *out, const IppMergeImage *in, IppMergeFormat format)
+{
+    return RunSerial(IPP_MERGE_COPY, format, out, in, NULL, 0, NULL);
+}
+
+int IppMergeSideBySide(const IppMergeImage *out, const IppMergeImage *left, const IppMergeImage *right,
+    IppMergeFormat format, IppMergeScratch *scratch)
+{
+    return RunSerial(IPP_MERGE_SIDE_BY_SIDE, format, out, left, right, 0, scratch);
+}
+
+int IppMergePictureInPicture(const IppMergeImage *out, const IppMergeImage *base, const IppMergeImage *inset,
+    IppMergeFormat format, IppMergeScratch *scratch)
+{
+    return RunSerial(IPP_MERGE_PICTURE_IN_PICTURE, format, out, base, inset, 0, scratch);
+}
+
+int IppMergeBlend(const IppMergeImage *out, const IppMergeImage *a, const IppMergeImage *b, IppMergeFormat format,
+    uint32_t weight)
+{
+    return RunSerial(IPP_MERGE_BLEND, format, out, a, b, weight, NULL);
+}
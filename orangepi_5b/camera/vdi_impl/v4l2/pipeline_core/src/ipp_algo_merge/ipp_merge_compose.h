@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_IPP_MERGE_COMPOSE_H
+#define HOS_CAMERA_IPP_MERGE_COMPOSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    IPP_MERGE_YUYV = 0,     // packed 4:2:2, what the example plugin assumed
+    IPP_MERGE_NV12,         // the chroma plane follows the luma rows at stride * height
+} IppMergeFormat;
+
+typedef enum {
+    IPP_MERGE_SIDE_BY_SIDE = 0,     // both pictures squeezed to half width, the first on the left
+    IPP_MERGE_PICTURE_IN_PICTURE,   // the second at half size over the lower right of the first
+    IPP_MERGE_BLEND,                // the two mixed with a fixed weight
+    IPP_MERGE_COPY,                 // one input copied through, not a configurable layout
+} IppMergeLayout;
+
+// band edges in luma rows: whole NV12 chroma rows and whole row pairs of a halved inset
+#define IPP_MERGE_BAND_ALIGN 4u
+
+// one picture, stride is the distance between rows in bytes
+typedef struct {
+    uint8_t *addr;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t size;
+} IppMergeImage;
+
+// grown on demand and kept between frames, a picture in picture over its own source needs a copy of it
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} IppMergeScratch;
+
+// at least size bytes, NULL when they cannot be had
+uint8_t *IppMergeReserveScratch(IppMergeScratch *scratch, size_t size);
+void IppMergeReleaseScratch(IppMergeScratch *scratch);
+
+// 0 when the picture fits its buffer and the kernels: width and height multiples of 4
+int IppMergeCheckImage(const IppMergeImage *image, IppMergeFormat format);
+
+/*
+ * All of these write out, which may be either input as long as the strides match, and return 0 or -1
+ * when the pictures do not have the same size.
+ */
+int IppMergeCopy(const IppMergeImage *out, const IppMergeImage *in, IppMergeFormat format);
+int IppMergeSideBySide(const IppMergeImage *out, const IppMergeImage *left, const IppMergeImage *right,
+    IppMergeFormat format, IppMergeScratch *scratch);
+int IppMergePictureInPicture(const IppMergeImage *out, const IppMergeImage *base, const IppMergeImage *inset,
+    IppMergeFormat format, IppMergeScratch *scratch);
+int IppMergeBlend(const IppMergeImage *out, const IppMergeImage *a, const IppMergeImage *b, IppMergeFormat format,
+    uint32_t weight);
+
+/*
+ * One merge cut into bands of output rows, for running it on several threads. IppMergePlanMerge checks the
+ * pictures like the functions above and works out the scratch; IppMergeRunBand then writes the output rows
+ * [rowBegin, rowEnd), edges on IPP_MERGE_BAND_ALIGN. The bands of a phase may run in any order and at once,
+ * each with bandScratch bytes of its own, and give the same bytes as a single band over the whole picture.
+ * The phases run one after the other.
+ */
+typedef struct {
+    IppMergeLayout layout;
+    IppMergeFormat format;
+    IppMergeImage out;
+    IppMergeImage first;
+    IppMergeImage second;       // unused by IPP_MERGE_COPY
+    uint32_t weight;
+    uint32_t phases;            // 2 when an inset over its own source is shrunk aside first
+    size_t bandScratch;
+    size_t sharedScratch;       // for the caller to point shared at before the first phase
+    uint8_t *shared;
+} IppMergePlan;
+
+int IppMergePlanMerge(IppMergePlan *plan, IppMergeLayout layout, IppMergeFormat format, const IppMergeImage *out,
+    const IppMergeImage *first, const IppMergeImage *second, uint32_t weight);
+void IppMergeRunBand(const IppMergePlan *plan, uint32_t phase, uint32_t rowBegin, uint32_t rowEnd,
+    uint8_t *bandScratch);
+
+// where the inset of IppMergePictureInPicture goes, in pixels of the output
+void IppMergeInsetOrigin(uint32_t width, uint32_t height, uint32_t *x, uint32_t *y);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ipp_merge_kernels.h"
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IPP_MERGE_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define IPP_MERGE_USE_SSE2 1
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define IPP_MERGE_USE_SSSE3 1
+#endif
+#endif
+
+#define PAIR_GROUP_IN 16
+#define PAIR_GROUP_OUT 8
+#define SIMD_WIDTH 16
+#define FULL_WEIGHT 256
+#define WEIGHT_SHIFT 8
+#define WEIGHT_ROUND 128
+
+// the two source bytes of each output byte within a group of 16
+static const uint8_t PAIR_FIRST[IPP_MERGE_PAIR_COUNT][PAIR_GROUP_OUT] = {
+    {0, 2, 4, 6, 8, 10, 12, 14},
+    {0, 1, 4, 5, 8, 9, 12, 13},
+    {0, 1, 4, 3, 8, 9, 12, 11},     // Y0 Y1 averaged, U0 U1, Y2 Y3, V0 V1
+};
+static const uint8_t PAIR_SECOND[IPP_MERGE_PAIR_COUNT][PAIR_GROUP_OUT] = {
+    {1, 3, 5, 7, 9, 11, 13, 15},
+    {2, 3, 6, 7, 10, 11, 14, 15},
+    {2, 5, 6, 7, 10, 13, 14, 15},
+};
+static const size_t PAIR_PERIOD[IPP_MERGE_PAIR_COUNT] = {2, 4, 8};
+
+size_t IppMergePairingPeriod(IppMergePairing pairing)
+{
+    return pairing < IPP_MERGE_PAIR_COUNT ? PAIR_PERIOD[pairing] : 0;
+}
+
+const char *IppMergeSimdName(void)
+{
+#if defined(IPP_MERGE_USE_NEON)
+    return "neon";
+#elif defined(IPP_MERGE_USE_SSSE3)
+    return "ssse3";
+#elif defined(IPP_MERGE_USE_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void IppMergeHalveRowScalar(uint8_t *dst, const uint8_t *src, size_t inBytes, IppMergePairing pairing)
+{
+    if (pairing >= IPP_MERGE_PAIR_COUNT) {
+        return;
+    }
+    const uint8_t *first = PAIR_FIRST[pairing];
+    const uint8_t *second = PAIR_SECOND[pairing];
+    size_t outBytes = inBytes / 2;
+    for (size_t i = 0; i < outBytes; i++) {
+        const uint8_t *group = src + (i / PAIR_GROUP_OUT) * PAIR_GROUP_IN;
+        size_t k = i % PAIR_GROUP_OUT;
+        dst[i] = (uint8_t)((group[first[k]] + group[second[k]] + 1) >> 1);
+    }
+}
+
+void IppMergeHalveRowSimd(uint8_t *dst, const uint8_t *src, size_t inBytes, IppMergePairing pairing)
+{
+    if (pairing >= IPP_MERGE_PAIR_COUNT) {
+        return;
+    }
+    size_t done = 0;
+#if defined(IPP_MERGE_USE_NEON)
+    const uint8x8_t first = vld1_u8(PAIR_FIRST[pairing]);
+    const uint8x8_t second = vld1_u8(PAIR_SECOND[pairing]);
+    for (; done + PAIR_GROUP_IN <= inBytes; done += PAIR_GROUP_IN) {
+        uint8x16_t group = vld1q_u8(src + done);
+        vst1_u8(dst + done / 2, vrhadd_u8(vqtbl1_u8(group, first), vqtbl1_u8(group, second)));
+    }
+#elif defined(IPP_MERGE_USE_SSSE3)
+    // 0x80 clears the upper half of the shuffled group
+    uint8_t firstMask[SIMD_WIDTH];
+    uint8_t secondMask[SIMD_WIDTH];
+    memset(firstMask, 0x80, sizeof(firstMask));
+    memset(secondMask, 0x80, sizeof(secondMask));
+    memcpy(firstMask, PAIR_FIRST[pairing], PAIR_GROUP_OUT);
+    memcpy(secondMask, PAIR_SECOND[pairing], PAIR_GROUP_OUT);
+    const __m128i first = _mm_loadu_si128((const __m128i *)firstMask);
+    const __m128i second = _mm_loadu_si128((const __m128i *)secondMask);
+    for (; done + PAIR_GROUP_IN <= inBytes; done += PAIR_GROUP_IN) {
+        __m128i group = _mm_loadu_si128((const __m128i *)(src + done));
+        _mm_storel_epi64((__m128i *)(dst + done / 2),
+            _mm_avg_epu8(_mm_shuffle_epi8(group, first), _mm_shuffle_epi8(group, second)));
+    }
+#endif
+    IppMergeHalveRowScalar(dst + done / 2, src + done, inBytes - done, pairing);
+}
+
+void IppMergeAverageRowsScalar(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; i++) {
+        dst[i] = (uint8_t)((a[i] + b[i] + 1) >> 1);
+    }
+}
+
+void IppMergeAverageRowsSimd(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t bytes)
+{
+    size_t done = 0;
+#if defined(IPP_MERGE_USE_NEON)
+    for (; done + SIMD_WIDTH <= bytes; done += SIMD_WIDTH) {
+        vst1q_u8(dst + done, vrhaddq_u8(vld1q_u8(a + done), vld1q_u8(b + done)));
+    }
+#elif defined(IPP_MERGE_USE_SSE2)
+    for (; done + SIMD_WIDTH <= bytes; done += SIMD_WIDTH) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + done));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + done));
+        _mm_storeu_si128((__m128i *)(dst + done), _mm_avg_epu8(va, vb));
+    }
+#endif
+    IppMergeAverageRowsScalar(dst + done, a + done, b + done, bytes - done);
+}
+
+void IppMergeBlendRowScalar(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t bytes, uint32_t weight)
+{
+    uint32_t wb = weight > FULL_WEIGHT ? FULL_WEIGHT : weight;
+    uint32_t wa = FULL_WEIGHT - wb;
+    for (size_t i = 0; i < bytes; i++) {
+        dst[i] = (uint8_t)((a[i] * wa + b[i] * wb + WEIGHT_ROUND) >> WEIGHT_SHIFT);
+    }
+}
+
+void IppMergeBlendRowSimd(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t bytes, uint32_t weight)
+{
+    // the end points are plain copies, and keep the vector weights within 8 bits
+    if (weight == 0 || weight >= FULL_WEIGHT) {
+        const uint8_t *src = weight == 0 ? a : b;
+        if (dst != src && bytes != 0) {
+            memmove(dst, src, bytes);
+        }
+        return;
+    }
+    size_t done = 0;
+#if defined(IPP_MERGE_USE_NEON)
+    const uint8x8_t wa = vdup_n_u8((uint8_t)(FULL_WEIGHT - weight));
+    const uint8x8_t wb = vdup_n_u8((uint8_t)weight);
+    for (; done + SIMD_WIDTH <= bytes; done += SIMD_WIDTH) {
+        uint8x16_t va = vld1q_u8(a + done);
+        uint8x16_t vb = vld1q_u8(b + done);
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(va), wa), vget_low_u8(vb), wb);
+        uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(va), wa), vget_high_u8(vb), wb);
+        vst1q_u8(dst + done, vcombine_u8(vrshrn_n_u16(lo, WEIGHT_SHIFT), vrshrn_n_u16(hi, WEIGHT_SHIFT)));
+    }
+#elif defined(IPP_MERGE_USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wa = _mm_set1_epi16((short)(FULL_WEIGHT - weight));
+    const __m128i wb = _mm_set1_epi16((short)weight);
+    const __m128i round = _mm_set1_epi16(WEIGHT_ROUND);
+    for (; done + SIMD_WIDTH <= bytes; done += SIMD_WIDTH) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + done));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + done));
+        // at most 255 * 256 + 128, the 16 bit lanes do not wrap
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+            _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+            _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), WEIGHT_SHIFT);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), WEIGHT_SHIFT);
+        _mm_storeu_si128((__m128i *)(dst + done), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    IppMergeBlendRowScalar(dst + done, a + done, b + done, bytes - done, weight);
+}
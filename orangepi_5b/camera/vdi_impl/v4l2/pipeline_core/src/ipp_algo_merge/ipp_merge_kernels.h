@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_IPP_MERGE_KERNELS_H
+#define HOS_CAMERA_IPP_MERGE_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// how the bytes of a row pair up when it is halved horizontally, every 16 bytes in give 8 out
+typedef enum {
+    IPP_MERGE_PAIR_LUMA = 0,    // a Y plane: neighbouring samples
+    IPP_MERGE_PAIR_UV,          // NV12 chroma: neighbouring U/V pairs
+    IPP_MERGE_PAIR_YUYV,        // packed 4:2:2: two macropixels into one
+    IPP_MERGE_PAIR_COUNT,
+} IppMergePairing;
+
+// bytes one pairing step consumes, the row length has to be a multiple of it
+size_t IppMergePairingPeriod(IppMergePairing pairing);
+
+// the vector unit the Simd kernels use: "neon", "ssse3", "sse2" or "scalar"
+const char *IppMergeSimdName(void);
+
+/*
+ * dst[i] = (a + b + 1) >> 1 of the two src bytes the pairing maps to output byte i, for inBytes / 2
+ * bytes. dst may be src: every output byte is written after the bytes it reads.
+ */
+void IppMergeHalveRowScalar(uint8_t *dst, const uint8_t *src, size_t inBytes, IppMergePairing pairing);
+void IppMergeHalveRowSimd(uint8_t *dst, const uint8_t *src, size_t inBytes, IppMergePairing pairing);
+
+// dst[i] = (a[i] + b[i] + 1) >> 1, dst may be a or b
+void IppMergeAverageRowsScalar(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t bytes);
+void IppMergeAverageRowsSimd(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t bytes);
+
+// dst[i] = (a[i] * (256 - weight) + b[i] * weight + 128) >> 8 for a weight up to 256, dst may be a or b
+void IppMergeBlendRowScalar(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t bytes, uint32_t weight);
+void IppMergeBlendRowSimd(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t bytes, uint32_t weight);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
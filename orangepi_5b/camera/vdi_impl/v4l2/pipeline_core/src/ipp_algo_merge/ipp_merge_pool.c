@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define _GNU_SOURCE
+#include "ipp_merge_pool.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define CACHE_LINE 64
+#define RANGE_SHIFT 32
+#define RANGE_MASK 0xffffffffu
+#define SYSFS_PATH_LEN 96
+#define SYSFS_BASE 10
+
+// the bands a thread has left, the next in the low half and the end in the high half, one cache line each
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint64_t range;
+} BandQueue;
+
+struct IppMergePool {
+    BandQueue queues[IPP_MERGE_POOL_MAX_THREADS];
+    uint32_t threads;
+    uint32_t started;
+    pthread_t workers[IPP_MERGE_POOL_MAX_THREADS];
+    cpu_set_t cpus;
+    int pinned;
+    pthread_mutex_t runLock;    // one run at a time
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    uint64_t generation;        // bumped by every run
+    uint32_t running;           // workers still busy with the current run
+    int stopping;
+    IppMergeBandFunc func;
+    void *context;
+};
+
+typedef struct {
+    IppMergePool *pool;
+    uint32_t index;
+} WorkerArg;
+
+static uint64_t PackRange(uint32_t next, uint32_t end)
+{
+    return ((uint64_t)end << RANGE_SHIFT) | next;
+}
+
+// the owner takes from the front, a thief from the back, so each keeps its neighbouring rows
+static int TakeBand(BandQueue *queue, int steal, uint32_t *band)
+{
+    uint64_t range = atomic_load_explicit(&queue->range, memory_order_acquire);
+    for (;;) {
+        uint32_t next = (uint32_t)(range & RANGE_MASK);
+        uint32_t end = (uint32_t)(range >> RANGE_SHIFT);
+        if (next >= end) {
+            return 0;
+        }
+        uint64_t left = steal ? PackRange(next, end - 1) : PackRange(next + 1, end);
+        if (atomic_compare_exchange_weak_explicit(&queue->range, &range, left, memory_order_acq_rel,
+            memory_order_acquire)) {
+            *band = steal ? end - 1 : next;
+            return 1;
+        }
+    }
+}
+
+static void WorkBands(IppMergePool *pool, uint32_t index)
+{
+    uint32_t band = 0;
+    while (TakeBand(&pool->queues[index], 0, &band)) {
+        pool->func(pool->context, band, index);
+    }
+    for (uint32_t i = 1; i < pool->threads; i++) {
+        BandQueue *victim = &pool->queues[(index + i) % pool->threads];
+        while (TakeBand(victim, 1, &band)) {
+            pool->func(pool->context, band, index);
+        }
+    }
+}
+
+static void *WorkerLoop(void *data)
+{
+    WorkerArg arg = *(WorkerArg *)data;
+    free(data);
+    IppMergePool *pool = arg.pool;
+    if (pool->pinned) {
+        (void)sched_setaffinity(0, sizeof(pool->cpus), &pool->cpus);
+    }
+    uint64_t seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stopping) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        WorkBands(pool, arg.index);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+IppMergePool *IppMergePoolCreate(uint32_t threads, const uint32_t *cpus, uint32_t cpuCount)
+{
+    if (threads == 0 || threads > IPP_MERGE_POOL_MAX_THREADS) {
+        return NULL;
+    }
+    IppMergePool *pool = (IppMergePool *)calloc(1, sizeof(IppMergePool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->threads = threads;
+    CPU_ZERO(&pool->cpus);
+    for (uint32_t i = 0; cpus != NULL && i < cpuCount; i++) {
+        CPU_SET(cpus[i], &pool->cpus);
+        pool->pinned = 1;
+    }
+    pthread_mutex_init(&pool->runLock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (uint32_t i = 0; i + 1 < threads; i++) {
+        WorkerArg *arg = (WorkerArg *)malloc(sizeof(WorkerArg));
+        if (arg == NULL) {
+            break;
+        }
+        arg->pool = pool;
+        arg->index = i;
+        if (pthread_create(&pool->workers[i], NULL, WorkerLoop, arg) != 0) {
+            free(arg);
+            break;
+        }
+        pool->started++;
+    }
+    // the caller takes the index after the last worker that came up
+    pool->threads = pool->started + 1;
+    return pool;
+}
+
+void IppMergePoolDestroy(IppMergePool *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for (uint32_t i = 0; i < pool->started; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->runLock);
+    free(pool);
+}
+
+uint32_t IppMergePoolThreads(const IppMergePool *pool)
+{
+    return pool != NULL ? pool->threads : 1;
+}
+
+void IppMergePoolRun(IppMergePool *pool, uint32_t bands, IppMergeBandFunc func, void *context)
+{
+    pthread_mutex_lock(&pool->runLock);
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func;
+    pool->context = context;
+    for (uint32_t i = 0; i < pool->threads; i++) {
+        uint32_t begin = (uint32_t)((uint64_t)bands * i / pool->threads);
+        uint32_t end = (uint32_t)((uint64_t)bands * (i + 1) / pool->threads);
+        atomic_store_explicit(&pool->queues[i].range, PackRange(begin, end), memory_order_relaxed);
+    }
+    pool->running = pool->started;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    WorkBands(pool, pool->threads - 1);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running != 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->runLock);
+}
+
+static long ReadCpuValue(uint32_t cpu, const char *file)
+{
+    char path[SYSFS_PATH_LEN];
+    if (snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/%s", cpu, file) <= 0) {
+        return -1;
+    }
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    char text[SYSFS_PATH_LEN] = {0};
+    long value = fgets(text, sizeof(text), fp) != NULL ? strtol(text, NULL, SYSFS_BASE) : -1;
+    fclose(fp);
+    return value;
+}
+
+uint32_t IppMergeBigCores(uint32_t *cpus, uint32_t maxCpus)
+{
+    static const char *const SOURCES[] = {"cpu_capacity", "cpufreq/cpuinfo_max_freq"};
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    for (size_t s = 0; s < sizeof(SOURCES) / sizeof(SOURCES[0]); s++) {
+        long best = -1;
+        uint32_t count = 0;
+        for (uint32_t cpu = 0; cpu < (uint32_t)configured && cpu < CPU_SETSIZE; cpu++) {
+            long value = ReadCpuValue(cpu, SOURCES[s]);
+            if (value > best) {
+                best = value;
+                count = 0;
+            }
+            if (value == best && value > 0 && count < maxCpus) {
+                cpus[count++] = cpu;
+            }
+        }
+        if (count != 0) {
+            return count;
+        }
+    }
+    return 0;
+}
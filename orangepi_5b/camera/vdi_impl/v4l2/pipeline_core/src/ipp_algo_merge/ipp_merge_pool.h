@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_IPP_MERGE_POOL_H
+#define HOS_CAMERA_IPP_MERGE_POOL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IPP_MERGE_POOL_MAX_THREADS 16
+
+// one band of a run, worker is the index of the thread running it, below IppMergePoolThreads
+typedef void (*IppMergeBandFunc)(void *context, uint32_t band, uint32_t worker);
+
+typedef struct IppMergePool IppMergePool;
+
+/*
+ * threads - 1 workers kept for the life of the pool, the thread calling IppMergePoolRun is the last one.
+ * The workers are held to cpus when there are any, the caller is left where it is.
+ */
+IppMergePool *IppMergePoolCreate(uint32_t threads, const uint32_t *cpus, uint32_t cpuCount);
+void IppMergePoolDestroy(IppMergePool *pool);
+uint32_t IppMergePoolThreads(const IppMergePool *pool);
+
+/*
+ * Runs func once for every band in [0, bands) and returns when all have run. Each thread starts on its own
+ * run of neighbouring bands and, when that is done, steals from the far end of the others', so a thread that
+ * was late to wake or sits on a slow core holds up no one. Runs from several callers take turns.
+ */
+void IppMergePoolRun(IppMergePool *pool, uint32_t bands, IppMergeBandFunc func, void *context);
+
+// the cpus of the highest capacity, the A76 cores of the RK3588; 0 when sysfs does not say
+uint32_t IppMergeBigCores(uint32_t *cpus, uint32_t maxCpus);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
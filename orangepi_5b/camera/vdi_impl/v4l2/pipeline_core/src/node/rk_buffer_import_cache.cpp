@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_buffer_import_cache.h"
+#include <algorithm>
+
+namespace OHOS::Camera {
+RKBufferImportCache::RKBufferImportCache(size_t capacity, const ImportFunc& importer, const ReleaseFunc& releaser)
+    : capacity_(std::max<size_t>(capacity, 1)), importer_(importer), releaser_(releaser)
+{
+}
+
+RKBufferImportCache::~RKBufferImportCache()
+{
+    Clear();
+}
+
+void* RKBufferImportCache::Get(const ImportKey& key)
+{
+    useCount_++;
+    auto it = entries_.find({key.fd, key.index});
+    if (it != entries_.end()) {
+        if (it->second.addr == key.addr && it->second.size == key.size) {
+            stats_.hits++;
+            it->second.lastUse = useCount_;
+            return it->second.handle;
+        }
+        // the fd was closed and handed out again for another buffer
+        Evict(it);
+    }
+
+    stats_.misses++;
+    if (entries_.size() >= capacity_) {
+        auto oldest = std::min_element(entries_.begin(), entries_.end(), [](const auto& a, const auto& b) {
+            return a.second.lastUse < b.second.lastUse;
+        });
+        Evict(oldest);
+    }
+
+    void* handle = importer_(key);
+    if (handle == nullptr) {
+        stats_.failures++;
+        return nullptr;
+    }
+    Entry entry;
+    entry.addr = key.addr;
+    entry.size = key.size;
+    entry.handle = handle;
+    entry.lastUse = useCount_;
+    entries_[{key.fd, key.index}] = entry;
+    stats_.cached = static_cast<uint32_t>(entries_.size());
+    return handle;
+}
+
+void RKBufferImportCache::Clear()
+{
+    for (auto& it : entries_) {
+        releaser_(it.second.handle);
+    }
+    entries_.clear();
+    stats_.cached = 0;
+}
+
+BufferImportStats RKBufferImportCache::GetStats() const
+{
+    return stats_;
+}
+
+void RKBufferImportCache::Evict(std::map<std::pair<int32_t, int32_t>, Entry>::iterator it)
+{
+    releaser_(it->second.handle);
+    entries_.erase(it);
+    stats_.evictions++;
+    stats_.cached = static_cast<uint32_t>(entries_.size());
+}
+} // namespace OHOS::Camera
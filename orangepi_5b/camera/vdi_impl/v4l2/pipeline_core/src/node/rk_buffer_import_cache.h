@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_BUFFER_IMPORT_CACHE_H
+#define HOS_CAMERA_RK_BUFFER_IMPORT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+
+namespace OHOS::Camera {
+// a camera buffer as the importer sees it, fd and index identify it and addr/size tell a reused fd apart
+struct ImportKey {
+    int32_t fd = -1;
+    int32_t index = -1;
+    void* addr = nullptr;
+    size_t size = 0;
+};
+
+struct BufferImportStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;     // dropped for room, or because the fd now maps another buffer
+    uint64_t failures = 0;
+    uint32_t cached = 0;
+};
+
+/*
+ * Keeps the imports of the camera buffers of one stream so that each dma fd is registered with the
+ * hardware once instead of on every frame. The stream cycles through a small fixed set of buffers,
+ * the least recently used import goes when a new buffer shows up and the cache is full.
+ * Not thread safe, the owner serializes access.
+ */
+class RKBufferImportCache {
+public:
+    using ImportFunc = std::function<void*(const ImportKey& key)>;
+    using ReleaseFunc = std::function<void(void* handle)>;
+
+    RKBufferImportCache(size_t capacity, const ImportFunc& importer, const ReleaseFunc& releaser);
+    ~RKBufferImportCache();
+
+    // the imported handle of the buffer, nullptr when the import failed
+    void* Get(const ImportKey& key);
+    void Clear();
+    BufferImportStats GetStats() const;
+
+private:
+    struct Entry {
+        void* addr = nullptr;
+        size_t size = 0;
+        void* handle = nullptr;
+        uint64_t lastUse = 0;
+    };
+
+    void Evict(std::map<std::pair<int32_t, int32_t>, Entry>::iterator it);
+
+    size_t capacity_ = 0;
+    ImportFunc importer_;
+    ReleaseFunc releaser_;
+    std::map<std::pair<int32_t, int32_t>, Entry> entries_;
+    uint64_t useCount_ = 0;
+    BufferImportStats stats_;
+};
+} // namespace OHOS::Camera
+#endif
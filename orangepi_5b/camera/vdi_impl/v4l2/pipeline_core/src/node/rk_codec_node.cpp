@@ -12,33 +12,84 @@
  */
 
 #include "rk_codec_node.h"
+#include <algorithm>
 #include <securec.h>
+#include <unistd.h>
 #include "camera_dump.h"
-
-extern "C" {
-#include <jpeglib.h>
-#include <transupp.h>
-}
+#include "rk_node_params.h"
+#include "rk_vendor_tags.h"
 
 namespace OHOS::Camera {
 const unsigned long long TIME_CONVERSION_NS_S = 1000000000ULL; /* ns to s */
+const int64_t TIME_CONVERSION_NS_US = 1000; /* ns to us */
+const int32_t JPEG_DEFAULT_WORKERS = 4;  /* one per A76 core */
+const int32_t JPEG_QUEUE_PER_WORKER = 2;
+
+static int64_t GetMonotonicUs()
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * (TIME_CONVERSION_NS_S / TIME_CONVERSION_NS_US) +
+        ts.tv_nsec / TIME_CONVERSION_NS_US;
+}
+
+static int64_t GetMonotonicNs()
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * TIME_CONVERSION_NS_S + ts.tv_nsec;
+}
+
+static bool ToJpegBackend(int32_t value, JpegBackendType& type)
+{
+    if (value < static_cast<int32_t>(JpegBackendType::MPP) || value > static_cast<int32_t>(JpegBackendType::LIBJPEG)) {
+        return false;
+    }
+    type = static_cast<JpegBackendType>(value);
+    return true;
+}
 
 RKCodecNode::RKCodecNode(const std::string& name, const std::string& type, const std::string &cameraId)
-    : NodeBase(name, type, cameraId)
+    : NodeBase(name, type, cameraId), videoEncoder_(CreateMppVideoEncoder)
 {
     CAMERA_LOGV("%{public}s enter, type(%{public}s)\n", name_.c_str(), type_.c_str());
-    jpegRotation_ = static_cast<uint32_t>(JXFORM_ROT_270);
+    jpegRotation_ = RgaRotation::ROT_270;
     jpegQuality_ = 100; // 100:jpeg quality
 }
 
 RKCodecNode::~RKCodecNode()
 {
+    // joining the pool runs whatever is still queued before the worker contexts go away
+    jpegPool_ = nullptr;
+    for (auto& worker : jpegWorkers_) {
+        ReleaseJpegWorker(worker);
+    }
+    ReleaseJpegWorker(jpegSyncWorker_);
+    std::atomic_store(&streams_, std::shared_ptr<const StreamContexts>(std::make_shared<const StreamContexts>()));
     CAMERA_LOGI("~RKCodecNode Node exit.");
 }
 
 RetCode RKCodecNode::Start(const int32_t streamId)
 {
     CAMERA_LOGI("RKCodecNode::Start streamId = %{public}d\n", streamId);
+    portTable_.Build(GetOutPorts());
+    std::unique_lock<std::mutex> l(streamLock_);
+    StreamSettings* settings = FindSettings(streamId);
+    if (settings == nullptr) {
+        return RC_ERROR;
+    }
+    videoEncoder_.Open(streamId);
+    if (FindStream(streamId) != nullptr) {
+        return RC_OK;
+    }
+    auto ctx = std::make_shared<StreamContext>();
+    ctx->settings = *settings;
+    ctx->rga = RKRgaSession::Acquire(streamId);
+    if (ctx->rga != nullptr) {
+        // every path of this node syncs before touching the frame, upstream nodes can defer theirs
+        ctx->rga->SetDeferredConsumer(true);
+    }
+    PublishStream(streamId, ctx);
     return RC_OK;
 }
 
@@ -46,12 +97,39 @@ RetCode RKCodecNode::Stop(const int32_t streamId)
 {
     CAMERA_LOGI("RKCodecNode::Stop streamId = %{public}d\n", streamId);
 
-    if (halCtx_ != nullptr) {
-        CAMERA_LOGI("RKCodecNode::Stop hal_mpp_ctx_delete\n");
-        hal_mpp_ctx_delete(halCtx_);
-        halCtx_ = nullptr;
-        mppStatus_ = 0;
+    RKWorkerPool* pool = nullptr;
+    {
+        std::unique_lock<std::mutex> l(jpegPoolLock_);
+        pool = jpegPool_.get();
+    }
+    if (pool != nullptr) {
+        // every still of the stream has to be encoded and returned before it stops
+        pool->Drain(streamId);
+        [[maybe_unused]] WorkerPoolStats stats = pool->GetStats();
+        CAMERA_LOGI("RKCodecNode::Stop jpeg pool: %{public}llu encoded, max depth %{public}u, "
+            "%{public}llu blocked, wait avg %{public}llu us, encode avg %{public}llu us, max latency %{public}llu us",
+            stats.completed, stats.maxDepth, stats.blocked, stats.totalWaitUs / std::max<uint64_t>(stats.completed, 1),
+            stats.totalRunUs / std::max<uint64_t>(stats.completed, 1), stats.maxLatencyUs);
+    }
+
+    // a frame still in the node keeps the context, and with it the session and staging, until it returns
+    std::shared_ptr<StreamContext> ctx = nullptr;
+    {
+        std::unique_lock<std::mutex> l(streamLock_);
+        ctx = FindStream(streamId);
+        if (ctx != nullptr) {
+            PublishStream(streamId, nullptr);
+            if (ctx->rga != nullptr) {
+                ctx->rga->SetDeferredConsumer(false);
+                RKRgaSession::Release(streamId);
+            }
+        }
     }
+    if (ctx != nullptr) {
+        LogLatency(streamId, *ctx);
+    }
+
+    videoEncoder_.Close(streamId);
 
     return RC_OK;
 }
@@ -62,52 +140,6 @@ RetCode RKCodecNode::Flush(const int32_t streamId)
     return RC_OK;
 }
 
-static void RotJpegImg(
-    const unsigned char *inputImg, size_t inputSize, unsigned char **outImg, size_t *outSize, JXFORM_CODE rotDegrees)
-{
-    struct jpeg_decompress_struct inputInfo;
-    struct jpeg_error_mgr jerrIn;
-    struct jpeg_compress_struct outInfo;
-    struct jpeg_error_mgr jerrOut;
-    jvirt_barray_ptr *src_coef_arrays;
-    jvirt_barray_ptr *dst_coef_arrays;
-
-    inputInfo.err = jpeg_std_error(&jerrIn);
-    jpeg_create_decompress(&inputInfo);
-    outInfo.err = jpeg_std_error(&jerrOut);
-    jpeg_create_compress(&outInfo);
-    jpeg_mem_src(&inputInfo, inputImg, inputSize);
-    jpeg_mem_dest(&outInfo, outImg, (unsigned long *)outSize);
-
-    JCOPY_OPTION copyoption;
-    jpeg_transform_info transformoption;
-    transformoption.transform = rotDegrees;
-    transformoption.perfect = TRUE;
-    transformoption.trim = FALSE;
-    transformoption.force_grayscale = FALSE;
-    transformoption.crop = FALSE;
-
-    jcopy_markers_setup(&inputInfo, copyoption);
-    (void)jpeg_read_header(&inputInfo, TRUE);
-
-    if (!jtransform_request_workspace(&inputInfo, &transformoption)) {
-        CAMERA_LOGE("%s: transformation is not perfect", __func__);
-        return;
-    }
-
-    src_coef_arrays = jpeg_read_coefficients(&inputInfo);
-    jpeg_copy_critical_parameters(&inputInfo, &outInfo);
-    dst_coef_arrays = jtransform_adjust_parameters(&inputInfo, &outInfo, src_coef_arrays, &transformoption);
-    jpeg_write_coefficients(&outInfo, dst_coef_arrays);
-    jcopy_markers_execute(&inputInfo, &outInfo, copyoption);
-    jtransform_execute_transformation(&inputInfo, &outInfo, src_coef_arrays, &transformoption);
-
-    jpeg_finish_compress(&outInfo);
-    jpeg_destroy_compress(&outInfo);
-    (void)jpeg_finish_decompress(&inputInfo);
-    jpeg_destroy_decompress(&inputInfo);
-}
-
 RetCode RKCodecNode::ConfigJpegOrientation(common_metadata_header_t* data)
 {
     camera_metadata_item_t entry;
@@ -117,18 +149,18 @@ RetCode RKCodecNode::ConfigJpegOrientation(common_metadata_header_t* data)
         return RC_OK;
     }
 
-    JXFORM_CODE jxRotation = JXFORM_ROT_270;
+    RgaRotation rotation = RgaRotation::ROT_270;
     int32_t ohosRotation = *entry.data.i32;
     if (ohosRotation == OHOS_CAMERA_JPEG_ROTATION_0) {
-        jxRotation = JXFORM_NONE;
+        rotation = RgaRotation::ROT_0;
     } else if (ohosRotation == OHOS_CAMERA_JPEG_ROTATION_90) {
-        jxRotation = JXFORM_ROT_90;
+        rotation = RgaRotation::ROT_90;
     } else if (ohosRotation == OHOS_CAMERA_JPEG_ROTATION_180) {
-        jxRotation = JXFORM_ROT_180;
+        rotation = RgaRotation::ROT_180;
     } else {
-        jxRotation = JXFORM_ROT_270;
+        rotation = RgaRotation::ROT_270;
     }
-    jpegRotation_ = static_cast<uint32_t>(jxRotation);
+    jpegRotation_ = rotation;
     return RC_OK;
 }
 
@@ -171,283 +203,756 @@ RetCode RKCodecNode::Config(const int32_t streamId, const CaptureMeta& meta)
         return RC_ERROR;
     }
 
+    {
+        std::unique_lock<std::mutex> l(streamLock_);
+        if (FindSettings(streamId) == nullptr) {
+            return RC_ERROR;
+        }
+    }
+
     RetCode rc = ConfigJpegOrientation(data);
 
     rc = ConfigJpegQuality(data);
-    return rc;
+    if (rc != RC_OK) {
+        return rc;
+    }
+    rc = ConfigJpegBackend(streamId, data);
+    if (rc != RC_OK) {
+        return rc;
+    }
+    rc = ConfigJpegExifOrientation(streamId, data);
+    if (rc != RC_OK) {
+        return rc;
+    }
+    return ConfigVideoEncoder(streamId, data);
 }
 
-void RKCodecNode::encodeJpegToMemory(unsigned char* image, int width, int height,
-    const char* comment, unsigned long* jpegSize, unsigned char** jpegBuf)
+RetCode RKCodecNode::ConfigJpegBackend(const int32_t streamId, common_metadata_header_t* data)
 {
-    struct jpeg_compress_struct cInfo;
-    struct jpeg_error_mgr jErr;
-    JSAMPROW row_pointer[1];
-    int row_stride = 0;
-    constexpr uint32_t colorMap = 3;
-    constexpr uint32_t pixelsThick = 3;
+    camera_metadata_item_t entry;
+    int ret = FindCameraMetadataItem(data, RK_VENDOR_JPEG_BACKEND, &entry);
+    if (ret != 0 || entry.data.i32 == nullptr) {
+        return RC_OK;
+    }
 
-    cInfo.err = jpeg_std_error(&jErr);
+    JpegBackendType type = JpegBackendType::TURBO;
+    if (!ToJpegBackend(*entry.data.i32, type)) {
+        CAMERA_LOGW("RK_VENDOR_JPEG_BACKEND %{public}d is not a jpeg backend", *entry.data.i32);
+        return RC_OK;
+    }
+    return SetJpegBackend(streamId, type) ? RC_OK : RC_ERROR;
+}
 
-    jpeg_create_compress(&cInfo);
-    cInfo.image_width = width;
-    cInfo.image_height = height;
-    cInfo.input_components = colorMap;
-    cInfo.in_color_space = JCS_RGB;
+RetCode RKCodecNode::ConfigJpegExifOrientation(const int32_t streamId, common_metadata_header_t* data)
+{
+    camera_metadata_item_t entry;
+    int ret = FindCameraMetadataItem(data, RK_VENDOR_JPEG_EXIF_ORIENTATION, &entry);
+    if (ret != 0 || entry.data.i32 == nullptr) {
+        return RC_OK;
+    }
+    return SetJpegExifOrientation(streamId, *entry.data.i32 != 0) ? RC_OK : RC_ERROR;
+}
 
-    jpeg_set_defaults(&cInfo);
-    CAMERA_LOGE("RKCodecNode::encodeJpegToMemory jpegQuality_ is = %{public}d", jpegQuality_);
-    jpeg_set_quality(&cInfo, jpegQuality_, TRUE);
-    jpeg_mem_dest(&cInfo, jpegBuf, jpegSize);
-    jpeg_start_compress(&cInfo, TRUE);
+// every tag is optional, whatever is missing keeps its current value
+RetCode RKCodecNode::ConfigVideoEncoder(const int32_t streamId, common_metadata_header_t* data)
+{
+    const uint32_t rangeCount = 2;
+    VideoEncConfig config = GetVideoEncConfig(streamId);
+    camera_metadata_item_t entry;
+    int ret = FindCameraMetadataItem(data, RK_VENDOR_VIDEO_RC_MODE, &entry);
+    if (ret == 0 && entry.data.i32 != nullptr && !ToVideoRcMode(*entry.data.i32, config.rcMode)) {
+        CAMERA_LOGW("RK_VENDOR_VIDEO_RC_MODE %{public}d is not a rate control mode", *entry.data.i32);
+    }
+    ret = FindCameraMetadataItem(data, RK_VENDOR_VIDEO_BITRATE, &entry);
+    if (ret == 0 && entry.data.i32 != nullptr) {
+        config.bitrate = *entry.data.i32;
+    }
+    ret = FindCameraMetadataItem(data, RK_VENDOR_VIDEO_GOP, &entry);
+    if (ret == 0 && entry.data.i32 != nullptr) {
+        config.gop = *entry.data.i32;
+    }
+    ret = FindCameraMetadataItem(data, RK_VENDOR_VIDEO_QP_RANGE, &entry);
+    if (ret == 0 && entry.data.i32 != nullptr && entry.count >= rangeCount) {
+        config.qpMin = entry.data.i32[0];
+        config.qpMax = entry.data.i32[1];
+    }
+    ret = FindCameraMetadataItem(data, OHOS_CONTROL_FPS_RANGES, &entry);
+    if (ret == 0 && entry.data.i32 != nullptr && entry.count >= rangeCount) {
+        config.fps = entry.data.i32[1];
+    }
+    return SetVideoEncConfig(streamId, config) ? RC_OK : RC_ERROR;
+}
 
-    if (comment) {
-        jpeg_write_marker(&cInfo, JPEG_COM, (const JOCTET*)comment, strlen(comment));
+/*
+ * One pass over the encoded access unit gives the keyframe flag, the NAL sizes and the parameter
+ * sets, which are kept per stream so the latest SPS/PPS are at hand without rescanning.
+ */
+void RKCodecNode::IndexEsFrame(std::shared_ptr<IBuffer>& buffer, size_t size, NalCodec codec, VideoStreamState& state)
+{
+    const uint8_t* data = static_cast<const uint8_t*>(buffer->GetVirAddress());
+    if (data == nullptr) {
+        CAMERA_LOGI("RKCodecNode::IndexEsFrame buffer has no address");
+        return;
     }
 
-    row_stride = width;
-    while (cInfo.next_scanline < cInfo.image_height) {
-        row_pointer[0] = &image[cInfo.next_scanline * row_stride * pixelsThick];
-        jpeg_write_scanlines(&cInfo, row_pointer, 1);
+    // only the stream's own state is locked, other streams keep delivering meanwhile
+    std::unique_lock<std::mutex> l(state.lock);
+    IndexNalUnits(data, size, codec, state.nalIndex);
+    buffer->SetEsKeyFrame(state.nalIndex.keyFrame ? 1 : 0);
+    if (state.nalIndex.hasParameterSets) {
+        ExtractParameterSets(data, state.nalIndex, codec, state.parameterSets);
     }
 
-    jpeg_finish_compress(&cInfo);
-    jpeg_destroy_compress(&cInfo);
+    for ([[maybe_unused]] const NalUnit& unit : state.nalIndex.units) {
+        CAMERA_LOGD("RKCodecNode::IndexEsFrame nal type %{public}u offset %{public}zu size %{public}zu",
+            unit.type, unit.offset, unit.size);
+    }
+    CAMERA_LOGV("RKCodecNode::IndexEsFrame %{public}zu nal units, key frame %{public}d, size %{public}zu",
+        state.nalIndex.units.size(), state.nalIndex.keyFrame, size);
+}
 
-    size_t rotJpgSize = 0;
-    unsigned char* rotJpgBuf = nullptr;
-    /* rotate image */
-    RotJpegImg(*jpegBuf, *jpegSize, &rotJpgBuf, &rotJpgSize, static_cast<JXFORM_CODE>(jpegRotation_));
-    if (rotJpgBuf != nullptr && rotJpgSize != 0) {
-        free(*jpegBuf);
-        *jpegBuf = rotJpgBuf;
-        *jpegSize = rotJpgSize;
+std::vector<uint8_t> RKCodecNode::GetParameterSets(const int32_t streamId)
+{
+    std::shared_ptr<StreamContext> ctx = FindStream(streamId);
+    if (ctx == nullptr) {
+        return std::vector<uint8_t>();
     }
+    std::unique_lock<std::mutex> l(ctx->videoState->lock);
+    return ctx->videoState->parameterSets;
 }
 
-int RKCodecNode::findStartCode(unsigned char *data, size_t dataSz)
+void RKCodecNode::RecordLatency(const VideoFrameContext& video, const FrameTimes& times)
 {
-    constexpr uint32_t dataSize = 4;
-    constexpr uint32_t dataBit2 = 2;
-    constexpr uint32_t dataBit3 = 3;
+    if (times.captureNs <= 0) {
+        video.state->unstampedFrames++;
+    }
+    video.latency->Record(times);
+}
 
-    if (data == nullptr) {
-        CAMERA_LOGI("RKCodecNode::findStartCode paramater == nullptr");
-        return -1;
+LatencySummary RKCodecNode::GetLatency(const int32_t streamId, LatencyStage stage)
+{
+    std::shared_ptr<StreamContext> ctx = FindStream(streamId);
+    return ctx == nullptr ? LatencySummary() : ctx->latency->Summarize(stage);
+}
+
+void RKCodecNode::LogLatency(const int32_t streamId, StreamContext& ctx)
+{
+    {
+        std::unique_lock<std::mutex> l(ctx.lock);
+        CAMERA_LOGI("RKCodecNode::Stop streamId = %{public}d rgba frames = %{public}llu copied = %{public}llu\n",
+            streamId, ctx.frames, ctx.totalCopyBytes);
+    }
+    for (uint32_t i = 0; i < static_cast<uint32_t>(LatencyStage::COUNT); i++) {
+        LatencyStage stage = static_cast<LatencyStage>(i);
+        LatencySummary summary = ctx.latency->Summarize(stage);
+        if (summary.count == 0) {
+            continue;
+        }
+        CAMERA_LOGI("RKCodecNode::Stop streamId = %{public}d %{public}s: %{public}llu frames, mean %{public}llu us, "
+            "p50 %{public}llu p90 %{public}llu p99 %{public}llu max %{public}llu us", streamId,
+            RKPipelineLatency::StageName(stage), summary.count, summary.meanUs, summary.p50Us, summary.p90Us,
+            summary.p99Us, summary.maxUs);
+    }
+    uint64_t unstampedFrames = ctx.videoState->unstampedFrames.load();
+    if (unstampedFrames != 0) {
+        CAMERA_LOGW("RKCodecNode::Stop streamId = %{public}d %{public}llu frames had no capture timestamp",
+            streamId, unstampedFrames);
     }
+}
 
-    if ((dataSz > dataSize) && (data[0] == 0) && (data[1] == 0) && \
-        (data[dataBit2] == 0) && (data[dataBit3] == 1)) {
-        return 4; // 4:start node
+/*
+ * Settings are loaded from the stream parameters once, when the stream is first configured or started,
+ * and from then on only Config and the setters change them; Stop leaves them for the next Start.
+ * A stream without a port on this node has none, the caller fails.
+ */
+RKCodecNode::StreamSettings* RKCodecNode::FindSettings(const int32_t streamId)
+{
+    auto it = settings_.find(streamId);
+    if (it != settings_.end()) {
+        return &it->second;
+    }
+    if (portTable_.Find(streamId, [this] { return GetOutPorts(); }) == nullptr) {
+        CAMERA_LOGE("RKCodecNode stream %{public}d has no port on this node", streamId);
+        return nullptr;
     }
 
-    return -1;
+    StreamSettings& settings = settings_[streamId];
+    settings.zeroCopy = GetRkNodeStreamParam(RK_PARAM_RGBA_ZERO_COPY, streamId, 1) != 0;
+    int32_t backend = GetRkNodeStreamParam(RK_PARAM_JPEG_BACKEND, streamId,
+        static_cast<int32_t>(JpegBackendType::TURBO));
+    if (!ToJpegBackend(backend, settings.jpegBackend)) {
+        CAMERA_LOGW("RKCodecNode stream %{public}d unknown jpeg backend %{public}d", streamId, backend);
+    }
+    settings.exifOrientation = GetRkNodeStreamParam(RK_PARAM_JPEG_EXIF_ORIENTATION, streamId, 0) != 0;
+    settings.exifApp1 = GetRkNodeStreamParam(RK_PARAM_JPEG_EXIF_APP1, streamId, 1) != 0;
+    int32_t rcMode = GetRkNodeStreamParam(RK_PARAM_VIDEO_RC_MODE, streamId, static_cast<int32_t>(VideoRcMode::VBR));
+    if (!ToVideoRcMode(rcMode, settings.video.rcMode)) {
+        CAMERA_LOGW("RKCodecNode stream %{public}d unknown video rc mode %{public}d", streamId, rcMode);
+    }
+    settings.video.bitrate = GetRkNodeStreamParam(RK_PARAM_VIDEO_BITRATE, streamId, 0);
+    settings.video.gop = GetRkNodeStreamParam(RK_PARAM_VIDEO_GOP, streamId, 0);
+    return &settings;
 }
 
-static constexpr uint32_t nalBit = 0x1F;
+// the kept settings and the copy the running stream reads, false for a stream without a port here
+bool RKCodecNode::UpdateSettings(const int32_t streamId, const std::function<void(StreamSettings&)>& update)
+{
+    std::unique_lock<std::mutex> l(streamLock_);
+    StreamSettings* settings = FindSettings(streamId);
+    if (settings == nullptr) {
+        return false;
+    }
+    update(*settings);
+    std::shared_ptr<StreamContext> ctx = FindStream(streamId);
+    if (ctx != nullptr) {
+        std::unique_lock<std::mutex> cl(ctx->lock);
+        ctx->settings = *settings;
+    }
+    return true;
+}
 
-void RKCodecNode::SerchIFps(unsigned char* buf, size_t bufSize, std::shared_ptr<IBuffer>& buffer)
+// one atomic load, the frame paths of different streams never wait on each other here
+std::shared_ptr<RKCodecNode::StreamContext> RKCodecNode::FindStream(const int32_t streamId)
 {
-    size_t nalType = 0;
-    size_t idx = 0;
-    size_t size = bufSize;
-    constexpr uint32_t nalTypeValue = 0x05;
+    std::shared_ptr<const StreamContexts> streams = std::atomic_load(&streams_);
+    auto it = streams->find(streamId);
+    return it == streams->end() ? nullptr : it->second;
+}
 
-    if (buffer == nullptr || buf == nullptr) {
-        CAMERA_LOGI("RKCodecNode::SerchIFps paramater == nullptr");
-        return;
+// called under streamLock_, nullptr takes the stream out
+void RKCodecNode::PublishStream(const int32_t streamId, const std::shared_ptr<StreamContext>& ctx)
+{
+    auto next = std::make_shared<StreamContexts>(*std::atomic_load(&streams_));
+    if (ctx == nullptr) {
+        next->erase(streamId);
+    } else {
+        (*next)[streamId] = ctx;
     }
+    std::atomic_store(&streams_, std::shared_ptr<const StreamContexts>(std::move(next)));
+}
 
-    for (int i = 0; i < bufSize; i++) {
-        int ret = findStartCode(buf + idx, size);
-        if (ret == -1) {
-            idx += 1;
-            size -= 1;
-        } else {
-            nalType = ((buf[idx + ret]) & nalBit);
-            CAMERA_LOGI("ForkNode::ForkBuffers nalu == 0x%{public}x buf == 0x%{public}x \n", nalType, buf[idx + ret]);
-            if (nalType == nalTypeValue) {
-                buffer->SetEsKeyFrame(1);
-                CAMERA_LOGI("ForkNode::ForkBuffers SetEsKeyFrame == 1 nalu == 0x%{public}x\n", nalType);
-                break;
-            } else {
-                idx += ret;
-                size -= ret;
-            }
-        }
+bool RKCodecNode::GetVideoFrameContext(const int32_t streamId, VideoFrameContext& video)
+{
+    std::shared_ptr<StreamContext> ctx = FindStream(streamId);
+    if (ctx == nullptr) {
+        return false;
+    }
+    video.rga = ctx->rga;
+    video.latency = ctx->latency;
+    video.state = ctx->videoState;
+    std::unique_lock<std::mutex> l(ctx->lock);
+    video.config = ctx->settings.video;
+    return true;
+}
 
-        if (idx >= bufSize) {
-            break;
-        }
+bool RKCodecNode::SetRgbaZeroCopy(const int32_t streamId, bool enable)
+{
+    if (!UpdateSettings(streamId, [enable](StreamSettings& settings) { settings.zeroCopy = enable; })) {
+        return false;
+    }
+    std::shared_ptr<StreamContext> ctx = FindStream(streamId);
+    if (!enable && ctx != nullptr) {
+        std::unique_lock<std::mutex> l(ctx->lock);
+        ReleaseStaging(ctx->rga, ctx->staging);
     }
+    return true;
+}
 
-    if (idx >= bufSize) {
-        buffer->SetEsKeyFrame(0);
-        CAMERA_LOGI("ForkNode::ForkBuffers SetEsKeyFrame == 0 nalu == 0x%{public}x idx = %{public}d\n",
-            nalType, idx);
+uint64_t RKCodecNode::GetRgbaCopyBytes(const int32_t streamId)
+{
+    std::shared_ptr<StreamContext> ctx = FindStream(streamId);
+    if (ctx == nullptr) {
+        return 0;
     }
+    std::unique_lock<std::mutex> l(ctx->lock);
+    return ctx->copyBytes;
 }
 
-void RKCodecNode::Yuv420ToRGBA8888(std::shared_ptr<IBuffer>& buffer)
+WorkerPoolStats RKCodecNode::GetJpegQueueStats()
 {
-    if (buffer == nullptr) {
-        CAMERA_LOGI("RKCodecNode::Yuv420ToRGBA8888 buffer == nullptr");
+    std::unique_lock<std::mutex> l(jpegPoolLock_);
+    return jpegPool_ == nullptr ? WorkerPoolStats() : jpegPool_->GetStats();
+}
+
+bool RKCodecNode::SetJpegExifOrientation(const int32_t streamId, bool enable)
+{
+    return UpdateSettings(streamId, [enable](StreamSettings& settings) { settings.exifOrientation = enable; });
+}
+
+bool RKCodecNode::SetVideoEncConfig(const int32_t streamId, const VideoEncConfig& config)
+{
+    return UpdateSettings(streamId, [&config](StreamSettings& settings) { settings.video = config; });
+}
+
+VideoEncConfig RKCodecNode::GetVideoEncConfig(const int32_t streamId)
+{
+    std::unique_lock<std::mutex> l(streamLock_);
+    auto it = settings_.find(streamId);
+    return it == settings_.end() ? VideoEncConfig() : it->second.video;
+}
+
+VideoEncoderPoolStats RKCodecNode::GetVideoPoolStats(const int32_t streamId)
+{
+    std::shared_ptr<VideoEncoderSession> session = videoEncoder_.Get(streamId);
+    if (session == nullptr) {
+        return VideoEncoderPoolStats();
+    }
+    std::unique_lock<std::mutex> l(session->encodeLock);
+    return session->encoder->GetPoolStats();
+}
+
+bool RKCodecNode::SetJpegBackend(const int32_t streamId, JpegBackendType type)
+{
+    return UpdateSettings(streamId, [type](StreamSettings& settings) { settings.jpegBackend = type; });
+}
+
+bool RKCodecNode::PrepareStaging(const std::shared_ptr<RKRgaSession>& rga, RgaStaging& staging,
+    uint32_t width, uint32_t height)
+{
+    if (staging.buffer.handle != nullptr && staging.width == width && staging.height == height) {
+        return true;
+    }
+    ReleaseStaging(rga, staging);
+
+    if (rga == nullptr || rga->AllocBuffer(width, height, RgaPixelFormat::YUV420P, staging.buffer) != 0) {
+        CAMERA_LOGE("RKCodecNode::PrepareStaging alloc %{public}u x %{public}u failed", width, height);
+        return false;
+    }
+    staging.width = width;
+    staging.height = height;
+    return true;
+}
+
+void RKCodecNode::ReleaseStaging(const std::shared_ptr<RKRgaSession>& rga, RgaStaging& staging)
+{
+    if (staging.buffer.handle == nullptr || rga == nullptr) {
         return;
     }
+    rga->FreeBuffer(staging.buffer);
+    staging.width = 0;
+    staging.height = 0;
+}
 
+uint64_t RKCodecNode::Yuv420ToRGBA8888Copy(std::shared_ptr<IBuffer>& buffer, StreamContext& ctx)
+{
     int dma_fd = buffer->GetFileDescriptor();
+    ctx.rga->Sync();
     void* temp = malloc(buffer->GetSize());
     if (temp == nullptr) {
         CAMERA_LOGI("RKCodecNode::Yuv420ToRGBA8888 malloc buffer == nullptr");
-        return;
+        return 0;
     }
 
     int ret = memcpy_s(temp, buffer->GetSize(), (const void *)buffer->GetVirAddress(), buffer->GetSize());
     if (ret == 0) {
         buffer->SetEsFrameSize(buffer->GetSize());
     } else {
-        printf("memcpy_s failed!\n");
+        CAMERA_LOGE("RKCodecNode::Yuv420ToRGBA8888 memcpy_s failed");
         buffer->SetEsFrameSize(0);
     }
-    RockchipRga rkRga;
-
-    rga_info_t src = {};
-    rga_info_t dst = {};
 
-    src.fd = -1;
-    src.mmuFlag = 1;
-    src.rotation = 0;
-    src.virAddr = (void *)temp;
-
-    dst.fd = dma_fd;
-    dst.mmuFlag = 1;
-    dst.virAddr = 0;
-
-    rga_set_rect(&src.rect, 0, 0, buffer->GetWidth(), buffer->GetHeight(),
-        buffer->GetWidth(), buffer->GetHeight(), RK_FORMAT_YCbCr_420_P);
-    rga_set_rect(&dst.rect, 0, 0, buffer->GetWidth(), buffer->GetHeight(),
-        buffer->GetWidth(), buffer->GetHeight(), RK_FORMAT_RGBA_8888);
-
-    rkRga.RkRgaBlit(&src, &dst, NULL);
-    rkRga.RkRgaFlush();
+    RgaJob job;
+    job.src = MakeRgaSurface(-1, temp, buffer->GetWidth(), buffer->GetHeight(), RgaPixelFormat::YUV420P);
+    job.dst = MakeRgaSurface(dma_fd, buffer->GetVirAddress(), buffer->GetWidth(), buffer->GetHeight(),
+        RgaPixelFormat::RGBA8888);
+    if (ctx.rga->Sync(ctx.rga->Queue(job)) != 0) {
+        CAMERA_LOGE("RKCodecNode::Yuv420ToRGBA8888Copy rga csc failed");
+    }
     free(temp);
+    return ret == 0 ? buffer->GetSize() : 0;
 }
 
-void RKCodecNode::Yuv420ToJpeg(std::shared_ptr<IBuffer>& buffer)
+/*
+ * The RGBA output is larger than the YUV input and both live in the same dma buffer, so the
+ * conversion cannot run in place. Instead of a cpu copy, RGA first moves the YUV frame into a
+ * per-stream staging buffer and then converts it back into the camera buffer: fd to fd both ways,
+ * queued behind whatever the upstream nodes left in the stream session and run as one batch.
+ */
+bool RKCodecNode::Yuv420ToRGBA8888ZeroCopy(std::shared_ptr<IBuffer>& buffer, StreamContext& ctx)
 {
-    constexpr uint32_t RGB24Width = 3;
+    int dma_fd = buffer->GetFileDescriptor();
+    uint32_t width = buffer->GetWidth();
+    uint32_t height = buffer->GetHeight();
+    if (dma_fd < 0 || !PrepareStaging(ctx.rga, ctx.staging, width, height)) {
+        return false;
+    }
+
+    RgaSurface frame = MakeRgaSurface(dma_fd, buffer->GetVirAddress(), width, height, RgaPixelFormat::YUV420P);
+    RgaSurface staging = MakeRgaSurface(ctx.staging.buffer.fd, ctx.staging.buffer.virAddr, width, height,
+        RgaPixelFormat::YUV420P);
+
+    // the frame may still be written by an upstream job of the batch, and the two jobs below read
+    // and write each other's buffers, so each one waits for whatever was queued before it
+    RgaJob stage;
+    stage.src = frame;
+    stage.dst = staging;
+    stage.waitPrevious = true;
+
+    RgaJob csc;
+    csc.src = staging;
+    csc.dst = frame;
+    csc.dst.format = RgaPixelFormat::RGBA8888;
+    csc.waitPrevious = true;
+
+    // one batch with what the upstream nodes left queued, its result covers their jobs as well
+    if (ctx.rga->Sync(ctx.rga->Queue({stage, csc})) != 0) {
+        CAMERA_LOGE("RKCodecNode::Yuv420ToRGBA8888ZeroCopy rga batch failed");
+        return false;
+    }
+    buffer->SetEsFrameSize(buffer->GetSize());
+    return true;
+}
 
+void RKCodecNode::Yuv420ToRGBA8888(std::shared_ptr<IBuffer>& buffer)
+{
     if (buffer == nullptr) {
-        CAMERA_LOGI("RKCodecNode::Yuv420ToJpeg buffer == nullptr");
+        CAMERA_LOGI("RKCodecNode::Yuv420ToRGBA8888 buffer == nullptr");
         return;
     }
 
-    int dma_fd = buffer->GetFileDescriptor();
-    unsigned char* jBuf = nullptr;
-    unsigned long jpegSize = 0;
-    uint32_t tempSize = (buffer->GetWidth() * buffer->GetHeight() * RGB24Width);
-
-    void* temp = malloc(tempSize);
-    if (temp == nullptr) {
-        CAMERA_LOGI("RKCodecNode::Yuv420ToJpeg malloc buffer == nullptr");
+    // the session is acquired in Start(), a frame of a stream that is not running is passed on as it is
+    std::shared_ptr<StreamContext> stream = FindStream(buffer->GetStreamId());
+    if (stream == nullptr || stream->rga == nullptr) {
+        CAMERA_LOGW("RKCodecNode::Yuv420ToRGBA8888 stream %{public}d is not started", buffer->GetStreamId());
         return;
     }
+    // only this stream's lock, the staging buffer is shared by its frames
+    StreamContext& ctx = *stream;
+    std::unique_lock<std::mutex> l(ctx.lock);
+    uint64_t copyBytes = 0;
+    if (!ctx.settings.zeroCopy || !Yuv420ToRGBA8888ZeroCopy(buffer, ctx)) {
+        copyBytes = Yuv420ToRGBA8888Copy(buffer, ctx);
+    }
+
+    ctx.frames++;
+    ctx.copyBytes = copyBytes;
+    ctx.totalCopyBytes += copyBytes;
+    CAMERA_LOGV("RKCodecNode::Yuv420ToRGBA8888 streamId = %{public}d copied %{public}llu bytes\n",
+        buffer->GetStreamId(), copyBytes);
+}
+
+// called with ctx.lock held
+RKCodecNode::JpegTask RKCodecNode::MakeJpegTask(StreamContext& ctx)
+{
+    JpegTask task;
+    task.backend = ctx.settings.jpegBackend;
+    task.rotation = jpegRotation_.load();
+    task.exifOrientation = ctx.settings.exifOrientation;
+    task.exifApp1 = ctx.settings.exifApp1;
+    task.quality = jpegQuality_.load();
+    task.frameNum = ctx.jpegFrames++;
+    return task;
+}
+
+int32_t RKCodecNode::EncodeJpeg(JpegWorkerContext& worker, const int32_t streamId, JpegBackendType backend,
+    const JpegInput& in, JpegOutput& out)
+{
+    if (worker.jpeg == nullptr || worker.jpeg->GetType() != backend) {
+        worker.jpeg = CreateJpegEncoder(backend, worker.rga);
+        if (worker.jpeg == nullptr && backend != JpegBackendType::LIBJPEG) {
+            CAMERA_LOGE("RKCodecNode::EncodeJpeg %{public}s unavailable, use libjpeg", JpegBackendName(backend));
+            SetJpegBackend(streamId, JpegBackendType::LIBJPEG);
+            worker.jpeg = CreateJpegEncoder(JpegBackendType::LIBJPEG, worker.rga);
+        }
+        if (worker.jpeg == nullptr) {
+            return -1;
+        }
+    }
 
-    RockchipRga rkRga;
-    rga_info_t src = {};
-    rga_info_t dst = {};
+    // a backend that is there but fails one frame fails only that frame, the next still uses it
+    if (worker.jpeg->Encode(in, out) != 0) {
+        CAMERA_LOGE("RKCodecNode::EncodeJpeg %{public}s failed", worker.jpeg->GetName());
+        return -1;
+    }
+    return 0;
+}
 
-    src.mmuFlag = 1;
-    src.rotation = 0;
-    src.virAddr = 0;
-    src.fd = dma_fd;
+/*
+ * The picture is turned on the YUV frame before encoding: RGA writes the rotated frame into the
+ * worker staging buffer and the encoder reads it from there. This replaces the coefficient
+ * transcode that used to run on every encoded jpeg.
+ */
+bool RKCodecNode::RotateForJpeg(JpegWorkerContext& worker, RgaRotation rotation, JpegInput& in)
+{
+    bool swap = rotation == RgaRotation::ROT_90 || rotation == RgaRotation::ROT_270;
+    uint32_t width = swap ? in.height : in.width;
+    uint32_t height = swap ? in.width : in.height;
+    // the cpu encoders read the rotated frame, so the staging buffer needs a mapping as well as an fd
+    if (!PrepareStaging(worker.rga, worker.staging, width, height) || worker.staging.buffer.virAddr == nullptr) {
+        return false;
+    }
 
-    dst.fd = -1;
-    dst.mmuFlag = 1;
-    dst.virAddr = temp;
+    RgaJob job;
+    job.src = MakeRgaSurface(in.fd, in.yuv, in.width, in.height, RgaPixelFormat::YUV420P);
+    job.dst = MakeRgaSurface(worker.staging.buffer.fd, worker.staging.buffer.virAddr, width, height,
+        RgaPixelFormat::YUV420P);
+    job.rotation = rotation;
+    if (worker.rga->Sync(worker.rga->Queue(job)) != 0) {
+        CAMERA_LOGE("RKCodecNode::RotateForJpeg rga rotate failed");
+        return false;
+    }
 
-    rga_set_rect(&src.rect, 0, 0, buffer->GetWidth(), buffer->GetHeight(),
-        buffer->GetWidth(), buffer->GetHeight(), RK_FORMAT_YCbCr_420_P);
-    rga_set_rect(&dst.rect, 0, 0, buffer->GetWidth(), buffer->GetHeight(),
-        buffer->GetWidth(), buffer->GetHeight(), RK_FORMAT_RGB_888);
+    in.fd = worker.staging.buffer.fd;
+    in.yuv = static_cast<uint8_t*>(worker.staging.buffer.virAddr);
+    in.width = width;
+    in.height = height;
+    return true;
+}
 
-    rkRga.RkRgaBlit(&src, &dst, NULL);
-    rkRga.RkRgaFlush();
-    encodeJpegToMemory((unsigned char *)temp, buffer->GetWidth(), buffer->GetHeight(), nullptr, &jpegSize, &jBuf);
+/*
+ * Copies the jpeg into the camera buffer with an Exif segment right after SOI: the full fixed size
+ * segment when asked, which RKExifNode later fills in without moving the picture, or else just the
+ * Orientation tag when the pixels were not turned.
+ */
+size_t RKCodecNode::OutputJpeg(std::shared_ptr<IBuffer>& buffer, const JpegOutput& out, const ExifFields& exif,
+    bool exifApp1)
+{
+    constexpr size_t soiSize = 2;
+    uint8_t* dst = static_cast<uint8_t*>(buffer->GetVirAddress());
+    size_t capacity = buffer->GetSize();
+    if ((!exifApp1 && exif.orientation == ExifOrientation::NORMAL) || out.size < soiSize) {
+        return memcpy_s(dst, capacity, out.data, out.size) == 0 ? out.size : 0;
+    }
 
-    int ret = memcpy_s((unsigned char*)buffer->GetVirAddress(), buffer->GetSize(), jBuf, jpegSize);
-    if (ret == 0) {
-        buffer->SetEsFrameSize(jpegSize);
+    size_t app1Size = exifApp1 ? ExifApp1Size() : ExifOrientationApp1Size();
+    size_t jpegSize = out.size + app1Size;
+    if (capacity < jpegSize) {
+        CAMERA_LOGE("RKCodecNode::OutputJpeg jpeg %{public}zu exceeds buffer %{public}zu", jpegSize, capacity);
+        return 0;
+    }
+    dst[0] = out.data[0];
+    dst[1] = out.data[1];
+    if (exifApp1) {
+        WriteExifApp1(dst + soiSize, app1Size, exif);
     } else {
-        CAMERA_LOGI("memcpy_s failed, ret = %{public}d\n", ret);
+        WriteExifOrientationApp1(dst + soiSize, app1Size, exif.orientation);
+    }
+    if (memcpy_s(dst + soiSize + app1Size, capacity - soiSize - app1Size, out.data + soiSize,
+        out.size - soiSize) != 0) {
+        return 0;
+    }
+    return jpegSize;
+}
+
+// the stream session has been synced by the caller, the worker only uses its own RGA session
+void RKCodecNode::EncodeJpegFrame(std::shared_ptr<IBuffer>& buffer, const JpegTask& task,
+    JpegWorkerContext& worker)
+{
+    JpegStageTimes times;
+    int64_t begin = GetMonotonicUs();
+    if (worker.rga == nullptr) {
+        worker.rga = RKRgaSession::Create();
+    }
+
+    JpegInput in;
+    in.fd = buffer->GetFileDescriptor();
+    in.yuv = static_cast<uint8_t*>(buffer->GetVirAddress());
+    in.width = buffer->GetWidth();
+    in.height = buffer->GetHeight();
+    in.quality = task.quality;
+
+    RgaRotation exifRotation = RgaRotation::ROT_0;
+    if (task.rotation != RgaRotation::ROT_0) {
+        if (task.exifOrientation || worker.rga == nullptr || !RotateForJpeg(worker, task.rotation, in)) {
+            exifRotation = task.rotation;
+        }
+    }
+    int64_t stage = GetMonotonicUs();
+    times.rotateUs = stage - begin;
+
+    // the encoder reads the camera buffer when nothing was rotated, the jpeg is built aside
+    size_t worst = JpegWorstCaseSize(in.width, in.height);
+    if (worker.jpegOut.size() < worst) {
+        worker.jpegOut.resize(worst);
+    }
+    JpegOutput out;
+    out.data = worker.jpegOut.data();
+    out.capacity = worker.jpegOut.size();
+    buffer->SetEsFrameNum(task.frameNum);
+    if (EncodeJpeg(worker, buffer->GetStreamId(), task.backend, in, out) != 0) {
+        CAMERA_LOGE("RKCodecNode::EncodeJpegFrame encode failed");
         buffer->SetEsFrameSize(0);
+        return;
     }
+    int64_t now = GetMonotonicUs();
+    times.encodeUs = now - stage;
+    stage = now;
+
+    ExifFields exif;
+    exif.orientation = ToExifOrientation(exifRotation);
+    exif.width = in.width;
+    exif.height = in.height;
+    FormatExifDateTime(static_cast<int64_t>(time(nullptr)), exif.dateTime);
+    size_t jpegSize = OutputJpeg(buffer, out, exif, task.exifApp1);
+    buffer->SetEsFrameSize(jpegSize);
+    now = GetMonotonicUs();
+    times.outputUs = now - stage;
+
+    CAMERA_LOGI("RKCodecNode::EncodeJpegFrame frame %{public}d %{public}s %{public}ux%{public}u "
+        "jpegSize = %{public}zu exif = %{public}d rotate %{public}lld encode %{public}lld output %{public}lld "
+        "total %{public}lld us\n", task.frameNum, worker.jpeg->GetName(), in.width, in.height,
+        jpegSize, exifRotation != RgaRotation::ROT_0, times.rotateUs, times.encodeUs, times.outputUs, now - begin);
+}
 
-    free(jBuf);
-    free(temp);
+void RKCodecNode::ReleaseJpegWorker(JpegWorkerContext& worker)
+{
+    worker.jpeg = nullptr;
+    ReleaseStaging(worker.rga, worker.staging);
+    worker.rga = nullptr;
+    std::vector<uint8_t>().swap(worker.jpegOut);
+}
+
+// synced with the upstream RGA work of the frame, the snapshot of the capture settings is taken
+bool RKCodecNode::PrepareJpegTask(std::shared_ptr<IBuffer>& buffer, JpegTask& task)
+{
+    std::shared_ptr<StreamContext> ctx = FindStream(buffer->GetStreamId());
+    if (ctx == nullptr || ctx->rga == nullptr) {
+        CAMERA_LOGW("RKCodecNode::PrepareJpegTask stream %{public}d is not started", buffer->GetStreamId());
+        return false;
+    }
+    {
+        std::unique_lock<std::mutex> l(ctx->lock);
+        task = MakeJpegTask(*ctx);
+    }
+    [[maybe_unused]] int64_t begin = GetMonotonicUs();
+    ctx->rga->Sync();
+    CAMERA_LOGV("RKCodecNode::PrepareJpegTask frame %{public}d rga sync %{public}lld us\n",
+        task.frameNum, GetMonotonicUs() - begin);
+    return true;
+}
+
+RKWorkerPool* RKCodecNode::GetJpegPool()
+{
+    std::unique_lock<std::mutex> l(jpegPoolLock_);
+    if (jpegPoolChecked_) {
+        return jpegPool_.get();
+    }
+    jpegPoolChecked_ = true;
+
+    int32_t workers = GetRkNodeParam(RK_PARAM_JPEG_WORKERS, JPEG_DEFAULT_WORKERS);
+    if (workers <= 0) {
+        CAMERA_LOGI("RKCodecNode jpeg encode runs on the delivery thread");
+        return nullptr;
+    }
+    int32_t depth = GetRkNodeParam(RK_PARAM_JPEG_QUEUE_DEPTH, workers * JPEG_QUEUE_PER_WORKER);
+    jpegWorkers_.resize(static_cast<size_t>(workers));
+    jpegPool_ = std::make_unique<RKWorkerPool>("rkjpeg", static_cast<uint32_t>(workers),
+        static_cast<uint32_t>(std::max(depth, 1)));
+    CAMERA_LOGI("RKCodecNode jpeg encode pool: %{public}d workers, queue depth %{public}d", workers, depth);
+    return jpegPool_.get();
+}
 
-    CAMERA_LOGE("RKCodecNode::Yuv420ToJpeg jpegSize = %{public}d\n", jpegSize);
+/*
+ * Stills are handed to the encode pool so a burst does not hold the delivery thread that preview and
+ * video share. The workers deliver each buffer as soon as it is encoded, so buffers of one stream may
+ * reach the port out of order; EsFrameNum carries the submission order.
+ */
+bool RKCodecNode::SubmitJpeg(std::shared_ptr<IBuffer>& buffer)
+{
+    RKWorkerPool* pool = GetJpegPool();
+    if (pool == nullptr) {
+        return false;
+    }
+    JpegTask task;
+    if (!PrepareJpegTask(buffer, task)) {
+        return false;
+    }
+
+    std::shared_ptr<IBuffer> frame = buffer;
+    pool->Submit(buffer->GetStreamId(), [this, frame, task](uint32_t worker) mutable {
+        EncodeJpegFrame(frame, task, jpegWorkers_[worker]);
+        DeliverEncoded(frame);
+    });
+    return true;
+}
+
+void RKCodecNode::Yuv420ToJpeg(std::shared_ptr<IBuffer>& buffer)
+{
+    if (buffer == nullptr) {
+        CAMERA_LOGI("RKCodecNode::Yuv420ToJpeg buffer == nullptr");
+        return;
+    }
+
+    JpegTask task;
+    if (!PrepareJpegTask(buffer, task)) {
+        return;
+    }
+    std::unique_lock<std::mutex> l(jpegSyncLock_);
+    EncodeJpegFrame(buffer, task, jpegSyncWorker_);
 }
 
-void RKCodecNode::Yuv420ToH264(std::shared_ptr<IBuffer>& buffer)
+/*
+ * The ES timestamp is the capture time the source put on the buffer (the v4l2 timestamp, CLOCK_MONOTONIC),
+ * so encoder and pipeline jitter stay out of A/V sync. Frames without one are stamped on arrival here.
+ */
+void RKCodecNode::Yuv420ToVideo(std::shared_ptr<IBuffer>& buffer, NalCodec codec, const VideoFrameContext& video,
+    FrameTimes& times)
 {
     if (buffer == nullptr) {
-        CAMERA_LOGI("RKCodecNode::Yuv420ToH264 buffer == nullptr");
+        CAMERA_LOGI("RKCodecNode::Yuv420ToVideo buffer == nullptr");
         return;
     }
 
-    int ret = 0;
     size_t buf_size = 0;
-    struct timespec ts = {};
-    int64_t timestamp = 0;
     int dma_fd = buffer->GetFileDescriptor();
+    int64_t arrivalNs = GetMonotonicNs();
+    times.captureNs = static_cast<int64_t>(buffer->GetTimestamp());
 
-    if (mppStatus_ == 0) {
-        MpiEncTestArgs args = {};
-        args.width       = buffer->GetWidth();
-        args.height      = buffer->GetHeight();
-        args.format      = MPP_FMT_YUV420P;
-        args.type        = MPP_VIDEO_CodingAVC;
-        halCtx_ = hal_mpp_ctx_create(&args);
-        if (halCtx_ == nullptr) {
-            CAMERA_LOGI("RKCodecNode::Yuv420ToH264 halCtx_ = %{public}p\n", halCtx_);
-            return;
+    if (video.rga != nullptr) {
+        video.rga->Sync();
+    }
+    // the session stays alive for this frame even if the stream is stopped meanwhile
+    std::shared_ptr<VideoEncoderSession> session = videoEncoder_.Acquire(buffer->GetStreamId(), codec,
+        buffer->GetWidth(), buffer->GetHeight());
+    if (session == nullptr) {
+        CAMERA_LOGI("RKCodecNode::Yuv420ToVideo no encoder for stream %{public}d", buffer->GetStreamId());
+        return;
+    }
+    VideoEncConfig config = video.config;
+    config.codec = codec;
+    VideoRateControl rc = ResolveVideoRateControl(config, session->width, session->height);
+
+    {
+        std::unique_lock<std::mutex> l(session->encodeLock);
+        times.encodeStartNs = GetMonotonicNs();
+        // rate control is changed on the running context, a failed update is retried with the next frame
+        if ((!session->rcApplied || rc != session->rc) && session->encoder->SetRateControl(rc)) {
+            session->rc = rc;
+            session->rcApplied = true;
         }
-        mppStatus_ = 1;
-        buf_size = ((MpiEncTestData *)halCtx_)->frame_size;
-
-        {
-            std::unique_lock<std::mutex> l(hal_mpp);
-            ret = hal_mpp_encode(halCtx_, dma_fd, (unsigned char *)buffer->GetVirAddress(), &buf_size);
+        VideoFrame frame;
+        frame.fd = dma_fd;
+        frame.index = buffer->GetIndex();
+        frame.addr = static_cast<uint8_t*>(buffer->GetVirAddress());
+        frame.size = buffer->GetSize();
+        if (session->encoder->Encode(frame, buf_size) != 0) {
+            CAMERA_LOGE("RKCodecNode::Yuv420ToVideo encode failed, stream %{public}d", buffer->GetStreamId());
+            buf_size = 0;
         }
-        SerchIFps((unsigned char *)buffer->GetVirAddress(), buf_size, buffer);
+        times.encodeEndNs = GetMonotonicNs();
+    }
 
-        buffer->SetEsFrameSize(buf_size);
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        timestamp = ts.tv_nsec + ts.tv_sec * TIME_CONVERSION_NS_S;
-        buffer->SetEsTimestamp(timestamp);
-        CAMERA_LOGI("RKCodecNode::Yuv420ToH264 video capture on\n");
-    } else {
-        if (halCtx_ == nullptr) {
-            CAMERA_LOGI("RKCodecNode::Yuv420ToH264 halCtx_ = %{public}p\n", halCtx_);
-            return;
-        }
-        buf_size = ((MpiEncTestData *)halCtx_)->frame_size;
+    IndexEsFrame(buffer, buf_size, codec, *video.state);
+    buffer->SetEsFrameSize(buf_size);
+    int64_t timestamp = times.captureNs > 0 ? times.captureNs : arrivalNs;
+    buffer->SetEsTimestamp(timestamp);
 
-        {
-            std::unique_lock<std::mutex> l(hal_mpp);
-            ret = hal_mpp_encode(halCtx_, dma_fd, (unsigned char *)buffer->GetVirAddress(), &buf_size);
-        }
+    CAMERA_LOGI("RKCodecNode::Yuv420ToVideo %{public}s size = %{public}zu timestamp = %{public}lld "
+        "encode %{public}lld us\n", codec == NalCodec::H265 ? "H265" : "H264", buf_size, timestamp,
+        (times.encodeEndNs - times.encodeStartNs) / TIME_CONVERSION_NS_US);
+}
 
-        SerchIFps((unsigned char *)buffer->GetVirAddress(), buf_size, buffer);
-        buffer->SetEsFrameSize(buf_size);
-        clock_gettime(CLOCK_MONOTONIC, &ts);
-        timestamp = ts.tv_nsec + ts.tv_sec * TIME_CONVERSION_NS_S;
-        buffer->SetEsTimestamp(timestamp);
-    }
+void RKCodecNode::DeliverEncoded(std::shared_ptr<IBuffer>& buffer)
+{
+    int32_t id = buffer->GetStreamId();
+    CameraDumper& dumper = CameraDumper::GetInstance();
+    dumper.DumpBuffer("board_RKCodecNode", ENABLE_RKCODEC_NODE_CONVERTED, buffer);
 
-    CAMERA_LOGI("ForkNode::ForkBuffers H264 size = %{public}d ret = %{public}d timestamp = %{public}lld\n",
-        buf_size, ret, timestamp);
+    IPort* port = portTable_.Find(id, [this] { return GetOutPorts(); });
+    if (port != nullptr) {
+        port->DeliverBuffer(buffer);
+        CAMERA_LOGI("RKCodecNode deliver buffer streamid = %{public}d", id);
+    }
 }
 
 void RKCodecNode::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
@@ -460,25 +965,30 @@ void RKCodecNode::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
     int32_t id = buffer->GetStreamId();
     CAMERA_LOGE("RKCodecNode::DeliverBuffer StreamId %{public}d", id);
     if (buffer->GetEncodeType() == ENCODE_TYPE_JPEG) {
+        if (SubmitJpeg(buffer)) {
+            return;
+        }
         Yuv420ToJpeg(buffer);
-    } else if (buffer->GetEncodeType() == ENCODE_TYPE_H264) {
-        Yuv420ToH264(buffer);
+    } else if (buffer->GetEncodeType() == ENCODE_TYPE_H264 || buffer->GetEncodeType() == ENCODE_TYPE_H265) {
+        // a frame of a stream that is not running is passed on as it is
+        VideoFrameContext video;
+        if (!GetVideoFrameContext(id, video)) {
+            CAMERA_LOGW("RKCodecNode::DeliverBuffer stream %{public}d is not started", id);
+            DeliverEncoded(buffer);
+            return;
+        }
+        FrameTimes times;
+        NalCodec codec = buffer->GetEncodeType() == ENCODE_TYPE_H265 ? NalCodec::H265 : NalCodec::H264;
+        Yuv420ToVideo(buffer, codec, video, times);
+        DeliverEncoded(buffer);
+        times.deliveredNs = GetMonotonicNs();
+        RecordLatency(video, times);
+        return;
     } else {
         Yuv420ToRGBA8888(buffer);
     }
 
-    CameraDumper& dumper = CameraDumper::GetInstance();
-    dumper.DumpBuffer("board_RKCodecNode", ENABLE_RKCODEC_NODE_CONVERTED, buffer);
-
-    std::vector<std::shared_ptr<IPort>> outPutPorts_;
-    outPutPorts_ = GetOutPorts();
-    for (auto& it : outPutPorts_) {
-        if (it->format_.streamId_ == id) {
-            it->DeliverBuffer(buffer);
-            CAMERA_LOGI("RKCodecNode deliver buffer streamid = %{public}d", it->format_.streamId_);
-            return;
-        }
-    }
+    DeliverEncoded(buffer);
 }
 
 RetCode RKCodecNode::Capture(const int32_t streamId, const int32_t captureId)
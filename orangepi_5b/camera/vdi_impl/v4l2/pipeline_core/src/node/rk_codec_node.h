@@ -14,9 +14,12 @@
 #ifndef HOS_CAMERA_RKCODEC_NODE_H
 #define HOS_CAMERA_RKCODEC_NODE_H
 
+#include <atomic>
 #include <vector>
+#include <map>
 #include <condition_variable>
 #include <ctime>
+#include <functional>
 #include <mutex>
 #include "device_manager_adapter.h"
 #include "utils.h"
@@ -26,6 +29,15 @@
 #include "RgaUtils.h"
 #include "RgaApi.h"
 #include "rk_mpi.h"
+#include "rk_jpeg_encoder.h"
+#include "rk_jpeg_exif.h"
+#include "rk_latency_histogram.h"
+#include "rk_nal_indexer.h"
+#include "rk_port_table.h"
+#include "rk_rga_session.h"
+#include "rk_video_enc_config.h"
+#include "rk_video_encoder.h"
+#include "rk_worker_pool.h"
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_log.h"
@@ -48,21 +60,148 @@ public:
     RetCode Flush(const int32_t streamId);
     RetCode ConfigJpegOrientation(common_metadata_header_t* data);
     RetCode ConfigJpegQuality(common_metadata_header_t* data);
+    RetCode ConfigJpegBackend(const int32_t streamId, common_metadata_header_t* data);
+    RetCode ConfigJpegExifOrientation(const int32_t streamId, common_metadata_header_t* data);
+    RetCode ConfigVideoEncoder(const int32_t streamId, common_metadata_header_t* data);
     RetCode Config(const int32_t streamId, const CaptureMeta& meta) override;
+    // the setters keep the value across Stop/Start and fail for a stream that has no port on this node
+    bool SetRgbaZeroCopy(const int32_t streamId, bool enable);
+    uint64_t GetRgbaCopyBytes(const int32_t streamId);
+    bool SetJpegBackend(const int32_t streamId, JpegBackendType type);
+    bool SetJpegExifOrientation(const int32_t streamId, bool enable);
+    WorkerPoolStats GetJpegQueueStats();
+    bool SetVideoEncConfig(const int32_t streamId, const VideoEncConfig& config);
+    VideoEncConfig GetVideoEncConfig(const int32_t streamId);
+    // input import and access unit counters of the running video encoder of the stream
+    VideoEncoderPoolStats GetVideoPoolStats(const int32_t streamId);
+    // capture to delivery latencies of the encoded frames of the stream
+    LatencySummary GetLatency(const int32_t streamId, LatencyStage stage);
+    // SPS/PPS (and VPS) of the last encoded keyframe of the stream, Annex-B
+    std::vector<uint8_t> GetParameterSets(const int32_t streamId);
 private:
-    void encodeJpegToMemory(unsigned char* image, int width, int height,
-            const char* comment, unsigned long* jpegSize, unsigned char** jpegBuf);
-    int findStartCode(unsigned char *data, size_t dataSz);
-    void SerchIFps(unsigned char* buf, size_t bufSize, std::shared_ptr<IBuffer>& buffer);
+    struct RgaStaging {
+        RgaBuffer buffer;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    // the bitstream side of a video stream, used by its delivery thread and by GetParameterSets
+    struct VideoStreamState {
+        std::mutex lock;
+        NalIndex nalIndex;
+        std::vector<uint8_t> parameterSets;
+        std::atomic<uint64_t> unstampedFrames {0};  // no capture time from the source, stamped on arrival instead
+    };
+
+    // what the stream parameters and Config set for a stream, from its first Config or Start on
+    struct StreamSettings {
+        bool zeroCopy = true;
+        JpegBackendType jpegBackend = JpegBackendType::TURBO;
+        bool exifOrientation = false;   // tag the orientation instead of turning the pixels
+        bool exifApp1 = true;           // every jpeg carries a full Exif segment for RKExifNode to fill in
+        VideoEncConfig video;
+    };
+
+    /*
+     * What a running stream holds, from Start to Stop. The frame paths find it without streamLock_
+     * and a frame keeps it alive until it returns, the staging buffer goes with the last reference.
+     */
+    struct StreamContext {
+        ~StreamContext()
+        {
+            ReleaseStaging(rga, staging);
+        }
+
+        std::shared_ptr<RKRgaSession> rga = nullptr;    // set before the context is published
+        std::shared_ptr<RKPipelineLatency> latency = std::make_shared<RKPipelineLatency>();
+        std::shared_ptr<VideoStreamState> videoState = std::make_shared<VideoStreamState>();
+        std::mutex lock;                // this stream's frames and setters, never held across streams
+        StreamSettings settings;        // a copy of settings_, kept current by the setters
+        RgaStaging staging;
+        uint64_t frames = 0;
+        uint64_t copyBytes = 0;      // bytes copied by the cpu for the last frame
+        uint64_t totalCopyBytes = 0;
+        int32_t jpegFrames = 0;
+    };
+    using StreamContexts = std::map<int32_t, std::shared_ptr<StreamContext>>;
+
+    // what the encode path of one video frame needs from its stream, taken in one go from its context
+    struct VideoFrameContext {
+        std::shared_ptr<RKRgaSession> rga = nullptr;
+        VideoEncConfig config;
+        std::shared_ptr<RKPipelineLatency> latency = nullptr;
+        std::shared_ptr<VideoStreamState> state = nullptr;
+    };
+
+    // what one encoder thread owns, the stream session stays with the stream
+    struct JpegWorkerContext {
+        std::shared_ptr<RKRgaSession> rga = nullptr;
+        RgaStaging staging;
+        std::unique_ptr<IJpegEncoder> jpeg = nullptr;
+        std::vector<uint8_t> jpegOut;
+    };
+
+    // capture settings of one still, taken when it is queued
+    struct JpegTask {
+        JpegBackendType backend = JpegBackendType::TURBO;
+        RgaRotation rotation = RgaRotation::ROT_0;
+        bool exifOrientation = false;
+        bool exifApp1 = true;
+        uint32_t quality = 100;
+        int32_t frameNum = 0;
+    };
+
+    struct JpegStageTimes {
+        int64_t rotateUs = 0;
+        int64_t encodeUs = 0;
+        int64_t outputUs = 0;
+    };
+
+    StreamSettings* FindSettings(const int32_t streamId);
+    bool UpdateSettings(const int32_t streamId, const std::function<void(StreamSettings&)>& update);
+    std::shared_ptr<StreamContext> FindStream(const int32_t streamId);
+    void PublishStream(const int32_t streamId, const std::shared_ptr<StreamContext>& ctx);
+    JpegTask MakeJpegTask(StreamContext& ctx);
+    bool PrepareJpegTask(std::shared_ptr<IBuffer>& buffer, JpegTask& task);
+    RKWorkerPool* GetJpegPool();
+    bool SubmitJpeg(std::shared_ptr<IBuffer>& buffer);
+    void EncodeJpegFrame(std::shared_ptr<IBuffer>& buffer, const JpegTask& task, JpegWorkerContext& worker);
+    int32_t EncodeJpeg(JpegWorkerContext& worker, const int32_t streamId, JpegBackendType backend,
+        const JpegInput& in, JpegOutput& out);
+    void ReleaseJpegWorker(JpegWorkerContext& worker);
+    void DeliverEncoded(std::shared_ptr<IBuffer>& buffer);
+    void IndexEsFrame(std::shared_ptr<IBuffer>& buffer, size_t size, NalCodec codec, VideoStreamState& state);
     void Yuv420ToRGBA8888(std::shared_ptr<IBuffer>& buffer);
+    uint64_t Yuv420ToRGBA8888Copy(std::shared_ptr<IBuffer>& buffer, StreamContext& ctx);
+    bool Yuv420ToRGBA8888ZeroCopy(std::shared_ptr<IBuffer>& buffer, StreamContext& ctx);
+    static bool PrepareStaging(const std::shared_ptr<RKRgaSession>& rga, RgaStaging& staging,
+        uint32_t width, uint32_t height);
+    static void ReleaseStaging(const std::shared_ptr<RKRgaSession>& rga, RgaStaging& staging);
+    bool RotateForJpeg(JpegWorkerContext& worker, RgaRotation rotation, JpegInput& in);
+    size_t OutputJpeg(std::shared_ptr<IBuffer>& buffer, const JpegOutput& out, const ExifFields& exif,
+        bool exifApp1);
+    bool GetVideoFrameContext(const int32_t streamId, VideoFrameContext& video);
     void Yuv420ToJpeg(std::shared_ptr<IBuffer>& buffer);
-    void Yuv420ToH264(std::shared_ptr<IBuffer>& buffer);
+    void Yuv420ToVideo(std::shared_ptr<IBuffer>& buffer, NalCodec codec, const VideoFrameContext& video,
+        FrameTimes& times);
+    static void RecordLatency(const VideoFrameContext& video, const FrameTimes& times);
+    void LogLatency(const int32_t streamId, StreamContext& ctx);
 
-    void* halCtx_ = nullptr;
-    int mppStatus_ = 0;
-    uint32_t jpegRotation_;
-    uint32_t jpegQuality_;
-    std::mutex hal_mpp;
+    RKVideoEncoderHandle videoEncoder_;
+    RKPortTable<IPort> portTable_;
+    // written by Config, read when a still is queued, which may be on another thread
+    std::atomic<RgaRotation> jpegRotation_;
+    std::atomic<uint32_t> jpegQuality_;
+    std::mutex streamLock_;     // Start, Stop, Config and the setters; no frame path takes it
+    std::map<int32_t, StreamSettings> settings_;
+    // published copy on write under streamLock_, only through std::atomic_load/store
+    std::shared_ptr<const StreamContexts> streams_ = std::make_shared<const StreamContexts>();
+    std::mutex jpegSyncLock_;
+    JpegWorkerContext jpegSyncWorker_;
+    std::mutex jpegPoolLock_;
+    bool jpegPoolChecked_ = false;
+    std::vector<JpegWorkerContext> jpegWorkers_;
+    std::unique_ptr<RKWorkerPool> jpegPool_ = nullptr;
 };
 } // namespace OHOS::Camera
 #endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_DOUBLE_BUFFER_H
+#define HOS_CAMERA_RK_DOUBLE_BUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace OHOS::Camera {
+/*
+ * Two instances of a value, one published to readers and one the writer fills in place. Read() pins
+ * the front slot with a counter and never blocks or allocates. Back() waits for readers that pinned
+ * that slot before it was replaced to let go, which is one short Read(). Publish() makes it the
+ * front with a single pointer store. Only one writer at a time; the caller serialises them.
+ */
+template<typename T>
+class RKDoubleBuffer {
+public:
+    RKDoubleBuffer() = default;
+    RKDoubleBuffer(const RKDoubleBuffer&) = delete;
+    RKDoubleBuffer& operator=(const RKDoubleBuffer&) = delete;
+
+    // the slot readers do not see, exclusive to the writer until Publish()
+    T& Back()
+    {
+        Slot* back = BackSlot();
+        while (back->readers.load() != 0) {
+            std::this_thread::yield();
+        }
+        return back->value;
+    }
+
+    void Publish()
+    {
+        front_.store(BackSlot());
+        publishes_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // f(const T&) on the published value
+    template<typename F>
+    void Read(F&& f) const
+    {
+        Slot* slot = nullptr;
+        while (true) {
+            slot = front_.load();
+            slot->readers.fetch_add(1);
+            // a writer that swapped in between may already be filling this slot
+            if (front_.load() == slot) {
+                break;
+            }
+            slot->readers.fetch_sub(1);
+        }
+        f(static_cast<const T&>(slot->value));
+        slot->readers.fetch_sub(1, std::memory_order_release);
+    }
+
+    uint64_t GetPublishCount() const
+    {
+        return publishes_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        T value {};
+        mutable std::atomic<uint32_t> readers {0};
+    };
+
+    Slot* BackSlot() const
+    {
+        return front_.load() == &slots_[0] ? &slots_[1] : &slots_[0];
+    }
+
+    mutable Slot slots_[2];
+    std::atomic<Slot*> front_ {&slots_[0]};
+    std::atomic<uint64_t> publishes_ {0};
+};
+} // namespace OHOS::Camera
+#endif
@@ -12,9 +12,13 @@
  */
 
 #include "rk_exif_node.h"
+#include <algorithm>
+#include <ctime>
 #include <exif_utils.h>
 #include <securec.h>
 #include "camera_dump.h"
+#include "rk_jpeg_exif.h"
+#include "rk_vendor_tags.h"
 
 namespace OHOS::Camera {
 RKExifNode::RKExifNode(const std::string &name, const std::string &type, const std::string &cameraId)
@@ -31,6 +35,7 @@ RKExifNode::~RKExifNode()
 RetCode RKExifNode::Start(const int32_t streamId)
 {
     CAMERA_LOGI("RKExifNode::Start streamId = %{public}d\n", streamId);
+    portTable_.Build(GetOutPorts());
     return RC_OK;
 }
 
@@ -55,39 +60,74 @@ void RKExifNode::DeliverBuffer(std::shared_ptr<IBuffer> &buffer)
 
     int32_t id = buffer->GetStreamId();
     CAMERA_LOGE("RKExifNode::DeliverBuffer StreamId %{public}d", id);
-    if (buffer->GetEncodeType() == ENCODE_TYPE_JPEG && gpsInfo_.size() > 0) {
-        int outPutBufferSize = 0;
-        exif_data exifInfo;
-        exifInfo.latitude = gpsInfo_.at(LATITUDE_INDEX);
-        exifInfo.longitude = gpsInfo_.at(LONGITUDE_INDEX);
-        exifInfo.altitude = gpsInfo_.at(ALTITUDE_INDEX);
-        EsFrameInfo info = buffer->GetEsFrameInfo();
-        CAMERA_LOGI("%{public}s info.size = (%{public}d)\n", __FUNCTION__, info.size);
-        if (info.size != -1) {
-            exifInfo.frame_size = info.size;
-            ExifUtils::AddCustomExifInfo(exifInfo, buffer->GetVirAddress(), outPutBufferSize);
-            CAMERA_LOGI("%{public}s virAddress(%{public}p) and outPutBufferSize = (%{public}d)\n",
-                __FUNCTION__, buffer->GetVirAddress(), outPutBufferSize);
-            buffer->SetEsFrameSize(outPutBufferSize);
-        }
+    ExifSnapshot snapshot;
+    if (buffer->GetEncodeType() == ENCODE_TYPE_JPEG && GetExifSnapshot(buffer, snapshot) &&
+        !FillExifApp1(buffer, snapshot) && snapshot.hasGps) {
+        AddGpsExif(buffer, snapshot);
     }
 
     CameraDumper& dumper = CameraDumper::GetInstance();
     dumper.DumpBuffer("board_RKExifNode", ENABLE_RKEXIF_NODE_CONVERTED, buffer);
 
-    std::vector<std::shared_ptr<IPort>> outPutPorts;
-    outPutPorts = GetOutPorts();
-    for (auto& it : outPutPorts) {
-        if (it == nullptr) {
-            CAMERA_LOGE("RKExifNode deliver buffer port is null");
-            continue;
-        }
-        if (it->format_.streamId_ == id) {
-            it->DeliverBuffer(buffer);
-            CAMERA_LOGI("RKExifNode deliver buffer streamid = %{public}d", it->format_.streamId_);
-            return;
-        }
+    IPort* port = portTable_.Find(id, [this] { return GetOutPorts(); });
+    if (port == nullptr) {
+        CAMERA_LOGE("RKExifNode deliver buffer no port for streamid = %{public}d", id);
+        return;
+    }
+    port->DeliverBuffer(buffer);
+    CAMERA_LOGI("RKExifNode deliver buffer streamid = %{public}d", id);
+}
+
+// rewrites the segment RKCodecNode reserved after SOI, the picture stays where it is
+bool RKExifNode::FillExifApp1(std::shared_ptr<IBuffer> &buffer, const ExifSnapshot &snapshot)
+{
+    uint8_t* jpeg = static_cast<uint8_t*>(buffer->GetVirAddress());
+    EsFrameInfo info = buffer->GetEsFrameInfo();
+    if (jpeg == nullptr || info.size <= 0) {
+        return false;
+    }
+    size_t size = std::min(static_cast<size_t>(info.size), static_cast<size_t>(buffer->GetSize()));
+    size_t offset = FindExifApp1(jpeg, size);
+    ExifFields fields;
+    if (offset == 0 || !ParseExifApp1(jpeg + offset, ExifApp1Size(), fields)) {
+        return false;
+    }
+    fields.exposureNs = snapshot.exposureNs;
+    fields.iso = static_cast<uint32_t>(std::max(snapshot.iso, 0));
+    fields.focalLengthUm = static_cast<uint32_t>(std::max(snapshot.focalLengthUm, 0));
+    if (snapshot.captureTime != 0) {
+        FormatExifDateTime(snapshot.captureTime, fields.dateTime);
     }
+    fields.hasGps = snapshot.hasGps;
+    fields.latitude = snapshot.gps[LATITUDE_INDEX];
+    fields.longitude = snapshot.gps[LONGITUDE_INDEX];
+    fields.altitude = snapshot.gps[ALTITUDE_INDEX];
+    return WriteExifApp1(jpeg + offset, ExifApp1Size(), fields) != 0;
+}
+
+// a jpeg without the reserved segment, libexif rebuilds it with the gps tags
+void RKExifNode::AddGpsExif(std::shared_ptr<IBuffer> &buffer, const ExifSnapshot &snapshot)
+{
+    int outPutBufferSize = 0;
+    exif_data exifInfo;
+    exifInfo.latitude = snapshot.gps[LATITUDE_INDEX];
+    exifInfo.longitude = snapshot.gps[LONGITUDE_INDEX];
+    exifInfo.altitude = snapshot.gps[ALTITUDE_INDEX];
+    EsFrameInfo info = buffer->GetEsFrameInfo();
+    CAMERA_LOGI("%{public}s info.size = (%{public}d)\n", __FUNCTION__, info.size);
+    if (info.size != -1) {
+        exifInfo.frame_size = info.size;
+        ExifUtils::AddCustomExifInfo(exifInfo, buffer->GetVirAddress(), outPutBufferSize);
+        CAMERA_LOGI("%{public}s virAddress(%{public}p) and outPutBufferSize = (%{public}d)\n",
+            __FUNCTION__, buffer->GetVirAddress(), outPutBufferSize);
+        buffer->SetEsFrameSize(outPutBufferSize);
+    }
+}
+
+// the settings of the buffer's own capture, or the current ones when the capture is no longer known
+bool RKExifNode::GetExifSnapshot(const std::shared_ptr<IBuffer> &buffer, ExifSnapshot &snapshot) const
+{
+    return exifSnapshots_.Find(buffer->GetCaptureId(), snapshot) || currentExif_.Latest(snapshot);
 }
 
 RetCode RKExifNode::Config(const int32_t streamId, const CaptureMeta &meta)
@@ -102,46 +142,50 @@ RetCode RKExifNode::Config(const int32_t streamId, const CaptureMeta &meta)
     return RC_OK;
 }
 
+// settings a request leaves out keep their previous value
 RetCode RKExifNode::SendMetadata(std::shared_ptr<CameraMetadata> meta)
 {
     common_metadata_header_t *data = meta->get();
     camera_metadata_item_t entry;
-    uint8_t captureQuality = 0;
-    int32_t captureOrientation = 0;
-    uint8_t mirrorSwitch = 0;
     int ret = RC_OK;
 
     if (data == nullptr) {
         CAMERA_LOGE("%{public}s data is nullptr", __FUNCTION__);
         return RC_ERROR;
     }
+    std::lock_guard<std::mutex> l(configLock_);
     RetCode rc = SetGpsInfoMetadata(data);
-    if (rc == RC_ERROR) {
-        CAMERA_LOGE("%{public}s SetGpsInfoMetadata fail", __FUNCTION__);
-        return RC_ERROR;
-    }
 
     ret = FindCameraMetadataItem(data, OHOS_JPEG_QUALITY, &entry);
-    if (ret != 0) {
-        CAMERA_LOGE("%{public}s get OHOS_JPEG_QUALITY error and ret= %{public}d", __FUNCTION__, ret);
-        return RC_ERROR;
+    if (ret == 0 && entry.count > 0) {
+        pendingExif_.quality = *(entry.data.u8);
     }
-    captureQuality = *(entry.data.u8);
     ret = FindCameraMetadataItem(data, OHOS_JPEG_ORIENTATION, &entry);
-    if (ret != 0) {
-        CAMERA_LOGE("%{public}s get OHOS_JPEG_ORIENTATION error and ret= %{public}d", __FUNCTION__, ret);
-        return RC_ERROR;
+    if (ret == 0 && entry.count > 0) {
+        pendingExif_.orientation = *(entry.data.i32);
     }
-    captureOrientation = *(entry.data.i32);
     ret = FindCameraMetadataItem(data, OHOS_CONTROL_CAPTURE_MIRROR, &entry);
-    if (ret != 0) {
-        CAMERA_LOGE("%{public}s get OHOS_CONTROL_CAPTURE_MIRROR error and ret= %{public}d", __FUNCTION__, ret);
-        return RC_ERROR;
+    if (ret == 0 && entry.count > 0) {
+        pendingExif_.mirror = *(entry.data.u8);
+    }
+    ret = FindCameraMetadataItem(data, OHOS_SENSOR_EXPOSURE_TIME, &entry);
+    if (ret == 0 && entry.count > 0) {
+        pendingExif_.exposureNs = *(entry.data.i64);
+    }
+    ret = FindCameraMetadataItem(data, RK_VENDOR_EXIF_ISO, &entry);
+    if (ret == 0 && entry.count > 0) {
+        pendingExif_.iso = *(entry.data.i32);
+    }
+    ret = FindCameraMetadataItem(data, RK_VENDOR_EXIF_FOCAL_LENGTH, &entry);
+    if (ret == 0 && entry.count > 0) {
+        pendingExif_.focalLengthUm = *(entry.data.i32);
     }
-    mirrorSwitch = *(entry.data.u8);
     CAMERA_LOGI("%{public}s captureQuality= %{public}d and captureOrientation= %{public}d and mirrorSwitch= %{public}d",
-        __FUNCTION__, captureQuality, captureOrientation, mirrorSwitch);
+        __FUNCTION__, pendingExif_.quality, pendingExif_.orientation, pendingExif_.mirror);
 
+    // until Capture() binds them to a capture id they apply to any jpeg that has none of its own,
+    // kept apart so that repeated settings never push a capture's snapshot out of the ring
+    currentExif_.Publish(EXIF_NO_CAPTURE, pendingExif_);
     return rc;
 }
 
@@ -161,16 +205,19 @@ RetCode RKExifNode::SetGpsInfoMetadata(common_metadata_header_t *data)
         return RC_ERROR;
     }
 
-    for (int i = 0; i < count; i++) {
-        std::lock_guard<std::mutex> l(gpsMetaDatalock_);
-        gpsInfo_.push_back(*(entry.data.d + i));
+    for (uint32_t i = 0; i < count; i++) {
+        pendingExif_.gps[i] = *(entry.data.d + i);
     }
+    pendingExif_.hasGps = true;
     return RC_OK;
 }
 
 RetCode RKExifNode::Capture(const int32_t streamId, const int32_t captureId)
 {
     CAMERA_LOGV("RKExifNode::Capture");
+    std::lock_guard<std::mutex> l(configLock_);
+    pendingExif_.captureTime = static_cast<int64_t>(time(nullptr));
+    exifSnapshots_.Publish(captureId, pendingExif_);
     return RC_OK;
 }
 
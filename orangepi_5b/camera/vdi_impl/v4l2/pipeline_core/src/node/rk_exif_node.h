@@ -21,6 +21,8 @@
 #include "utils.h"
 #include "camera.h"
 #include "source_node.h"
+#include "rk_port_table.h"
+#include "rk_snapshot_ring.h"
 
 enum GpsIndex : int32_t {
     LATITUDE_INDEX = 0,
@@ -29,6 +31,19 @@ enum GpsIndex : int32_t {
 };
 
 namespace OHOS::Camera {
+// the exif relevant settings of one capture request
+struct ExifSnapshot {
+    double gps[ALTITUDE_INDEX + 1] = {};
+    bool hasGps = false;
+    uint8_t quality = 0;
+    uint8_t mirror = 0;
+    int32_t orientation = 0;
+    int64_t exposureNs = 0;
+    int32_t iso = 0;
+    int32_t focalLengthUm = 0;
+    int64_t captureTime = 0;    // wall clock seconds when the capture was asked for
+};
+
 class RKExifNode : public NodeBase {
 public:
     RKExifNode(const std::string &name, const std::string &type, const std::string &cameraId);
@@ -41,11 +56,20 @@ public:
     RetCode Flush(const int32_t streamId);
     RetCode Config(const int32_t streamId, const CaptureMeta &meta) override;
 private:
+    static constexpr size_t EXIF_SNAPSHOTS = 8;     // captures in flight between Capture and the jpeg
+    static constexpr int64_t EXIF_NO_CAPTURE = -1;  // settings that arrived outside a capture
+
     RetCode SendMetadata(std::shared_ptr<CameraMetadata> meta);
     RetCode SetGpsInfoMetadata(common_metadata_header_t *data);
+    bool GetExifSnapshot(const std::shared_ptr<IBuffer> &buffer, ExifSnapshot &snapshot) const;
+    bool FillExifApp1(std::shared_ptr<IBuffer> &buffer, const ExifSnapshot &snapshot);
+    void AddGpsExif(std::shared_ptr<IBuffer> &buffer, const ExifSnapshot &snapshot);
 
-    std::mutex gpsMetaDatalock_;
-    std::vector<double> gpsInfo_;
+    std::mutex configLock_;         // Config and Capture, never the delivery path
+    ExifSnapshot pendingExif_;      // under configLock_, the settings of the next capture
+    RKSnapshotRing<ExifSnapshot, EXIF_SNAPSHOTS> exifSnapshots_;   // written by Capture() only
+    RKSnapshotRing<ExifSnapshot, 1> currentExif_;   // 1: the settings not yet bound to a capture
+    RKPortTable<IPort> portTable_;
 };
 } // namespace OHOS::Camera
 #endif
@@ -0,0 +1,646 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_face_detector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include "camera.h"
+
+namespace OHOS::Camera {
+namespace {
+constexpr float GROUP_EPS = 0.2f;           // opencv detectMultiScale
+constexpr float SAME_FACE_IOU = 0.3f;
+constexpr uint32_t INTERNAL_NODE_VALUES = 4;    // left, right, feature, threshold of a stump
+constexpr uint32_t LEAF_VALUES = 2;
+constexpr uint32_t RECT_VALUES = 5;             // x y width height weight
+constexpr uint32_t FRACTION_BITS = 16;
+constexpr uint32_t FRACTION_ONE = 1u << FRACTION_BITS;
+
+struct Element {
+    size_t open = 0;    // of the opening tag
+    size_t begin = 0;   // of the text
+    size_t end = 0;
+};
+
+// the next <tag>text</tag> starting in [pos, limit)
+bool NextElement(const std::string& xml, const std::string& tag, size_t pos, size_t limit, Element& element)
+{
+    const std::string open = "<" + tag + ">";
+    const std::string close = "</" + tag + ">";
+    size_t begin = xml.find(open, pos);
+    if (begin == std::string::npos || begin >= limit) {
+        return false;
+    }
+    element.open = begin;
+    begin += open.size();
+    size_t end = xml.find(close, begin);
+    if (end == std::string::npos || end > limit) {
+        return false;
+    }
+    element.begin = begin;
+    element.end = end;
+    return true;
+}
+
+std::string ElementText(const std::string& xml, const Element& element)
+{
+    return xml.substr(element.begin, element.end - element.begin);
+}
+
+void ParseNumbers(const std::string& text, std::vector<double>& values)
+{
+    values.clear();
+    const char* p = text.c_str();
+    while (true) {
+        char* end = nullptr;
+        double v = strtod(p, &end);
+        if (end == p) {
+            return;
+        }
+        values.push_back(v);
+        p = end;
+    }
+}
+
+std::string StripComments(const std::string& xml)
+{
+    std::string out;
+    out.reserve(xml.size());
+    size_t pos = 0;
+    while (pos < xml.size()) {
+        size_t begin = xml.find("<!--", pos);
+        if (begin == std::string::npos) {
+            break;
+        }
+        size_t end = xml.find("-->", begin);
+        out.append(xml, pos, begin - pos);
+        pos = end == std::string::npos ? xml.size() : end + 3;  // 3: -->
+    }
+    if (pos < xml.size()) {
+        out.append(xml, pos, std::string::npos);
+    }
+    return out;
+}
+
+bool ParseStages(const std::string& xml, const Element& stages, HaarCascade& cascade)
+{
+    std::vector<double> values;
+    Element threshold;
+    size_t pos = stages.begin;
+    while (NextElement(xml, "stageThreshold", pos, stages.end, threshold)) {
+        Element next;
+        size_t stageEnd = NextElement(xml, "stageThreshold", threshold.end, stages.end, next) ? next.open :
+            stages.end;
+        HaarStage stage;
+        stage.threshold = static_cast<float>(strtod(ElementText(xml, threshold).c_str(), nullptr));
+
+        Element nodes;
+        Element leaves;
+        size_t p = threshold.end;
+        while (NextElement(xml, "internalNodes", p, stageEnd, nodes)) {
+            ParseNumbers(ElementText(xml, nodes), values);
+            if (values.size() != INTERNAL_NODE_VALUES) {
+                CAMERA_LOGE("cascade weak classifier is not a stump, %{public}zu node values", values.size());
+                return false;
+            }
+            HaarStump stump;
+            stump.feature = static_cast<uint32_t>(values[2]);                  // 2: feature index
+            stump.threshold = static_cast<float>(values[3]);                   // 3: node threshold
+            if (!NextElement(xml, "leafValues", nodes.end, stageEnd, leaves)) {
+                return false;
+            }
+            ParseNumbers(ElementText(xml, leaves), values);
+            if (values.size() != LEAF_VALUES) {
+                return false;
+            }
+            stump.left = static_cast<float>(values[0]);
+            stump.right = static_cast<float>(values[1]);
+            stage.stumps.push_back(stump);
+            p = leaves.end;
+        }
+        if (stage.stumps.empty()) {
+            return false;
+        }
+        cascade.stages.push_back(std::move(stage));
+        pos = stageEnd;
+    }
+    return !cascade.stages.empty();
+}
+
+bool ParseFeatures(const std::string& xml, const Element& features, HaarCascade& cascade)
+{
+    std::vector<double> values;
+    Element rects;
+    size_t pos = features.begin;
+    while (NextElement(xml, "rects", pos, features.end, rects)) {
+        Element next;
+        size_t featureEnd = NextElement(xml, "rects", rects.end, features.end, next) ? next.open : features.end;
+        Element tilted;
+        if (NextElement(xml, "tilted", rects.end, featureEnd, tilted) &&
+            atoi(ElementText(xml, tilted).c_str()) != 0) {
+            CAMERA_LOGE("cascade has tilted features, not supported");
+            return false;
+        }
+
+        HaarFeature feature;
+        Element rect;
+        size_t p = rects.begin;
+        while (NextElement(xml, "_", p, rects.end, rect)) {
+            ParseNumbers(ElementText(xml, rect), values);
+            if (values.size() != RECT_VALUES || feature.count == HAAR_MAX_RECTS) {
+                return false;
+            }
+            HaarRect& r = feature.rects[feature.count++];
+            r.x = static_cast<int32_t>(values[0]);
+            r.y = static_cast<int32_t>(values[1]);
+            r.width = static_cast<int32_t>(values[2]);     // 2: width
+            r.height = static_cast<int32_t>(values[3]);    // 3: height
+            r.weight = static_cast<float>(values[4]);      // 4: weight
+            p = rect.end;
+        }
+        if (feature.count == 0) {
+            return false;
+        }
+        cascade.features.push_back(feature);
+        pos = featureEnd;
+    }
+    return !cascade.features.empty();
+}
+
+bool ValidateCascade(const HaarCascade& cascade)
+{
+    int32_t w = static_cast<int32_t>(cascade.windowWidth);
+    int32_t h = static_cast<int32_t>(cascade.windowHeight);
+    for (const HaarFeature& feature : cascade.features) {
+        for (uint32_t i = 0; i < feature.count; i++) {
+            const HaarRect& r = feature.rects[i];
+            if (r.x < 0 || r.y < 0 || r.width <= 0 || r.height <= 0 || r.x + r.width > w || r.y + r.height > h) {
+                return false;
+            }
+        }
+    }
+    for (const HaarStage& stage : cascade.stages) {
+        for (const HaarStump& stump : stage.stumps) {
+            if (stump.feature >= cascade.features.size()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SimilarBoxes(const FaceBox& a, const FaceBox& b)
+{
+    float delta = GROUP_EPS * (std::min(a.width, b.width) + std::min(a.height, b.height)) * 0.5f;  // 0.5: mean
+    return std::fabs(a.x - b.x) <= delta && std::fabs(a.y - b.y) <= delta &&
+        std::fabs(a.x + a.width - b.x - b.width) <= delta && std::fabs(a.y + a.height - b.y - b.height) <= delta;
+}
+
+uint32_t FindRoot(std::vector<uint32_t>& parent, uint32_t i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+float BoxIou(const FaceBox& a, const FaceBox& b)
+{
+    float ix = std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x);
+    float iy = std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y);
+    if (ix <= 0.0f || iy <= 0.0f) {
+        return 0.0f;
+    }
+    float inter = ix * iy;
+    return inter / (a.width * a.height + b.width * b.height - inter);
+}
+
+// BT.601 luma of 8 bit rgb
+inline uint32_t RgbLuma(const uint8_t* p)
+{
+    return (77u * p[0] + 150u * p[1] + 29u * p[2]) >> 8;   // 77, 150, 29, 8: 0.299, 0.587, 0.114 in 8 bit fixed point
+}
+
+template<uint32_t BPP, bool RGB>
+void BoxFilter(const uint8_t* frame, uint32_t width, uint32_t height, uint32_t stride, LumaImage& out)
+{
+    uint32_t tw = out.width;
+    uint32_t th = out.height;
+    for (uint32_t y = 0; y < th; y++) {
+        uint32_t y0 = y * height / th;
+        uint32_t y1 = std::max((y + 1) * height / th, y0 + 1);
+        uint8_t* dst = out.data.data() + static_cast<size_t>(y) * tw;
+        for (uint32_t x = 0; x < tw; x++) {
+            uint32_t x0 = x * width / tw;
+            uint32_t x1 = std::max((x + 1) * width / tw, x0 + 1);
+            uint32_t sum = 0;
+            for (uint32_t sy = y0; sy < y1; sy++) {
+                const uint8_t* row = frame + (static_cast<size_t>(sy) * stride + x0) * BPP;
+                for (uint32_t sx = x0; sx < x1; sx++, row += BPP) {
+                    sum += RGB ? RgbLuma(row) : row[0];
+                }
+            }
+            uint32_t area = (x1 - x0) * (y1 - y0);
+            dst[x] = static_cast<uint8_t>((sum + area / 2) / area);    // 2: round to nearest
+        }
+    }
+}
+
+class CascadeFaceDetector : public IFaceDetector {
+public:
+    CascadeFaceDetector(const HaarCascade& cascade, const CascadeParams& params);
+    ~CascadeFaceDetector() override = default;
+    const char* GetName() const override
+    {
+        return "cascade";
+    }
+    int32_t Detect(const LumaImage& image, std::vector<FaceBox>& faces) override;
+
+private:
+    // corners of a rect relative to the window origin in the integral image
+    struct OptRect {
+        int32_t p0 = 0;
+        int32_t p1 = 0;
+        int32_t p2 = 0;
+        int32_t p3 = 0;
+        float weight = 0.0f;
+    };
+    struct OptFeature {
+        OptRect rects[HAAR_MAX_RECTS];
+        uint32_t count = 0;
+    };
+
+    void Resize(const LumaImage& image, uint32_t w, uint32_t h);
+    void Integrate(uint32_t w, uint32_t h);
+    void PrepareOffsets(uint32_t istride);
+    bool EvaluateWindow(size_t origin, uint32_t istride) const;
+
+    HaarCascade cascade_;
+    CascadeParams params_;
+    std::vector<OptFeature> features_;
+    std::vector<uint8_t> level_;
+    std::vector<uint32_t> sum_;
+    std::vector<uint64_t> sqsum_;
+    std::vector<uint32_t> xofs_;
+    std::vector<uint32_t> xfrac_;
+    uint32_t offsetsStride_ = 0;
+};
+
+CascadeFaceDetector::CascadeFaceDetector(const HaarCascade& cascade, const CascadeParams& params)
+    : cascade_(cascade), params_(params), features_(cascade.features.size())
+{
+    params_.scaleFactor = std::max(params_.scaleFactor, 1.01f);    // 1.01: keeps the pyramid finite
+}
+
+// bilinear, 16 bit fractions
+void CascadeFaceDetector::Resize(const LumaImage& image, uint32_t w, uint32_t h)
+{
+    level_.resize(static_cast<size_t>(w) * h);
+    if (w == image.width && h == image.height) {
+        std::copy(image.data.begin(), image.data.begin() + level_.size(), level_.begin());
+        return;
+    }
+    uint64_t xstep = (static_cast<uint64_t>(image.width) << FRACTION_BITS) / w;
+    uint64_t ystep = (static_cast<uint64_t>(image.height) << FRACTION_BITS) / h;
+    xofs_.resize(w);
+    xfrac_.resize(w);
+    for (uint32_t x = 0; x < w; x++) {
+        uint64_t sx = x * xstep;
+        xofs_[x] = std::min(static_cast<uint32_t>(sx >> FRACTION_BITS), image.width - 1);
+        xfrac_[x] = xofs_[x] + 1 < image.width ? static_cast<uint32_t>(sx & (FRACTION_ONE - 1)) : 0;
+    }
+    for (uint32_t y = 0; y < h; y++) {
+        uint64_t sy = y * ystep;
+        uint32_t y0 = std::min(static_cast<uint32_t>(sy >> FRACTION_BITS), image.height - 1);
+        uint32_t fy = y0 + 1 < image.height ? static_cast<uint32_t>(sy & (FRACTION_ONE - 1)) : 0;
+        const uint8_t* r0 = image.data.data() + static_cast<size_t>(y0) * image.width;
+        const uint8_t* r1 = fy == 0 ? r0 : r0 + image.width;
+        uint8_t* dst = level_.data() + static_cast<size_t>(y) * w;
+        for (uint32_t x = 0; x < w; x++) {
+            uint32_t x0 = xofs_[x];
+            uint32_t fx = xfrac_[x];
+            uint32_t x1 = fx == 0 ? x0 : x0 + 1;
+            uint64_t top = static_cast<uint64_t>(r0[x0]) * (FRACTION_ONE - fx) + static_cast<uint64_t>(r0[x1]) * fx;
+            uint64_t bottom = static_cast<uint64_t>(r1[x0]) * (FRACTION_ONE - fx) +
+                static_cast<uint64_t>(r1[x1]) * fx;
+            uint64_t v = top * (FRACTION_ONE - fy) + bottom * fy;
+            dst[x] = static_cast<uint8_t>((v + (1ull << (2 * FRACTION_BITS - 1))) >> (2 * FRACTION_BITS));  // 2: two
+        }
+    }
+}
+
+void CascadeFaceDetector::Integrate(uint32_t w, uint32_t h)
+{
+    uint32_t istride = w + 1;
+    size_t size = static_cast<size_t>(istride) * (h + 1);
+    sum_.assign(size, 0);
+    sqsum_.assign(size, 0);
+    for (uint32_t y = 0; y < h; y++) {
+        const uint8_t* src = level_.data() + static_cast<size_t>(y) * w;
+        const uint32_t* above = sum_.data() + static_cast<size_t>(y) * istride;
+        const uint64_t* sqAbove = sqsum_.data() + static_cast<size_t>(y) * istride;
+        uint32_t* row = sum_.data() + static_cast<size_t>(y + 1) * istride;
+        uint64_t* sqRow = sqsum_.data() + static_cast<size_t>(y + 1) * istride;
+        uint32_t s = 0;
+        uint64_t sq = 0;
+        for (uint32_t x = 0; x < w; x++) {
+            s += src[x];
+            sq += static_cast<uint64_t>(src[x]) * src[x];
+            row[x + 1] = above[x + 1] + s;
+            sqRow[x + 1] = sqAbove[x + 1] + sq;
+        }
+    }
+}
+
+void CascadeFaceDetector::PrepareOffsets(uint32_t istride)
+{
+    if (offsetsStride_ == istride) {
+        return;
+    }
+    int32_t is = static_cast<int32_t>(istride);
+    for (size_t i = 0; i < cascade_.features.size(); i++) {
+        const HaarFeature& feature = cascade_.features[i];
+        OptFeature& opt = features_[i];
+        opt.count = feature.count;
+        for (uint32_t k = 0; k < feature.count; k++) {
+            const HaarRect& r = feature.rects[k];
+            opt.rects[k].p0 = r.y * is + r.x;
+            opt.rects[k].p1 = r.y * is + r.x + r.width;
+            opt.rects[k].p2 = (r.y + r.height) * is + r.x;
+            opt.rects[k].p3 = (r.y + r.height) * is + r.x + r.width;
+            opt.rects[k].weight = r.weight;
+        }
+    }
+    offsetsStride_ = istride;
+}
+
+bool CascadeFaceDetector::EvaluateWindow(size_t origin, uint32_t istride) const
+{
+    // variance normalisation over the window less a one pixel border, as opencv does
+    const uint32_t nw = cascade_.windowWidth - 2;   // 2: one pixel each side
+    const uint32_t nh = cascade_.windowHeight - 2;  // 2: one pixel each side
+    size_t n0 = origin + istride + 1;
+    size_t n1 = n0 + nw;
+    size_t n2 = n0 + static_cast<size_t>(nh) * istride;
+    size_t n3 = n2 + nw;
+    double area = static_cast<double>(nw) * nh;
+    double s = static_cast<double>(sum_[n3] - sum_[n1] - sum_[n2] + sum_[n0]);
+    double sq = static_cast<double>(sqsum_[n3] - sqsum_[n1] - sqsum_[n2] + sqsum_[n0]);
+    double nf = area * sq - s * s;
+    float norm = nf > 0.0 ? static_cast<float>(std::sqrt(nf)) : 1.0f;
+
+    const uint32_t* base = sum_.data() + origin;
+    for (const HaarStage& stage : cascade_.stages) {
+        float stageSum = 0.0f;
+        for (const HaarStump& stump : stage.stumps) {
+            const OptFeature& feature = features_[stump.feature];
+            float value = 0.0f;
+            for (uint32_t k = 0; k < feature.count; k++) {
+                const OptRect& r = feature.rects[k];
+                int32_t rectSum = static_cast<int32_t>(base[r.p3] - base[r.p1] - base[r.p2] + base[r.p0]);
+                value += r.weight * static_cast<float>(rectSum);
+            }
+            stageSum += value < stump.threshold * norm ? stump.left : stump.right;
+        }
+        if (stageSum < stage.threshold) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int32_t CascadeFaceDetector::Detect(const LumaImage& image, std::vector<FaceBox>& faces)
+{
+    faces.clear();
+    const uint32_t ww = cascade_.windowWidth;
+    const uint32_t wh = cascade_.windowHeight;
+    if (image.width < ww || image.height < wh || image.data.size() < static_cast<size_t>(image.width) * image.height) {
+        return 0;
+    }
+    for (float scale = 1.0f;; scale *= params_.scaleFactor) {
+        uint32_t w = static_cast<uint32_t>(image.width / scale);
+        uint32_t h = static_cast<uint32_t>(image.height / scale);
+        if (w < ww || h < wh) {
+            break;
+        }
+        if (ww * scale < params_.minSize) {
+            continue;
+        }
+        Resize(image, w, h);
+        Integrate(w, h);
+        uint32_t istride = w + 1;
+        PrepareOffsets(istride);
+        uint32_t step = scale > 2.0f ? 1 : 2;   // 2: coarser steps where the windows are small, as opencv
+        for (uint32_t y = 0; y + wh <= h; y += step) {
+            for (uint32_t x = 0; x + ww <= w; x += step) {
+                if (EvaluateWindow(static_cast<size_t>(y) * istride + x, istride)) {
+                    FaceBox box;
+                    box.x = x * scale;
+                    box.y = y * scale;
+                    box.width = ww * scale;
+                    box.height = wh * scale;
+                    box.score = 1.0f;
+                    faces.push_back(box);
+                }
+            }
+        }
+    }
+
+    GroupFaceBoxes(faces, params_.minNeighbors);
+    for (FaceBox& face : faces) {
+        face.x /= image.width;
+        face.y /= image.height;
+        face.width /= image.width;
+        face.height /= image.height;
+    }
+    return 0;
+}
+} // namespace
+
+bool ParseOpenCvCascade(const std::string& text, HaarCascade& cascade)
+{
+    cascade = HaarCascade();
+    const std::string xml = StripComments(text);
+    Element element;
+    if (!NextElement(xml, "featureType", 0, xml.size(), element) ||
+        ElementText(xml, element).find("HAAR") == std::string::npos) {
+        CAMERA_LOGE("cascade is not a haar cascade in the opencv format");
+        return false;
+    }
+    if (!NextElement(xml, "width", 0, xml.size(), element)) {
+        return false;
+    }
+    cascade.windowWidth = static_cast<uint32_t>(atoi(ElementText(xml, element).c_str()));
+    if (!NextElement(xml, "height", 0, xml.size(), element)) {
+        return false;
+    }
+    cascade.windowHeight = static_cast<uint32_t>(atoi(ElementText(xml, element).c_str()));
+    constexpr uint32_t minWindow = 3;   // 3: the normalisation rect leaves a border of one
+    if (cascade.windowWidth < minWindow || cascade.windowHeight < minWindow) {
+        return false;
+    }
+
+    Element stages;
+    Element features;
+    if (!NextElement(xml, "stages", 0, xml.size(), stages) || !ParseStages(xml, stages, cascade) ||
+        !NextElement(xml, "features", stages.end, xml.size(), features) ||
+        !ParseFeatures(xml, features, cascade) || !ValidateCascade(cascade)) {
+        CAMERA_LOGE("cascade stages or features malformed");
+        cascade = HaarCascade();
+        return false;
+    }
+    return true;
+}
+
+bool LoadOpenCvCascade(const std::string& path, HaarCascade& cascade)
+{
+    std::ifstream file(path);
+    if (!file) {
+        CAMERA_LOGE("cascade %{public}s not found", path.c_str());
+        return false;
+    }
+    std::string xml((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return ParseOpenCvCascade(xml, cascade);
+}
+
+std::unique_ptr<IFaceDetector> CreateCascadeFaceDetector(const HaarCascade& cascade, const CascadeParams& params)
+{
+    if (cascade.stages.empty() || cascade.features.empty() || !ValidateCascade(cascade)) {
+        return nullptr;
+    }
+    return std::make_unique<CascadeFaceDetector>(cascade, params);
+}
+
+bool DownscaleLuma(const uint8_t* frame, RgaPixelFormat format, uint32_t width, uint32_t height, uint32_t stride,
+    uint32_t targetWidth, LumaImage& out)
+{
+    if (frame == nullptr || width == 0 || height == 0 || targetWidth == 0 || stride < width) {
+        return false;
+    }
+    out.width = std::min(targetWidth, width);
+    out.height = std::max(static_cast<uint32_t>(static_cast<uint64_t>(height) * out.width / width), 1u);
+    out.data.resize(static_cast<size_t>(out.width) * out.height);
+
+    constexpr uint32_t yuyvBpp = 2;
+    constexpr uint32_t rgbaBpp = 4;
+    constexpr uint32_t rgbBpp = 3;
+    switch (format) {
+        case RgaPixelFormat::YUV420P:
+        case RgaPixelFormat::NV12:
+        case RgaPixelFormat::NV21:
+            BoxFilter<1, false>(frame, width, height, stride, out);
+            return true;
+        case RgaPixelFormat::YUYV:
+            BoxFilter<yuyvBpp, false>(frame, width, height, stride, out);
+            return true;
+        case RgaPixelFormat::RGBA8888:
+            BoxFilter<rgbaBpp, true>(frame, width, height, stride, out);
+            return true;
+        case RgaPixelFormat::RGB888:
+            BoxFilter<rgbBpp, true>(frame, width, height, stride, out);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void GroupFaceBoxes(std::vector<FaceBox>& boxes, uint32_t minNeighbors)
+{
+    uint32_t count = static_cast<uint32_t>(boxes.size());
+    std::vector<uint32_t> parent(count);
+    for (uint32_t i = 0; i < count; i++) {
+        parent[i] = i;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t j = i + 1; j < count; j++) {
+            if (SimilarBoxes(boxes[i], boxes[j])) {
+                parent[FindRoot(parent, j)] = FindRoot(parent, i);
+            }
+        }
+    }
+
+    // average the members of each class, the score counts them
+    std::vector<FaceBox> groups;
+    std::vector<uint32_t> groupOf(count, UINT32_MAX);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t root = FindRoot(parent, i);
+        if (groupOf[root] == UINT32_MAX) {
+            groupOf[root] = static_cast<uint32_t>(groups.size());
+            groups.emplace_back();
+        }
+        FaceBox& g = groups[groupOf[root]];
+        g.x += boxes[i].x;
+        g.y += boxes[i].y;
+        g.width += boxes[i].width;
+        g.height += boxes[i].height;
+        g.score += 1.0f;
+    }
+    for (FaceBox& g : groups) {
+        g.x /= g.score;
+        g.y /= g.score;
+        g.width /= g.score;
+        g.height /= g.score;
+    }
+
+    // a weak group inside a stronger one is the same face seen at another scale
+    constexpr float minStrong = 3.0f;   // 3: opencv
+    boxes.clear();
+    for (size_t i = 0; i < groups.size(); i++) {
+        const FaceBox& a = groups[i];
+        if (a.score <= static_cast<float>(minNeighbors)) {
+            continue;
+        }
+        bool inside = false;
+        for (size_t j = 0; j < groups.size() && !inside; j++) {
+            const FaceBox& b = groups[j];
+            if (i == j || b.score <= static_cast<float>(minNeighbors)) {
+                continue;
+            }
+            float dx = b.width * GROUP_EPS;
+            float dy = b.height * GROUP_EPS;
+            inside = (b.score > std::max(minStrong, a.score) || a.score < minStrong) &&
+                a.x >= b.x - dx && a.y >= b.y - dy && a.x + a.width <= b.x + b.width + dx &&
+                a.y + a.height <= b.y + b.height + dy;
+        }
+        if (!inside) {
+            boxes.push_back(a);
+        }
+    }
+}
+
+void AssignFaceIds(const std::vector<FaceBox>& previous, std::vector<FaceBox>& faces, int32_t& nextId)
+{
+    std::vector<bool> taken(previous.size(), false);
+    for (FaceBox& face : faces) {
+        float best = SAME_FACE_IOU;
+        size_t match = previous.size();
+        for (size_t i = 0; i < previous.size(); i++) {
+            float iou = BoxIou(face, previous[i]);
+            if (!taken[i] && iou >= best) {
+                best = iou;
+                match = i;
+            }
+        }
+        if (match < previous.size()) {
+            taken[match] = true;
+            face.id = previous[match].id;
+        } else {
+            face.id = nextId++;
+        }
+    }
+}
+} // namespace OHOS::Camera
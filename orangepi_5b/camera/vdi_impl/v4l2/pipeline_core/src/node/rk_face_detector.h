@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_FACE_DETECTOR_H
+#define HOS_CAMERA_RK_FACE_DETECTOR_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "rk_rga_session.h"
+
+namespace OHOS::Camera {
+// one 8 bit plane, rows are width bytes apart
+struct LumaImage {
+    std::vector<uint8_t> data;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+// a face in fractions of the analysed frame, so it maps onto any stream of the same field of view
+struct FaceBox {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+    float score = 0.0f;     // raw detections merged into this one
+    int32_t id = -1;
+};
+
+class IFaceDetector {
+public:
+    virtual ~IFaceDetector() = default;
+    virtual const char* GetName() const = 0;
+    // replaces faces with the faces found in image, ids are left to the caller
+    virtual int32_t Detect(const LumaImage& image, std::vector<FaceBox>& faces) = 0;
+};
+
+using FaceDetectorFactory = std::function<std::unique_ptr<IFaceDetector>()>;
+
+// Viola-Jones cascade of decision stumps over upright haar features, as trained by opencv_traincascade
+struct HaarRect {
+    int32_t x = 0;
+    int32_t y = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    float weight = 0.0f;
+};
+
+constexpr uint32_t HAAR_MAX_RECTS = 3;
+
+struct HaarFeature {
+    HaarRect rects[HAAR_MAX_RECTS];
+    uint32_t count = 0;
+};
+
+struct HaarStump {
+    uint32_t feature = 0;
+    float threshold = 0.0f;     // in units of the window standard deviation
+    float left = 0.0f;          // feature < threshold
+    float right = 0.0f;
+};
+
+struct HaarStage {
+    float threshold = 0.0f;
+    std::vector<HaarStump> stumps;
+};
+
+struct HaarCascade {
+    uint32_t windowWidth = 0;
+    uint32_t windowHeight = 0;
+    std::vector<HaarStage> stages;
+    std::vector<HaarFeature> features;
+};
+
+struct CascadeParams {
+    float scaleFactor = 1.2f;   // between pyramid levels
+    uint32_t minNeighbors = 3;  // raw detections a face needs, fewer are dropped as noise
+    uint32_t minSize = 0;       // smallest face in pixels of the analysed image, 0: the cascade window
+};
+
+// the "opencv-cascade-classifier" xml format with featureType HAAR, stumps only and no tilted features
+bool ParseOpenCvCascade(const std::string& xml, HaarCascade& cascade);
+bool LoadOpenCvCascade(const std::string& path, HaarCascade& cascade);
+std::unique_ptr<IFaceDetector> CreateCascadeFaceDetector(const HaarCascade& cascade, const CascadeParams& params);
+
+/*
+ * Box filtered luma of a frame, at most targetWidth wide with the frame aspect kept. stride is in pixels
+ * of the format as RgaStrideFromBytes() gives it. out is reused, nothing is allocated once it has grown.
+ */
+bool DownscaleLuma(const uint8_t* frame, RgaPixelFormat format, uint32_t width, uint32_t height, uint32_t stride,
+    uint32_t targetWidth, LumaImage& out);
+
+// merges overlapping raw detections like opencv groupRectangles(eps 0.2) and drops those with few neighbours
+void GroupFaceBoxes(std::vector<FaceBox>& boxes, uint32_t minNeighbors);
+
+// keeps the id of a face that overlaps one of the previous result, new faces take nextId and up
+void AssignFaceIds(const std::vector<FaceBox>& previous, std::vector<FaceBox>& faces, int32_t& nextId);
+} // namespace OHOS::Camera
+#endif
@@ -12,13 +12,52 @@
  */
 
 #include "rk_face_node.h"
+#include <algorithm>
 #include <securec.h>
 #include "camera_dump.h"
+#include "rk_node_params.h"
+#include "rk_vendor_tags.h"
 
 namespace OHOS::Camera {
+namespace {
+constexpr int32_t DEFAULT_DETECT_INTERVAL = 5;  // 6 results a second at 30fps
+constexpr int32_t DEFAULT_DETECT_WIDTH = 320;
+constexpr int32_t ENTRY_CAPACITY = 30;    // 30:entry capacity
+constexpr int32_t DATA_CAPACITY = 2000;   // 2000:data capacity, 16 faces take 336 bytes
+constexpr const char* DEFAULT_CASCADE = "/vendor/etc/camera/haarcascade_frontalface_default.xml";
+constexpr int64_t NS_PER_US = 1000;
+constexpr int64_t US_PER_S = 1000000;
+
+int64_t GetMonotonicUs()
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * US_PER_S + ts.tv_nsec / NS_PER_US;
+}
+
+std::unique_ptr<IFaceDetector> CreateDefaultFaceDetector()
+{
+    HaarCascade cascade;
+    std::string path = GetRkNodeStringParam(RK_PARAM_FACE_CASCADE, DEFAULT_CASCADE);
+    if (!LoadOpenCvCascade(path, cascade)) {
+        return nullptr;
+    }
+    CAMERA_LOGI("RKFaceNode cascade %{public}s, %{public}zu stages", path.c_str(), cascade.stages.size());
+    return CreateCascadeFaceDetector(cascade, CascadeParams {});
+}
+
+std::mutex g_factoryLock;
+FaceDetectorFactory g_detectorFactory = CreateDefaultFaceDetector;
+} // namespace
+
 RKFaceNode::RKFaceNode(const std::string &name, const std::string &type, const std::string &cameraId)
-    : NodeBase(name, type, cameraId), metaDataSize_(0)
+    : NodeBase(name, type, cameraId)
 {
+    // both slots once, frames only ever copy them out
+    for (uint32_t i = 0; i < 2; i++) {  // 2: double buffered
+        metaData_.Back() = std::make_shared<CameraMetadata>(ENTRY_CAPACITY, DATA_CAPACITY);
+        metaData_.Publish();
+    }
     CAMERA_LOGV("%{public}s enter, type(%{public}s)\n", name_.c_str(), type_.c_str());
 }
 
@@ -30,6 +69,33 @@ RKFaceNode::~RKFaceNode()
 RetCode RKFaceNode::Start(const int32_t streamId)
 {
     CAMERA_LOGI("RKFaceNode::Start streamId = %{public}d\n", streamId);
+    portTable_.Build(GetOutPorts());
+    detectInterval_ = static_cast<uint32_t>(std::max(GetRkNodeParam(RK_PARAM_FACE_DETECT_INTERVAL,
+        DEFAULT_DETECT_INTERVAL), 0));
+    detectWidth_ = static_cast<uint32_t>(std::max(GetRkNodeParam(RK_PARAM_FACE_DETECT_WIDTH, DEFAULT_DETECT_WIDTH), 1));
+    if (detectInterval_ != 0 && detector_ == nullptr) {
+        FaceDetectorFactory factory;
+        {
+            std::unique_lock<std::mutex> l(g_factoryLock);
+            factory = g_detectorFactory;
+        }
+        detector_ = factory ? factory() : nullptr;
+        if (detector_ == nullptr) {
+            CAMERA_LOGW("RKFaceNode no face detector, faces are not reported");
+        }
+    }
+    if (detector_ != nullptr && detectPool_ == nullptr) {
+        detectPool_ = std::make_unique<RKWorkerPool>("rkface", 1, 1);
+    }
+    {
+        std::unique_lock<std::mutex> l(rgaLock_);
+        if (rgaSessions_.count(streamId) == 0) {
+            std::shared_ptr<RKRgaSession> session = RKRgaSession::Acquire(streamId);
+            if (session != nullptr) {
+                rgaSessions_[streamId] = session;
+            }
+        }
+    }
     CreateMetadataInfo();
     return RC_OK;
 }
@@ -37,8 +103,24 @@ RetCode RKFaceNode::Start(const int32_t streamId)
 RetCode RKFaceNode::Stop(const int32_t streamId)
 {
     CAMERA_LOGI("RKFaceNode::Stop streamId = %{public}d\n", streamId);
+    if (detectPool_ != nullptr) {
+        detectPool_->Drain(streamId);
+    }
+    {
+        std::unique_lock<std::mutex> l(rgaLock_);
+        if (rgaSessions_.erase(streamId) != 0) {
+            RKRgaSession::Release(streamId);
+        }
+    }
+    [[maybe_unused]] FaceDetectStats stats = GetDetectStats();
+    CAMERA_LOGI("RKFaceNode detected %{public}llu of %{public}llu frames, %{public}llu skipped busy, "
+        "%{public}lld us per detection, %{public}llu metadata updates",
+        static_cast<unsigned long long>(stats.detections), static_cast<unsigned long long>(stats.frames),
+        static_cast<unsigned long long>(stats.skippedBusy), static_cast<long long>(stats.detections == 0 ? 0 :
+        stats.totalDetectUs / static_cast<int64_t>(stats.detections)),
+        static_cast<unsigned long long>(metaData_.GetPublishCount()));
     std::unique_lock <std::mutex> lock(mLock_);
-    metaDataSize_ = 0;
+    faces_.clear();
     return RC_OK;
 }
 
@@ -55,20 +137,108 @@ void RKFaceNode::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
         return;
     }
 
+    // the dump and the detector read the frame, an upstream RGA job may still be queued for it
+    int32_t id = buffer->GetStreamId();
+    SyncRga(id);
+
     CameraDumper& dumper = CameraDumper::GetInstance();
     dumper.DumpBuffer("board_RKFaceNode", ENABLE_RKFACE_NODE_CONVERTED, buffer);
 
-    int32_t id = buffer->GetStreamId();
+    IPort* port = portTable_.Find(id, [this] { return GetOutPorts(); });
+    if (port != nullptr) {
+        // the luma is sampled before the metadata takes the place of the image
+        SubmitDetect(buffer);
+        metaData_.Read([this, &buffer](const std::shared_ptr<CameraMetadata>& metadata) {
+            CopyMetadataBuffer(metadata, buffer);
+        });
+        port->DeliverBuffer(buffer);
+        CAMERA_LOGI("RKFaceNode deliver buffer streamid = %{public}d", id);
+    }
+}
 
-    outPutPorts_ = GetOutPorts();
-    for (auto& it : outPutPorts_) {
-        if (it->format_.streamId_ == id) {
-            CopyMetadataBuffer(metaData_, buffer, metaDataSize_);
-            it->DeliverBuffer(buffer);
-            CAMERA_LOGI("RKFaceNode deliver buffer streamid = %{public}d", it->format_.streamId_);
+// RKScaleNode leaves its job queued when a codec node further down syncs, the frame is read here before that
+void RKFaceNode::SyncRga(const int32_t streamId)
+{
+    std::shared_ptr<RKRgaSession> session = nullptr;
+    {
+        std::unique_lock<std::mutex> l(rgaLock_);
+        auto it = rgaSessions_.find(streamId);
+        if (it == rgaSessions_.end()) {
             return;
         }
+        session = it->second;
+    }
+    if (session->Sync() != 0) {
+        CAMERA_LOGE("RKFaceNode rga failed before the frame was read, streamId = %{public}d", streamId);
+    }
+}
+
+void RKFaceNode::SubmitDetect(std::shared_ptr<IBuffer>& buffer)
+{
+    uint64_t frame = detectFrames_.fetch_add(1, std::memory_order_relaxed);
+    if (detectPool_ == nullptr || detectInterval_ == 0 || frame % detectInterval_ != 0) {
+        return;
+    }
+    if (detectBusy_.exchange(true, std::memory_order_acquire)) {
+        detectSkipped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // the frame is as RKScaleNode wrote it, tightly packed I420 whatever the stream format is
+    const RgaPixelFormat format = RgaPixelFormat::YUV420P;
+    uint32_t width = buffer->GetWidth();
+    uint32_t height = buffer->GetHeight();
+    const uint8_t* frameData = static_cast<const uint8_t*>(buffer->GetVirAddress());
+    uint32_t stride = width;
+    if (RgaFrameSize(format, stride, height) > buffer->GetSize() ||
+        !DownscaleLuma(frameData, format, width, height, stride, detectWidth_, detectInput_)) {
+        detectBusy_.store(false, std::memory_order_release);
+        return;
+    }
+    int64_t timestamp = buffer->GetTimestamp();
+    detectPool_->Submit(buffer->GetStreamId(), [this, timestamp](uint32_t) { RunDetect(timestamp); });
+}
+
+void RKFaceNode::RunDetect(int64_t timestamp)
+{
+    int64_t startUs = GetMonotonicUs();
+    if (detector_->Detect(detectInput_, detected_) != 0) {
+        detected_.clear();
     }
+    if (detected_.size() > MAX_FACES) {
+        std::partial_sort(detected_.begin(), detected_.begin() + MAX_FACES, detected_.end(),
+            [](const FaceBox& a, const FaceBox& b) { return a.score > b.score; });
+        detected_.resize(MAX_FACES);
+    }
+    // faces_ only changes here, reading it outside the lock is safe on this thread
+    AssignFaceIds(faces_, detected_, nextFaceId_);
+    int64_t detectUs = GetMonotonicUs() - startUs;
+    {
+        std::unique_lock<std::mutex> lock(mLock_);
+        faces_.swap(detected_);
+        facesTimestamp_ = timestamp;
+        detectStats_.detections++;
+        detectStats_.lastDetectUs = detectUs;
+        detectStats_.totalDetectUs += detectUs;
+        detectStats_.faces = static_cast<uint32_t>(faces_.size());
+    }
+    CreateMetadataInfo();
+    detectBusy_.store(false, std::memory_order_release);
+}
+
+FaceDetectStats RKFaceNode::GetDetectStats()
+{
+    std::unique_lock<std::mutex> lock(mLock_);
+    FaceDetectStats stats = detectStats_;
+    stats.frames = detectFrames_.load(std::memory_order_relaxed);
+    stats.skippedBusy = detectSkipped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void RKFaceNode::SetDetectorFactory(const FaceDetectorFactory& factory)
+{
+    std::unique_lock<std::mutex> l(g_factoryLock);
+    g_detectorFactory = factory;
 }
 
 RetCode RKFaceNode::Config(const int32_t streamId, const CaptureMeta& meta)
@@ -92,86 +262,67 @@ RetCode RKFaceNode::CancelCapture(const int32_t streamId)
 RetCode RKFaceNode::GetFaceDetectMetaData(std::shared_ptr<CameraMetadata> &metadata)
 {
     GetCameraFaceDetectSwitch(metadata);
-    GetCameraFaceRectangles(metadata);
-    GetCameraFaceIds(metadata);
+    if (faceCount_ != 0) {
+        GetCameraFaceRectangles(metadata);
+        GetCameraFaceIds(metadata);
+        GetCameraFaceTimestamp(metadata);
+    }
     return RC_OK;
 }
 
+// updates the entry in place when the slot has it, the face arrays fit the data capacity at any count
+void RKFaceNode::SetMetadataEntry(std::shared_ptr<CameraMetadata> &metadata, uint32_t tag, const void* data,
+    size_t count)
+{
+    camera_metadata_item_t entry;
+    if (FindCameraMetadataItem(metadata->get(), tag, &entry) == 0) {
+        metadata->updateEntry(tag, data, count);
+    } else {
+        metadata->addEntry(tag, data, count);
+    }
+}
+
 RetCode RKFaceNode::GetCameraFaceDetectSwitch(std::shared_ptr<CameraMetadata> &metadata)
 {
-    uint8_t faceDetectSwitch = OHOS_CAMERA_FACE_DETECT_MODE_SIMPLE;
-    metadata->addEntry(OHOS_STATISTICS_FACE_DETECT_SWITCH, &faceDetectSwitch, sizeof(uint8_t));
+    uint8_t faceDetectSwitch = detector_ == nullptr ? OHOS_CAMERA_FACE_DETECT_MODE_OFF :
+        OHOS_CAMERA_FACE_DETECT_MODE_SIMPLE;
+    SetMetadataEntry(metadata, OHOS_STATISTICS_FACE_DETECT_SWITCH, &faceDetectSwitch, sizeof(uint8_t));
     return RC_OK;
 }
 
+// x, y, width, height of each face in fractions of the frame
 RetCode RKFaceNode::GetCameraFaceRectangles(std::shared_ptr<CameraMetadata> &metadata)
 {
-    constexpr int32_t row = 3;
-    constexpr int32_t col = 4;
-    constexpr float rect_one_x = 0.0; // dummy data: faceRectangles data
-    constexpr float rect_one_y = 0.0;
-    constexpr float rect_one_width = 0.2;
-    constexpr float rect_one_height = 0.3;
-
-    constexpr float rect_two_x = 0.3; // dummy data: faceRectangles data
-    constexpr float rect_two_y = 0.3;
-    constexpr float rect_two_width = 0.2;
-    constexpr float rect_two_height = 0.3;
-
-    constexpr float rect_three_x = 0.6; // dummy data: faceRectangles data
-    constexpr float rect_three_y = 0.6;
-    constexpr float rect_three_width = 0.2;
-    constexpr float rect_three_height = 0.3;
-
-    float faceRectangles[row][col];
-    faceRectangles[INDEX_0][INDEX_0] = rect_one_x;
-    faceRectangles[INDEX_0][INDEX_1] = rect_one_y;
-    faceRectangles[INDEX_0][INDEX_2] = rect_one_width;
-    faceRectangles[INDEX_0][INDEX_3] = rect_one_height;
-
-    faceRectangles[INDEX_1][INDEX_0] = rect_two_x;
-    faceRectangles[INDEX_1][INDEX_1] = rect_two_y;
-    faceRectangles[INDEX_1][INDEX_2] = rect_two_width;
-    faceRectangles[INDEX_1][INDEX_3] = rect_two_height;
-
-    faceRectangles[INDEX_2][INDEX_0] = rect_three_x;
-    faceRectangles[INDEX_2][INDEX_1] = rect_three_y;
-    faceRectangles[INDEX_2][INDEX_2] = rect_three_width;
-    faceRectangles[INDEX_2][INDEX_3] = rect_three_height;
-    metadata->addEntry(OHOS_STATISTICS_FACE_RECTANGLES, static_cast<void*>(&faceRectangles[0]),
-        row * col);
+    SetMetadataEntry(metadata, OHOS_STATISTICS_FACE_RECTANGLES, &faceRects_[0][0], faceCount_ * RECT_VALUES);
     return RC_OK;
 }
 
 RetCode RKFaceNode::GetCameraFaceIds(std::shared_ptr<CameraMetadata> &metadata)
 {
-    std::vector<int32_t> vFaceIds;
-    constexpr int32_t id_zero = 0;
-    constexpr int32_t id_one = 1;
-    constexpr int32_t id_two = 2;
-    vFaceIds.push_back(id_zero);
-    vFaceIds.push_back(id_one);
-    vFaceIds.push_back(id_two);
-    metadata->addEntry(OHOS_STATISTICS_FACE_IDS, vFaceIds.data(), vFaceIds.size());
+    SetMetadataEntry(metadata, OHOS_STATISTICS_FACE_IDS, faceIds_, faceCount_);
+    return RC_OK;
+}
+
+// the result trails the frames it is attached to by up to one detection
+RetCode RKFaceNode::GetCameraFaceTimestamp(std::shared_ptr<CameraMetadata> &metadata)
+{
+    SetMetadataEntry(metadata, RK_VENDOR_FACE_FRAME_TIMESTAMP, &faceTimestamp_, 1);
     return RC_OK;
 }
 
-RetCode RKFaceNode::CopyMetadataBuffer(std::shared_ptr<CameraMetadata> &metadata,
-    std::shared_ptr<IBuffer>& outPutBuffer, int32_t dataSize)
+// only the metadata blob is written, the consumer reads EsFrameSize bytes and the rest of the buffer is left as is
+RetCode RKFaceNode::CopyMetadataBuffer(const std::shared_ptr<CameraMetadata> &metadata,
+    std::shared_ptr<IBuffer>& outPutBuffer)
 {
-    int bufferSize = outPutBuffer->GetSize();
-    int metadataSize = metadata->get()->size;
-    CAMERA_LOGI("outPutBuffer.size=%{public}d  and metadataSize=%{public}d ", bufferSize, metadataSize);
-    int ret = 0;
-    ret = memset_s(outPutBuffer->GetVirAddress(),  bufferSize, 0,  bufferSize);
-    if (ret != RC_OK) {
-        CAMERA_LOGE("memset_s failed");
+    if (metadata == nullptr || outPutBuffer->GetVirAddress() == nullptr) {
+        CAMERA_LOGE("CopyMetadataBuffer no metadata or buffer");
         return RC_ERROR;
     }
-
-    if (memcpy_s(outPutBuffer->GetVirAddress(), metadataSize, static_cast<void*>(metadata->get()),
+    uint32_t bufferSize = outPutBuffer->GetSize();
+    uint32_t metadataSize = metadata->get()->size;
+    if (memcpy_s(outPutBuffer->GetVirAddress(), bufferSize, static_cast<void*>(metadata->get()),
         metadataSize) != 0) {
-        CAMERA_LOGE("memcpy_s failed");
+        CAMERA_LOGE("memcpy_s failed, buffer %{public}u metadata %{public}u", bufferSize, metadataSize);
         return RC_ERROR;
     }
     outPutBuffer->SetEsFrameSize(metadataSize);
@@ -190,15 +341,32 @@ RetCode RKFaceNode::CopyBuffer(unsigned char *sourceBuffer, std::shared_ptr<IBuf
 
 RetCode RKFaceNode::CreateMetadataInfo()
 {
-    const int ENTRY_CAPACITY = 30; // 30:entry capacity
-    const int DATA_CAPACITY = 2000; // 2000:data capacity
-    std::unique_lock <std::mutex> lock(mLock_);
-    metaData_ = std::make_shared<CameraMetadata>(ENTRY_CAPACITY, DATA_CAPACITY);
-    RetCode result = GetFaceDetectMetaData(metaData_);
+    std::unique_lock<std::mutex> writeLock(metaWriteLock_);
+    {
+        std::unique_lock<std::mutex> lock(mLock_);
+        faceCount_ = static_cast<uint32_t>(std::min<size_t>(faces_.size(), MAX_FACES));
+        for (uint32_t i = 0; i < faceCount_; i++) {
+            faceRects_[i][INDEX_0] = faces_[i].x;
+            faceRects_[i][INDEX_1] = faces_[i].y;
+            faceRects_[i][INDEX_2] = faces_[i].width;
+            faceRects_[i][INDEX_3] = faces_[i].height;
+            faceIds_[i] = faces_[i].id;
+        }
+        faceTimestamp_ = facesTimestamp_;
+    }
+
+    std::shared_ptr<CameraMetadata>& metadata = metaData_.Back();
+    camera_metadata_item_t entry;
+    // entries cannot be taken out again, the slot starts over when the last face went away
+    if (faceCount_ == 0 && FindCameraMetadataItem(metadata->get(), OHOS_STATISTICS_FACE_RECTANGLES, &entry) == 0) {
+        metadata = std::make_shared<CameraMetadata>(ENTRY_CAPACITY, DATA_CAPACITY);
+    }
+    RetCode result = GetFaceDetectMetaData(metadata);
     if (result  != RC_OK) {
         CAMERA_LOGE("GetFaceDetectMetaData failed\n");
         return RC_ERROR;
     }
+    metaData_.Publish();
     return RC_OK;
 }
 
@@ -15,12 +15,19 @@
 #define HOS_CAMERA_RKFACE_NODE_H
 
 #include <vector>
-#include <condition_variable>
+#include <atomic>
 #include <ctime>
+#include <map>
+#include <memory>
 #include "device_manager_adapter.h"
 #include "utils.h"
 #include "camera.h"
 #include "source_node.h"
+#include "rk_double_buffer.h"
+#include "rk_face_detector.h"
+#include "rk_port_table.h"
+#include "rk_rga_session.h"
+#include "rk_worker_pool.h"
 
 enum FaceRectanglesIndex : int32_t {
     INDEX_0 = 0,
@@ -30,12 +37,21 @@ enum FaceRectanglesIndex : int32_t {
 };
 
 namespace OHOS::Camera {
-std::vector<uint32_t> FaceDetectMetadataTag = {
+const std::vector<uint32_t> FaceDetectMetadataTag = {
     OHOS_STATISTICS_FACE_DETECT_SWITCH,
     OHOS_STATISTICS_FACE_RECTANGLES,
     OHOS_STATISTICS_FACE_IDS
 };
 
+struct FaceDetectStats {
+    uint64_t frames = 0;        // through the node
+    uint64_t detections = 0;    // frames the detector finished
+    uint64_t skippedBusy = 0;   // due frames dropped while the detector was still on an older one
+    int64_t lastDetectUs = 0;
+    int64_t totalDetectUs = 0;
+    uint32_t faces = 0;         // in the latest result
+};
+
 class RKFaceNode : public NodeBase {
 public:
     RKFaceNode(const std::string &name, const std::string &type, const std::string &cameraId);
@@ -47,23 +63,54 @@ public:
     RetCode CancelCapture(const int32_t streamId) override;
     RetCode Flush(const int32_t streamId);
     RetCode Config(const int32_t streamId, const CaptureMeta& meta) override;
+    FaceDetectStats GetDetectStats();
+    // what the node detects with from the next Start, the default loads the RK_PARAM_FACE_CASCADE cascade
+    static void SetDetectorFactory(const FaceDetectorFactory& factory);
 
 private:
     RetCode GetFaceDetectMetaData(std::shared_ptr<CameraMetadata> &metadata);
     RetCode GetCameraFaceDetectSwitch(std::shared_ptr<CameraMetadata> &metadata);
     RetCode GetCameraFaceRectangles(std::shared_ptr<CameraMetadata> &metadata);
     RetCode GetCameraFaceIds(std::shared_ptr<CameraMetadata> &metadata);
+    RetCode GetCameraFaceTimestamp(std::shared_ptr<CameraMetadata> &metadata);
+    static void SetMetadataEntry(std::shared_ptr<CameraMetadata> &metadata, uint32_t tag, const void* data,
+        size_t count);
+    void SyncRga(const int32_t streamId);
+    void SubmitDetect(std::shared_ptr<IBuffer>& buffer);
+    void RunDetect(int64_t timestamp);
     RetCode CopyBuffer(unsigned char *sourceBuffer, std::shared_ptr<IBuffer>& outPutBuffer, int32_t dataSize);
-    RetCode CopyMetadataBuffer(std::shared_ptr<CameraMetadata> &metadata,
-        std::shared_ptr<IBuffer>& outPutBuffer, int32_t dataSize);
+    RetCode CopyMetadataBuffer(const std::shared_ptr<CameraMetadata> &metadata, std::shared_ptr<IBuffer>& outPutBuffer);
     RetCode CreateMetadataInfo();
 
 private:
-    std::vector<std::shared_ptr<IPort>> outPutPorts_;
+    static constexpr uint32_t MAX_FACES = 16;
+    static constexpr uint32_t RECT_VALUES = 4;  // x, y, width, height
+
+    RKPortTable<IPort> portTable_;
     std::mutex mLock_;
-    std::shared_ptr<CameraMetadata> metaData_ = nullptr;
-    std::condition_variable cv_;
-    int32_t metaDataSize_;
+    // what DeliverBuffer copies out, rebuilt in place in the back slot when a result comes in
+    RKDoubleBuffer<std::shared_ptr<CameraMetadata>> metaData_;
+    std::mutex metaWriteLock_;
+    float faceRects_[MAX_FACES][RECT_VALUES] = {};    // the result being written, under metaWriteLock_
+    int32_t faceIds_[MAX_FACES] = {};
+    uint32_t faceCount_ = 0;
+    int64_t faceTimestamp_ = 0;
+    std::vector<FaceBox> faces_;        // latest result, under mLock_
+    int64_t facesTimestamp_ = 0;
+    FaceDetectStats detectStats_;       // frames and skippedBusy are kept in the atomics below
+    std::atomic<uint64_t> detectFrames_ {0};
+    std::atomic<uint64_t> detectSkipped_ {0};
+    uint32_t detectInterval_ = 0;
+    uint32_t detectWidth_ = 0;
+    // owned by the detect worker while detectBusy_ is set, by the delivering thread otherwise
+    std::atomic<bool> detectBusy_ {false};
+    std::unique_ptr<IFaceDetector> detector_ = nullptr;
+    LumaImage detectInput_;
+    std::vector<FaceBox> detected_;
+    int32_t nextFaceId_ = 0;
+    std::mutex rgaLock_;
+    std::map<int32_t, std::shared_ptr<RKRgaSession>> rgaSessions_;
+    std::unique_ptr<RKWorkerPool> detectPool_ = nullptr;   // last, so its thread stops first
 };
 } // namespace OHOS::Camera
 #endif
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_jpeg_encoder.h"
+#include <cstdio>
+#include <cstdlib>
+#include <securec.h>
+#include "camera.h"
+
+extern "C" {
+#include <jpeglib.h>
+#include <turbojpeg.h>
+}
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t RGB888_BPP = 3;
+constexpr uint32_t CHROMA_DIV = 2;
+
+inline uint32_t WStride(const JpegInput& in)
+{
+    return in.wstride == 0 ? in.width : in.wstride;
+}
+
+inline uint32_t HStride(const JpegInput& in)
+{
+    return in.hstride == 0 ? in.height : in.hstride;
+}
+} // namespace
+
+const char* JpegBackendName(JpegBackendType type)
+{
+    switch (type) {
+        case JpegBackendType::MPP:
+            return "mpp";
+        case JpegBackendType::TURBO:
+            return "turbo";
+        case JpegBackendType::LIBJPEG:
+            return "libjpeg";
+        default:
+            return "unknown";
+    }
+}
+
+size_t JpegWorstCaseSize(uint32_t width, uint32_t height)
+{
+    return static_cast<size_t>(tjBufSize(width, height, TJSAMP_420));
+}
+
+/*
+ * libjpeg-turbo compressing the I420 planes directly: no RGB intermediate, no per-scanline calls,
+ * and the jpeg goes straight into the output buffer when it is big enough for the worst case.
+ */
+class TurboJpegEncoder : public IJpegEncoder {
+public:
+    TurboJpegEncoder() : handle_(tjInitCompress()) {}
+    ~TurboJpegEncoder() override
+    {
+        if (handle_ != nullptr) {
+            tjDestroy(handle_);
+        }
+    }
+
+    JpegBackendType GetType() const override
+    {
+        return JpegBackendType::TURBO;
+    }
+
+    const char* GetName() const override
+    {
+        return JpegBackendName(GetType());
+    }
+
+    bool IsReady() const
+    {
+        return handle_ != nullptr;
+    }
+
+    int32_t Encode(const JpegInput& in, JpegOutput& out) override
+    {
+        if (handle_ == nullptr || in.yuv == nullptr || out.data == nullptr) {
+            return -1;
+        }
+        uint32_t ws = WStride(in);
+        uint32_t hs = HStride(in);
+        const unsigned char* planes[3];    // 3: y u v
+        planes[0] = in.yuv;
+        planes[1] = in.yuv + static_cast<size_t>(ws) * hs;
+        planes[2] = planes[1] + static_cast<size_t>(ws / CHROMA_DIV) * (hs / CHROMA_DIV);
+        int strides[3] = {static_cast<int>(ws), static_cast<int>(ws / CHROMA_DIV), static_cast<int>(ws / CHROMA_DIV)};
+
+        unsigned long worst = tjBufSize(in.width, in.height, TJSAMP_420);
+        bool direct = out.capacity >= worst;
+        if (!direct && scratch_.size() < worst) {
+            scratch_.resize(worst);
+        }
+        unsigned char* jpegBuf = direct ? out.data : scratch_.data();
+        unsigned long jpegSize = direct ? out.capacity : scratch_.size();
+        int ret = tjCompressFromYUVPlanes(handle_, planes, in.width, strides, in.height, TJSAMP_420,
+            &jpegBuf, &jpegSize, in.quality, TJFLAG_NOREALLOC | TJFLAG_FASTDCT);
+        if (ret != 0) {
+            CAMERA_LOGE("TurboJpegEncoder failed: %{public}s", tjGetErrorStr2(handle_));
+            return -1;
+        }
+        if (!direct) {
+            if (memcpy_s(out.data, out.capacity, jpegBuf, jpegSize) != 0) {
+                CAMERA_LOGE("TurboJpegEncoder jpeg %{public}lu exceeds output %{public}zu", jpegSize, out.capacity);
+                return -1;
+            }
+        }
+        out.size = jpegSize;
+        return 0;
+    }
+
+private:
+    tjhandle handle_ = nullptr;
+    std::vector<unsigned char> scratch_;
+};
+
+// the original path: RGA converts to RGB888, libjpeg takes it one scanline at a time
+class LibJpegEncoder : public IJpegEncoder {
+public:
+    explicit LibJpegEncoder(std::shared_ptr<RKRgaSession> rga) : rga_(rga) {}
+    ~LibJpegEncoder() override = default;
+
+    JpegBackendType GetType() const override
+    {
+        return JpegBackendType::LIBJPEG;
+    }
+
+    const char* GetName() const override
+    {
+        return JpegBackendName(GetType());
+    }
+
+    int32_t Encode(const JpegInput& in, JpegOutput& out) override
+    {
+        if (rga_ == nullptr || out.data == nullptr) {
+            return -1;
+        }
+        rgb_.resize(static_cast<size_t>(in.width) * in.height * RGB888_BPP);
+
+        RgaJob job;
+        job.src = MakeRgaSurface(in.fd, in.yuv, in.width, in.height, RgaPixelFormat::YUV420P);
+        job.src.wstride = WStride(in);
+        job.src.hstride = HStride(in);
+        job.dst = MakeRgaSurface(-1, rgb_.data(), in.width, in.height, RgaPixelFormat::RGB888);
+        if (rga_->Sync(rga_->Queue(job)) != 0) {
+            return -1;
+        }
+
+        struct jpeg_compress_struct cInfo;
+        struct jpeg_error_mgr jErr;
+        JSAMPROW row_pointer[1];
+        unsigned char* jpegBuf = out.data;
+        unsigned long jpegSize = out.capacity;
+
+        cInfo.err = jpeg_std_error(&jErr);
+        jpeg_create_compress(&cInfo);
+        cInfo.image_width = in.width;
+        cInfo.image_height = in.height;
+        cInfo.input_components = RGB888_BPP;
+        cInfo.in_color_space = JCS_RGB;
+
+        jpeg_set_defaults(&cInfo);
+        jpeg_set_quality(&cInfo, in.quality, TRUE);
+        jpeg_mem_dest(&cInfo, &jpegBuf, &jpegSize);
+        jpeg_start_compress(&cInfo, TRUE);
+
+        while (cInfo.next_scanline < cInfo.image_height) {
+            row_pointer[0] = &rgb_[static_cast<size_t>(cInfo.next_scanline) * in.width * RGB888_BPP];
+            jpeg_write_scanlines(&cInfo, row_pointer, 1);
+        }
+
+        jpeg_finish_compress(&cInfo);
+        jpeg_destroy_compress(&cInfo);
+
+        int32_t ret = 0;
+        if (jpegBuf != out.data) {
+            // libjpeg ran out of the output buffer and moved to its own allocation
+            ret = memcpy_s(out.data, out.capacity, jpegBuf, jpegSize) == 0 ? 0 : -1;
+            free(jpegBuf);
+        }
+        out.size = ret == 0 ? jpegSize : 0;
+        return ret;
+    }
+
+private:
+    std::shared_ptr<RKRgaSession> rga_;
+    std::vector<unsigned char> rgb_;
+};
+
+std::unique_ptr<IJpegEncoder> CreateJpegEncoder(JpegBackendType type, std::shared_ptr<RKRgaSession> rga)
+{
+    switch (type) {
+        case JpegBackendType::MPP:
+            return CreateMppJpegEncoder();
+        case JpegBackendType::TURBO: {
+            auto encoder = std::make_unique<TurboJpegEncoder>();
+            if (!encoder->IsReady()) {
+                return nullptr;
+            }
+            return encoder;
+        }
+        case JpegBackendType::LIBJPEG:
+            if (rga == nullptr) {
+                return nullptr;
+            }
+            return std::make_unique<LibJpegEncoder>(rga);
+        default:
+            return nullptr;
+    }
+}
+} // namespace OHOS::Camera
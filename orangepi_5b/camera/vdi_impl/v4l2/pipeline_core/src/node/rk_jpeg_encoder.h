@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_JPEG_ENCODER_H
+#define HOS_CAMERA_RK_JPEG_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "rk_rga_session.h"
+
+namespace OHOS::Camera {
+enum class JpegBackendType : int32_t {
+    MPP = 0,        // rk3588 hardware jpeg encoder
+    TURBO = 1,      // libjpeg-turbo, straight from the yuv planes
+    LIBJPEG = 2,    // RGA to RGB888, then libjpeg scanlines
+};
+
+// an I420 frame, planes packed to wstride x hstride
+struct JpegInput {
+    int fd = -1;
+    uint8_t* yuv = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t wstride = 0;
+    uint32_t hstride = 0;
+    uint32_t quality = 100;
+};
+
+// the encoder writes into data[0, capacity) and reports the jpeg size
+struct JpegOutput {
+    uint8_t* data = nullptr;
+    size_t capacity = 0;
+    size_t size = 0;
+};
+
+class IJpegEncoder {
+public:
+    virtual ~IJpegEncoder() = default;
+    virtual JpegBackendType GetType() const = 0;
+    virtual const char* GetName() const = 0;
+    virtual int32_t Encode(const JpegInput& in, JpegOutput& out) = 0;
+};
+
+const char* JpegBackendName(JpegBackendType type);
+// output capacity that no backend can overflow for an I420 frame of this size
+size_t JpegWorstCaseSize(uint32_t width, uint32_t height);
+// returns nullptr when the backend is not available on this device
+std::unique_ptr<IJpegEncoder> CreateJpegEncoder(JpegBackendType type, std::shared_ptr<RKRgaSession> rga);
+std::unique_ptr<IJpegEncoder> CreateMppJpegEncoder();
+} // namespace OHOS::Camera
+#endif
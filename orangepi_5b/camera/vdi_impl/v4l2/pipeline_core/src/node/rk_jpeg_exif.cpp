@@ -0,0 +1,462 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_jpeg_exif.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint8_t JPEG_MARKER = 0xff;
+constexpr uint8_t JPEG_APP1 = 0xe1;
+constexpr uint8_t EXIF_HEADER[] = {'E', 'x', 'i', 'f', 0, 0};
+constexpr uint16_t TIFF_MAGIC = 0x002a;
+constexpr uint32_t TIFF_IFD0_OFFSET = 8;
+constexpr uint16_t TIFF_TAG_ORIENTATION = 0x0112;
+constexpr uint16_t TIFF_TYPE_BYTE = 1;
+constexpr uint16_t TIFF_TYPE_ASCII = 2;
+constexpr uint16_t TIFF_TYPE_SHORT = 3;
+constexpr uint16_t TIFF_TYPE_LONG = 4;
+constexpr uint16_t TIFF_TYPE_RATIONAL = 5;
+constexpr uint16_t TIFF_TYPE_UNDEFINED = 7;
+constexpr uint16_t TIFF_TAG_DATE_TIME = 0x0132;
+constexpr uint16_t TIFF_TAG_EXIF_IFD = 0x8769;
+constexpr uint16_t TIFF_TAG_GPS_IFD = 0x8825;
+constexpr uint16_t EXIF_TAG_EXPOSURE_TIME = 0x829a;
+constexpr uint16_t EXIF_TAG_ISO = 0x8827;
+constexpr uint16_t EXIF_TAG_VERSION = 0x9000;
+constexpr uint16_t EXIF_TAG_DATE_TIME_ORIGINAL = 0x9003;
+constexpr uint16_t EXIF_TAG_FOCAL_LENGTH = 0x920a;
+constexpr uint16_t EXIF_TAG_PIXEL_X = 0xa002;
+constexpr uint16_t EXIF_TAG_PIXEL_Y = 0xa003;
+constexpr uint16_t GPS_TAG_VERSION = 0x0000;
+constexpr uint16_t GPS_TAG_LATITUDE_REF = 0x0001;
+constexpr uint16_t GPS_TAG_LATITUDE = 0x0002;
+constexpr uint16_t GPS_TAG_LONGITUDE_REF = 0x0003;
+constexpr uint16_t GPS_TAG_LONGITUDE = 0x0004;
+constexpr uint16_t GPS_TAG_ALTITUDE_REF = 0x0005;
+constexpr uint16_t GPS_TAG_ALTITUDE = 0x0006;
+constexpr size_t MARKER_SIZE = 2;
+constexpr size_t TIFF_HEADER_SIZE = 8;
+constexpr size_t IFD_ENTRY_SIZE = 12;
+// marker, length, Exif header, TIFF header, one IFD entry with its count and next IFD offset
+constexpr size_t APP1_HEADER_SIZE = MARKER_SIZE + sizeof(uint16_t) + sizeof(EXIF_HEADER);
+// the largest set of fields takes 364 bytes, the rest is room for more tags
+constexpr size_t EXIF_APP1_SIZE = 512;
+constexpr size_t INLINE_VALUE_SIZE = 4;
+constexpr size_t MAX_VALUE_SIZE = 24;       // three rationals
+constexpr size_t MAX_IFD_ENTRIES = 8;
+constexpr size_t RATIONAL_SIZE = 8;
+constexpr uint32_t NS_PER_S = 1000000000;
+constexpr uint32_t UM_PER_MM = 1000;
+constexpr uint32_t GPS_SECONDS_DEN = 10000;
+constexpr uint32_t GPS_ALTITUDE_DEN = 100;
+constexpr double MINUTES_PER_DEGREE = 60.0;
+constexpr size_t ORIENTATION_APP1_SIZE = MARKER_SIZE + sizeof(uint16_t) + sizeof(EXIF_HEADER) + TIFF_HEADER_SIZE +
+    sizeof(uint16_t) + IFD_ENTRY_SIZE + sizeof(uint32_t);
+
+// the segment is written big endian ("MM"), like the JPEG marker lengths
+uint8_t* Put16(uint8_t* p, uint16_t v)
+{
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+    return p + sizeof(uint16_t);
+}
+
+uint8_t* Put32(uint8_t* p, uint32_t v)
+{
+    p = Put16(p, static_cast<uint16_t>(v >> 16));
+    return Put16(p, static_cast<uint16_t>(v));
+}
+
+uint16_t Get16(const uint8_t* p)
+{
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t Get32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(Get16(p)) << 16) | Get16(p + sizeof(uint16_t));
+}
+
+struct Rational {
+    uint32_t num = 0;
+    uint32_t den = 1;
+};
+
+uint64_t Gcd(uint64_t a, uint64_t b)
+{
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+Rational MakeRational(uint64_t num, uint64_t den)
+{
+    constexpr uint64_t decimal = 10;
+    uint64_t g = Gcd(num, den);
+    if (g > 1) {
+        num /= g;
+        den /= g;
+    }
+    while (num > UINT32_MAX || den > UINT32_MAX) {
+        num /= decimal;
+        den = den / decimal == 0 ? 1 : den / decimal;
+    }
+    return {static_cast<uint32_t>(num), static_cast<uint32_t>(den)};
+}
+
+// degrees, minutes and seconds of a coordinate
+void ToDms(double degrees, Rational (&dms)[3])
+{
+    double v = std::fabs(degrees);
+    double whole = std::floor(v);
+    double minutes = (v - whole) * MINUTES_PER_DEGREE;
+    double wholeMinutes = std::floor(minutes);
+    double seconds = (minutes - wholeMinutes) * MINUTES_PER_DEGREE;
+    dms[0] = {static_cast<uint32_t>(whole), 1};
+    dms[1] = {static_cast<uint32_t>(wholeMinutes), 1};
+    dms[2] = {static_cast<uint32_t>(std::lround(seconds * GPS_SECONDS_DEN)), GPS_SECONDS_DEN};   // 2: seconds
+}
+
+// one IFD and the values that do not fit its entries, tags are added in ascending order
+class IfdBuilder {
+public:
+    void Add(uint16_t tag, uint16_t type, uint32_t count, const uint8_t* value, size_t size)
+    {
+        if (count_ == MAX_IFD_ENTRIES || size > MAX_VALUE_SIZE) {
+            return;
+        }
+        Entry& e = entries_[count_++];
+        e.tag = tag;
+        e.type = type;
+        e.count = count;
+        e.size = size;
+        memset(e.value, 0, sizeof(e.value));
+        memcpy(e.value, value, size);
+    }
+
+    void AddShort(uint16_t tag, uint16_t v)
+    {
+        uint8_t b[sizeof(uint16_t)];
+        Put16(b, v);
+        Add(tag, TIFF_TYPE_SHORT, 1, b, sizeof(b));
+    }
+
+    void AddLong(uint16_t tag, uint32_t v)
+    {
+        uint8_t b[sizeof(uint32_t)];
+        Put32(b, v);
+        Add(tag, TIFF_TYPE_LONG, 1, b, sizeof(b));
+    }
+
+    void AddRationals(uint16_t tag, const Rational* r, uint32_t count)
+    {
+        uint8_t b[MAX_VALUE_SIZE];
+        uint8_t* p = b;
+        for (uint32_t i = 0; i < count && (i + 1) * RATIONAL_SIZE <= sizeof(b); i++) {
+            p = Put32(p, r[i].num);
+            p = Put32(p, r[i].den);
+        }
+        Add(tag, TIFF_TYPE_RATIONAL, count, b, static_cast<size_t>(p - b));
+    }
+
+    void AddAscii(uint16_t tag, const char* text, size_t size)
+    {
+        Add(tag, TIFF_TYPE_ASCII, static_cast<uint32_t>(size), reinterpret_cast<const uint8_t*>(text), size);
+    }
+
+    // a LONG added before the offsets are known
+    void SetLong(uint16_t tag, uint32_t v)
+    {
+        for (size_t i = 0; i < count_; i++) {
+            if (entries_[i].tag == tag) {
+                Put32(entries_[i].value, v);
+            }
+        }
+    }
+
+    size_t Size() const
+    {
+        size_t size = sizeof(uint16_t) + count_ * IFD_ENTRY_SIZE + sizeof(uint32_t);
+        for (size_t i = 0; i < count_; i++) {
+            if (entries_[i].size > INLINE_VALUE_SIZE) {
+                size += (entries_[i].size + 1) & ~static_cast<size_t>(1);   // values start on a word boundary
+            }
+        }
+        return size;
+    }
+
+    // at tiff + offset, the values right after the entries
+    void Write(uint8_t* tiff, size_t offset) const
+    {
+        uint8_t* p = Put16(tiff + offset, static_cast<uint16_t>(count_));
+        size_t dataOffset = offset + sizeof(uint16_t) + count_ * IFD_ENTRY_SIZE + sizeof(uint32_t);
+        for (size_t i = 0; i < count_; i++) {
+            const Entry& e = entries_[i];
+            p = Put16(p, e.tag);
+            p = Put16(p, e.type);
+            p = Put32(p, e.count);
+            if (e.size <= INLINE_VALUE_SIZE) {
+                memcpy(p, e.value, INLINE_VALUE_SIZE);
+                p += INLINE_VALUE_SIZE;
+                continue;
+            }
+            p = Put32(p, static_cast<uint32_t>(dataOffset));
+            memcpy(tiff + dataOffset, e.value, e.size);
+            dataOffset += (e.size + 1) & ~static_cast<size_t>(1);
+        }
+        Put32(p, 0);    // no next IFD
+    }
+
+private:
+    struct Entry {
+        uint16_t tag = 0;
+        uint16_t type = 0;
+        uint32_t count = 0;
+        uint8_t value[MAX_VALUE_SIZE] = {};
+        size_t size = 0;
+    };
+    Entry entries_[MAX_IFD_ENTRIES];
+    size_t count_ = 0;
+};
+
+void BuildExifIfd(const ExifFields& fields, IfdBuilder& exif)
+{
+    if (fields.exposureNs > 0) {
+        Rational exposure = MakeRational(static_cast<uint64_t>(fields.exposureNs), NS_PER_S);
+        exif.AddRationals(EXIF_TAG_EXPOSURE_TIME, &exposure, 1);
+    }
+    if (fields.iso != 0) {
+        exif.AddShort(EXIF_TAG_ISO, static_cast<uint16_t>(std::min<uint32_t>(fields.iso, UINT16_MAX)));
+    }
+    const uint8_t version[] = {'0', '2', '3', '0'};
+    exif.Add(EXIF_TAG_VERSION, TIFF_TYPE_UNDEFINED, sizeof(version), version, sizeof(version));
+    if (fields.dateTime[0] != 0) {
+        exif.AddAscii(EXIF_TAG_DATE_TIME_ORIGINAL, fields.dateTime, EXIF_DATE_TIME_SIZE);
+    }
+    if (fields.focalLengthUm != 0) {
+        Rational focal = MakeRational(fields.focalLengthUm, UM_PER_MM);
+        exif.AddRationals(EXIF_TAG_FOCAL_LENGTH, &focal, 1);
+    }
+    if (fields.width != 0 && fields.height != 0) {
+        exif.AddLong(EXIF_TAG_PIXEL_X, fields.width);
+        exif.AddLong(EXIF_TAG_PIXEL_Y, fields.height);
+    }
+}
+
+void BuildGpsIfd(const ExifFields& fields, IfdBuilder& gps)
+{
+    const uint8_t version[] = {2, 2, 0, 0};     // 2.2.0.0
+    gps.Add(GPS_TAG_VERSION, TIFF_TYPE_BYTE, sizeof(version), version, sizeof(version));
+    Rational dms[3];
+    gps.AddAscii(GPS_TAG_LATITUDE_REF, fields.latitude < 0 ? "S" : "N", sizeof("N"));
+    ToDms(fields.latitude, dms);
+    gps.AddRationals(GPS_TAG_LATITUDE, dms, 3);     // 3: degrees, minutes, seconds
+    gps.AddAscii(GPS_TAG_LONGITUDE_REF, fields.longitude < 0 ? "W" : "E", sizeof("E"));
+    ToDms(fields.longitude, dms);
+    gps.AddRationals(GPS_TAG_LONGITUDE, dms, 3);    // 3: degrees, minutes, seconds
+    uint8_t belowSeaLevel = fields.altitude < 0 ? 1 : 0;
+    gps.Add(GPS_TAG_ALTITUDE_REF, TIFF_TYPE_BYTE, 1, &belowSeaLevel, 1);
+    Rational altitude = {static_cast<uint32_t>(std::lround(std::fabs(fields.altitude) * GPS_ALTITUDE_DEN)),
+        GPS_ALTITUDE_DEN};
+    gps.AddRationals(GPS_TAG_ALTITUDE, &altitude, 1);
+}
+
+// entries of the IFD at offset, false when it does not lie inside the tiff data
+bool IfdEntries(const uint8_t* tiff, size_t size, uint32_t offset, const uint8_t*& entries, uint16_t& count)
+{
+    if (offset + sizeof(uint16_t) > size) {
+        return false;
+    }
+    count = Get16(tiff + offset);
+    if (offset + sizeof(uint16_t) + static_cast<size_t>(count) * IFD_ENTRY_SIZE > size) {
+        return false;
+    }
+    entries = tiff + offset + sizeof(uint16_t);
+    return true;
+}
+
+// SHORT or LONG in the value field of an entry
+uint32_t EntryInteger(const uint8_t* entry)
+{
+    constexpr size_t typeOffset = 2;
+    constexpr size_t valueOffset = 8;
+    return Get16(entry + typeOffset) == TIFF_TYPE_SHORT ? Get16(entry + valueOffset) : Get32(entry + valueOffset);
+}
+} // namespace
+
+ExifOrientation ToExifOrientation(RgaRotation rotation)
+{
+    switch (rotation) {
+        case RgaRotation::ROT_90:
+            return ExifOrientation::ROT_90;
+        case RgaRotation::ROT_180:
+            return ExifOrientation::ROT_180;
+        case RgaRotation::ROT_270:
+            return ExifOrientation::ROT_270;
+        default:
+            return ExifOrientation::NORMAL;
+    }
+}
+
+size_t ExifOrientationApp1Size()
+{
+    return ORIENTATION_APP1_SIZE;
+}
+
+size_t WriteExifOrientationApp1(uint8_t* dst, size_t capacity, ExifOrientation orientation)
+{
+    if (dst == nullptr || capacity < ORIENTATION_APP1_SIZE) {
+        return 0;
+    }
+
+    uint8_t* p = dst;
+    *p++ = JPEG_MARKER;
+    *p++ = JPEG_APP1;
+    p = Put16(p, static_cast<uint16_t>(ORIENTATION_APP1_SIZE - MARKER_SIZE));
+    for (uint8_t c : EXIF_HEADER) {
+        *p++ = c;
+    }
+    *p++ = 'M';
+    *p++ = 'M';
+    p = Put16(p, TIFF_MAGIC);
+    p = Put32(p, TIFF_IFD0_OFFSET);
+    p = Put16(p, 1);    // one entry
+    p = Put16(p, TIFF_TAG_ORIENTATION);
+    p = Put16(p, TIFF_TYPE_SHORT);
+    p = Put32(p, 1);    // one value, left aligned in the 4 byte field
+    p = Put16(p, static_cast<uint16_t>(orientation));
+    p = Put16(p, 0);
+    p = Put32(p, 0);    // no IFD1
+    return static_cast<size_t>(p - dst);
+}
+
+void FormatExifDateTime(int64_t epochSeconds, char (&dateTime)[EXIF_DATE_TIME_SIZE])
+{
+    time_t t = static_cast<time_t>(epochSeconds);
+    struct tm local = {};
+    if (localtime_r(&t, &local) == nullptr || strftime(dateTime, sizeof(dateTime), "%Y:%m:%d %H:%M:%S", &local) == 0) {
+        dateTime[0] = 0;
+    }
+}
+
+size_t ExifApp1Size()
+{
+    return EXIF_APP1_SIZE;
+}
+
+size_t WriteExifApp1(uint8_t* dst, size_t capacity, const ExifFields& fields)
+{
+    if (dst == nullptr || capacity < EXIF_APP1_SIZE) {
+        return 0;
+    }
+    IfdBuilder ifd0;
+    IfdBuilder exif;
+    IfdBuilder gps;
+    ifd0.AddShort(TIFF_TAG_ORIENTATION, static_cast<uint16_t>(fields.orientation));
+    if (fields.dateTime[0] != 0) {
+        ifd0.AddAscii(TIFF_TAG_DATE_TIME, fields.dateTime, EXIF_DATE_TIME_SIZE);
+    }
+    ifd0.AddLong(TIFF_TAG_EXIF_IFD, 0);
+    if (fields.hasGps) {
+        ifd0.AddLong(TIFF_TAG_GPS_IFD, 0);
+        BuildGpsIfd(fields, gps);
+    }
+    BuildExifIfd(fields, exif);
+
+    size_t exifOffset = TIFF_IFD0_OFFSET + ifd0.Size();
+    size_t gpsOffset = exifOffset + exif.Size();
+    size_t tiffSize = gpsOffset + (fields.hasGps ? gps.Size() : 0);
+    if (APP1_HEADER_SIZE + tiffSize > EXIF_APP1_SIZE) {
+        return 0;
+    }
+    ifd0.SetLong(TIFF_TAG_EXIF_IFD, static_cast<uint32_t>(exifOffset));
+    ifd0.SetLong(TIFF_TAG_GPS_IFD, static_cast<uint32_t>(gpsOffset));
+
+    memset(dst, 0, EXIF_APP1_SIZE);
+    uint8_t* p = dst;
+    *p++ = JPEG_MARKER;
+    *p++ = JPEG_APP1;
+    p = Put16(p, static_cast<uint16_t>(EXIF_APP1_SIZE - MARKER_SIZE));
+    memcpy(p, EXIF_HEADER, sizeof(EXIF_HEADER));
+    uint8_t* tiff = p + sizeof(EXIF_HEADER);
+    tiff[0] = 'M';
+    tiff[1] = 'M';
+    Put16(tiff + sizeof(uint16_t), TIFF_MAGIC);
+    Put32(tiff + sizeof(uint32_t), TIFF_IFD0_OFFSET);
+    ifd0.Write(tiff, TIFF_IFD0_OFFSET);
+    exif.Write(tiff, exifOffset);
+    if (fields.hasGps) {
+        gps.Write(tiff, gpsOffset);
+    }
+    return EXIF_APP1_SIZE;
+}
+
+size_t FindExifApp1(const uint8_t* jpeg, size_t size)
+{
+    constexpr uint8_t soi = 0xd8;
+    constexpr size_t soiSize = 2;
+    if (jpeg == nullptr || size < soiSize + EXIF_APP1_SIZE || jpeg[0] != JPEG_MARKER || jpeg[1] != soi) {
+        return 0;
+    }
+    const uint8_t* app1 = jpeg + soiSize;
+    if (app1[0] != JPEG_MARKER || app1[1] != JPEG_APP1 || Get16(app1 + MARKER_SIZE) != EXIF_APP1_SIZE - MARKER_SIZE ||
+        memcmp(app1 + MARKER_SIZE + sizeof(uint16_t), EXIF_HEADER, sizeof(EXIF_HEADER)) != 0) {
+        return 0;
+    }
+    return soiSize;
+}
+
+bool ParseExifApp1(const uint8_t* app1, size_t size, ExifFields& fields)
+{
+    if (app1 == nullptr || size < APP1_HEADER_SIZE + TIFF_HEADER_SIZE) {
+        return false;
+    }
+    const uint8_t* tiff = app1 + APP1_HEADER_SIZE;
+    size_t tiffSize = size - APP1_HEADER_SIZE;
+    if (tiff[0] != 'M' || tiff[1] != 'M' || Get16(tiff + sizeof(uint16_t)) != TIFF_MAGIC) {
+        return false;
+    }
+    const uint8_t* entries = nullptr;
+    uint16_t count = 0;
+    uint32_t exifOffset = 0;
+    if (!IfdEntries(tiff, tiffSize, Get32(tiff + sizeof(uint32_t)), entries, count)) {
+        return false;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        const uint8_t* e = entries + i * IFD_ENTRY_SIZE;
+        if (Get16(e) == TIFF_TAG_ORIENTATION) {
+            fields.orientation = static_cast<ExifOrientation>(EntryInteger(e));
+        } else if (Get16(e) == TIFF_TAG_EXIF_IFD) {
+            exifOffset = EntryInteger(e);
+        }
+    }
+    if (exifOffset != 0 && IfdEntries(tiff, tiffSize, exifOffset, entries, count)) {
+        for (uint16_t i = 0; i < count; i++) {
+            const uint8_t* e = entries + i * IFD_ENTRY_SIZE;
+            if (Get16(e) == EXIF_TAG_PIXEL_X) {
+                fields.width = EntryInteger(e);
+            } else if (Get16(e) == EXIF_TAG_PIXEL_Y) {
+                fields.height = EntryInteger(e);
+            }
+        }
+    }
+    return true;
+}
+} // namespace OHOS::Camera
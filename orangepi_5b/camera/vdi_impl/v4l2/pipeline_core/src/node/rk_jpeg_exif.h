@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_JPEG_EXIF_H
+#define HOS_CAMERA_RK_JPEG_EXIF_H
+
+#include <cstddef>
+#include <cstdint>
+#include "rk_rga_session.h"
+
+namespace OHOS::Camera {
+// values of the TIFF Orientation tag for a picture that has to be turned clockwise to be upright
+enum class ExifOrientation : uint16_t {
+    NORMAL = 1,
+    ROT_180 = 3,
+    ROT_90 = 6,
+    ROT_270 = 8,
+};
+
+ExifOrientation ToExifOrientation(RgaRotation rotation);
+
+// size of the segment written by WriteExifOrientationApp1, marker included
+size_t ExifOrientationApp1Size();
+
+// writes an APP1 Exif segment carrying only IFD0 Orientation, returns the bytes written or 0
+size_t WriteExifOrientationApp1(uint8_t* dst, size_t capacity, ExifOrientation orientation);
+
+constexpr size_t EXIF_DATE_TIME_SIZE = 20;  // "YYYY:MM:DD HH:MM:SS" and its nul
+
+// what the full segment carries, a zero or empty value leaves its tag out
+struct ExifFields {
+    ExifOrientation orientation = ExifOrientation::NORMAL;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int64_t exposureNs = 0;
+    uint32_t iso = 0;
+    uint32_t focalLengthUm = 0;
+    char dateTime[EXIF_DATE_TIME_SIZE] = {};
+    bool hasGps = false;
+    double latitude = 0.0;      // degrees, north positive
+    double longitude = 0.0;     // degrees, east positive
+    double altitude = 0.0;      // metres above sea level
+};
+
+// local time in the exif DateTime format
+void FormatExifDateTime(int64_t epochSeconds, char (&dateTime)[EXIF_DATE_TIME_SIZE]);
+
+/*
+ * Size of the segment written by WriteExifApp1, marker included. It is fixed whatever the fields, so
+ * the encoder output can carry it from the start and a later node rewrites it in place.
+ */
+size_t ExifApp1Size();
+
+// writes IFD0, the Exif IFD and the GPS IFD padded to ExifApp1Size(), returns that size or 0
+size_t WriteExifApp1(uint8_t* dst, size_t capacity, const ExifFields& fields);
+
+// offset of a segment written by WriteExifApp1 right after the SOI of jpeg, 0 when there is none
+size_t FindExifApp1(const uint8_t* jpeg, size_t size);
+
+// orientation and dimensions back from such a segment, the fields a later writer keeps
+bool ParseExifApp1(const uint8_t* app1, size_t size, ExifFields& fields);
+} // namespace OHOS::Camera
+#endif
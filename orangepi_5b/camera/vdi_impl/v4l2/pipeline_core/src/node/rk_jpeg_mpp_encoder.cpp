@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_jpeg_encoder.h"
+#include "camera.h"
+#include "rk_mpi.h"
+#include "mpp_common.h"
+extern "C" {
+#include "mpi_enc_utils.h"
+}
+
+namespace OHOS::Camera {
+// MPP MJPEG encoder fed with the dma fd of the frame, the context is kept while the size stays the same
+class MppJpegEncoder : public IJpegEncoder {
+public:
+    MppJpegEncoder() = default;
+    ~MppJpegEncoder() override
+    {
+        Reset();
+    }
+
+    JpegBackendType GetType() const override
+    {
+        return JpegBackendType::MPP;
+    }
+
+    const char* GetName() const override
+    {
+        return JpegBackendName(GetType());
+    }
+
+    int32_t Encode(const JpegInput& in, JpegOutput& out) override
+    {
+        if (in.fd < 0 || out.data == nullptr) {
+            return -1;
+        }
+        if (!Prepare(in)) {
+            return -1;
+        }
+
+        size_t size = out.capacity;
+        int ret = hal_mpp_encode(halCtx_, in.fd, out.data, &size);
+        if (ret != 0 || size == 0 || size > out.capacity) {
+            CAMERA_LOGE("MppJpegEncoder encode failed, ret = %{public}d size = %{public}zu", ret, size);
+            return -1;
+        }
+        out.size = size;
+        return 0;
+    }
+
+private:
+    bool Prepare(const JpegInput& in)
+    {
+        uint32_t ws = in.wstride == 0 ? in.width : in.wstride;
+        uint32_t hs = in.hstride == 0 ? in.height : in.hstride;
+        if (halCtx_ != nullptr && in.width == width_ && in.height == height_ && ws == wstride_ && hs == hstride_) {
+            return SetQuality(in.quality);
+        }
+        Reset();
+
+        MpiEncTestArgs args = {};
+        args.width = in.width;
+        args.height = in.height;
+        args.hor_stride = ws;
+        args.ver_stride = hs;
+        args.format = MPP_FMT_YUV420P;
+        args.type = MPP_VIDEO_CodingMJPEG;
+        halCtx_ = hal_mpp_ctx_create(&args);
+        if (halCtx_ == nullptr) {
+            CAMERA_LOGE("MppJpegEncoder hal_mpp_ctx_create %{public}u x %{public}u failed", in.width, in.height);
+            return false;
+        }
+        width_ = in.width;
+        height_ = in.height;
+        wstride_ = ws;
+        hstride_ = hs;
+        quality_ = 0;
+        return SetQuality(in.quality);
+    }
+
+    bool SetQuality(uint32_t quality)
+    {
+        if (quality == quality_) {
+            return true;
+        }
+        MpiEncTestData* data = static_cast<MpiEncTestData*>(halCtx_);
+        mpp_enc_cfg_set_s32(data->cfg, "rc:mode", MPP_ENC_RC_MODE_FIXQP);
+        mpp_enc_cfg_set_s32(data->cfg, "jpeg:q_factor", static_cast<RK_S32>(quality));
+        mpp_enc_cfg_set_s32(data->cfg, "jpeg:qf_max", static_cast<RK_S32>(quality));
+        mpp_enc_cfg_set_s32(data->cfg, "jpeg:qf_min", static_cast<RK_S32>(quality));
+        if (data->mpi->control(data->ctx, MPP_ENC_SET_CFG, data->cfg) != MPP_OK) {
+            CAMERA_LOGE("MppJpegEncoder set quality %{public}u failed", quality);
+            return false;
+        }
+        quality_ = quality;
+        return true;
+    }
+
+    void Reset()
+    {
+        if (halCtx_ != nullptr) {
+            hal_mpp_ctx_delete(halCtx_);
+            halCtx_ = nullptr;
+        }
+        width_ = 0;
+        height_ = 0;
+        wstride_ = 0;
+        hstride_ = 0;
+    }
+
+    void* halCtx_ = nullptr;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t wstride_ = 0;
+    uint32_t hstride_ = 0;
+    uint32_t quality_ = 0;
+};
+
+std::unique_ptr<IJpegEncoder> CreateMppJpegEncoder()
+{
+    return std::make_unique<MppJpegEncoder>();
+}
+} // namespace OHOS::Camera
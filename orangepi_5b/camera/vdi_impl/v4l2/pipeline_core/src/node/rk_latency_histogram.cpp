@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t SUB_BITS = 2;
+constexpr uint64_t SUB_BUCKETS = 1 << SUB_BITS;
+constexpr uint32_t MSB_LIMIT = 63;
+constexpr int64_t NS_PER_US = 1000;
+constexpr double P50 = 0.5;
+constexpr double P90 = 0.9;
+constexpr double P99 = 0.99;
+
+void RecordElapsed(RKLatencyHistogram& histogram, int64_t fromNs, int64_t toNs)
+{
+    if (fromNs > 0 && toNs >= fromNs) {
+        histogram.Record(static_cast<uint64_t>((toNs - fromNs) / NS_PER_US));
+    }
+}
+} // namespace
+
+RKLatencyHistogram::RKLatencyHistogram()
+{
+    Reset();
+}
+
+size_t RKLatencyHistogram::BucketIndex(uint64_t us)
+{
+    if (us < SUB_BUCKETS) {
+        return static_cast<size_t>(us);
+    }
+    uint32_t msb = MSB_LIMIT - static_cast<uint32_t>(__builtin_clzll(us));
+    uint64_t sub = (us >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1);
+    size_t index = static_cast<size_t>((msb - SUB_BITS + 1) * SUB_BUCKETS + sub);
+    return std::min(index, BUCKET_COUNT - 1);
+}
+
+uint64_t RKLatencyHistogram::BucketLowerBound(size_t index)
+{
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    uint64_t msb = index / SUB_BUCKETS + SUB_BITS - 1;
+    uint64_t sub = index % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub) << (msb - SUB_BITS);
+}
+
+void RKLatencyHistogram::Record(uint64_t us)
+{
+    buckets_[BucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumUs_.fetch_add(us, std::memory_order_relaxed);
+    uint64_t max = maxUs_.load(std::memory_order_relaxed);
+    while (us > max && !maxUs_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+    }
+}
+
+void RKLatencyHistogram::Reset()
+{
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sumUs_.store(0, std::memory_order_relaxed);
+    maxUs_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t RKLatencyHistogram::Percentile(double fraction) const
+{
+    uint64_t count = count_.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t upper = i + 1 < BUCKET_COUNT ? BucketLowerBound(i + 1) - 1 : UINT64_MAX;
+            return std::min(upper, maxUs_.load(std::memory_order_relaxed));
+        }
+    }
+    return maxUs_.load(std::memory_order_relaxed);
+}
+
+LatencySummary RKLatencyHistogram::Summarize() const
+{
+    LatencySummary summary;
+    summary.count = count_.load(std::memory_order_relaxed);
+    if (summary.count == 0) {
+        return summary;
+    }
+    summary.meanUs = sumUs_.load(std::memory_order_relaxed) / summary.count;
+    summary.p50Us = Percentile(P50);
+    summary.p90Us = Percentile(P90);
+    summary.p99Us = Percentile(P99);
+    summary.maxUs = maxUs_.load(std::memory_order_relaxed);
+    return summary;
+}
+
+void RKPipelineLatency::Record(const FrameTimes& times)
+{
+    RecordElapsed(stages_[static_cast<size_t>(LatencyStage::CAPTURE_TO_ENCODE)], times.captureNs,
+        times.encodeStartNs);
+    RecordElapsed(stages_[static_cast<size_t>(LatencyStage::ENCODE)], times.encodeStartNs, times.encodeEndNs);
+    RecordElapsed(stages_[static_cast<size_t>(LatencyStage::ENCODE_TO_DELIVERY)], times.encodeEndNs,
+        times.deliveredNs);
+    RecordElapsed(stages_[static_cast<size_t>(LatencyStage::CAPTURE_TO_DELIVERY)], times.captureNs,
+        times.deliveredNs);
+}
+
+void RKPipelineLatency::Reset()
+{
+    for (auto& stage : stages_) {
+        stage.Reset();
+    }
+}
+
+LatencySummary RKPipelineLatency::Summarize(LatencyStage stage) const
+{
+    if (stage >= LatencyStage::COUNT) {
+        return LatencySummary();
+    }
+    return stages_[static_cast<size_t>(stage)].Summarize();
+}
+
+const char* RKPipelineLatency::StageName(LatencyStage stage)
+{
+    switch (stage) {
+        case LatencyStage::CAPTURE_TO_ENCODE:
+            return "capture->encode";
+        case LatencyStage::ENCODE:
+            return "encode";
+        case LatencyStage::ENCODE_TO_DELIVERY:
+            return "encode->delivery";
+        case LatencyStage::CAPTURE_TO_DELIVERY:
+            return "capture->delivery";
+        default:
+            return "unknown";
+    }
+}
+} // namespace OHOS::Camera
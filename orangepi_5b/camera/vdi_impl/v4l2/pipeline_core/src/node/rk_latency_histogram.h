@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_LATENCY_HISTOGRAM_H
+#define HOS_CAMERA_RK_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace OHOS::Camera {
+struct LatencySummary {
+    uint64_t count = 0;
+    uint64_t meanUs = 0;
+    uint64_t p50Us = 0;
+    uint64_t p90Us = 0;
+    uint64_t p99Us = 0;
+    uint64_t maxUs = 0;
+};
+
+/*
+ * Log-linear histogram of microsecond latencies: four buckets per power of two, so a percentile is
+ * off by less than 25%, up to about two hours. Recording is a few relaxed atomic adds and can run
+ * on any thread; a summary taken while frames are recorded may be off by those frames.
+ */
+class RKLatencyHistogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 128;
+
+    RKLatencyHistogram();
+    void Record(uint64_t us);
+    void Reset();
+    // upper bound of the bucket holding the given fraction of the samples, 0 when empty
+    uint64_t Percentile(double fraction) const;
+    LatencySummary Summarize() const;
+
+    static size_t BucketIndex(uint64_t us);
+    static uint64_t BucketLowerBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_;
+    std::atomic<uint64_t> count_ {0};
+    std::atomic<uint64_t> sumUs_ {0};
+    std::atomic<uint64_t> maxUs_ {0};
+};
+
+enum class LatencyStage : uint32_t {
+    CAPTURE_TO_ENCODE = 0,  // sensor to the encoder picking the frame up, isp and the nodes before
+    ENCODE,
+    ENCODE_TO_DELIVERY,     // nal indexing and the ports after the codec node
+    CAPTURE_TO_DELIVERY,
+    COUNT,
+};
+
+// CLOCK_MONOTONIC nanoseconds, the clock v4l2 stamps its buffers with
+struct FrameTimes {
+    int64_t captureNs = 0;
+    int64_t encodeStartNs = 0;
+    int64_t encodeEndNs = 0;
+    int64_t deliveredNs = 0;
+};
+
+// one histogram per stage of a stream, a stage with a missing or out of order stamp is left out
+class RKPipelineLatency {
+public:
+    void Record(const FrameTimes& times);
+    void Reset();
+    LatencySummary Summarize(LatencyStage stage) const;
+    static const char* StageName(LatencyStage stage);
+
+private:
+    std::array<RKLatencyHistogram, static_cast<size_t>(LatencyStage::COUNT)> stages_;
+};
+} // namespace OHOS::Camera
+#endif
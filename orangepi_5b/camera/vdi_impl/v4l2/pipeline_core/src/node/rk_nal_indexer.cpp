@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_nal_indexer.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RK_NAL_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define RK_NAL_USE_SSE2 1
+#endif
+
+namespace OHOS::Camera {
+namespace {
+constexpr size_t START_CODE_SIZE = 3;
+constexpr size_t LONG_START_CODE_SIZE = 4;
+constexpr size_t SIMD_WIDTH = 16;
+// a vector step compares [p, p + 16) against [p + 2, p + 18)
+constexpr size_t SIMD_READ = SIMD_WIDTH + 2;
+
+constexpr uint8_t H264_TYPE_MASK = 0x1f;
+constexpr uint8_t H264_NAL_IDR = 5;
+constexpr uint8_t H264_NAL_SPS = 7;
+constexpr uint8_t H264_NAL_PPS = 8;
+constexpr uint8_t H265_TYPE_SHIFT = 1;
+constexpr uint8_t H265_TYPE_MASK = 0x3f;
+constexpr uint8_t H265_NAL_BLA_W_LP = 16;
+constexpr uint8_t H265_NAL_IRAP_END = 23;   // 22, 23 are reserved IRAP types
+constexpr uint8_t H265_NAL_VPS = 32;
+constexpr uint8_t H265_NAL_PPS = 34;
+} // namespace
+
+const uint8_t* FindStartCodeScalar(const uint8_t* begin, const uint8_t* end)
+{
+    const uint8_t* p = begin;
+    while (p + START_CODE_SIZE <= end) {
+        // p[2] decides how far we may skip: above 1 no start code can begin at p, p + 1 or p + 2
+        if (p[2] > 1) {
+            p += START_CODE_SIZE;
+        } else if (p[2] == 0) {
+            p++;
+        } else if (p[0] == 0 && p[1] == 0) {
+            return p;
+        } else {
+            p += START_CODE_SIZE;
+        }
+    }
+    return end;
+}
+
+const uint8_t* FindStartCodeSimd(const uint8_t* begin, const uint8_t* end)
+{
+    const uint8_t* p = begin;
+#if defined(RK_NAL_USE_NEON)
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    while (end - p >= static_cast<ptrdiff_t>(SIMD_READ)) {
+        uint8x16_t hit = vandq_u8(vandq_u8(vceqq_u8(vld1q_u8(p), zero), vceqq_u8(vld1q_u8(p + 1), zero)),
+            vceqq_u8(vld1q_u8(p + 2), one));
+        // narrow every lane to 4 bits so the first hit can be found with a bit scan
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (bits != 0) {
+            return p + (__builtin_ctzll(bits) >> 2);
+        }
+        p += SIMD_WIDTH;
+    }
+#elif defined(RK_NAL_USE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    while (end - p >= static_cast<ptrdiff_t>(SIMD_READ)) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2));
+        __m128i hit = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(a, zero), _mm_cmpeq_epi8(b, zero)),
+            _mm_cmpeq_epi8(c, one));
+        int bits = _mm_movemask_epi8(hit);
+        if (bits != 0) {
+            return p + __builtin_ctz(static_cast<unsigned int>(bits));
+        }
+        p += SIMD_WIDTH;
+    }
+#endif
+    return FindStartCodeScalar(p, end);
+}
+
+uint8_t GetNalType(NalCodec codec, uint8_t header)
+{
+    if (codec == NalCodec::H265) {
+        return (header >> H265_TYPE_SHIFT) & H265_TYPE_MASK;
+    }
+    return header & H264_TYPE_MASK;
+}
+
+bool IsKeyFrameNal(NalCodec codec, uint8_t type)
+{
+    if (codec == NalCodec::H265) {
+        return type >= H265_NAL_BLA_W_LP && type <= H265_NAL_IRAP_END;
+    }
+    return type == H264_NAL_IDR;
+}
+
+bool IsParameterSetNal(NalCodec codec, uint8_t type)
+{
+    if (codec == NalCodec::H265) {
+        return type >= H265_NAL_VPS && type <= H265_NAL_PPS;
+    }
+    return type == H264_NAL_SPS || type == H264_NAL_PPS;
+}
+
+size_t IndexNalUnits(const uint8_t* data, size_t size, NalCodec codec, NalIndex& index)
+{
+    index.units.clear();
+    index.keyFrame = false;
+    index.hasParameterSets = false;
+    if (data == nullptr || size < START_CODE_SIZE) {
+        return 0;
+    }
+
+    const uint8_t* end = data + size;
+    const uint8_t* start = FindStartCodeSimd(data, end);
+    while (start < end) {
+        const uint8_t* payload = start + START_CODE_SIZE;
+        const uint8_t* next = FindStartCodeSimd(payload, end);
+        const uint8_t* nalEnd = next;
+        // the leading zero of a 4 byte start code belongs to the next unit
+        if (next < end && next > payload && next[-1] == 0) {
+            nalEnd--;
+        }
+
+        if (nalEnd > payload) {
+            NalUnit unit;
+            unit.offset = static_cast<size_t>(payload - data);
+            unit.size = static_cast<size_t>(nalEnd - payload);
+            unit.startCodeSize = (start > data && start[-1] == 0) ? LONG_START_CODE_SIZE : START_CODE_SIZE;
+            unit.type = GetNalType(codec, *payload);
+            index.keyFrame = index.keyFrame || IsKeyFrameNal(codec, unit.type);
+            index.hasParameterSets = index.hasParameterSets || IsParameterSetNal(codec, unit.type);
+            index.units.push_back(unit);
+        }
+        start = next;
+    }
+    return index.units.size();
+}
+
+size_t ExtractParameterSets(const uint8_t* data, const NalIndex& index, NalCodec codec, std::vector<uint8_t>& out)
+{
+    out.clear();
+    if (data == nullptr) {
+        return 0;
+    }
+    for (const NalUnit& unit : index.units) {
+        if (!IsParameterSetNal(codec, unit.type)) {
+            continue;
+        }
+        const uint8_t* begin = data + unit.offset - unit.startCodeSize;
+        out.insert(out.end(), begin, data + unit.offset + unit.size);
+    }
+    return out.size();
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_NAL_INDEXER_H
+#define HOS_CAMERA_RK_NAL_INDEXER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace OHOS::Camera {
+enum class NalCodec : int32_t {
+    H264 = 0,
+    H265,
+};
+
+struct NalUnit {
+    size_t offset = 0;          // first byte of the NAL header, right after the start code
+    size_t size = 0;            // header and payload, up to the next start code
+    uint8_t startCodeSize = 0;  // 3 or 4
+    uint8_t type = 0;
+};
+
+// summary of one access unit, everything comes from a single pass over the bitstream
+struct NalIndex {
+    std::vector<NalUnit> units;
+    bool keyFrame = false;
+    bool hasParameterSets = false;
+};
+
+// first "00 00 01" in [begin, end), or end; the SIMD variant falls back to scalar without NEON/SSE2
+const uint8_t* FindStartCodeScalar(const uint8_t* begin, const uint8_t* end);
+const uint8_t* FindStartCodeSimd(const uint8_t* begin, const uint8_t* end);
+
+uint8_t GetNalType(NalCodec codec, uint8_t header);
+// H.264 IDR, H.265 IRAP (BLA, IDR, CRA)
+bool IsKeyFrameNal(NalCodec codec, uint8_t type);
+// H.264 SPS/PPS, H.265 VPS/SPS/PPS
+bool IsParameterSetNal(NalCodec codec, uint8_t type);
+
+// indexes an Annex-B buffer, reusing the storage of index.units; returns the number of NAL units
+size_t IndexNalUnits(const uint8_t* data, size_t size, NalCodec codec, NalIndex& index);
+
+// copies the parameter set NALs of an indexed buffer, start codes included, into out
+size_t ExtractParameterSets(const uint8_t* data, const NalIndex& index, NalCodec codec, std::vector<uint8_t>& out);
+} // namespace OHOS::Camera
+#endif
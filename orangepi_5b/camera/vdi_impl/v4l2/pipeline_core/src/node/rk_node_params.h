@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_NODE_PARAMS_H
+#define HOS_CAMERA_RK_NODE_PARAMS_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include "parameter.h"
+
+namespace OHOS::Camera {
+// board node tunables, read from system parameters when a stream starts
+constexpr const char* RK_PARAM_RGBA_ZERO_COPY = "persist.camera.rkcodec.rgba_zero_copy";
+constexpr const char* RK_PARAM_JPEG_BACKEND = "persist.camera.rkcodec.jpeg_backend";    // 0 mpp, 1 turbo, 2 libjpeg
+constexpr const char* RK_PARAM_JPEG_EXIF_ORIENTATION = "persist.camera.rkcodec.jpeg_exif_orientation";
+constexpr const char* RK_PARAM_JPEG_EXIF_APP1 = "persist.camera.rkcodec.jpeg_exif_app1";  // 1: reserve a full segment
+constexpr const char* RK_PARAM_JPEG_WORKERS = "persist.camera.rkcodec.jpeg_workers";    // 0: encode in place
+constexpr const char* RK_PARAM_JPEG_QUEUE_DEPTH = "persist.camera.rkcodec.jpeg_queue_depth";
+constexpr const char* RK_PARAM_VIDEO_RC_MODE = "persist.camera.rkcodec.video_rc_mode";  // 0 cbr, 1 vbr, 2 avbr
+constexpr const char* RK_PARAM_VIDEO_BITRATE = "persist.camera.rkcodec.video_bitrate";  // bps, 0: from the size
+constexpr const char* RK_PARAM_VIDEO_GOP = "persist.camera.rkcodec.video_gop";
+constexpr const char* RK_PARAM_SCALE_FANOUT = "persist.camera.rkscale.fanout";  // 0 off, 1 shared, 2 cascade
+constexpr const char* RK_PARAM_FACE_DETECT_INTERVAL = "persist.camera.rkface.detect_interval";  // frames, 0: off
+constexpr const char* RK_PARAM_FACE_DETECT_WIDTH = "persist.camera.rkface.detect_width";    // of the analysed luma
+constexpr const char* RK_PARAM_FACE_CASCADE = "persist.camera.rkface.cascade";  // path of an opencv haar cascade
+
+inline int32_t GetRkNodeParam(const std::string& key, int32_t defValue)
+{
+    constexpr uint32_t valueLen = 32;
+    char value[valueLen] = {0};
+    if (GetParameter(key.c_str(), "", value, valueLen) <= 0) {
+        return defValue;
+    }
+    char* end = nullptr;
+    long result = strtol(value, &end, 0);
+    if (end == value) {
+        return defValue;
+    }
+    return static_cast<int32_t>(result);
+}
+
+inline std::string GetRkNodeStringParam(const std::string& key, const std::string& defValue)
+{
+    constexpr uint32_t valueLen = 96;   // 96: PARAM_VALUE_LEN_MAX
+    char value[valueLen] = {0};
+    if (GetParameter(key.c_str(), "", value, valueLen) <= 0) {
+        return defValue;
+    }
+    return value;
+}
+
+// a per-stream override "<key>.<streamId>" wins over the node wide "<key>"
+inline int32_t GetRkNodeStreamParam(const std::string& key, int32_t streamId, int32_t defValue)
+{
+    return GetRkNodeParam(key + "." + std::to_string(streamId), GetRkNodeParam(key, defValue));
+}
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_PORT_TABLE_H
+#define HOS_CAMERA_RK_PORT_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace OHOS::Camera {
+/*
+ * streamId -> output port lookup for the board nodes. GetOutPorts() hands out a copy of the port
+ * vector, so looking a port up per frame cost a vector allocation, a refcount round trip per port
+ * and a linear scan. The table is built from that vector when a stream starts and published as an
+ * immutable open addressed hash; Find() is one acquire load and a probe or two, with no shared_ptr
+ * copies. Tables that were replaced stay around until the node goes away, as a frame on another
+ * stream may still be reading one, and they only change when the ports do.
+ */
+template<typename Port>
+class RKPortTable {
+public:
+    RKPortTable() = default;
+    RKPortTable(const RKPortTable&) = delete;
+    RKPortTable& operator=(const RKPortTable&) = delete;
+
+    // returns true when the ports changed and a new table was published
+    bool Build(const std::vector<std::shared_ptr<Port>>& ports)
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        const Table* current = table_.load(std::memory_order_relaxed);
+        if (current != nullptr && current->owned == ports) {
+            return false;
+        }
+
+        auto table = std::make_unique<Table>();
+        table->owned = ports;
+        size_t slots = MIN_SLOTS;
+        while (slots < ports.size() * LOAD_FACTOR_INV) {
+            slots <<= 1;
+        }
+        table->mask = slots - 1;
+        table->ids.assign(slots, 0);
+        table->ports.assign(slots, nullptr);
+        for (const auto& port : ports) {
+            if (port == nullptr) {
+                continue;
+            }
+            int32_t streamId = port->format_.streamId_;
+            size_t slot = Hash(streamId) & table->mask;
+            while (table->ports[slot] != nullptr && table->ids[slot] != streamId) {
+                slot = (slot + 1) & table->mask;
+            }
+            // the first port of a stream wins, like the scan it replaces
+            if (table->ports[slot] == nullptr) {
+                table->ids[slot] = streamId;
+                table->ports[slot] = port.get();
+            }
+        }
+        table_.store(table.get(), std::memory_order_release);
+        tables_.push_back(std::move(table));
+        return true;
+    }
+
+    // the port stays valid for as long as the table does, that is the life of the node
+    Port* Find(int32_t streamId) const
+    {
+        const Table* table = table_.load(std::memory_order_acquire);
+        if (table == nullptr) {
+            return nullptr;
+        }
+        for (size_t slot = Hash(streamId) & table->mask; table->ports[slot] != nullptr;
+            slot = (slot + 1) & table->mask) {
+            if (table->ids[slot] == streamId) {
+                return table->ports[slot];
+            }
+        }
+        return nullptr;
+    }
+
+    // Find(), reloading the ports first when the stream is unknown, in case they were linked after Start
+    template<typename GetPorts>
+    Port* Find(int32_t streamId, const GetPorts& getPorts)
+    {
+        Port* port = Find(streamId);
+        if (port == nullptr && Build(getPorts())) {
+            port = Find(streamId);
+        }
+        return port;
+    }
+
+    size_t GetVersionCount()
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        return tables_.size();
+    }
+
+private:
+    static constexpr size_t MIN_SLOTS = 8;
+    static constexpr size_t LOAD_FACTOR_INV = 2;   // at most half full, probes stay short
+
+    struct Table {
+        size_t mask = 0;
+        std::vector<int32_t> ids;
+        std::vector<Port*> ports;
+        std::vector<std::shared_ptr<Port>> owned;
+    };
+
+    static size_t Hash(int32_t streamId)
+    {
+        // fibonacci hashing spreads the small consecutive ids the host hands out
+        constexpr uint32_t golden = 0x9e3779b1;
+        constexpr uint32_t shift = 16;
+        return static_cast<size_t>((static_cast<uint32_t>(streamId) * golden) >> shift);
+    }
+
+    std::mutex lock_;
+    std::atomic<const Table*> table_ {nullptr};
+    std::vector<std::unique_ptr<const Table>> tables_;
+};
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include "rk_rga_session.h"
+#include "camera.h"
+#include "RockchipRga.h"
+#include "RgaUtils.h"
+#include "RgaApi.h"
+
+namespace OHOS::Camera {
+namespace {
+int ToRkFormat(RgaPixelFormat format)
+{
+    switch (format) {
+        case RgaPixelFormat::YUV420P:
+            return RK_FORMAT_YCbCr_420_P;
+        case RgaPixelFormat::NV12:
+            return RK_FORMAT_YCbCr_420_SP;
+        case RgaPixelFormat::NV21:
+            return RK_FORMAT_YCrCb_420_SP;
+        case RgaPixelFormat::YUYV:
+            return RK_FORMAT_YUYV_422;
+        case RgaPixelFormat::RGBA8888:
+            return RK_FORMAT_RGBA_8888;
+        case RgaPixelFormat::RGB888:
+            return RK_FORMAT_RGB_888;
+        default:
+            return RK_FORMAT_YCbCr_420_P;
+    }
+}
+
+int ToRkRotation(RgaRotation rotation)
+{
+    switch (rotation) {
+        case RgaRotation::ROT_90:
+            return HAL_TRANSFORM_ROT_90;
+        case RgaRotation::ROT_180:
+            return HAL_TRANSFORM_ROT_180;
+        case RgaRotation::ROT_270:
+            return HAL_TRANSFORM_ROT_270;
+        default:
+            return 0;
+    }
+}
+
+void ToRgaInfo(const RgaSurface& surface, rga_info_t& info)
+{
+    info.mmuFlag = 1;
+    if (surface.fd >= 0) {
+        info.fd = surface.fd;
+        info.virAddr = nullptr;
+    } else {
+        info.fd = -1;
+        info.virAddr = surface.virAddr;
+    }
+
+    uint32_t w = surface.rect.width == 0 ? surface.width : surface.rect.width;
+    uint32_t h = surface.rect.height == 0 ? surface.height : surface.rect.height;
+    uint32_t wstride = surface.wstride == 0 ? surface.width : surface.wstride;
+    uint32_t hstride = surface.hstride == 0 ? surface.height : surface.hstride;
+    rga_set_rect(&info.rect, surface.rect.x, surface.rect.y, w, h, wstride, hstride, ToRkFormat(surface.format));
+}
+} // namespace
+
+class RgaHwBackend : public IRgaBackend {
+public:
+    RgaHwBackend() = default;
+    ~RgaHwBackend() override = default;
+
+    int32_t Run(const std::vector<RgaJob>& batch) override
+    {
+        int32_t result = 0;
+        for (auto& job : batch) {
+            rga_info_t src = {};
+            rga_info_t dst = {};
+            ToRgaInfo(job.src, src);
+            ToRgaInfo(job.dst, dst);
+            src.rotation = ToRkRotation(job.rotation);
+            // the jobs of a batch may run on different RGA cores, drain them before reading their output
+            if (job.waitPrevious) {
+                rkRga_.RkRgaFlush();
+            }
+            // queue every job of the batch, RkRgaFlush below waits for all of them at once
+            src.sync_mode = RGA_BLIT_ASYNC;
+            int ret = rkRga_.RkRgaBlit(&src, &dst, NULL);
+            if (ret != 0) {
+                CAMERA_LOGE("RgaHwBackend blit failed, ret = %{public}d", ret);
+                result = ret;
+            }
+        }
+        rkRga_.RkRgaFlush();
+        return result;
+    }
+
+    int32_t AllocBuffer(uint32_t width, uint32_t height, RgaPixelFormat format, RgaBuffer& buffer) override
+    {
+        constexpr int bitsPerByte = 8;
+        bo_t* bo = new bo_t();
+        size_t size = RgaFrameSize(format, width, height);
+        // allocate as a 8bpp surface of the right byte size, RGA gets the real layout per blit
+        int rows = static_cast<int>((size + width - 1) / width);
+        if (rkRga_.RkRgaGetAllocBuffer(bo, width, rows, bitsPerByte) != 0) {
+            CAMERA_LOGE("RgaHwBackend alloc %{public}u x %{public}u failed", width, height);
+            delete bo;
+            return -1;
+        }
+        // the cpu fills and reads these buffers too (jpeg input, benchmarks), so they are mapped as well
+        if (rkRga_.RkRgaGetMmap(bo) != 0 || bo->ptr == nullptr) {
+            CAMERA_LOGE("RgaHwBackend map %{public}u x %{public}u failed", width, height);
+            rkRga_.RkRgaFree(bo);
+            delete bo;
+            return -1;
+        }
+        int fd = -1;
+        if (rkRga_.RkRgaGetBufferFd(bo, &fd) != 0 || fd < 0) {
+            CAMERA_LOGE("RgaHwBackend get buffer fd failed");
+            rkRga_.RkRgaUnmap(bo);
+            rkRga_.RkRgaFree(bo);
+            delete bo;
+            return -1;
+        }
+        buffer.fd = fd;
+        buffer.virAddr = bo->ptr;
+        buffer.size = size;
+        buffer.handle = bo;
+        return 0;
+    }
+
+    void FreeBuffer(RgaBuffer& buffer) override
+    {
+        if (buffer.fd >= 0) {
+            close(buffer.fd);
+        }
+        bo_t* bo = static_cast<bo_t*>(buffer.handle);
+        if (bo != nullptr) {
+            rkRga_.RkRgaUnmap(bo);
+            rkRga_.RkRgaFree(bo);
+            delete bo;
+        }
+        buffer = {};
+    }
+
+private:
+    RockchipRga rkRga_;
+};
+
+std::shared_ptr<IRgaBackend> CreateRgaHwBackend()
+{
+    return std::make_shared<RgaHwBackend>();
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_rga_session.h"
+#include "camera.h"
+
+namespace OHOS::Camera {
+namespace {
+struct SessionEntry {
+    std::shared_ptr<RKRgaSession> session;
+    uint32_t users = 0;
+};
+
+std::mutex g_registryLock;
+std::map<int32_t, SessionEntry> g_sessions;
+RKRgaSession::BackendFactory g_backendFactory = CreateRgaHwBackend;
+} // namespace
+
+size_t RgaFrameSize(RgaPixelFormat format, uint32_t wstride, uint32_t hstride)
+{
+    constexpr size_t yuv420Num = 3;
+    constexpr size_t yuv420Den = 2;
+    constexpr size_t yuyvBpp = 2;
+    constexpr size_t rgbaBpp = 4;
+    constexpr size_t rgbBpp = 3;
+
+    size_t pixels = static_cast<size_t>(wstride) * hstride;
+    switch (format) {
+        case RgaPixelFormat::YUV420P:
+        case RgaPixelFormat::NV12:
+        case RgaPixelFormat::NV21:
+            return pixels * yuv420Num / yuv420Den;
+        case RgaPixelFormat::YUYV:
+            return pixels * yuyvBpp;
+        case RgaPixelFormat::RGBA8888:
+            return pixels * rgbaBpp;
+        case RgaPixelFormat::RGB888:
+            return pixels * rgbBpp;
+        default:
+            return 0;
+    }
+}
+
+bool ToRgaPixelFormat(int32_t cameraFormat, RgaPixelFormat& format)
+{
+    switch (cameraFormat) {
+        case CAMERA_FORMAT_YCBCR_420_P:
+            format = RgaPixelFormat::YUV420P;
+            return true;
+        case CAMERA_FORMAT_YCBCR_420_SP:
+            format = RgaPixelFormat::NV12;
+            return true;
+        case CAMERA_FORMAT_YCRCB_420_SP:
+            format = RgaPixelFormat::NV21;
+            return true;
+        case CAMERA_FORMAT_YUYV_422_PKG:
+            format = RgaPixelFormat::YUYV;
+            return true;
+        case CAMERA_FORMAT_RGBA_8888:
+            format = RgaPixelFormat::RGBA8888;
+            return true;
+        case CAMERA_FORMAT_RGB_888:
+            format = RgaPixelFormat::RGB888;
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t RgaStrideFromBytes(RgaPixelFormat format, uint32_t width, uint32_t strideBytes)
+{
+    constexpr uint32_t yuyvBpp = 2;
+    constexpr uint32_t rgbaBpp = 4;
+    constexpr uint32_t rgbBpp = 3;
+    uint32_t bpp = 1;   // the luma row of the planar and semi-planar layouts
+    if (format == RgaPixelFormat::YUYV) {
+        bpp = yuyvBpp;
+    } else if (format == RgaPixelFormat::RGBA8888) {
+        bpp = rgbaBpp;
+    } else if (format == RgaPixelFormat::RGB888) {
+        bpp = rgbBpp;
+    }
+    uint32_t stride = strideBytes / bpp;
+    return (strideBytes % bpp != 0 || stride < width) ? width : stride;
+}
+
+RKRgaSession::RKRgaSession(std::shared_ptr<IRgaBackend> backend)
+    : backend_(backend)
+{
+    worker_ = std::thread([this] { WorkerLoop(); });
+}
+
+RKRgaSession::~RKRgaSession()
+{
+    Sync();
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        running_ = false;
+    }
+    workCv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+uint64_t RKRgaSession::Queue(const RgaJob& job)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    pending_.push_back(job);
+    stats_.jobs++;
+    return committed_ + 1;
+}
+
+uint64_t RKRgaSession::Queue(std::initializer_list<RgaJob> jobs)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    pending_.insert(pending_.end(), jobs);
+    stats_.jobs += jobs.size();
+    return committed_ + 1;
+}
+
+bool RKRgaSession::CommitLocked()
+{
+    if (pending_.empty()) {
+        return false;
+    }
+    if (spare_.empty()) {
+        batches_.emplace_back();
+    } else {
+        batches_.splice(batches_.end(), spare_, spare_.begin());
+    }
+    batches_.back().swap(pending_);
+    committed_++;
+    stats_.batches++;
+    return true;
+}
+
+void RKRgaSession::Commit()
+{
+    bool committed = false;
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        committed = CommitLocked();
+    }
+    if (committed) {
+        workCv_.notify_one();
+    }
+}
+
+void RKRgaSession::WaitLocked(std::unique_lock<std::mutex>& l, uint64_t ticket)
+{
+    doneCv_.wait(l, [this, ticket] { return completed_ >= ticket; });
+    stats_.syncs++;
+}
+
+int32_t RKRgaSession::ResultLocked(uint64_t ticket) const
+{
+    const BatchResult& slot = results_[ticket % RESULT_SLOTS];
+    if (slot.ticket != ticket) {
+        CAMERA_LOGW("RKRgaSession result of batch %{public}llu is gone", static_cast<unsigned long long>(ticket));
+        return 0;
+    }
+    return slot.result;
+}
+
+// waits for everything committed so far, the result is the one of the batch committed here
+int32_t RKRgaSession::Sync()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    bool committed = CommitLocked();
+    uint64_t last = committed_;
+    if (committed) {
+        workCv_.notify_one();
+    }
+    WaitLocked(l, last);
+    return committed ? ResultLocked(last) : 0;
+}
+
+// waits for the batch Queue() returned the ticket of, committing it when it is still pending
+int32_t RKRgaSession::Sync(uint64_t ticket)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    if (ticket > committed_ && CommitLocked()) {
+        workCv_.notify_one();
+    }
+    if (ticket == 0 || ticket > committed_) {
+        return 0;
+    }
+    WaitLocked(l, ticket);
+    return ResultLocked(ticket);
+}
+
+int32_t RKRgaSession::AllocBuffer(uint32_t width, uint32_t height, RgaPixelFormat format, RgaBuffer& buffer)
+{
+    if (backend_ == nullptr) {
+        return -1;
+    }
+    return backend_->AllocBuffer(width, height, format, buffer);
+}
+
+void RKRgaSession::FreeBuffer(RgaBuffer& buffer)
+{
+    if (backend_ != nullptr) {
+        backend_->FreeBuffer(buffer);
+    }
+}
+
+void RKRgaSession::SetDeferredConsumer(bool deferred)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    deferredConsumer_ = deferred;
+}
+
+bool RKRgaSession::HasDeferredConsumer()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    return deferredConsumer_;
+}
+
+bool RKRgaSession::SharesSourceReads() const
+{
+    return backend_ != nullptr && backend_->SharesSourceReads();
+}
+
+RgaSessionStats RKRgaSession::GetStats()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    return stats_;
+}
+
+void RKRgaSession::WorkerLoop()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    while (true) {
+        workCv_.wait(l, [this] { return !batches_.empty() || !running_; });
+        if (batches_.empty()) {
+            return;
+        }
+        std::list<std::vector<RgaJob>> running;
+        running.splice(running.end(), batches_, batches_.begin());
+        const std::vector<RgaJob>& batch = running.front();
+
+        l.unlock();
+        int32_t ret = backend_ == nullptr ? -1 : backend_->Run(batch);
+        l.lock();
+
+        if (ret != 0) {
+            CAMERA_LOGE("RKRgaSession batch of %{public}zu jobs failed, ret = %{public}d", batch.size(), ret);
+            stats_.errors++;
+        }
+        running.front().clear();
+        spare_.splice(spare_.end(), running);
+        completed_++;
+        results_[completed_ % RESULT_SLOTS] = {completed_, ret};
+        doneCv_.notify_all();
+    }
+}
+
+std::shared_ptr<RKRgaSession> RKRgaSession::Acquire(const int32_t streamId)
+{
+    std::unique_lock<std::mutex> l(g_registryLock);
+    SessionEntry& entry = g_sessions[streamId];
+    if (entry.session == nullptr) {
+        std::shared_ptr<IRgaBackend> backend = g_backendFactory ? g_backendFactory() : nullptr;
+        if (backend == nullptr) {
+            CAMERA_LOGE("RKRgaSession::Acquire no rga backend for stream %{public}d", streamId);
+            g_sessions.erase(streamId);
+            return nullptr;
+        }
+        entry.session = std::make_shared<RKRgaSession>(backend);
+    }
+    entry.users++;
+    return entry.session;
+}
+
+std::shared_ptr<RKRgaSession> RKRgaSession::Create()
+{
+    BackendFactory factory;
+    {
+        std::unique_lock<std::mutex> l(g_registryLock);
+        factory = g_backendFactory;
+    }
+    std::shared_ptr<IRgaBackend> backend = factory ? factory() : nullptr;
+    if (backend == nullptr) {
+        CAMERA_LOGE("RKRgaSession::Create no rga backend");
+        return nullptr;
+    }
+    return std::make_shared<RKRgaSession>(backend);
+}
+
+void RKRgaSession::Release(const int32_t streamId)
+{
+    std::shared_ptr<RKRgaSession> last = nullptr;
+    {
+        std::unique_lock<std::mutex> l(g_registryLock);
+        auto it = g_sessions.find(streamId);
+        if (it == g_sessions.end()) {
+            return;
+        }
+        if (--it->second.users == 0) {
+            last = it->second.session;
+            g_sessions.erase(it);
+        }
+    }
+    if (last != nullptr) {
+        last->Sync();
+    }
+}
+
+void RKRgaSession::SetBackendFactory(const BackendFactory& factory)
+{
+    std::unique_lock<std::mutex> l(g_registryLock);
+    g_backendFactory = factory;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_RGA_SESSION_H
+#define HOS_CAMERA_RK_RGA_SESSION_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace OHOS::Camera {
+enum class RgaPixelFormat : int32_t {
+    YUV420P = 0,
+    NV12,
+    NV21,
+    YUYV,
+    RGBA8888,
+    RGB888,
+};
+
+enum class RgaRotation : int32_t {
+    ROT_0 = 0,
+    ROT_90,
+    ROT_180,
+    ROT_270,
+};
+
+struct RgaRect {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;     // 0 means the whole image
+    uint32_t height = 0;
+};
+
+// one image as seen by RGA, strides are in pixels like rga_set_rect
+struct RgaSurface {
+    int fd = -1;
+    void* virAddr = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t wstride = 0;
+    uint32_t hstride = 0;
+    RgaPixelFormat format = RgaPixelFormat::YUV420P;
+    RgaRect rect;
+};
+
+struct RgaJob {
+    RgaSurface src;
+    RgaSurface dst;
+    RgaRotation rotation = RgaRotation::ROT_0;
+    bool waitPrevious = false;  // reads what an earlier job of the same batch writes
+};
+
+struct RgaBuffer {
+    int fd = -1;
+    void* virAddr = nullptr;
+    size_t size = 0;
+    void* handle = nullptr;
+};
+
+size_t RgaFrameSize(RgaPixelFormat format, uint32_t wstride, uint32_t hstride);
+// a CAMERA_FORMAT_* of the HDI as an RGA layout, false when the nodes have no RGA path for it
+bool ToRgaPixelFormat(int32_t cameraFormat, RgaPixelFormat& format);
+// pixels per row of a row stride in bytes, the width when the stride is unknown or too small
+uint32_t RgaStrideFromBytes(RgaPixelFormat format, uint32_t width, uint32_t strideBytes);
+
+inline RgaSurface MakeRgaSurface(int fd, void* virAddr, uint32_t width, uint32_t height, RgaPixelFormat format)
+{
+    RgaSurface surface;
+    surface.fd = fd;
+    surface.virAddr = virAddr;
+    surface.width = width;
+    surface.height = height;
+    surface.wstride = width;
+    surface.hstride = height;
+    surface.format = format;
+    return surface;
+}
+
+class IRgaBackend {
+public:
+    virtual ~IRgaBackend() = default;
+    // runs a whole batch and returns once every job of it has completed
+    virtual int32_t Run(const std::vector<RgaJob>& batch) = 0;
+    // a buffer RGA reaches through fd and the cpu through virAddr, both are set on success
+    virtual int32_t AllocBuffer(uint32_t width, uint32_t height, RgaPixelFormat format, RgaBuffer& buffer) = 0;
+    virtual void FreeBuffer(RgaBuffer& buffer) = 0;
+    // consecutive jobs of a batch with the same source are served from one read of it
+    virtual bool SharesSourceReads() const
+    {
+        return false;
+    }
+};
+
+std::shared_ptr<IRgaBackend> CreateRgaHwBackend();
+std::shared_ptr<IRgaBackend> CreateRgaSoftBackend();
+
+struct RgaSessionStats {
+    uint64_t jobs = 0;
+    uint64_t batches = 0;
+    uint64_t syncs = 0;
+    uint64_t errors = 0;
+};
+
+/*
+ * Per-stream RGA session shared by the board nodes of one stream. Jobs are queued without touching
+ * the hardware, Commit() hands the pending jobs to the session worker as one batch and Sync() waits
+ * until everything committed so far has been executed. A node that reads the output (cpu, MPP or a
+ * consumer outside the board nodes) must Sync() first.
+ *
+ * Queue() returns the ticket of the batch the job goes out in. Several nodes sync the same session,
+ * so results are kept per batch: Sync(ticket) reports the batch of the caller's own jobs, Sync()
+ * only the batch it committed itself.
+ */
+class RKRgaSession {
+public:
+    using BackendFactory = std::function<std::shared_ptr<IRgaBackend>()>;
+
+    explicit RKRgaSession(std::shared_ptr<IRgaBackend> backend);
+    ~RKRgaSession();
+
+    uint64_t Queue(const RgaJob& job);
+    // the jobs go out in one batch, whatever other nodes commit meanwhile
+    uint64_t Queue(std::initializer_list<RgaJob> jobs);
+    void Commit();
+    int32_t Sync();
+    int32_t Sync(uint64_t ticket);
+    int32_t AllocBuffer(uint32_t width, uint32_t height, RgaPixelFormat format, RgaBuffer& buffer);
+    void FreeBuffer(RgaBuffer& buffer);
+
+    // set by a downstream node of the stream that syncs before using the frame, so upstream
+    // nodes may leave their jobs queued and let them go to the hardware in the same batch
+    void SetDeferredConsumer(bool deferred);
+    bool HasDeferredConsumer();
+    RgaSessionStats GetStats();
+    bool SharesSourceReads() const;
+
+    static std::shared_ptr<RKRgaSession> Acquire(const int32_t streamId);
+    static void Release(const int32_t streamId);
+    // a private session outside the per-stream registry, e.g. for a worker thread
+    static std::shared_ptr<RKRgaSession> Create();
+    static void SetBackendFactory(const BackendFactory& factory);
+
+private:
+    struct BatchResult {
+        uint64_t ticket = 0;
+        int32_t result = 0;
+    };
+    static constexpr size_t RESULT_SLOTS = 64;  // batches a waiter may fall behind before its result is gone
+
+    bool CommitLocked();
+    void WaitLocked(std::unique_lock<std::mutex>& l, uint64_t ticket);
+    int32_t ResultLocked(uint64_t ticket) const;
+    void WorkerLoop();
+
+    std::shared_ptr<IRgaBackend> backend_;
+    std::mutex lock_;
+    std::condition_variable workCv_;
+    std::condition_variable doneCv_;
+    std::vector<RgaJob> pending_;
+    // committed batches, and run ones kept with their capacity so a steady stream of frames does not allocate
+    std::list<std::vector<RgaJob>> batches_;
+    std::list<std::vector<RgaJob>> spare_;
+    uint64_t committed_ = 0;
+    uint64_t completed_ = 0;
+    std::vector<BatchResult> results_ = std::vector<BatchResult>(RESULT_SLOTS);
+    bool deferredConsumer_ = false;
+    bool running_ = true;
+    RgaSessionStats stats_;
+    std::thread worker_;
+};
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Plain C++ stand-in for RGA: nearest-neighbour scale, 90 degree rotations and BT.601 colour space
+ * conversion between the formats the board nodes use. It is slow and only meant for host tests and
+ * benchmarks of the code around RGA. Jobs of a batch that scale the same source are run as one pass
+ * over it in bands of rows, the way a fan-out would be done on the cpu.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+#include "rk_rga_session.h"
+
+namespace OHOS::Camera {
+namespace {
+struct Yuv {
+    int32_t y;
+    int32_t u;
+    int32_t v;
+};
+
+struct Plane {
+    uint8_t* base = nullptr;
+    size_t mapped = 0;
+    bool owned = false;
+};
+
+constexpr int32_t UV_BIAS = 128;
+constexpr int32_t Y_BIAS = 16;
+constexpr int32_t ROUND = 128;
+constexpr int32_t SHIFT = 8;
+constexpr uint32_t RGBA_BPP = 4;
+constexpr uint32_t RGB_BPP = 3;
+constexpr uint32_t YUYV_BPP = 2;
+constexpr uint32_t FANOUT_BAND_ROWS = 16;   // source rows kept hot in the cache while every output samples them
+
+inline uint8_t Clamp(int32_t value)
+{
+    constexpr int32_t maxValue = 255;
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > maxValue ? maxValue : value));
+}
+
+inline Yuv RgbToYuv(int32_t r, int32_t g, int32_t b)
+{
+    Yuv yuv;
+    yuv.y = ((66 * r + 129 * g + 25 * b + ROUND) >> SHIFT) + Y_BIAS;      // 66 129 25: bt601 luma
+    yuv.u = ((-38 * r - 74 * g + 112 * b + ROUND) >> SHIFT) + UV_BIAS;   // -38 -74 112: bt601 cb
+    yuv.v = ((112 * r - 94 * g - 18 * b + ROUND) >> SHIFT) + UV_BIAS;    // 112 -94 -18: bt601 cr
+    return yuv;
+}
+
+inline void YuvToRgb(const Yuv& yuv, uint8_t* rgb)
+{
+    int32_t c = yuv.y - Y_BIAS;
+    int32_t d = yuv.u - UV_BIAS;
+    int32_t e = yuv.v - UV_BIAS;
+    rgb[0] = Clamp((298 * c + 409 * e + ROUND) >> SHIFT);            // 298 409: bt601 r
+    rgb[1] = Clamp((298 * c - 100 * d - 208 * e + ROUND) >> SHIFT);  // 298 -100 -208: bt601 g
+    rgb[2] = Clamp((298 * c + 516 * d + ROUND) >> SHIFT);            // 298 516: bt601 b
+}
+
+inline uint32_t WStride(const RgaSurface& s)
+{
+    return s.wstride == 0 ? s.width : s.wstride;
+}
+
+inline uint32_t HStride(const RgaSurface& s)
+{
+    return s.hstride == 0 ? s.height : s.hstride;
+}
+
+bool MapSurface(const RgaSurface& s, Plane& plane)
+{
+    if (s.virAddr != nullptr) {
+        plane.base = static_cast<uint8_t*>(s.virAddr);
+        return true;
+    }
+    if (s.fd < 0) {
+        return false;
+    }
+    plane.mapped = RgaFrameSize(s.format, WStride(s), HStride(s));
+    void* addr = mmap(nullptr, plane.mapped, PROT_READ | PROT_WRITE, MAP_SHARED, s.fd, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    plane.base = static_cast<uint8_t*>(addr);
+    plane.owned = true;
+    return true;
+}
+
+void UnmapSurface(Plane& plane)
+{
+    if (plane.owned) {
+        munmap(plane.base, plane.mapped);
+    }
+    plane = {};
+}
+
+Yuv ReadPixel(const RgaSurface& s, const uint8_t* base, uint32_t x, uint32_t y)
+{
+    uint32_t ws = WStride(s);
+    uint32_t hs = HStride(s);
+    size_t lumaSize = static_cast<size_t>(ws) * hs;
+    Yuv yuv = {0, UV_BIAS, UV_BIAS};
+    switch (s.format) {
+        case RgaPixelFormat::YUV420P: {
+            size_t chroma = static_cast<size_t>(y / 2) * (ws / 2) + x / 2;
+            yuv.y = base[static_cast<size_t>(y) * ws + x];
+            yuv.u = base[lumaSize + chroma];
+            yuv.v = base[lumaSize + lumaSize / 4 + chroma];  // 4: quarter size chroma plane
+            break;
+        }
+        case RgaPixelFormat::NV12:
+        case RgaPixelFormat::NV21: {
+            size_t chroma = lumaSize + static_cast<size_t>(y / 2) * ws + (x & ~1u);
+            bool vu = s.format == RgaPixelFormat::NV21;
+            yuv.y = base[static_cast<size_t>(y) * ws + x];
+            yuv.u = base[chroma + (vu ? 1 : 0)];
+            yuv.v = base[chroma + (vu ? 0 : 1)];
+            break;
+        }
+        case RgaPixelFormat::YUYV: {
+            const uint8_t* pair = base + static_cast<size_t>(y) * ws * YUYV_BPP + (x & ~1u) * YUYV_BPP;
+            yuv.y = pair[(x & 1u) * 2];  // 2: Y0 U Y1 V
+            yuv.u = pair[1];
+            yuv.v = pair[3];             // 3: V of the pair
+            break;
+        }
+        case RgaPixelFormat::RGBA8888:
+        case RgaPixelFormat::RGB888: {
+            uint32_t bpp = s.format == RgaPixelFormat::RGBA8888 ? RGBA_BPP : RGB_BPP;
+            const uint8_t* p = base + (static_cast<size_t>(y) * ws + x) * bpp;
+            yuv = RgbToYuv(p[0], p[1], p[2]);
+            break;
+        }
+        default:
+            break;
+    }
+    return yuv;
+}
+
+void WritePixel(const RgaSurface& s, uint8_t* base, uint32_t x, uint32_t y, const Yuv& yuv)
+{
+    uint32_t ws = WStride(s);
+    uint32_t hs = HStride(s);
+    size_t lumaSize = static_cast<size_t>(ws) * hs;
+    bool chromaSite = ((x | y) & 1u) == 0;
+    switch (s.format) {
+        case RgaPixelFormat::YUV420P: {
+            base[static_cast<size_t>(y) * ws + x] = Clamp(yuv.y);
+            if (chromaSite) {
+                size_t chroma = static_cast<size_t>(y / 2) * (ws / 2) + x / 2;
+                base[lumaSize + chroma] = Clamp(yuv.u);
+                base[lumaSize + lumaSize / 4 + chroma] = Clamp(yuv.v);  // 4: quarter size chroma plane
+            }
+            break;
+        }
+        case RgaPixelFormat::NV12:
+        case RgaPixelFormat::NV21: {
+            base[static_cast<size_t>(y) * ws + x] = Clamp(yuv.y);
+            if (chromaSite) {
+                size_t chroma = lumaSize + static_cast<size_t>(y / 2) * ws + x;
+                bool vu = s.format == RgaPixelFormat::NV21;
+                base[chroma + (vu ? 1 : 0)] = Clamp(yuv.u);
+                base[chroma + (vu ? 0 : 1)] = Clamp(yuv.v);
+            }
+            break;
+        }
+        case RgaPixelFormat::YUYV: {
+            uint8_t* pair = base + static_cast<size_t>(y) * ws * YUYV_BPP + (x & ~1u) * YUYV_BPP;
+            pair[(x & 1u) * 2] = Clamp(yuv.y);  // 2: Y0 U Y1 V
+            if ((x & 1u) == 0) {
+                pair[1] = Clamp(yuv.u);
+                pair[3] = Clamp(yuv.v);         // 3: V of the pair
+            }
+            break;
+        }
+        case RgaPixelFormat::RGBA8888:
+        case RgaPixelFormat::RGB888: {
+            uint32_t bpp = s.format == RgaPixelFormat::RGBA8888 ? RGBA_BPP : RGB_BPP;
+            uint8_t* p = base + (static_cast<size_t>(y) * ws + x) * bpp;
+            YuvToRgb(yuv, p);
+            if (bpp == RGBA_BPP) {
+                p[3] = 0xff;  // 3: alpha
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// same format, same size, no rotation: plain plane copies
+bool TryCopy(const RgaJob& job, const uint8_t* src, uint8_t* dst)
+{
+    const RgaSurface& s = job.src;
+    const RgaSurface& d = job.dst;
+    if (s.format != d.format || job.rotation != RgaRotation::ROT_0 ||
+        s.rect.x != 0 || s.rect.y != 0 || d.rect.x != 0 || d.rect.y != 0 ||
+        WStride(s) != WStride(d) || HStride(s) != HStride(d) || s.width != d.width || s.height != d.height ||
+        (s.rect.width != 0 && s.rect.width != s.width) || (s.rect.height != 0 && s.rect.height != s.height) ||
+        (d.rect.width != 0 && d.rect.width != d.width) || (d.rect.height != 0 && d.rect.height != d.height)) {
+        return false;
+    }
+    size_t size = RgaFrameSize(s.format, WStride(s), HStride(s));
+    if (src != dst) {
+        memmove(dst, src, size);
+    }
+    return true;
+}
+
+void RunJob(const RgaJob& job, const uint8_t* src, uint8_t* dst)
+{
+    if (TryCopy(job, src, dst)) {
+        return;
+    }
+    const RgaSurface& s = job.src;
+    const RgaSurface& d = job.dst;
+    uint32_t sx0 = s.rect.x;
+    uint32_t sy0 = s.rect.y;
+    uint32_t sw = s.rect.width == 0 ? s.width : s.rect.width;
+    uint32_t sh = s.rect.height == 0 ? s.height : s.rect.height;
+    uint32_t dx0 = d.rect.x;
+    uint32_t dy0 = d.rect.y;
+    uint32_t dw = d.rect.width == 0 ? d.width : d.rect.width;
+    uint32_t dh = d.rect.height == 0 ? d.height : d.rect.height;
+    if (sw == 0 || sh == 0 || dw == 0 || dh == 0) {
+        return;
+    }
+
+    for (uint32_t v = 0; v < dh; v++) {
+        for (uint32_t u = 0; u < dw; u++) {
+            uint64_t sx = 0;
+            uint64_t sy = 0;
+            switch (job.rotation) {
+                case RgaRotation::ROT_90:
+                    sx = static_cast<uint64_t>(v) * sw / dh;
+                    sy = static_cast<uint64_t>(dw - 1 - u) * sh / dw;
+                    break;
+                case RgaRotation::ROT_180:
+                    sx = static_cast<uint64_t>(dw - 1 - u) * sw / dw;
+                    sy = static_cast<uint64_t>(dh - 1 - v) * sh / dh;
+                    break;
+                case RgaRotation::ROT_270:
+                    sx = static_cast<uint64_t>(dh - 1 - v) * sw / dh;
+                    sy = static_cast<uint64_t>(u) * sh / dw;
+                    break;
+                default:
+                    sx = static_cast<uint64_t>(u) * sw / dw;
+                    sy = static_cast<uint64_t>(v) * sh / dh;
+                    break;
+            }
+            Yuv yuv = ReadPixel(s, src, sx0 + static_cast<uint32_t>(sx), sy0 + static_cast<uint32_t>(sy));
+            WritePixel(d, dst, dx0 + u, dy0 + v, yuv);
+        }
+    }
+}
+
+bool SameSurface(const RgaSurface& a, const RgaSurface& b)
+{
+    return a.fd == b.fd && a.virAddr == b.virAddr && a.format == b.format && a.width == b.width &&
+        a.height == b.height && WStride(a) == WStride(b) && HStride(a) == HStride(b) && a.rect.x == b.rect.x &&
+        a.rect.y == b.rect.y && a.rect.width == b.rect.width && a.rect.height == b.rect.height;
+}
+
+bool SharesSource(const RgaJob& first, const RgaJob& job)
+{
+    return !job.waitPrevious && first.rotation == RgaRotation::ROT_0 && job.rotation == RgaRotation::ROT_0 &&
+        SameSurface(first.src, job.src);
+}
+
+struct BandCursor {
+    const RgaJob* job = nullptr;
+    uint8_t* dst = nullptr;
+    uint32_t dw = 0;
+    uint32_t dh = 0;
+    uint32_t row = 0;
+};
+
+// the same sampling as RunJob without rotation, walking the source once for all outputs
+void RunBands(std::vector<BandCursor>& cursors, const uint8_t* src)
+{
+    const RgaSurface& s = cursors.front().job->src;
+    uint32_t sw = s.rect.width == 0 ? s.width : s.rect.width;
+    uint32_t sh = s.rect.height == 0 ? s.height : s.rect.height;
+    if (sw == 0 || sh == 0) {
+        return;
+    }
+    for (uint32_t band = 0; band < sh; band += FANOUT_BAND_ROWS) {
+        uint32_t bandEnd = std::min(band + FANOUT_BAND_ROWS, sh);
+        for (auto& c : cursors) {
+            const RgaSurface& d = c.job->dst;
+            for (; c.row < c.dh; c.row++) {
+                uint64_t sy = static_cast<uint64_t>(c.row) * sh / c.dh;
+                if (sy >= bandEnd) {
+                    break;
+                }
+                for (uint32_t u = 0; u < c.dw; u++) {
+                    uint32_t sx = static_cast<uint32_t>(static_cast<uint64_t>(u) * sw / c.dw);
+                    Yuv yuv = ReadPixel(s, src, s.rect.x + sx, s.rect.y + static_cast<uint32_t>(sy));
+                    WritePixel(d, c.dst, d.rect.x + u, d.rect.y + c.row, yuv);
+                }
+            }
+        }
+    }
+}
+} // namespace
+
+class RgaSoftBackend : public IRgaBackend {
+public:
+    RgaSoftBackend() = default;
+    ~RgaSoftBackend() override = default;
+
+    int32_t Run(const std::vector<RgaJob>& batch) override
+    {
+        int32_t result = 0;
+        size_t first = 0;
+        while (first < batch.size()) {
+            size_t last = first + 1;
+            while (last < batch.size() && SharesSource(batch[first], batch[last])) {
+                last++;
+            }
+            if (RunGroup(batch, first, last) != 0) {
+                result = -1;
+            }
+            first = last;
+        }
+        return result;
+    }
+
+    bool SharesSourceReads() const override
+    {
+        return true;
+    }
+
+    int32_t AllocBuffer(uint32_t width, uint32_t height, RgaPixelFormat format, RgaBuffer& buffer) override
+    {
+        size_t size = RgaFrameSize(format, width, height);
+        void* addr = malloc(size);
+        if (addr == nullptr) {
+            return -1;
+        }
+        buffer.fd = -1;
+        buffer.virAddr = addr;
+        buffer.size = size;
+        buffer.handle = addr;
+        return 0;
+    }
+
+    void FreeBuffer(RgaBuffer& buffer) override
+    {
+        free(buffer.handle);
+        buffer = {};
+    }
+
+private:
+    // jobs [first, last) of the batch read the same source
+    static int32_t RunGroup(const std::vector<RgaJob>& batch, size_t first, size_t last)
+    {
+        Plane src;
+        if (!MapSurface(batch[first].src, src)) {
+            return -1;
+        }
+        int32_t result = 0;
+        std::vector<Plane> dsts(last - first);
+        std::vector<BandCursor> cursors;
+        for (size_t i = first; i < last; i++) {
+            const RgaJob& job = batch[i];
+            Plane& dst = dsts[i - first];
+            if (!MapSurface(job.dst, dst)) {
+                result = -1;
+                continue;
+            }
+            if (last - first == 1) {
+                RunJob(job, src.base, dst.base);
+                continue;
+            }
+            if (TryCopy(job, src.base, dst.base)) {
+                continue;
+            }
+            BandCursor cursor;
+            cursor.job = &job;
+            cursor.dst = dst.base;
+            cursor.dw = job.dst.rect.width == 0 ? job.dst.width : job.dst.rect.width;
+            cursor.dh = job.dst.rect.height == 0 ? job.dst.height : job.dst.rect.height;
+            if (cursor.dw != 0 && cursor.dh != 0) {
+                cursors.push_back(cursor);
+            }
+        }
+        if (!cursors.empty()) {
+            RunBands(cursors, src.base);
+        }
+        for (auto& dst : dsts) {
+            UnmapSurface(dst);
+        }
+        UnmapSurface(src);
+        return result;
+    }
+};
+
+std::shared_ptr<IRgaBackend> CreateRgaSoftBackend()
+{
+    return std::make_shared<RgaSoftBackend>();
+}
+} // namespace OHOS::Camera
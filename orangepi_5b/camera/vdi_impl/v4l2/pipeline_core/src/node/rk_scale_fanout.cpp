@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_scale_fanout.h"
+#include <array>
+
+namespace OHOS::Camera {
+namespace {
+inline uint32_t RectWidth(const RgaSurface& surface)
+{
+    return surface.rect.width == 0 ? surface.width : surface.rect.width;
+}
+
+inline uint32_t RectHeight(const RgaSurface& surface)
+{
+    return surface.rect.height == 0 ? surface.height : surface.rect.height;
+}
+
+inline uint64_t RectArea(const RgaSurface& surface)
+{
+    return static_cast<uint64_t>(RectWidth(surface)) * RectHeight(surface);
+}
+} // namespace
+
+uint64_t RgaSurfaceBytes(const RgaSurface& surface)
+{
+    return RgaFrameSize(surface.format, RectWidth(surface), RectHeight(surface));
+}
+
+FanOutTraffic EstimateJobTraffic(const RgaJob& job)
+{
+    FanOutTraffic traffic;
+    traffic.readBytes = RgaSurfaceBytes(job.src);
+    traffic.writeBytes = RgaSurfaceBytes(job.dst);
+    traffic.naiveBytes = traffic.readBytes + traffic.writeBytes;
+    return traffic;
+}
+
+FanOutTraffic PlanFanOut(const RgaSurface& src, const std::vector<RgaSurface>& dsts, FanOutMode mode,
+    bool sharedSourceReads, std::vector<RgaJob>& jobs)
+{
+    jobs.clear();
+    FanOutTraffic traffic;
+    uint64_t srcBytes = RgaSurfaceBytes(src);
+    size_t count = dsts.size() < FANOUT_MAX_OUTPUTS ? dsts.size() : FANOUT_MAX_OUTPUTS;
+
+    // largest first, so an output can only be taken from one that is already written; a stable
+    // insertion sort, std::stable_sort would want a temporary buffer
+    std::array<size_t, FANOUT_MAX_OUTPUTS> order;
+    for (size_t i = 0; i < count; i++) {
+        size_t j = i;
+        for (; j > 0 && RectArea(dsts[order[j - 1]]) < RectArea(dsts[i]); j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+
+    constexpr size_t fromSource = SIZE_MAX;
+    std::array<size_t, FANOUT_MAX_OUTPUTS> input;
+    input.fill(fromSource);
+    if (mode == FanOutMode::CASCADE) {
+        for (size_t i = 0; i < count; i++) {
+            const RgaSurface& dst = dsts[order[i]];
+            uint64_t best = srcBytes;
+            for (size_t j = 0; j < i; j++) {
+                const RgaSurface& candidate = dsts[order[j]];
+                uint64_t bytes = RgaSurfaceBytes(candidate);
+                if (RectWidth(candidate) >= RectWidth(dst) && RectHeight(candidate) >= RectHeight(dst) &&
+                    bytes < best) {
+                    best = bytes;
+                    input[order[i]] = order[j];
+                }
+            }
+        }
+    }
+
+    bool sourceRead = false;
+    for (size_t i = 0; i < count; i++) {
+        size_t index = order[i];
+        if (input[index] != fromSource) {
+            continue;
+        }
+        RgaJob job;
+        job.src = src;
+        job.dst = dsts[index];
+        jobs.push_back(job);
+        if (!sharedSourceReads || !sourceRead) {
+            traffic.readBytes += srcBytes;
+        }
+        sourceRead = true;
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t index = order[i];
+        if (input[index] == fromSource) {
+            continue;
+        }
+        RgaJob job;
+        job.src = dsts[input[index]];
+        job.dst = dsts[index];
+        job.waitPrevious = true;
+        jobs.push_back(job);
+        traffic.readBytes += RgaSurfaceBytes(job.src);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        traffic.writeBytes += RgaSurfaceBytes(dsts[i]);
+    }
+    traffic.naiveBytes = srcBytes * count + traffic.writeBytes;
+    return traffic;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_SCALE_FANOUT_H
+#define HOS_CAMERA_RK_SCALE_FANOUT_H
+
+#include <cstdint>
+#include <vector>
+#include "rk_rga_session.h"
+
+namespace OHOS::Camera {
+enum class FanOutMode : int32_t {
+    OFF = 0,    // every stream scales its own output from the source
+    SHARED,     // the first stream of a source frame writes the outputs of all streams in one batch
+    CASCADE,    // as SHARED, and an output is scaled from a larger output rather than the source when one exists
+};
+
+// estimated dram traffic of a set of jobs, the bytes of every surface rect read and written
+struct FanOutTraffic {
+    uint64_t readBytes = 0;
+    uint64_t writeBytes = 0;
+    uint64_t naiveBytes = 0;    // the same outputs with one pass over the source each
+};
+
+struct ScaleTrafficStats {
+    uint64_t frames = 0;            // source frames seen
+    uint64_t lastFrameBytes = 0;    // read + write estimate of the last complete source frame
+    uint64_t totalBytes = 0;
+    uint64_t naiveBytes = 0;
+    uint64_t fanOuts = 0;           // source frames scaled for more than one stream at once
+    uint64_t stagedCopies = 0;      // outputs taken from a fan-out staging buffer
+};
+
+constexpr size_t FANOUT_MAX_OUTPUTS = 8;
+
+uint64_t RgaSurfaceBytes(const RgaSurface& surface);
+FanOutTraffic EstimateJobTraffic(const RgaJob& job);
+
+/*
+ * Jobs writing every dst from src. Jobs reading the source come first and back to back, so a backend
+ * that SharesSourceReads() reads it once. In CASCADE mode an output is scaled from the smallest earlier
+ * output that still covers it, which reads less but samples twice; those jobs wait for their input.
+ * Outputs past FANOUT_MAX_OUTPUTS are left out. Nothing is allocated once jobs has grown to size.
+ */
+FanOutTraffic PlanFanOut(const RgaSurface& src, const std::vector<RgaSurface>& dsts, FanOutMode mode,
+    bool sharedSourceReads, std::vector<RgaJob>& jobs);
+} // namespace OHOS::Camera
+#endif
@@ -13,6 +13,8 @@
 
 #include "rk_scale_node.h"
 #include <securec.h>
+#include "rk_node_params.h"
+#include "rk_vendor_tags.h"
 
 namespace OHOS::Camera {
 RKScaleNode::RKScaleNode(const std::string& name, const std::string& type, const std::string &cameraId)
@@ -23,6 +25,10 @@ RKScaleNode::RKScaleNode(const std::string& name, const std::string& type, const
 
 RKScaleNode::~RKScaleNode()
 {
+    std::unique_lock<std::mutex> l(fanOutLock_);
+    for (auto& it : fanOutTargets_) {
+        ReleaseFanOutTarget(it.second);
+    }
     CAMERA_LOGI("~RKScaleNode Node exit.");
 }
 
@@ -30,11 +36,21 @@ RetCode RKScaleNode::Start(const int32_t streamId)
 {
     CAMERA_LOGI("RKScaleNode::Start streamId = %{public}d\n", streamId);
     uint64_t bufferPoolId = 0;
+    uint32_t bufferCount = 0;
 
     outPutPorts_ = GetOutPorts();
     for (auto& out : outPutPorts_) {
         bufferPoolId = out->format_.bufferPoolId_;
+        bufferCount = out->format_.bufferCount_;
+    }
+    // frames reach RGA in the layout the upstream node produces, no repack to planar
+    sourceFormat_ = RgaPixelFormat::YUV420P;
+    for (auto& in : GetInPorts()) {
+        if (in != nullptr && ToRgaPixelFormat(static_cast<int32_t>(in->format_.format_), sourceFormat_)) {
+            break;
+        }
     }
+    portTable_.Build(outPutPorts_);
 
     BufferManager* bufferManager = Camera::BufferManager::GetInstance();
     if (bufferManager == nullptr) {
@@ -45,14 +61,266 @@ RetCode RKScaleNode::Start(const int32_t streamId)
     bufferPool_ = bufferManager->GetBufferPool(bufferPoolId);
     if (bufferPool_ == nullptr) {
         CAMERA_LOGE("get bufferpool failed: %{public}zu", bufferPoolId);
+        sfBuffers_.Invalidate();
         return RC_ERROR;
     }
+    std::shared_ptr<IBufferPool> pool = bufferPool_;
+    if (sfBuffers_.Reset(bufferPoolId, bufferCount, [pool](int32_t index) { return pool->getSFBuffer(index); })) {
+        CAMERA_LOGI("RKScaleNode resolved %{public}u sf buffers of pool %{public}zu", bufferCount, bufferPoolId);
+    }
+
+    int32_t fanOut = GetRkNodeParam(RK_PARAM_SCALE_FANOUT, static_cast<int32_t>(FanOutMode::SHARED));
+    if (fanOut < static_cast<int32_t>(FanOutMode::OFF) || fanOut > static_cast<int32_t>(FanOutMode::CASCADE)) {
+        fanOut = static_cast<int32_t>(FanOutMode::SHARED);
+    }
+    SetFanOutMode(static_cast<FanOutMode>(fanOut));
+
+    std::unique_lock<std::mutex> l(rgaLock_);
+    if (rgaSessions_.count(streamId) == 0) {
+        std::shared_ptr<RKRgaSession> session = RKRgaSession::Acquire(streamId);
+        if (session == nullptr) {
+            CAMERA_LOGE("RKScaleNode::Start no rga session for streamId = %{public}d", streamId);
+            return RC_ERROR;
+        }
+        rgaSessions_[streamId] = session;
+    }
     return RC_OK;
 }
 
 RetCode RKScaleNode::Stop(const int32_t streamId)
 {
     CAMERA_LOGI("RKScaleNode::Stop streamId = %{public}d\n", streamId);
+    {
+        std::unique_lock<std::mutex> l(fanOutLock_);
+        auto target = fanOutTargets_.find(streamId);
+        if (target != fanOutTargets_.end()) {
+            ReleaseFanOutTarget(target->second);
+            fanOutTargets_.erase(target);
+        }
+        CAMERA_LOGI("RKScaleNode dram estimate %{public}llu bytes/frame, %{public}llu of %{public}llu total, "
+            "%{public}llu fan-outs", static_cast<unsigned long long>(traffic_.lastFrameBytes),
+            static_cast<unsigned long long>(traffic_.totalBytes), static_cast<unsigned long long>(traffic_.naiveBytes),
+            static_cast<unsigned long long>(traffic_.fanOuts));
+    }
+    {
+        std::unique_lock<std::mutex> l(cropLock_);
+        crops_.erase(streamId);
+    }
+    std::unique_lock<std::mutex> l(rgaLock_);
+    auto it = rgaSessions_.find(streamId);
+    if (it != rgaSessions_.end()) {
+        it->second->Sync();
+        rgaSessions_.erase(it);
+        RKRgaSession::Release(streamId);
+    }
+    return RC_OK;
+}
+
+std::shared_ptr<RKRgaSession> RKScaleNode::GetRgaSession(const int32_t streamId)
+{
+    std::unique_lock<std::mutex> l(rgaLock_);
+    auto it = rgaSessions_.find(streamId);
+    return it == rgaSessions_.end() ? nullptr : it->second;
+}
+
+void RKScaleNode::SubmitScale(std::shared_ptr<IBuffer>& buffer, const RgaJob& job)
+{
+    std::shared_ptr<RKRgaSession> session = GetRgaSession(buffer->GetStreamId());
+    if (session == nullptr) {
+        CAMERA_LOGE("RKScaleNode no rga session for streamId = %{public}d", buffer->GetStreamId());
+        return;
+    }
+    // a downstream board node syncs the stream session before it reads the frame, so the scale stays
+    // queued and goes to the hardware in the same batch as its csc/rotate; otherwise finish it here
+    uint64_t ticket = session->Queue(job);
+    if (!session->HasDeferredConsumer() && session->Sync(ticket) != 0) {
+        CAMERA_LOGE("RKScaleNode rga scale failed, streamId = %{public}d", buffer->GetStreamId());
+    }
+}
+
+void RKScaleNode::SetFanOutMode(FanOutMode mode)
+{
+    std::unique_lock<std::mutex> l(fanOutLock_);
+    fanOutMode_ = mode;
+}
+
+ScaleTrafficStats RKScaleNode::GetScaleTraffic()
+{
+    std::unique_lock<std::mutex> l(fanOutLock_);
+    return traffic_;
+}
+
+void RKScaleNode::AccountTraffic(uint64_t source, const FanOutTraffic& traffic)
+{
+    // a new capture time closes the estimate of the previous source frame
+    if (source == 0 || source != trafficSource_) {
+        if (traffic_.frames != 0) {
+            traffic_.lastFrameBytes = trafficFrameBytes_;
+        }
+        traffic_.frames++;
+        trafficSource_ = source;
+        trafficFrameBytes_ = 0;
+    }
+    uint64_t bytes = traffic.readBytes + traffic.writeBytes;
+    trafficFrameBytes_ += bytes;
+    traffic_.totalBytes += bytes;
+    traffic_.naiveBytes += traffic.naiveBytes;
+}
+
+void RKScaleNode::ReleaseFanOutTarget(FanOutTarget& target)
+{
+    if (target.staging.size != 0 && fanOutSession_ != nullptr) {
+        fanOutSession_->FreeBuffer(target.staging);
+    }
+    target.staging = {};
+    target.stagedSource = 0;
+}
+
+void RKScaleNode::PrepareFanOutTargets(const int32_t streamId, const RgaJob& job)
+{
+    if (fanOutSession_ == nullptr) {
+        fanOutSession_ = RKRgaSession::Create();
+        if (fanOutSession_ == nullptr) {
+            return;
+        }
+    }
+    constexpr uint64_t stagedPasses = 2;    // written by the fan-out, read again by the copy
+    uint64_t sourceBytes = RgaSurfaceBytes(job.src);
+    uint64_t source = fanOutSource_;
+    for (auto& it : fanOutTargets_) {
+        FanOutTarget& target = it.second;
+        // streams that took the previous source frame are expected for this one as well, and a staged
+        // output is only cheaper than another pass over the source while it is smaller than the source
+        uint64_t bytes = RgaFrameSize(target.format, target.width, target.height);
+        if (it.first == streamId || source == 0 || target.lastSource != source || bytes == 0 ||
+            target.crop != job.src.rect || bytes * stagedPasses >= sourceBytes ||
+            fanOutDsts_.size() >= FANOUT_MAX_OUTPUTS) {
+            continue;
+        }
+        if (target.staging.size == 0 &&
+            fanOutSession_->AllocBuffer(target.width, target.height, target.format, target.staging) != 0) {
+            CAMERA_LOGE("RKScaleNode fan-out staging alloc failed, streamId = %{public}d", it.first);
+            target.staging = {};
+            continue;
+        }
+        target.stagedSource = 0;
+        fanOutDsts_.push_back(MakeRgaSurface(target.staging.fd, target.staging.virAddr, target.width, target.height,
+            target.format));
+        fanOutStaged_.push_back(&target);
+    }
+}
+
+void RKScaleNode::FanOutScale(std::shared_ptr<IBuffer>& buffer, const RgaJob& job)
+{
+    int32_t streamId = buffer->GetStreamId();
+    uint64_t source = buffer->GetTimestamp();
+    std::unique_lock<std::mutex> l(fanOutLock_);
+    // without a capture time the frames of the streams cannot be matched up
+    if (fanOutMode_ == FanOutMode::OFF || source == 0) {
+        AccountTraffic(source, EstimateJobTraffic(job));
+        l.unlock();
+        SubmitScale(buffer, job);
+        return;
+    }
+
+    FanOutTarget& self = fanOutTargets_[streamId];
+    if (self.width != job.dst.width || self.height != job.dst.height || self.format != job.dst.format) {
+        ReleaseFanOutTarget(self);
+        self.width = job.dst.width;
+        self.height = job.dst.height;
+        self.format = job.dst.format;
+    }
+    if (self.crop != job.src.rect) {
+        self.crop = job.src.rect;
+        self.stagedSource = 0;
+    }
+
+    if (self.stagedSource == source) {
+        // scaled by the stream that came first, the staging is rewritten by the next fan-out so the
+        // copy has to be done before the lock is dropped
+        RgaJob copy;
+        copy.src = MakeRgaSurface(self.staging.fd, self.staging.virAddr, self.width, self.height, self.format);
+        copy.dst = job.dst;
+        self.stagedSource = 0;
+        self.lastSource = source;
+        FanOutTraffic traffic = EstimateJobTraffic(copy);
+        traffic.naiveBytes = 0;     // counted with the fan-out
+        AccountTraffic(source, traffic);
+        traffic_.stagedCopies++;
+        std::shared_ptr<RKRgaSession> session = GetRgaSession(streamId);
+        if (session != nullptr && session->Sync(session->Queue(copy)) != 0) {
+            CAMERA_LOGE("RKScaleNode staged copy failed, streamId = %{public}d", streamId);
+        }
+        return;
+    }
+
+    fanOutDsts_.clear();
+    fanOutDsts_.push_back(job.dst);
+    fanOutStaged_.clear();
+    PrepareFanOutTargets(streamId, job);
+    fanOutSource_ = source;
+    self.lastSource = source;
+    if (fanOutStaged_.empty()) {
+        AccountTraffic(source, EstimateJobTraffic(job));
+        l.unlock();
+        SubmitScale(buffer, job);
+        return;
+    }
+
+    FanOutTraffic traffic = PlanFanOut(job.src, fanOutDsts_, fanOutMode_, fanOutSession_->SharesSourceReads(),
+        fanOutJobs_);
+    uint64_t ticket = 0;
+    for (auto& it : fanOutJobs_) {
+        ticket = fanOutSession_->Queue(it);
+    }
+    // the fan-out session is the node's own, all of its jobs go out in the batch of the last one
+    if (fanOutSession_->Sync(ticket) != 0) {
+        CAMERA_LOGE("RKScaleNode fan-out failed, streamId = %{public}d", streamId);
+        return;
+    }
+    for (FanOutTarget* target : fanOutStaged_) {
+        target->stagedSource = source;
+    }
+    traffic_.fanOuts++;
+    AccountTraffic(source, traffic);
+    CAMERA_LOGD("RKScaleNode fan-out of %{public}zu outputs, dram estimate %{public}llu bytes",
+        fanOutDsts_.size(), static_cast<unsigned long long>(traffic.readBytes + traffic.writeBytes));
+}
+
+RetCode RKScaleNode::Config(const int32_t streamId, const CaptureMeta& meta)
+{
+    if (meta == nullptr) {
+        CAMERA_LOGE("meta is nullptr");
+        return RC_ERROR;
+    }
+
+    common_metadata_header_t* data = meta->get();
+    if (data == nullptr) {
+        CAMERA_LOGE("data is nullptr");
+        return RC_ERROR;
+    }
+
+    std::unique_lock<std::mutex> l(cropLock_);
+    ScaleCrop& crop = crops_[streamId];
+    camera_metadata_item_t entry;
+    int ret = FindCameraMetadataItem(data, OHOS_CONTROL_ZOOM_RATIO, &entry);
+    if (ret == 0 && entry.data.f != nullptr && entry.count > 0) {
+        crop.zoom = *entry.data.f;
+        CAMERA_LOGI("RKScaleNode streamId %{public}d zoom ratio %{public}f", streamId, crop.zoom);
+    }
+
+    constexpr uint32_t regionCount = 4;     // x, y, width, height
+    ret = FindCameraMetadataItem(data, RK_VENDOR_SCALE_CROP_REGION, &entry);
+    if (ret == 0 && entry.data.i32 != nullptr && entry.count >= regionCount) {
+        const int32_t* region = entry.data.i32;
+        if (region[0] < 0 || region[1] < 0 || region[2] < 0 || region[3] < 0) {     // 2, 3: width, height
+            CAMERA_LOGW("RK_VENDOR_SCALE_CROP_REGION %{public}d,%{public}d %{public}dx%{public}d is not a region",
+                region[0], region[1], region[2], region[3]);                                   // 2, 3: width, height
+        } else {
+            crop.region = {static_cast<uint32_t>(region[0]), static_cast<uint32_t>(region[1]),
+                static_cast<uint32_t>(region[2]), static_cast<uint32_t>(region[3])};          // 2, 3: width, height
+        }
+    }
     return RC_OK;
 }
 
@@ -62,6 +330,41 @@ RetCode RKScaleNode::Flush(const int32_t streamId)
     return RC_OK;
 }
 
+RgaSurface RKScaleNode::MakeSourceSurface(void* virAddr, uint32_t strideBytes, size_t size)
+{
+    // the row stride the buffer reports, tight rows and planes when it reports none or more than the buffer holds
+    RgaSurface surface = MakeRgaSurface(-1, virAddr, wide_, high_, sourceFormat_);
+    uint32_t wstride = RgaStrideFromBytes(sourceFormat_, wide_, strideBytes);
+    if (RgaFrameSize(sourceFormat_, wstride, high_) <= size) {
+        surface.wstride = wstride;
+    }
+    return surface;
+}
+
+void RKScaleNode::ApplyCrop(const int32_t streamId, RgaJob& job)
+{
+    ScaleCrop crop;
+    {
+        std::unique_lock<std::mutex> l(cropLock_);
+        auto it = crops_.find(streamId);
+        if (it == crops_.end()) {
+            return;
+        }
+        crop = it->second;
+    }
+    // only the window is read, the bandwidth drops with the square of the zoom
+    job.src.rect = ResolveScaleRoi(job.src.width, job.src.height, crop, job.dst.width, job.dst.height);
+}
+
+RgaSurface RKScaleNode::MakeBufferSurface(std::shared_ptr<IBuffer>& buffer, int fd, void* virAddr)
+{
+    /*
+     * RKCodecNode, the jpeg backends and the video encoder read the scaled frame as tightly packed I420,
+     * the stream format is what the codec node turns it into; only the source keeps its own layout.
+     */
+    return MakeRgaSurface(fd, virAddr, buffer->GetWidth(), buffer->GetHeight(), RgaPixelFormat::YUV420P);
+}
+
 void RKScaleNode::PreviewScaleConver(std::shared_ptr<IBuffer>& buffer)
 {
     if (buffer == nullptr) {
@@ -71,37 +374,27 @@ void RKScaleNode::PreviewScaleConver(std::shared_ptr<IBuffer>& buffer)
 
     int dma_fd = buffer->GetFileDescriptor();
     uint8_t* temp = (uint8_t *)buffer->GetVirAddress();
+    size_t tempSize = buffer->GetSize();
+    // the stride describes the source only while the buffer still has the source's width
+    uint32_t tempStride = static_cast<uint32_t>(buffer->GetWidth()) == wide_ ? buffer->GetStride() : 0;
 
-    std::map<int32_t, uint8_t*> sizeVirMap = bufferPool_->getSFBuffer(buffer->GetIndex());
-    if (sizeVirMap.empty()) {
+    SFBufferView sfBuffer;
+    if (!sfBuffers_.Get(buffer->GetIndex(), sfBuffer)) {
         CAMERA_LOGI("RKScaleNode::Yuv420ToRGBA8888 sizeVirMap buffer == nullptr");
         return;
     }
-    uint8_t* virBUffer = sizeVirMap.begin()->second;
-    int32_t virSize = sizeVirMap.begin()->first;
-    buffer->SetVirAddress(virBUffer);
-    buffer->SetSize(virSize);
-
-    RockchipRga rkRga;
-
-    rga_info_t src = {};
-    rga_info_t dst = {};
-
-    src.fd = -1;
-    src.mmuFlag = 1;
-    src.rotation = 0;
-    src.virAddr = (void *)temp;
-
-    dst.fd = dma_fd;
-    dst.mmuFlag = 1;
-    dst.virAddr = 0;
-
-    rga_set_rect(&src.rect, 0, 0, wide_, high_, wide_, high_, RK_FORMAT_YCbCr_420_P);
-    rga_set_rect(&dst.rect, 0, 0, buffer->GetWidth(), buffer->GetHeight(),
-        buffer->GetWidth(), buffer->GetHeight(), RK_FORMAT_YCbCr_420_P);
-
-    rkRga.RkRgaBlit(&src, &dst, NULL);
-    rkRga.RkRgaFlush();
+    buffer->SetVirAddress(sfBuffer.addr);
+    buffer->SetSize(sfBuffer.size);
+
+    RgaJob job;
+    job.src = MakeSourceSurface(temp, tempStride, tempSize);
+    job.dst = MakeBufferSurface(buffer, dma_fd, nullptr);
+    ApplyCrop(buffer->GetStreamId(), job);
+    {
+        std::unique_lock<std::mutex> l(fanOutLock_);
+        AccountTraffic(buffer->GetTimestamp(), EstimateJobTraffic(job));
+    }
+    SubmitScale(buffer, job);
 }
 
 void RKScaleNode::ScaleConver(std::shared_ptr<IBuffer>& buffer)
@@ -113,33 +406,19 @@ void RKScaleNode::ScaleConver(std::shared_ptr<IBuffer>& buffer)
 
     int dma_fd = buffer->GetFileDescriptor();
 
-    std::map<int32_t, uint8_t*> sizeVirMap = bufferPool_->getSFBuffer(bufferPool_->GetForkBufferId());
-    if (sizeVirMap.empty()) {
+    SFBufferView sfBuffer;
+    if (!sfBuffers_.Get(bufferPool_->GetForkBufferId(), sfBuffer)) {
         CAMERA_LOGI("RKScaleNode::Yuv420ToRGBA8888 sizeVirMap buffer == nullptr");
         return;
     }
-    uint8_t* temp = sizeVirMap.begin()->second;
-
-    RockchipRga rkRga;
-
-    rga_info_t src = {};
-    rga_info_t dst = {};
-
-    src.fd = -1;
-    src.mmuFlag = 1;
-    src.rotation = 0;
-    src.virAddr = (void *)temp;
-
-    dst.fd = dma_fd;
-    dst.mmuFlag = 1;
-    dst.virAddr = 0;
-
-    rga_set_rect(&src.rect, 0, 0, wide_, high_, wide_, high_, RK_FORMAT_YCbCr_420_P);
-    rga_set_rect(&dst.rect, 0, 0, buffer->GetWidth(), buffer->GetHeight(),
-        buffer->GetWidth(), buffer->GetHeight(), RK_FORMAT_YCbCr_420_P);
-
-    rkRga.RkRgaBlit(&src, &dst, NULL);
-    rkRga.RkRgaFlush();
+    uint8_t* temp = sfBuffer.addr;
+
+    RgaJob job;
+    // the fork buffer has no IBuffer to report a stride, it is read with tight strides
+    job.src = MakeSourceSurface(temp, 0, static_cast<size_t>(sfBuffer.size));
+    job.dst = MakeBufferSurface(buffer, dma_fd, buffer->GetVirAddress());
+    ApplyCrop(buffer->GetStreamId(), job);
+    FanOutScale(buffer, job);
 }
 
 void RKScaleNode::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
@@ -153,21 +432,18 @@ void RKScaleNode::DeliverBuffer(std::shared_ptr<IBuffer>& buffer)
     CAMERA_LOGE("RKScaleNode::DeliverBuffer StreamId %{public}d", id);
 
     if (bufferPool_->GetForkBufferId() != -1) {
-        if (buffer->GetEncodeType() == ENCODE_TYPE_JPEG || buffer->GetEncodeType() == ENCODE_TYPE_H264) {
+        if (buffer->GetEncodeType() == ENCODE_TYPE_JPEG || buffer->GetEncodeType() == ENCODE_TYPE_H264 ||
+            buffer->GetEncodeType() == ENCODE_TYPE_H265) {
             ScaleConver(buffer);
         } else {
             PreviewScaleConver(buffer);
         }
     }
 
-    std::vector<std::shared_ptr<IPort>> outPutPorts_;
-    outPutPorts_ = GetOutPorts();
-    for (auto& it : outPutPorts_) {
-        if (it->format_.streamId_ == id) {
-            it->DeliverBuffer(buffer);
-            CAMERA_LOGI("RKScaleNode deliver buffer streamid = %{public}d", it->format_.streamId_);
-            return;
-        }
+    IPort* port = portTable_.Find(id, [this] { return GetOutPorts(); });
+    if (port != nullptr) {
+        port->DeliverBuffer(buffer);
+        CAMERA_LOGI("RKScaleNode deliver buffer streamid = %{public}d", id);
     }
 }
 
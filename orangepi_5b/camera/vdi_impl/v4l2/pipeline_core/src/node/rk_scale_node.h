@@ -15,6 +15,7 @@
 #define HOS_CAMERA_RKSCALE_NODE_H
 
 #include <vector>
+#include <map>
 #include <condition_variable>
 #include <ctime>
 #include <mutex>
@@ -26,6 +27,11 @@
 #include "RgaUtils.h"
 #include "RgaApi.h"
 #include "rk_mpi.h"
+#include "rk_port_table.h"
+#include "rk_rga_session.h"
+#include "rk_scale_fanout.h"
+#include "rk_scale_roi.h"
+#include "rk_sf_buffer_cache.h"
 #include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_log.h"
@@ -42,11 +48,53 @@ public:
     virtual RetCode Capture(const int32_t streamId, const int32_t captureId) override;
     RetCode CancelCapture(const int32_t streamId) override;
     RetCode Flush(const int32_t streamId);
+    RetCode Config(const int32_t streamId, const CaptureMeta& meta) override;
+    void SetFanOutMode(FanOutMode mode);
+    // estimated dram traffic of the scaling, per source frame
+    ScaleTrafficStats GetScaleTraffic();
 private:
+    // a stream served by the fan-out, its output for the current source frame may already be staged
+    struct FanOutTarget {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        RgaPixelFormat format = RgaPixelFormat::YUV420P;
+        uint64_t lastSource = 0;    // capture time of the last source frame the stream took
+        uint64_t stagedSource = 0;  // capture time of the frame in staging, 0 if none
+        RgaRect crop;               // of the source, staging is only shared by streams with the same crop
+        RgaBuffer staging;
+    };
+
+    RgaSurface MakeSourceSurface(void* virAddr, uint32_t strideBytes, size_t size);
+    void ApplyCrop(const int32_t streamId, RgaJob& job);
+    static RgaSurface MakeBufferSurface(std::shared_ptr<IBuffer>& buffer, int fd, void* virAddr);
     void PreviewScaleConver(std::shared_ptr<IBuffer>& buffer);
     void ScaleConver(std::shared_ptr<IBuffer>& buffer);
+    void SubmitScale(std::shared_ptr<IBuffer>& buffer, const RgaJob& job);
+    void FanOutScale(std::shared_ptr<IBuffer>& buffer, const RgaJob& job);
+    void PrepareFanOutTargets(const int32_t streamId, const RgaJob& job);
+    void ReleaseFanOutTarget(FanOutTarget& target);
+    void AccountTraffic(uint64_t source, const FanOutTraffic& traffic);
+    std::shared_ptr<RKRgaSession> GetRgaSession(const int32_t streamId);
     std::vector<std::shared_ptr<IPort>>   outPutPorts_;
+    RKPortTable<IPort>                    portTable_;
     std::shared_ptr<IBufferPool>          bufferPool_ = nullptr;    // buffer pool of branch stream
+    RKSFBufferCache                       sfBuffers_;
+    RgaPixelFormat                        sourceFormat_ = RgaPixelFormat::YUV420P;   // of the in port
+    std::mutex                            cropLock_;
+    std::map<int32_t, ScaleCrop>          crops_;
+    std::mutex                            rgaLock_;
+    std::map<int32_t, std::shared_ptr<RKRgaSession>> rgaSessions_;
+    std::mutex                            fanOutLock_;
+    FanOutMode                            fanOutMode_ = FanOutMode::SHARED;
+    std::shared_ptr<RKRgaSession>         fanOutSession_ = nullptr;     // runs the fan-out, owns the staging
+    uint64_t                              fanOutSource_ = 0;
+    std::map<int32_t, FanOutTarget>       fanOutTargets_;
+    std::vector<RgaSurface>               fanOutDsts_;      // per frame scratch, kept for its capacity
+    std::vector<FanOutTarget*>            fanOutStaged_;
+    std::vector<RgaJob>                   fanOutJobs_;
+    uint64_t                              trafficSource_ = 0;
+    uint64_t                              trafficFrameBytes_ = 0;
+    ScaleTrafficStats                     traffic_;
 };
 } // namespace OHOS::Camera
 #endif
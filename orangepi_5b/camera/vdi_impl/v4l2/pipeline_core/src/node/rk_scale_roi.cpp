@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_scale_roi.h"
+#include <algorithm>
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t RGA_MAX_UPSCALE = 16;
+constexpr uint32_t EVEN_MASK = ~1u;
+
+// at least 1/16 of the output and 2 pixels, at most the source
+uint32_t ClampExtent(uint32_t extent, uint32_t src, uint32_t dst)
+{
+    uint32_t minExtent = std::max<uint32_t>((dst + RGA_MAX_UPSCALE - 1) / RGA_MAX_UPSCALE, 2);
+    minExtent = (minExtent + 1) & EVEN_MASK;
+    return std::min(std::max(extent & EVEN_MASK, minExtent), src & EVEN_MASK);
+}
+} // namespace
+
+RgaRect ResolveScaleRoi(uint32_t srcWidth, uint32_t srcHeight, const ScaleCrop& crop,
+    uint32_t dstWidth, uint32_t dstHeight)
+{
+    RgaRect roi;
+    if (srcWidth < 2 || srcHeight < 2) {    // 2: one chroma sample
+        return roi;
+    }
+
+    uint32_t centerX = srcWidth / 2;
+    uint32_t centerY = srcHeight / 2;
+    uint32_t width = srcWidth;
+    uint32_t height = srcHeight;
+    if (crop.region.width != 0 && crop.region.height != 0 && crop.region.x < srcWidth && crop.region.y < srcHeight) {
+        // clip to the frame first, then grow or shrink around the centre of what is left
+        width = std::min(crop.region.width, srcWidth - crop.region.x);
+        height = std::min(crop.region.height, srcHeight - crop.region.y);
+        centerX = crop.region.x + width / 2;
+        centerY = crop.region.y + height / 2;
+    } else if (crop.zoom > 1.0f) {
+        width = static_cast<uint32_t>(static_cast<float>(srcWidth) / crop.zoom);
+        height = static_cast<uint32_t>(static_cast<float>(srcHeight) / crop.zoom);
+    }
+    width = ClampExtent(width, srcWidth, dstWidth);
+    height = ClampExtent(height, srcHeight, dstHeight);
+    if (width >= (srcWidth & EVEN_MASK) && height >= (srcHeight & EVEN_MASK)) {
+        return roi;
+    }
+
+    uint32_t x = centerX > width / 2 ? centerX - width / 2 : 0;
+    uint32_t y = centerY > height / 2 ? centerY - height / 2 : 0;
+    roi.x = std::min(x, srcWidth - width) & EVEN_MASK;
+    roi.y = std::min(y, srcHeight - height) & EVEN_MASK;
+    roi.width = width;
+    roi.height = height;
+    return roi;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_SCALE_ROI_H
+#define HOS_CAMERA_RK_SCALE_ROI_H
+
+#include <cstdint>
+#include "rk_rga_session.h"
+
+namespace OHOS::Camera {
+// what a capture asked to be scaled, the region wins over the zoom ratio when both are set
+struct ScaleCrop {
+    float zoom = 1.0f;
+    RgaRect region;     // source pixels, an empty rect means none
+};
+
+inline bool operator==(const RgaRect& a, const RgaRect& b)
+{
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+inline bool operator!=(const RgaRect& a, const RgaRect& b)
+{
+    return !(a == b);
+}
+
+/*
+ * The source rect RGA has to read for crop on a srcWidth x srcHeight frame scaled to dstWidth x
+ * dstHeight: the region clipped to the frame, or a centred window of 1/zoom of it. Edges are even for
+ * the subsampled chroma and the window is kept within the 16x upscale RGA can do. A full frame
+ * comes back as an empty rect, so an unzoomed job looks like it always did.
+ */
+RgaRect ResolveScaleRoi(uint32_t srcWidth, uint32_t srcHeight, const ScaleCrop& crop,
+    uint32_t dstWidth, uint32_t dstHeight);
+} // namespace OHOS::Camera
+#endif
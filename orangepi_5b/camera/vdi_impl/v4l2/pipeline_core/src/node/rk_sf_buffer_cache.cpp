@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_sf_buffer_cache.h"
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t MAX_LAZY_INDEX = 64;     // bounds the array for indexes past the pool's buffers
+} // namespace
+
+bool RKSFBufferCache::Reset(uint64_t poolId, uint32_t bufferCount, const Lookup& lookup)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    if (valid_ && poolId == poolId_ && bufferCount == bufferCount_) {
+        return false;
+    }
+    poolId_ = poolId;
+    bufferCount_ = bufferCount;
+    lookup_ = lookup;
+    views_.assign(bufferCount, SFBufferView {});
+    views_.reserve(bufferCount + MAX_LAZY_INDEX);
+    valid_ = true;
+    stats_.resets++;
+    for (uint32_t i = 0; i < bufferCount; i++) {
+        Resolve(static_cast<int32_t>(i), views_[i]);
+    }
+    return true;
+}
+
+void RKSFBufferCache::Invalidate()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    valid_ = false;
+    views_.clear();
+}
+
+bool RKSFBufferCache::Get(int32_t index, SFBufferView& view)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    if (!valid_ || index < 0 || static_cast<uint32_t>(index) >= bufferCount_ + MAX_LAZY_INDEX) {
+        return false;
+    }
+    size_t slot = static_cast<size_t>(index);
+    if (slot >= views_.size()) {
+        views_.resize(slot + 1);
+    }
+    if (views_[slot].addr != nullptr) {
+        stats_.hits++;
+        view = views_[slot];
+        return true;
+    }
+    // not there when the stream started, or an index past the buffers: ask the pool again
+    if (!Resolve(index, views_[slot])) {
+        return false;
+    }
+    view = views_[slot];
+    return true;
+}
+
+SFBufferCacheStats RKSFBufferCache::GetStats()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    return stats_;
+}
+
+bool RKSFBufferCache::Resolve(int32_t index, SFBufferView& view)
+{
+    if (!lookup_) {
+        return false;
+    }
+    stats_.lookups++;
+    std::map<int32_t, uint8_t*> sizeVirMap = lookup_(index);
+    if (sizeVirMap.empty() || sizeVirMap.begin()->second == nullptr) {
+        return false;
+    }
+    view.size = sizeVirMap.begin()->first;
+    view.addr = sizeVirMap.begin()->second;
+    return true;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_SF_BUFFER_CACHE_H
+#define HOS_CAMERA_RK_SF_BUFFER_CACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace OHOS::Camera {
+struct SFBufferView {
+    uint8_t* addr = nullptr;
+    int32_t size = 0;
+};
+
+struct SFBufferCacheStats {
+    uint64_t lookups = 0;   // calls into the pool
+    uint64_t hits = 0;
+    uint64_t resets = 0;
+};
+
+/*
+ * IBufferPool::getSFBuffer() returns a std::map by value, a heap allocation for every frame. The
+ * buffers of a pool do not move while it is configured, so the first entry of every index is looked
+ * up once when the stream starts and kept in a flat array. An index past the buffer count, like the
+ * fork buffer, is looked up on first use. A different pool or buffer count drops everything.
+ */
+class RKSFBufferCache {
+public:
+    using Lookup = std::function<std::map<int32_t, uint8_t*>(int32_t)>;
+
+    // returns true when the pool changed and the buffers were resolved again
+    bool Reset(uint64_t poolId, uint32_t bufferCount, const Lookup& lookup);
+    void Invalidate();
+    bool Get(int32_t index, SFBufferView& view);
+    SFBufferCacheStats GetStats();
+
+private:
+    bool Resolve(int32_t index, SFBufferView& view);
+
+    std::mutex lock_;
+    bool valid_ = false;
+    uint64_t poolId_ = 0;
+    uint32_t bufferCount_ = 0;
+    Lookup lookup_;
+    std::vector<SFBufferView> views_;
+    SFBufferCacheStats stats_;
+};
+} // namespace OHOS::Camera
+#endif
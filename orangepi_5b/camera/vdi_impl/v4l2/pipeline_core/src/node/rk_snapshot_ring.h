@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_SNAPSHOT_RING_H
+#define HOS_CAMERA_RK_SNAPSHOT_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace OHOS::Camera {
+/*
+ * The last N values published, each under a key such as a capture id. Every slot is a seqlock over
+ * atomic words, so Find() and Latest() never block, allocate or see a half written value; they retry
+ * the slot when a write raced with them. Publish() overwrites the oldest slot and must not run on
+ * two threads at once.
+ */
+template<typename T, size_t N>
+class RKSnapshotRing {
+    static_assert(std::is_trivially_copyable<T>::value, "snapshots are copied word by word");
+    static_assert(N > 0, "at least one slot");
+
+public:
+    RKSnapshotRing() = default;
+    RKSnapshotRing(const RKSnapshotRing&) = delete;
+    RKSnapshotRing& operator=(const RKSnapshotRing&) = delete;
+
+    void Publish(int64_t key, const T& value)
+    {
+        uint64_t words[WORDS] = {};
+        memcpy(words, &value, sizeof(T));
+        uint64_t count = published_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[count % N];
+        uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        // release on the data orders the odd sequence before it, a reader that sees new data sees the write
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        slot.key.store(key, std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            slot.words[i].store(words[i], std::memory_order_release);
+        }
+        slot.seq.store(seq + 2, std::memory_order_release);     // 2: even again, one write later
+        published_.store(count + 1, std::memory_order_release);
+    }
+
+    // the newest value published under key
+    bool Find(int64_t key, T& value) const
+    {
+        uint64_t count = published_.load(std::memory_order_acquire);
+        for (uint64_t i = 0; i < N && i < count; i++) {
+            int64_t slotKey = 0;
+            if (ReadSlot(slots_[(count - 1 - i) % N], slotKey, value) && slotKey == key) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Latest(T& value) const
+    {
+        uint64_t count = published_.load(std::memory_order_acquire);
+        int64_t key = 0;
+        return count != 0 && ReadSlot(slots_[(count - 1) % N], key, value);
+    }
+
+    uint64_t GetPublishCount() const
+    {
+        return published_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct Slot {
+        std::atomic<uint32_t> seq {0};
+        std::atomic<int64_t> key {0};
+        std::atomic<uint64_t> words[WORDS] = {};
+    };
+
+    // false only when the slot was never written
+    static bool ReadSlot(const Slot& slot, int64_t& key, T& value)
+    {
+        uint64_t words[WORDS];
+        while (true) {
+            uint32_t before = slot.seq.load(std::memory_order_acquire);
+            if (before == 0) {
+                return false;
+            }
+            if ((before & 1) != 0) {
+                continue;
+            }
+            key = slot.key.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++) {
+                words[i] = slot.words[i].load(std::memory_order_acquire);
+            }
+            if (slot.seq.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    Slot slots_[N];
+    std::atomic<uint64_t> published_ {0};
+};
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_VENDOR_TAGS_H
+#define HOS_CAMERA_RK_VENDOR_TAGS_H
+
+#include <cstdint>
+#include "camera.h"
+
+namespace OHOS::Camera {
+// board private metadata, all tags live in the vendor section and carry a single int32 unless noted
+enum RkVendorTag : uint32_t {
+    RK_VENDOR_TAG_START = static_cast<uint32_t>(OHOS_VENDOR_SECTION) << 16,
+    RK_VENDOR_JPEG_BACKEND = RK_VENDOR_TAG_START,   // JpegBackendType
+    RK_VENDOR_JPEG_EXIF_ORIENTATION,                // 1: the client accepts an Exif Orientation tag
+    RK_VENDOR_VIDEO_RC_MODE,                        // VideoRcMode
+    RK_VENDOR_VIDEO_BITRATE,                        // target bps
+    RK_VENDOR_VIDEO_GOP,                            // frames between key frames
+    RK_VENDOR_VIDEO_QP_RANGE,                       // int32[2]: min, max
+    RK_VENDOR_SCALE_CROP_REGION,                    // int32[4]: x, y, width, height of the source to scale
+    RK_VENDOR_FACE_FRAME_TIMESTAMP,                 // int64: capture time of the frame the faces were found in
+    RK_VENDOR_EXIF_ISO,                             // sensitivity of the capture, for the Exif segment
+    RK_VENDOR_EXIF_FOCAL_LENGTH,                    // focal length of the lens in um, for the Exif segment
+    RK_VENDOR_TAG_END,
+};
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_video_enc_config.h"
+#include <algorithm>
+
+namespace OHOS::Camera {
+namespace {
+constexpr int32_t DEFAULT_FPS = 30;
+constexpr int32_t MAX_FPS = 240;
+constexpr int32_t GOP_SECONDS = 2;
+constexpr int32_t MAX_GOP = 1000;
+constexpr int64_t BITS_PER_PIXEL_DIV = 8;   // width * height * fps / 8, about 7.8 Mbps at 1080p30
+constexpr int64_t MIN_BITRATE = 64 * 1000;
+constexpr int64_t MAX_BITRATE = 100 * 1000 * 1000;
+// rc:bps_max and rc:bps_min in sixteenths of the target, the values of the mpp samples
+constexpr int64_t BPS_RANGE_DIV = 16;
+constexpr int64_t BPS_MAX_NUM = 17;
+constexpr int64_t CBR_MIN_NUM = 15;
+constexpr int64_t VBR_MIN_NUM = 1;
+constexpr int32_t QP_LOWEST = 0;
+constexpr int32_t QP_HIGHEST = 51;
+constexpr int32_t DEFAULT_QP_MIN = 10;
+constexpr int32_t DEFAULT_QP_MAX = 51;
+} // namespace
+
+const char* VideoRcModeName(VideoRcMode mode)
+{
+    switch (mode) {
+        case VideoRcMode::CBR:
+            return "cbr";
+        case VideoRcMode::VBR:
+            return "vbr";
+        case VideoRcMode::AVBR:
+            return "avbr";
+        default:
+            return "unknown";
+    }
+}
+
+bool ToVideoRcMode(int32_t value, VideoRcMode& mode)
+{
+    if (value < static_cast<int32_t>(VideoRcMode::CBR) || value > static_cast<int32_t>(VideoRcMode::AVBR)) {
+        return false;
+    }
+    mode = static_cast<VideoRcMode>(value);
+    return true;
+}
+
+VideoRateControl ResolveVideoRateControl(const VideoEncConfig& config, uint32_t width, uint32_t height)
+{
+    VideoRateControl rc;
+    rc.mode = config.rcMode;
+    int32_t fps = config.fps > 0 ? std::min(config.fps, MAX_FPS) : DEFAULT_FPS;
+
+    int64_t target = config.bitrate;
+    if (target <= 0) {
+        target = static_cast<int64_t>(width) * height * fps / BITS_PER_PIXEL_DIV;
+    }
+    target = std::clamp(target, MIN_BITRATE, MAX_BITRATE);
+    int64_t minNum = rc.mode == VideoRcMode::CBR ? CBR_MIN_NUM : VBR_MIN_NUM;
+    rc.bpsTarget = static_cast<int32_t>(target);
+    rc.bpsMax = static_cast<int32_t>(target * BPS_MAX_NUM / BPS_RANGE_DIV);
+    rc.bpsMin = static_cast<int32_t>(target * minNum / BPS_RANGE_DIV);
+
+    rc.gop = config.gop > 0 ? std::min(config.gop, MAX_GOP) : fps * GOP_SECONDS;
+
+    rc.qpMin = config.qpMin > 0 ? std::clamp(config.qpMin, QP_LOWEST, QP_HIGHEST) : DEFAULT_QP_MIN;
+    rc.qpMax = config.qpMax > 0 ? std::clamp(config.qpMax, QP_LOWEST, QP_HIGHEST) : DEFAULT_QP_MAX;
+    if (rc.qpMin > rc.qpMax) {
+        std::swap(rc.qpMin, rc.qpMax);
+    }
+    return rc;
+}
+} // namespace OHOS::Camera
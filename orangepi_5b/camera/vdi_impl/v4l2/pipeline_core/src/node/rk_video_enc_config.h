@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_VIDEO_ENC_CONFIG_H
+#define HOS_CAMERA_RK_VIDEO_ENC_CONFIG_H
+
+#include <cstdint>
+#include "rk_nal_indexer.h"
+
+namespace OHOS::Camera {
+enum class VideoRcMode : int32_t {
+    CBR = 0,
+    VBR,
+    AVBR,   // vbr that lowers the rate further on static scenes
+};
+
+// what a stream asks for, zero leaves a value to the encoder defaults
+struct VideoEncConfig {
+    NalCodec codec = NalCodec::H264;
+    VideoRcMode rcMode = VideoRcMode::VBR;
+    int32_t bitrate = 0;    // bps
+    int32_t gop = 0;        // frames from one key frame to the next
+    int32_t qpMin = 0;
+    int32_t qpMax = 0;
+    int32_t fps = 0;
+};
+
+// the settings handed to the encoder, every field is filled in
+struct VideoRateControl {
+    VideoRcMode mode = VideoRcMode::VBR;
+    int32_t bpsTarget = 0;
+    int32_t bpsMax = 0;
+    int32_t bpsMin = 0;
+    int32_t gop = 0;
+    int32_t qpMin = 0;
+    int32_t qpMax = 0;
+
+    bool operator==(const VideoRateControl& other) const
+    {
+        return mode == other.mode && bpsTarget == other.bpsTarget && bpsMax == other.bpsMax &&
+            bpsMin == other.bpsMin && gop == other.gop && qpMin == other.qpMin && qpMax == other.qpMax;
+    }
+    bool operator!=(const VideoRateControl& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+const char* VideoRcModeName(VideoRcMode mode);
+bool ToVideoRcMode(int32_t value, VideoRcMode& mode);
+
+/*
+ * Fills the defaults in and clamps what the stream asked for: the bitrate defaults to
+ * width * height * fps / 8 like the mpp samples, the gop to two seconds, and the bounds around
+ * the target follow the mode (tight for CBR, loose below the target for VBR and AVBR).
+ */
+VideoRateControl ResolveVideoRateControl(const VideoEncConfig& config, uint32_t width, uint32_t height);
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_video_encoder.h"
+
+namespace OHOS::Camera {
+RKVideoEncoderHandle::RKVideoEncoderHandle(const VideoEncoderFactory& factory)
+    : factory_(factory), sessions_(std::make_shared<const VideoEncoderSessions>())
+{
+}
+
+RKVideoEncoderHandle::~RKVideoEncoderHandle()
+{
+    std::atomic_store(&sessions_, std::shared_ptr<const VideoEncoderSessions>());
+}
+
+void RKVideoEncoderHandle::Open(int32_t streamId)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    closed_.erase(streamId);
+}
+
+void RKVideoEncoderHandle::Close(int32_t streamId)
+{
+    std::shared_ptr<VideoEncoderSession> retired = nullptr;
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        closed_.insert(streamId);
+        std::shared_ptr<const VideoEncoderSessions> current = std::atomic_load(&sessions_);
+        auto it = current->find(streamId);
+        if (it != current->end()) {
+            auto next = std::make_shared<VideoEncoderSessions>(*current);
+            retired = it->second;
+            next->erase(streamId);
+            std::atomic_store(&sessions_, std::shared_ptr<const VideoEncoderSessions>(std::move(next)));
+            stats_.retired++;
+        }
+    }
+    // retired drops here, outside the lock; a frame still encoding keeps the context until it returns
+}
+
+bool RKVideoEncoderHandle::Matches(const std::shared_ptr<VideoEncoderSession>& session, NalCodec codec,
+    uint32_t width, uint32_t height)
+{
+    return session != nullptr && session->codec == codec && session->width == width && session->height == height;
+}
+
+std::shared_ptr<VideoEncoderSession> RKVideoEncoderHandle::Find(
+    const std::shared_ptr<const VideoEncoderSessions>& sessions, int32_t streamId)
+{
+    if (sessions == nullptr) {
+        return nullptr;
+    }
+    auto it = sessions->find(streamId);
+    return it == sessions->end() ? nullptr : it->second;
+}
+
+std::shared_ptr<VideoEncoderSession> RKVideoEncoderHandle::Acquire(int32_t streamId, NalCodec codec,
+    uint32_t width, uint32_t height)
+{
+    std::shared_ptr<VideoEncoderSession> session = Find(std::atomic_load(&sessions_), streamId);
+    if (Matches(session, codec, width, height)) {
+        return session;
+    }
+
+    // declared first so the old session of the stream is released after the lock
+    std::shared_ptr<VideoEncoderSession> replaced = nullptr;
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        if (closed_.count(streamId) != 0) {
+            return nullptr;
+        }
+        // another frame may have created it while this one waited
+        std::shared_ptr<const VideoEncoderSessions> current = std::atomic_load(&sessions_);
+        session = Find(current, streamId);
+        if (Matches(session, codec, width, height)) {
+            return session;
+        }
+
+        auto created = std::make_shared<VideoEncoderSession>();
+        created->streamId = streamId;
+        created->codec = codec;
+        created->width = width;
+        created->height = height;
+        created->encoder = factory_(codec, width, height);
+        if (created->encoder == nullptr) {
+            stats_.failed++;
+            return nullptr;
+        }
+        stats_.created++;
+        if (session != nullptr) {
+            stats_.retired++;
+        }
+        // the other streams keep their sessions, only this stream's entry changes
+        auto next = std::make_shared<VideoEncoderSessions>(*current);
+        (*next)[streamId] = created;
+        std::atomic_store(&sessions_, std::shared_ptr<const VideoEncoderSessions>(std::move(next)));
+        replaced = std::move(session);
+        session = std::move(created);
+    }
+    return session;
+}
+
+std::shared_ptr<VideoEncoderSession> RKVideoEncoderHandle::Get(int32_t streamId)
+{
+    return Find(std::atomic_load(&sessions_), streamId);
+}
+
+VideoEncoderHandleStats RKVideoEncoderHandle::GetStats()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    return stats_;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_VIDEO_ENCODER_H
+#define HOS_CAMERA_RK_VIDEO_ENCODER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include "rk_buffer_import_cache.h"
+#include "rk_nal_indexer.h"
+#include "rk_video_enc_config.h"
+
+namespace OHOS::Camera {
+// a camera buffer to encode, the access unit is written into it once the encoder is done reading
+struct VideoFrame {
+    int32_t fd = -1;
+    int32_t index = -1;
+    uint8_t* addr = nullptr;
+    size_t size = 0;
+};
+
+struct VideoEncoderPoolStats {
+    BufferImportStats input;
+    uint64_t esFrames = 0;
+    uint64_t esOverflows = 0;   // access units that did not fit the camera buffer
+};
+
+class IVideoEncoder {
+public:
+    virtual ~IVideoEncoder() = default;
+    virtual bool SetRateControl(const VideoRateControl& rc) = 0;
+    // esSize returns the length of the access unit now at the start of frame.addr
+    virtual int32_t Encode(const VideoFrame& frame, size_t& esSize) = 0;
+    virtual VideoEncoderPoolStats GetPoolStats()
+    {
+        return VideoEncoderPoolStats();
+    }
+};
+
+using VideoEncoderFactory = std::function<std::unique_ptr<IVideoEncoder>(NalCodec codec, uint32_t width,
+    uint32_t height)>;
+
+// hal_mpp backed H.264/H.265 encoder
+std::unique_ptr<IVideoEncoder> CreateMppVideoEncoder(NalCodec codec, uint32_t width, uint32_t height);
+
+// one encoder context; whoever holds the last reference deletes it, after its frame is done
+struct VideoEncoderSession {
+    int32_t streamId = -1;
+    NalCodec codec = NalCodec::H264;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::unique_ptr<IVideoEncoder> encoder = nullptr;
+    // frames of a stream arrive one at a time, so this is only ever contended by a stray caller
+    std::mutex encodeLock;
+    VideoRateControl rc;
+    bool rcApplied = false;
+};
+
+struct VideoEncoderHandleStats {
+    uint64_t created = 0;
+    uint64_t failed = 0;
+    uint64_t retired = 0;
+};
+
+using VideoEncoderSessions = std::map<int32_t, std::shared_ptr<VideoEncoderSession>>;
+
+/*
+ * Owner of the video encoder contexts of a node, one per stream. The sessions are published as an
+ * immutable map through an atomic shared_ptr: the encode path loads it without taking a lock and keeps
+ * its stream's session alive for the frame, Close() publishes a map without that stream and the context
+ * goes away once the last frame using it returns. Sessions are only created and retired under the
+ * handle lock, which keeps a late frame from bringing a context back to life after its stream stopped.
+ */
+class RKVideoEncoderHandle {
+public:
+    explicit RKVideoEncoderHandle(const VideoEncoderFactory& factory);
+    ~RKVideoEncoderHandle();
+
+    void Open(int32_t streamId);
+    void Close(int32_t streamId);
+    // the stream's session for these parameters, created or replaced as needed; nullptr while it is closed
+    std::shared_ptr<VideoEncoderSession> Acquire(int32_t streamId, NalCodec codec, uint32_t width, uint32_t height);
+    VideoEncoderHandleStats GetStats();
+    // the published session of the stream if there is one, for stats; encoding goes through Acquire()
+    std::shared_ptr<VideoEncoderSession> Get(int32_t streamId);
+
+private:
+    static bool Matches(const std::shared_ptr<VideoEncoderSession>& session, NalCodec codec, uint32_t width,
+        uint32_t height);
+    static std::shared_ptr<VideoEncoderSession> Find(const std::shared_ptr<const VideoEncoderSessions>& sessions,
+        int32_t streamId);
+
+    VideoEncoderFactory factory_;
+    std::shared_ptr<const VideoEncoderSessions> sessions_ = nullptr;   // only through std::atomic_load/store
+    std::mutex lock_;
+    std::set<int32_t> closed_;
+    VideoEncoderHandleStats stats_;
+};
+} // namespace OHOS::Camera
+#endif
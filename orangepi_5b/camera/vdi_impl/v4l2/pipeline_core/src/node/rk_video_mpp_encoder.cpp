@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_video_encoder.h"
+#include <securec.h>
+#include "camera.h"
+#include "rk_mpi.h"
+#include "mpp_common.h"
+extern "C" {
+#include "mpi_enc_utils.h"
+}
+
+namespace OHOS::Camera {
+namespace {
+constexpr size_t IMPORT_CACHE_SIZE = 16;    // the most buffers a v4l2 stream queues
+} // namespace
+
+/*
+ * hal_mpp AVC/HEVC encoder driven through the mpi directly. The camera buffers are imported once per
+ * dma fd and kept in a cache. The stream hands its access units out in the camera buffer, so the
+ * packet the encoder returns is copied into it once the frame has been read, as hal_mpp_encode does.
+ * The codec and size are fixed for the life of the context.
+ */
+class MppVideoEncoder : public IVideoEncoder {
+public:
+    explicit MppVideoEncoder(void* halCtx)
+        : halCtx_(halCtx), data_(static_cast<MpiEncTestData*>(halCtx)),
+          imports_(IMPORT_CACHE_SIZE, ImportBuffer, ReleaseBuffer)
+    {
+    }
+
+    ~MppVideoEncoder() override
+    {
+        VideoEncoderPoolStats stats = GetPoolStats();
+        CAMERA_LOGI("MppVideoEncoder %{public}llu frames, import hits %{public}llu misses %{public}llu "
+            "evictions %{public}llu, es overflows %{public}llu", stats.esFrames, stats.input.hits,
+            stats.input.misses, stats.input.evictions, stats.esOverflows);
+        // the imports are the context's buffers, they go before the context does
+        imports_.Clear();
+        hal_mpp_ctx_delete(halCtx_);
+    }
+
+    bool Init()
+    {
+        // parameter sets in front of every key frame, the stream can be joined at any IDR/IRAP
+        MppEncHeaderMode headerMode = MPP_ENC_HEADER_MODE_EACH_IDR;
+        if (data_->mpi->control(data_->ctx, MPP_ENC_SET_HEADER_MODE, &headerMode) != MPP_OK) {
+            CAMERA_LOGE("MppVideoEncoder set header mode failed");
+            return false;
+        }
+        return true;
+    }
+
+    bool SetRateControl(const VideoRateControl& rc) override
+    {
+        RK_S32 mode = MPP_ENC_RC_MODE_VBR;
+        if (rc.mode == VideoRcMode::CBR) {
+            mode = MPP_ENC_RC_MODE_CBR;
+        } else if (rc.mode == VideoRcMode::AVBR) {
+            mode = MPP_ENC_RC_MODE_AVBR;
+        }
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:mode", mode);
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:bps_target", rc.bpsTarget);
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:bps_max", rc.bpsMax);
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:bps_min", rc.bpsMin);
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:gop", rc.gop);
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:qp_init", -1);   // -1: let the encoder pick the first qp
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:qp_min", rc.qpMin);
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:qp_max", rc.qpMax);
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:qp_min_i", rc.qpMin);
+        mpp_enc_cfg_set_s32(data_->cfg, "rc:qp_max_i", rc.qpMax);
+        if (data_->mpi->control(data_->ctx, MPP_ENC_SET_CFG, data_->cfg) != MPP_OK) {
+            CAMERA_LOGE("MppVideoEncoder %{public}s %{public}d bps failed", VideoRcModeName(rc.mode), rc.bpsTarget);
+            return false;
+        }
+        CAMERA_LOGI("MppVideoEncoder %{public}s %{public}d bps [%{public}d, %{public}d] gop %{public}d "
+            "qp [%{public}d, %{public}d]", VideoRcModeName(rc.mode), rc.bpsTarget, rc.bpsMin, rc.bpsMax, rc.gop,
+            rc.qpMin, rc.qpMax);
+        return true;
+    }
+
+    int32_t Encode(const VideoFrame& frame, size_t& esSize) override
+    {
+        esSize = 0;
+        if (frame.fd < 0 || frame.addr == nullptr) {
+            return -1;
+        }
+        ImportKey key;
+        key.fd = frame.fd;
+        key.index = frame.index;
+        key.addr = frame.addr;
+        key.size = frame.size;
+        MppBuffer input = imports_.Get(key);
+        if (input == nullptr) {
+            CAMERA_LOGE("MppVideoEncoder import of fd %{public}d failed", frame.fd);
+            return -1;
+        }
+        MppFrame mppFrame = nullptr;
+        MppPacket packet = nullptr;
+        if (mpp_frame_init(&mppFrame) != MPP_OK) {
+            return -1;
+        }
+        mpp_frame_set_width(mppFrame, data_->width);
+        mpp_frame_set_height(mppFrame, data_->height);
+        mpp_frame_set_hor_stride(mppFrame, data_->hor_stride);
+        mpp_frame_set_ver_stride(mppFrame, data_->ver_stride);
+        mpp_frame_set_fmt(mppFrame, data_->fmt);
+        mpp_frame_set_buffer(mppFrame, input);
+
+        MPP_RET ret = data_->mpi->encode_put_frame(data_->ctx, mppFrame);
+        if (ret == MPP_OK) {
+            // the packet comes back once the frame is encoded, the encoder is done reading the camera buffer
+            ret = data_->mpi->encode_get_packet(data_->ctx, &packet);
+        }
+        mpp_frame_deinit(&mppFrame);
+        if (ret == MPP_OK && packet != nullptr) {
+            ret = CopyOut(packet, frame, esSize);
+        }
+        if (packet != nullptr) {
+            mpp_packet_deinit(&packet);
+        }
+        return ret;
+    }
+
+    VideoEncoderPoolStats GetPoolStats() override
+    {
+        VideoEncoderPoolStats stats;
+        stats.input = imports_.GetStats();
+        stats.esFrames = esFrames_;
+        stats.esOverflows = esOverflows_;
+        return stats;
+    }
+
+private:
+    static void* ImportBuffer(const ImportKey& key)
+    {
+        MppBufferInfo info = {};
+        info.type = MPP_BUFFER_TYPE_EXT_DMA;
+        info.fd = key.fd;
+        info.size = key.size;
+        info.ptr = key.addr;
+        info.index = key.index;
+        MppBuffer buffer = nullptr;
+        if (mpp_buffer_import(&buffer, &info) != MPP_OK) {
+            return nullptr;
+        }
+        return buffer;
+    }
+
+    static void ReleaseBuffer(void* handle)
+    {
+        mpp_buffer_put(static_cast<MppBuffer>(handle));
+    }
+
+    MPP_RET CopyOut(MppPacket packet, const VideoFrame& frame, size_t& esSize)
+    {
+        size_t length = mpp_packet_get_length(packet);
+        if (length > frame.size) {
+            esOverflows_++;
+            CAMERA_LOGE("MppVideoEncoder access unit of %{public}zu bytes does not fit %{public}zu", length,
+                frame.size);
+            return MPP_NOK;
+        }
+        if (memcpy_s(frame.addr, frame.size, mpp_packet_get_pos(packet), length) != 0) {
+            return MPP_NOK;
+        }
+        esFrames_++;
+        esSize = length;
+        return MPP_OK;
+    }
+
+    void* halCtx_ = nullptr;
+    MpiEncTestData* data_ = nullptr;
+    RKBufferImportCache imports_;
+    uint64_t esFrames_ = 0;
+    uint64_t esOverflows_ = 0;
+};
+
+std::unique_ptr<IVideoEncoder> CreateMppVideoEncoder(NalCodec codec, uint32_t width, uint32_t height)
+{
+    MpiEncTestArgs args = {};
+    args.width = width;
+    args.height = height;
+    args.format = MPP_FMT_YUV420P;
+    args.type = codec == NalCodec::H265 ? MPP_VIDEO_CodingHEVC : MPP_VIDEO_CodingAVC;
+    void* halCtx = hal_mpp_ctx_create(&args);
+    if (halCtx == nullptr) {
+        CAMERA_LOGE("CreateMppVideoEncoder hal_mpp_ctx_create %{public}u x %{public}u failed", width, height);
+        return nullptr;
+    }
+    auto encoder = std::make_unique<MppVideoEncoder>(halCtx);
+    if (!encoder->Init()) {
+        return nullptr;
+    }
+    CAMERA_LOGI("CreateMppVideoEncoder %{public}s %{public}u x %{public}u",
+        codec == NalCodec::H265 ? "hevc" : "avc", width, height);
+    return encoder;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rk_worker_pool.h"
+#include <algorithm>
+#include <pthread.h>
+#include <ctime>
+
+namespace OHOS::Camera {
+namespace {
+constexpr int64_t NS_PER_US = 1000;
+constexpr int64_t US_PER_S = 1000000;
+constexpr size_t THREAD_NAME_LEN = 15;
+
+int64_t NowUs()
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * US_PER_S + ts.tv_nsec / NS_PER_US;
+}
+} // namespace
+
+RKWorkerPool::RKWorkerPool(const std::string& name, uint32_t workers, uint32_t capacity)
+    : name_(name), capacity_(std::max(capacity, 1u))
+{
+    workers = std::max(workers, 1u);
+    for (uint32_t i = 0; i < workers; i++) {
+        workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+RKWorkerPool::~RKWorkerPool()
+{
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        running_ = false;
+    }
+    workCv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void RKWorkerPool::Submit(int32_t key, const Task& task)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    if (queue_.size() >= capacity_) {
+        stats_.blocked++;
+        spaceCv_.wait(l, [this] { return queue_.size() < capacity_ || !running_; });
+    }
+
+    Item item;
+    item.key = key;
+    item.task = task;
+    item.submitUs = NowUs();
+    queue_.push_back(std::move(item));
+    outstanding_[key]++;
+    stats_.submitted++;
+    stats_.depth = static_cast<uint32_t>(queue_.size());
+    stats_.maxDepth = std::max(stats_.maxDepth, stats_.depth);
+    workCv_.notify_one();
+}
+
+void RKWorkerPool::Drain(int32_t key)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    doneCv_.wait(l, [this, key] { return outstanding_.find(key) == outstanding_.end(); });
+}
+
+uint32_t RKWorkerPool::GetWorkerCount() const
+{
+    return static_cast<uint32_t>(workers_.size());
+}
+
+WorkerPoolStats RKWorkerPool::GetStats()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    return stats_;
+}
+
+void RKWorkerPool::WorkerLoop(uint32_t index)
+{
+    std::string threadName = (name_ + std::to_string(index)).substr(0, THREAD_NAME_LEN);
+    pthread_setname_np(pthread_self(), threadName.c_str());
+
+    std::unique_lock<std::mutex> l(lock_);
+    while (true) {
+        // whatever was submitted still runs on shutdown, its buffers have to go back
+        workCv_.wait(l, [this] { return !queue_.empty() || !running_; });
+        if (queue_.empty()) {
+            break;
+        }
+        Item item = std::move(queue_.front());
+        queue_.pop_front();
+        stats_.depth = static_cast<uint32_t>(queue_.size());
+        spaceCv_.notify_one();
+        l.unlock();
+
+        int64_t startUs = NowUs();
+        item.task(index);
+        int64_t doneUs = NowUs();
+
+        l.lock();
+        stats_.completed++;
+        stats_.totalWaitUs += static_cast<uint64_t>(startUs - item.submitUs);
+        stats_.totalRunUs += static_cast<uint64_t>(doneUs - startUs);
+        stats_.maxLatencyUs = std::max(stats_.maxLatencyUs, static_cast<uint64_t>(doneUs - item.submitUs));
+        auto it = outstanding_.find(item.key);
+        if (it != outstanding_.end() && --it->second == 0) {
+            outstanding_.erase(it);
+        }
+        doneCv_.notify_all();
+    }
+}
+} // namespace OHOS::Camera
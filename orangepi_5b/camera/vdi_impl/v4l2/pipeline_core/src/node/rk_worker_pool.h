@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_RK_WORKER_POOL_H
+#define HOS_CAMERA_RK_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OHOS::Camera {
+struct WorkerPoolStats {
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    uint64_t blocked = 0;       // submissions that had to wait for a free slot
+    uint32_t depth = 0;         // queued and not started yet
+    uint32_t maxDepth = 0;
+    uint64_t totalWaitUs = 0;   // submit to start
+    uint64_t totalRunUs = 0;    // start to done
+    uint64_t maxLatencyUs = 0;  // submit to done
+};
+
+/*
+ * Fixed set of worker threads fed from a bounded queue. Submit() blocks while the queue is full,
+ * which pushes back on the producer instead of letting frames pile up. Tasks carry a key (the
+ * stream id) so a stream can be drained on its own, and run in any order across workers.
+ */
+class RKWorkerPool {
+public:
+    // the task gets the index of the worker running it, for per-worker resources
+    using Task = std::function<void(uint32_t worker)>;
+
+    RKWorkerPool(const std::string& name, uint32_t workers, uint32_t capacity);
+    ~RKWorkerPool();
+
+    void Submit(int32_t key, const Task& task);
+    // waits until every task submitted with this key has run
+    void Drain(int32_t key);
+    uint32_t GetWorkerCount() const;
+    WorkerPoolStats GetStats();
+
+private:
+    struct Item {
+        int32_t key = 0;
+        Task task;
+        int64_t submitUs = 0;
+    };
+
+    void WorkerLoop(uint32_t index);
+
+    std::string name_;
+    uint32_t capacity_ = 0;
+    std::mutex lock_;
+    std::condition_variable workCv_;
+    std::condition_variable spaceCv_;
+    std::condition_variable doneCv_;
+    std::deque<Item> queue_;
+    std::map<int32_t, uint32_t> outstanding_;
+    bool running_ = true;
+    WorkerPoolStats stats_;
+    std::vector<std::thread> workers_;
+};
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <dlfcn.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ipp_algo.h"
+#include "ipp_merge_compose.h"
+#include "ipp_merge_kernels.h"
+#include "ipp_merge_pool.h"
+
+namespace OHOS::Camera {
+namespace {
+// CAMERA_BENCH_IPP_PLUGIN=/vendor/lib64/libcamera_ipp_algo_merge.z.so picks the plugin under test,
+// CAMERA_BENCH_IPP_BASELINE the one it is compared with
+constexpr const char* PLUGIN_ENV = "CAMERA_BENCH_IPP_PLUGIN";
+constexpr const char* BASELINE_ENV = "CAMERA_BENCH_IPP_BASELINE";
+constexpr const char* DEFAULT_PLUGIN = "libcamera_ipp_algo_merge.z.so";
+constexpr const char* DEFAULT_BASELINE = "libcamera_ipp_algo_example.z.so";
+constexpr uint32_t FRAME_WIDTH = 1920;
+constexpr uint32_t FRAME_HEIGHT = 1080;
+constexpr uint32_t FRAME_STRIDE = 4096;     // a 1080p packed row padded to 4 KiB, like the ISP output
+constexpr int64_t SINGLE_INPUT = IPP_MERGE_COPY;
+constexpr uint32_t UHD_WIDTH = 3840;
+constexpr uint32_t UHD_HEIGHT = 2160;
+constexpr uint32_t BANDS_PER_THREAD = 4;    // as ipp_algo_merge.c picks them
+constexpr uint32_t MIN_BAND_ROWS = 16;
+constexpr int SERIAL_FRAMES = 10;
+
+// the entry points of ipp_algo.h, resolved by name like the IPP node does
+using InitFunc = int (*)(const IppAlgoMeta*);
+using StartFunc = int (*)();
+using ProcessFunc = int (*)(IppAlgoBuffer*[], int, IppAlgoBuffer*, const IppAlgoMeta*);
+using StopFunc = int (*)();
+using ConfigureFunc = int (*)(int, int, unsigned int);
+
+struct IppPlugin {
+    void* handle = nullptr;
+    InitFunc init = nullptr;
+    StartFunc start = nullptr;
+    ProcessFunc process = nullptr;
+    StopFunc stop = nullptr;
+    ConfigureFunc configure = nullptr;  // only the merge plugin has it
+};
+
+const IppPlugin* LoadPlugin(const char* env, const char* defaultPath)
+{
+    static std::map<std::string, IppPlugin> plugins;
+    const char* path = std::getenv(env);
+    std::string name = path != nullptr ? path : defaultPath;
+    auto it = plugins.find(name);
+    if (it != plugins.end()) {
+        return it->second.handle != nullptr ? &it->second : nullptr;
+    }
+    IppPlugin& plugin = plugins[name];
+    plugin.handle = dlopen(name.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (plugin.handle == nullptr) {
+        return nullptr;
+    }
+    plugin.init = reinterpret_cast<InitFunc>(dlsym(plugin.handle, "Init"));
+    plugin.start = reinterpret_cast<StartFunc>(dlsym(plugin.handle, "Start"));
+    plugin.process = reinterpret_cast<ProcessFunc>(dlsym(plugin.handle, "Process"));
+    plugin.stop = reinterpret_cast<StopFunc>(dlsym(plugin.handle, "Stop"));
+    plugin.configure = reinterpret_cast<ConfigureFunc>(dlsym(plugin.handle, "IppMergeConfigure"));
+    if (plugin.init == nullptr || plugin.start == nullptr || plugin.process == nullptr || plugin.stop == nullptr ||
+        plugin.init(nullptr) != 0) {
+        dlclose(plugin.handle);
+        plugin.handle = nullptr;
+        return nullptr;
+    }
+    return &plugin;
+}
+
+size_t FrameBytes(IppMergeFormat format)
+{
+    size_t luma = static_cast<size_t>(FRAME_STRIDE) * FRAME_HEIGHT;
+    return format == IPP_MERGE_NV12 ? luma + luma / 2 : luma;
+}
+
+struct Frames {
+    std::vector<std::vector<uint8_t>> bytes;
+    IppAlgoBuffer buffers[3] = {};  // 3: two inputs and the output
+};
+
+void MakeFrames(IppMergeFormat format, Frames& frames)
+{
+    frames.bytes.assign(3, std::vector<uint8_t>(FrameBytes(format)));    // 3: two inputs and the output
+    uint32_t seed = 1;
+    for (size_t i = 0; i < frames.bytes.size(); i++) {
+        for (uint8_t& b : frames.bytes[i]) {
+            seed = seed * 1103515245 + 12345;   // 1103515245, 12345: lcg
+            b = static_cast<uint8_t>(seed >> 16);   // 16: the better bits
+        }
+        IppAlgoBuffer& buffer = frames.buffers[i];
+        buffer.addr = frames.bytes[i].data();
+        buffer.width = FRAME_WIDTH;
+        buffer.height = FRAME_HEIGHT;
+        buffer.stride = FRAME_STRIDE;
+        buffer.size = static_cast<unsigned int>(frames.bytes[i].size());
+        buffer.id = static_cast<int>(i);
+    }
+}
+
+// pixel bytes of one frame, the padding of the stride is not counted
+int64_t PixelBytes(IppMergeFormat format)
+{
+    int64_t row = format == IPP_MERGE_YUYV ? FRAME_WIDTH * 2 : FRAME_WIDTH;    // 2: packed 4:2:2
+    int64_t rows = format == IPP_MERGE_NV12 ? FRAME_HEIGHT + FRAME_HEIGHT / 2 : FRAME_HEIGHT;
+    return row * rows;
+}
+
+void RunPlugin(benchmark::State& state, const IppPlugin* plugin, int64_t layout, IppMergeFormat format,
+    bool inPlace)
+{
+    if (plugin == nullptr) {
+        state.SkipWithError("plugin not loaded");
+        return;
+    }
+    constexpr unsigned int halfWeight = 128;
+    if (plugin->configure != nullptr) {
+        int configured = layout == SINGLE_INPUT ? IPP_MERGE_SIDE_BY_SIDE : static_cast<int>(layout);
+        if (plugin->configure(configured, format, halfWeight) != 0) {
+            state.SkipWithError("configure failed");
+            return;
+        }
+    }
+    Frames frames;
+    MakeFrames(format, frames);
+    IppAlgoBuffer* in[] = {&frames.buffers[0], &frames.buffers[1]};
+    // a single input in place would be nothing to do
+    int count = layout == SINGLE_INPUT ? 1 : 2;     // 2: a merge
+    IppAlgoBuffer* out = (inPlace && count > 1) ? nullptr : &frames.buffers[2];    // 2: the output
+    plugin->start();
+    for (auto _ : state) {
+        if (plugin->process(in, count, out, nullptr) != 0) {
+            state.SkipWithError("process failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    plugin->stop();
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * PixelBytes(format) * count);
+}
+
+// the plugin through its exported entry points: layout, format, output over the first input
+void BenchmarkIppMergePlugin(benchmark::State& state)
+{
+    const IppPlugin* plugin = LoadPlugin(PLUGIN_ENV, DEFAULT_PLUGIN);
+    RunPlugin(state, plugin, state.range(0), static_cast<IppMergeFormat>(state.range(1)), state.range(2) != 0);
+    state.SetLabel(IppMergeSimdName());
+}
+
+// the example plugin: packed 4:2:2 only and it prints on every frame
+void BenchmarkIppMergeBaseline(benchmark::State& state)
+{
+    const IppPlugin* plugin = LoadPlugin(BASELINE_ENV, DEFAULT_BASELINE);
+    RunPlugin(state, plugin, state.range(0), IPP_MERGE_YUYV, true);
+}
+
+struct BandRun {
+    IppMergePlan plan;
+    uint32_t phase = 0;
+    uint32_t bandRows = 0;
+    uint8_t* scratch = nullptr;
+};
+
+void RunBand(void* context, uint32_t band, uint32_t worker)
+{
+    const BandRun* run = static_cast<const BandRun*>(context);
+    IppMergeRunBand(&run->plan, run->phase, band * run->bandRows, (band + 1) * run->bandRows,
+        run->scratch + worker * run->plan.bandScratch);
+}
+
+// one frame the way the plugin's Process runs it, the bands one after the other without a pool
+void MergeFrame(BandRun& run, IppMergePool* pool)
+{
+    uint32_t bands = (run.plan.out.height + run.bandRows - 1) / run.bandRows;
+    for (run.phase = 0; run.phase < run.plan.phases; run.phase++) {
+        if (pool != nullptr) {
+            IppMergePoolRun(pool, bands, RunBand, &run);
+            continue;
+        }
+        for (uint32_t band = 0; band < bands; band++) {
+            RunBand(&run, band, 0);
+        }
+    }
+}
+
+/*
+ * A 1080p or 4K packed 4:2:2 merge in bands on a pool of big cores against the same frame in one piece,
+ * "speedup" is the serial frame time over the banded one; the output is the same either way.
+ */
+void BenchmarkIppMergeBands(benchmark::State& state)
+{
+    uint32_t height = static_cast<uint32_t>(state.range(0));
+    uint32_t width = height == UHD_HEIGHT ? UHD_WIDTH : FRAME_WIDTH;
+    IppMergeLayout layout = static_cast<IppMergeLayout>(state.range(1));
+    uint32_t threads = static_cast<uint32_t>(state.range(2));
+    uint32_t stride = width * 2;    // 2: packed 4:2:2, already on a 64 byte line at both sizes
+    std::vector<std::vector<uint8_t>> bytes(3, std::vector<uint8_t>(static_cast<size_t>(stride) * height));
+    IppMergeImage images[3];   // 3: two inputs and the output
+    uint32_t seed = 1;
+    for (size_t i = 0; i < bytes.size(); i++) {
+        for (uint8_t& b : bytes[i]) {
+            seed = seed * 1103515245 + 12345;   // 1103515245, 12345: lcg
+            b = static_cast<uint8_t>(seed >> 16);   // 16: the better bits
+        }
+        images[i] = {bytes[i].data(), width, height, stride, static_cast<uint32_t>(bytes[i].size())};
+    }
+    BandRun run;
+    constexpr uint32_t halfWeight = 128;
+    if (IppMergePlanMerge(&run.plan, layout, IPP_MERGE_YUYV, &images[2], &images[0], &images[1], halfWeight) != 0) {
+        state.SkipWithError("plan failed");
+        return;
+    }
+    uint32_t cpus[IPP_MERGE_POOL_MAX_THREADS];
+    uint32_t cpuCount = IppMergeBigCores(cpus, IPP_MERGE_POOL_MAX_THREADS);
+    IppMergePool* pool = threads > 1 ? IppMergePoolCreate(threads, cpus, cpuCount) : nullptr;
+    threads = IppMergePoolThreads(pool);
+    std::vector<uint8_t> scratch(run.plan.bandScratch * threads + run.plan.sharedScratch + 1);
+    run.scratch = scratch.data();
+    run.plan.shared = scratch.data() + run.plan.bandScratch * threads;
+
+    run.bandRows = height;
+    MergeFrame(run, nullptr);   // the first touch of the output is not the merge
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < SERIAL_FRAMES; i++) {
+        MergeFrame(run, nullptr);
+    }
+    double serialUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() /
+        SERIAL_FRAMES;
+
+    run.bandRows = std::max(height / (threads * BANDS_PER_THREAD) / IPP_MERGE_BAND_ALIGN * IPP_MERGE_BAND_ALIGN,
+        MIN_BAND_ROWS);
+    begin = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        MergeFrame(run, pool);
+        benchmark::ClobberMemory();
+    }
+    double frameUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() /
+        std::max<double>(static_cast<double>(state.iterations()), 1.0);
+    IppMergePoolDestroy(pool);
+
+    state.counters["threads"] = threads;
+    state.counters["band_rows"] = run.bandRows;
+    state.counters["serial_us"] = serialUs;
+    state.counters["frame_us"] = frameUs;
+    state.counters["speedup"] = frameUs > 0.0 ? serialUs / frameUs : 0.0;
+    state.SetLabel(std::to_string(width) + "x" + std::to_string(height));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * stride * height * 2);   // 2: both inputs
+}
+
+enum class MergeKernel : int64_t {
+    HALVE_YUYV = 0,
+    HALVE_LUMA,
+    AVERAGE,
+    BLEND,
+};
+
+// one 1080p plane through a row kernel, scalar against the vector unit
+void BenchmarkIppMergeKernel(benchmark::State& state)
+{
+    MergeKernel kernel = static_cast<MergeKernel>(state.range(0));
+    bool simd = state.range(1) != 0;
+    size_t rowBytes = kernel == MergeKernel::HALVE_YUYV ? FRAME_WIDTH * 2 : FRAME_WIDTH;    // 2: packed 4:2:2
+    std::vector<uint8_t> a(rowBytes * FRAME_HEIGHT, 0x5a);
+    std::vector<uint8_t> b(rowBytes * FRAME_HEIGHT, 0xa5);
+    std::vector<uint8_t> dst(rowBytes);
+    constexpr uint32_t weight = 96;
+    for (auto _ : state) {
+        for (uint32_t r = 0; r < FRAME_HEIGHT; r++) {
+            const uint8_t* rowA = a.data() + r * rowBytes;
+            const uint8_t* rowB = b.data() + r * rowBytes;
+            switch (kernel) {
+                case MergeKernel::HALVE_YUYV:
+                case MergeKernel::HALVE_LUMA: {
+                    IppMergePairing pairing = kernel == MergeKernel::HALVE_YUYV ? IPP_MERGE_PAIR_YUYV :
+                        IPP_MERGE_PAIR_LUMA;
+                    simd ? IppMergeHalveRowSimd(dst.data(), rowA, rowBytes, pairing) :
+                        IppMergeHalveRowScalar(dst.data(), rowA, rowBytes, pairing);
+                    break;
+                }
+                case MergeKernel::AVERAGE:
+                    simd ? IppMergeAverageRowsSimd(dst.data(), rowA, rowB, rowBytes) :
+                        IppMergeAverageRowsScalar(dst.data(), rowA, rowB, rowBytes);
+                    break;
+                default:
+                    simd ? IppMergeBlendRowSimd(dst.data(), rowA, rowB, rowBytes, weight) :
+                        IppMergeBlendRowScalar(dst.data(), rowA, rowB, rowBytes, weight);
+                    break;
+            }
+            benchmark::DoNotOptimize(dst.data());
+        }
+    }
+    state.SetLabel(simd ? IppMergeSimdName() : "scalar");
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * a.size()));
+}
+} // namespace
+
+BENCHMARK(BenchmarkIppMergeKernel)->ArgsProduct({{0, 1, 2, 3}, {0, 1}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BenchmarkIppMergePlugin)
+    ->ArgsProduct({{IPP_MERGE_SIDE_BY_SIDE, IPP_MERGE_PICTURE_IN_PICTURE, IPP_MERGE_BLEND, SINGLE_INPUT},
+        {IPP_MERGE_YUYV, IPP_MERGE_NV12}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BenchmarkIppMergeBands)
+    ->ArgsProduct({{FRAME_HEIGHT, UHD_HEIGHT}, {IPP_MERGE_SIDE_BY_SIDE, IPP_MERGE_PICTURE_IN_PICTURE, IPP_MERGE_BLEND},
+        {1, 2, 3, 4}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BenchmarkIppMergeBaseline)->Arg(IPP_MERGE_SIDE_BY_SIDE)->Arg(SINGLE_INPUT)->Unit(benchmark::kMicrosecond);
+} // namespace OHOS::Camera
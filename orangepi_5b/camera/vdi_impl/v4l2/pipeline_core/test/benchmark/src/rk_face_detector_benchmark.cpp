@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rk_face_detector.h"
+
+namespace OHOS::Camera {
+namespace {
+// CAMERA_BENCH_FACE_IMAGES=/data/local/tmp/a.pgm:/data/local/tmp/b.pgm runs over binary pgm stills,
+// CAMERA_BENCH_FACE_CASCADE=/data/local/tmp/haarcascade_frontalface_default.xml the shipped cascade
+constexpr const char* IMAGES_ENV = "CAMERA_BENCH_FACE_IMAGES";
+constexpr const char* CASCADE_ENV = "CAMERA_BENCH_FACE_CASCADE";
+constexpr uint32_t SYNTHETIC_WIDTH = 1920;
+constexpr uint32_t SYNTHETIC_HEIGHT = 1080;
+constexpr uint32_t WINDOW = 24;
+
+struct Still {
+    std::string name;
+    LumaImage full;
+};
+
+struct BenchData {
+    std::string name;
+    std::vector<Still> stills;
+    HaarCascade cascade;
+};
+
+bool LoadPgm(const std::string& path, LumaImage& image)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    uint32_t maxValue = 0;
+    file >> magic;
+    auto skipComments = [&file] {
+        file >> std::ws;
+        while (file.peek() == '#') {
+            std::string line;
+            std::getline(file, line);
+            file >> std::ws;
+        }
+    };
+    skipComments();
+    file >> image.width;
+    skipComments();
+    file >> image.height;
+    skipComments();
+    file >> maxValue;
+    constexpr uint32_t eightBit = 255;
+    if (!file || magic != "P5" || maxValue != eightBit || image.width == 0 || image.height == 0) {
+        return false;
+    }
+    file.get();     // the single whitespace before the raster
+    image.data.resize(static_cast<size_t>(image.width) * image.height);
+    file.read(reinterpret_cast<char*>(image.data.data()), static_cast<std::streamsize>(image.data.size()));
+    return static_cast<size_t>(file.gcount()) == image.data.size();
+}
+
+HaarFeature MakeFeature(std::initializer_list<HaarRect> rects)
+{
+    HaarFeature feature;
+    for (const HaarRect& r : rects) {
+        feature.rects[feature.count++] = r;
+    }
+    return feature;
+}
+
+// eyes darker than cheeks, nose bridge and forehead, both halves alike; see utest_rk_face_detector
+HaarCascade MakeSyntheticCascade()
+{
+    HaarCascade cascade;
+    cascade.windowWidth = WINDOW;
+    cascade.windowHeight = WINDOW;
+    cascade.features = {
+        MakeFeature({{2, 6, 20, 12, -1.0f}, {2, 12, 20, 6, 2.0f}}),
+        MakeFeature({{2, 6, 20, 6, -1.0f}, {10, 6, 4, 6, 5.0f}}),
+        MakeFeature({{2, 0, 20, 12, -1.0f}, {2, 0, 20, 6, 2.0f}}),
+        MakeFeature({{0, 0, 12, 24, -1.0f}, {12, 0, 12, 24, 1.0f}}),
+    };
+    constexpr float threshold = 0.25f;
+    constexpr float symmetry = 0.05f;
+    cascade.stages = {
+        {1.5f, {{0, threshold, -1.0f, 1.0f}, {1, threshold, -1.0f, 1.0f}}},    // 1.5: both
+        {0.5f, {{2, threshold, -1.0f, 1.0f}}},                                  // 0.5: the one
+        {1.5f, {{3, -symmetry, -1.0f, 1.0f}, {3, symmetry, 1.0f, -1.0f}}},      // 3: the symmetry feature
+    };
+    return cascade;
+}
+
+// a noisy 1080p luma plane with a few faces of different sizes
+Still MakeSyntheticStill()
+{
+    Still still;
+    still.name = "synthetic";
+    LumaImage& image = still.full;
+    image.width = SYNTHETIC_WIDTH;
+    image.height = SYNTHETIC_HEIGHT;
+    image.data.resize(static_cast<size_t>(SYNTHETIC_WIDTH) * SYNTHETIC_HEIGHT);
+    uint32_t seed = 1;
+    for (uint8_t& p : image.data) {
+        seed = seed * 1103515245 + 12345;   // 1103515245, 12345: lcg
+        p = static_cast<uint8_t>(100 + ((seed >> 16) % 40));    // 100, 16, 40: 100..139
+    }
+    const uint32_t faces[][3] = {{200, 200, 300}, {900, 300, 180}, {1500, 600, 120}};  // x, y, size
+    for (const auto& face : faces) {
+        for (uint32_t v = 0; v < face[2]; v++) {    // 2: size
+            for (uint32_t u = 0; u < face[2]; u++) {
+                uint32_t pu = u * WINDOW / face[2];
+                uint32_t pv = v * WINDOW / face[2];
+                bool eyes = pv >= 6 && pv < 12 && (pu < 10 || pu >= 14);   // 6, 12, 10, 14: eye band, bridge
+                image.data[(face[1] + v) * SYNTHETIC_WIDTH + face[0] + u] = eyes ? 40 : 170;    // 40, 170: grey
+            }
+        }
+    }
+    return still;
+}
+
+const BenchData& GetBenchData()
+{
+    static const BenchData data = [] {
+        BenchData d;
+        const char* images = std::getenv(IMAGES_ENV);
+        if (images != nullptr) {
+            std::stringstream list(images);
+            std::string path;
+            while (std::getline(list, path, ':')) {
+                Still still;
+                still.name = path;
+                if (LoadPgm(path, still.full)) {
+                    d.stills.push_back(std::move(still));
+                }
+            }
+        }
+        const char* cascadePath = std::getenv(CASCADE_ENV);
+        if (cascadePath == nullptr || !LoadOpenCvCascade(cascadePath, d.cascade)) {
+            d.cascade = MakeSyntheticCascade();
+        }
+        if (d.stills.empty()) {
+            d.stills.push_back(MakeSyntheticStill());
+        }
+        d.name = std::to_string(d.stills.size()) + " stills, " + std::to_string(d.cascade.stages.size()) + " stages";
+        return d;
+    }();
+    return data;
+}
+
+// the node side of one detection: full frame luma to the analysed size
+void BenchmarkFaceDownscale(benchmark::State& state)
+{
+    const BenchData& data = GetBenchData();
+    uint32_t targetWidth = static_cast<uint32_t>(state.range(0));
+    LumaImage out;
+    for (auto _ : state) {
+        for (const Still& still : data.stills) {
+            DownscaleLuma(still.full.data.data(), RgaPixelFormat::NV12, still.full.width, still.full.height,
+                still.full.width, targetWidth, out);
+            benchmark::DoNotOptimize(out.data.data());
+        }
+    }
+    state.SetLabel(data.name);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * data.stills.size()));
+}
+
+// the worker side: the cascade over the pyramid of the analysed image, items/s is detections per second
+void BenchmarkFaceDetect(benchmark::State& state)
+{
+    const BenchData& data = GetBenchData();
+    uint32_t targetWidth = static_cast<uint32_t>(state.range(0));
+    std::vector<LumaImage> inputs(data.stills.size());
+    for (size_t i = 0; i < data.stills.size(); i++) {
+        const LumaImage& full = data.stills[i].full;
+        DownscaleLuma(full.data.data(), RgaPixelFormat::NV12, full.width, full.height, full.width, targetWidth,
+            inputs[i]);
+    }
+    std::unique_ptr<IFaceDetector> detector = CreateCascadeFaceDetector(data.cascade, CascadeParams {});
+    if (detector == nullptr) {
+        state.SkipWithError("no detector");
+        return;
+    }
+
+    std::vector<FaceBox> faces;
+    size_t found = 0;
+    for (auto _ : state) {
+        found = 0;
+        for (const LumaImage& input : inputs) {
+            detector->Detect(input, faces);
+            found += faces.size();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetLabel(data.name);
+    state.counters["faces"] = static_cast<double>(found);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * inputs.size()));
+}
+} // namespace
+
+BENCHMARK(BenchmarkFaceDownscale)->Arg(320)->Arg(640)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BenchmarkFaceDetect)->Arg(160)->Arg(320)->Arg(480)->Arg(640)->Unit(benchmark::kMillisecond);
+} // namespace OHOS::Camera
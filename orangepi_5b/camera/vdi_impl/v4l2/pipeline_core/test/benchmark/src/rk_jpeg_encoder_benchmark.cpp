@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <vector>
+
+#include "rk_jpeg_encoder.h"
+#include "rk_worker_pool.h"
+
+namespace OHOS::Camera {
+namespace {
+constexpr int64_t PREVIEW_WIDTH = 1920;
+constexpr int64_t PREVIEW_HEIGHT = 1080;
+constexpr int64_t STILL_WIDTH = 4160;      // 13MP still capture
+constexpr int64_t STILL_HEIGHT = 3120;
+constexpr uint32_t NOISE_MASK = 0x0f;
+constexpr uint32_t BURST_FRAMES = 16;
+constexpr int64_t MAX_BURST_WORKERS = 8;
+
+// gradients with some noise, so that the entropy coder has realistic work to do
+void FillI420(uint8_t* frame, uint32_t width, uint32_t height)
+{
+    uint32_t seed = 1;
+    uint8_t* y = frame;
+    for (uint32_t row = 0; row < height; row++) {
+        for (uint32_t col = 0; col < width; col++) {
+            seed = seed * 1103515245 + 12345;   // 1103515245, 12345: lcg
+            y[row * width + col] = static_cast<uint8_t>((col + row) / 16 + ((seed >> 16) & NOISE_MASK));
+        }
+    }
+    size_t chroma = static_cast<size_t>(width / 2) * (height / 2);
+    uint8_t* u = frame + static_cast<size_t>(width) * height;
+    uint8_t* v = u + chroma;
+    for (size_t i = 0; i < chroma; i++) {
+        u[i] = static_cast<uint8_t>(96 + (i % width) / 32);     // 96, 32: blueish ramp
+        v[i] = static_cast<uint8_t>(160 - (i % width) / 32);    // 160, 32: reddish ramp
+    }
+}
+
+/*
+ * The source frame is a dma buffer like a camera buffer, so the MPP encoder gets an fd and the cpu
+ * encoders a mapping of the same frame. A buffer without a mapping cannot be filled and is refused.
+ */
+bool AllocSourceFrame(RKRgaSession& rga, uint32_t width, uint32_t height, RgaBuffer& frame)
+{
+    if (rga.AllocBuffer(width, height, RgaPixelFormat::YUV420P, frame) != 0) {
+        return false;
+    }
+    if (frame.virAddr == nullptr) {
+        rga.FreeBuffer(frame);
+        return false;
+    }
+    FillI420(static_cast<uint8_t*>(frame.virAddr), width, height);
+    return true;
+}
+
+void BenchmarkJpegEncode(benchmark::State& state)
+{
+    JpegBackendType type = static_cast<JpegBackendType>(state.range(0));
+    uint32_t width = static_cast<uint32_t>(state.range(1));
+    uint32_t height = static_cast<uint32_t>(state.range(2));
+    state.SetLabel(JpegBackendName(type));
+
+    auto rga = std::make_shared<RKRgaSession>(CreateRgaHwBackend());
+    RgaBuffer frame;
+    if (!AllocSourceFrame(*rga, width, height, frame)) {
+        state.SkipWithError("frame allocation failed");
+        return;
+    }
+
+    std::unique_ptr<IJpegEncoder> encoder = CreateJpegEncoder(type, rga);
+    if (encoder == nullptr) {
+        rga->FreeBuffer(frame);
+        state.SkipWithError("backend not available");
+        return;
+    }
+
+    JpegInput in;
+    in.fd = frame.fd;
+    in.yuv = static_cast<uint8_t*>(frame.virAddr);
+    in.width = width;
+    in.height = height;
+    in.quality = 95;    // 95: OHOS_CAMERA_JPEG_LEVEL_MIDDLE
+    std::vector<uint8_t> jpeg(JpegWorstCaseSize(width, height));
+    JpegOutput out;
+    out.data = jpeg.data();
+    out.capacity = jpeg.size();
+
+    for (auto _ : state) {
+        if (encoder->Encode(in, out) != 0) {
+            state.SkipWithError("encode failed");
+            break;
+        }
+    }
+
+    state.counters["jpeg_bytes"] = static_cast<double>(out.size);
+    state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(frame.size));
+    rga->FreeBuffer(frame);
+}
+
+void JpegEncodeArgs(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t type = static_cast<int64_t>(JpegBackendType::MPP);
+        type <= static_cast<int64_t>(JpegBackendType::LIBJPEG); type++) {
+        bench->Args({type, PREVIEW_WIDTH, PREVIEW_HEIGHT});
+        bench->Args({type, STILL_WIDTH, STILL_HEIGHT});
+    }
+}
+
+/*
+ * A burst of stills through the encode pool the way RKCodecNode runs it: one encoder, RGA session
+ * and output buffer per worker, all reading the same frame.
+ */
+void BenchmarkJpegBurst(benchmark::State& state)
+{
+    JpegBackendType type = static_cast<JpegBackendType>(state.range(0));
+    uint32_t workers = static_cast<uint32_t>(state.range(1));
+    state.SetLabel(JpegBackendName(type));
+
+    auto rga = std::make_shared<RKRgaSession>(CreateRgaHwBackend());
+    RgaBuffer frame;
+    if (!AllocSourceFrame(*rga, STILL_WIDTH, STILL_HEIGHT, frame)) {
+        state.SkipWithError("frame allocation failed");
+        return;
+    }
+
+    std::vector<std::unique_ptr<IJpegEncoder>> encoders;
+    std::vector<std::vector<uint8_t>> outputs;
+    for (uint32_t i = 0; i < workers; i++) {
+        encoders.push_back(CreateJpegEncoder(type, std::make_shared<RKRgaSession>(CreateRgaHwBackend())));
+        outputs.emplace_back(JpegWorstCaseSize(STILL_WIDTH, STILL_HEIGHT));
+        if (encoders.back() == nullptr) {
+            rga->FreeBuffer(frame);
+            state.SkipWithError("backend not available");
+            return;
+        }
+    }
+
+    JpegInput in;
+    in.fd = frame.fd;
+    in.yuv = static_cast<uint8_t*>(frame.virAddr);
+    in.width = STILL_WIDTH;
+    in.height = STILL_HEIGHT;
+    in.quality = 95;    // 95: OHOS_CAMERA_JPEG_LEVEL_MIDDLE
+
+    std::atomic<uint32_t> failures {0};
+    {
+        RKWorkerPool pool("jpegbench", workers, workers * 2);   // 2: the node default queue per worker
+        for (auto _ : state) {
+            for (uint32_t i = 0; i < BURST_FRAMES; i++) {
+                pool.Submit(0, [&encoders, &outputs, &in, &failures](uint32_t worker) {
+                    JpegOutput out;
+                    out.data = outputs[worker].data();
+                    out.capacity = outputs[worker].size();
+                    if (encoders[worker]->Encode(in, out) != 0) {
+                        failures++;
+                    }
+                });
+            }
+            pool.Drain(0);
+        }
+    }
+    if (failures != 0) {
+        state.SkipWithError("encode failed");
+    }
+
+    state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations() * BURST_FRAMES),
+        benchmark::Counter::kIsRate);
+    rga->FreeBuffer(frame);
+}
+
+void JpegBurstArgs(benchmark::internal::Benchmark* bench)
+{
+    for (int64_t type = static_cast<int64_t>(JpegBackendType::MPP);
+        type <= static_cast<int64_t>(JpegBackendType::LIBJPEG); type++) {
+        for (int64_t workers = 1; workers <= MAX_BURST_WORKERS; workers *= 2) {  // 2: 1, 2, 4, 8 workers
+            bench->Args({type, workers});
+        }
+    }
+}
+} // namespace
+
+BENCHMARK(BenchmarkJpegEncode)->Apply(JpegEncodeArgs)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BenchmarkJpegBurst)->Apply(JpegBurstArgs)->Unit(benchmark::kMillisecond)->UseRealTime();
+} // namespace OHOS::Camera
+
+BENCHMARK_MAIN();
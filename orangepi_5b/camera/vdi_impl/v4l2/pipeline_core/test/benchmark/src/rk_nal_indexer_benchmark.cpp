@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "rk_nal_indexer.h"
+
+namespace OHOS::Camera {
+namespace {
+// CAMERA_BENCH_BITSTREAM=/data/local/tmp/record.h264 replays a recorded Annex-B stream,
+// a .h265/.hevc extension selects the HEVC NAL types
+constexpr const char* BITSTREAM_ENV = "CAMERA_BENCH_BITSTREAM";
+constexpr size_t SYNTHETIC_IFRAME_SIZE = 256 * 1024;
+constexpr size_t SYNTHETIC_PFRAME_SIZE = 24 * 1024;
+constexpr uint32_t SYNTHETIC_PFRAMES = 29;  // one second at 30fps with a gop of 30
+
+enum class NalScan : int64_t {
+    BYTEWISE = 0,
+    SCALAR,
+    SIMD,
+    INDEX,
+};
+
+struct Bitstream {
+    std::vector<uint8_t> data;
+    NalCodec codec = NalCodec::H264;
+    std::string name;
+};
+
+bool EndsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// random slice payload with emulation prevention applied, like the encoder output
+void AppendNal(std::vector<uint8_t>& out, uint8_t header, size_t size, uint32_t& seed)
+{
+    const uint8_t startCode[] = {0, 0, 0, 1};
+    out.insert(out.end(), std::begin(startCode), std::end(startCode));
+    out.push_back(header);
+    uint32_t zeros = 0;
+    for (size_t i = 0; i < size; i++) {
+        seed = seed * 1103515245 + 12345;   // 1103515245, 12345: lcg
+        uint8_t b = static_cast<uint8_t>(seed >> 16);   // 16: the better bits of the lcg
+        if (zeros == 2 && b <= 3) {         // 2, 3: 00 00 0x needs an emulation prevention byte
+            out.push_back(3);               // 3: emulation_prevention_three_byte
+            zeros = 0;
+        }
+        zeros = (b == 0) ? zeros + 1 : 0;
+        out.push_back(b);
+    }
+}
+
+Bitstream MakeSyntheticStream()
+{
+    Bitstream stream;
+    stream.name = "synthetic";
+    uint32_t seed = 1;
+    AppendNal(stream.data, 0x67, 16, seed);     // 0x67, 16: SPS
+    AppendNal(stream.data, 0x68, 4, seed);      // 0x68, 4: PPS
+    AppendNal(stream.data, 0x65, SYNTHETIC_IFRAME_SIZE, seed);  // 0x65: IDR slice
+    for (uint32_t i = 0; i < SYNTHETIC_PFRAMES; i++) {
+        AppendNal(stream.data, 0x41, SYNTHETIC_PFRAME_SIZE, seed);  // 0x41: P slice
+    }
+    return stream;
+}
+
+const Bitstream& GetBitstream()
+{
+    static const Bitstream stream = [] {
+        const char* path = std::getenv(BITSTREAM_ENV);
+        if (path != nullptr) {
+            std::ifstream file(path, std::ios::binary);
+            if (file) {
+                Bitstream recorded;
+                recorded.name = path;
+                recorded.data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                if (EndsWith(recorded.name, ".h265") || EndsWith(recorded.name, ".hevc")) {
+                    recorded.codec = NalCodec::H265;
+                }
+                return recorded;
+            }
+        }
+        return MakeSyntheticStream();
+    }();
+    return stream;
+}
+
+// the search RKCodecNode did before the indexer, one byte at a time
+const uint8_t* FindStartCodeBytewise(const uint8_t* p, const uint8_t* end)
+{
+    for (; p + 3 <= end; p++) {             // 3: 00 00 01
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1) {
+            return p;
+        }
+    }
+    return end;
+}
+
+template<typename Find>
+size_t CountStartCodes(const std::vector<uint8_t>& data, Find find)
+{
+    const uint8_t* end = data.data() + data.size();
+    size_t count = 0;
+    for (const uint8_t* p = find(data.data(), end); p < end; p = find(p + 3, end)) {   // 3: skip 00 00 01
+        count++;
+    }
+    return count;
+}
+
+void BenchmarkNalScan(benchmark::State& state)
+{
+    const Bitstream& stream = GetBitstream();
+    NalScan scan = static_cast<NalScan>(state.range(0));
+    state.SetLabel(stream.name);
+
+    NalIndex index;
+    size_t units = 0;
+    for (auto _ : state) {
+        switch (scan) {
+            case NalScan::BYTEWISE:
+                units = CountStartCodes(stream.data, FindStartCodeBytewise);
+                break;
+            case NalScan::SCALAR:
+                units = CountStartCodes(stream.data, FindStartCodeScalar);
+                break;
+            case NalScan::SIMD:
+                units = CountStartCodes(stream.data, FindStartCodeSimd);
+                break;
+            default:
+                units = IndexNalUnits(stream.data.data(), stream.data.size(), stream.codec, index);
+                break;
+        }
+        benchmark::DoNotOptimize(units);
+    }
+
+    state.counters["nal_units"] = static_cast<double>(units);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(stream.data.size()));
+}
+} // namespace
+
+BENCHMARK(BenchmarkNalScan)->DenseRange(static_cast<int64_t>(NalScan::BYTEWISE),
+    static_cast<int64_t>(NalScan::INDEX))->Unit(benchmark::kMicrosecond);
+} // namespace OHOS::Camera
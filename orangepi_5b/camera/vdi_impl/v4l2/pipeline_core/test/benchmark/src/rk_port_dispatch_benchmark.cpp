@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+#include "rk_port_table.h"
+
+namespace OHOS::Camera {
+namespace {
+constexpr int64_t MIN_STREAMS = 1;
+constexpr int64_t MAX_STREAMS = 8;
+constexpr int32_t FIRST_STREAM_ID = 1000;   // the host numbers streams from wherever it likes
+
+struct FakeFormat {
+    int32_t streamId_ = 0;
+};
+
+struct FakePort {
+    FakeFormat format_;
+    uint64_t delivered = 0;
+    void DeliverBuffer()
+    {
+        delivered++;
+    }
+};
+
+// what NodeBase does: the ports live behind shared_ptr and GetOutPorts() returns a copy
+class FakeNode {
+public:
+    explicit FakeNode(int32_t streams)
+    {
+        for (int32_t i = 0; i < streams; i++) {
+            auto port = std::make_shared<FakePort>();
+            port->format_.streamId_ = FIRST_STREAM_ID + i;
+            ports_.push_back(port);
+        }
+    }
+
+    std::vector<std::shared_ptr<FakePort>> GetOutPorts() const
+    {
+        return ports_;
+    }
+
+    // the per frame dispatch the nodes did before the table
+    void DeliverScan(int32_t id)
+    {
+        std::vector<std::shared_ptr<FakePort>> outPutPorts_;
+        outPutPorts_ = GetOutPorts();
+        for (auto& it : outPutPorts_) {
+            if (it->format_.streamId_ == id) {
+                it->DeliverBuffer();
+                return;
+            }
+        }
+    }
+
+    void DeliverTable(int32_t id)
+    {
+        FakePort* port = table_.Find(id, [this] { return GetOutPorts(); });
+        if (port != nullptr) {
+            port->DeliverBuffer();
+        }
+    }
+
+    void Start()
+    {
+        table_.Build(GetOutPorts());
+    }
+
+private:
+    std::vector<std::shared_ptr<FakePort>> ports_;
+    RKPortTable<FakePort> table_;
+};
+
+// one frame per stream per iteration, round robin like interleaved preview/video/still streams
+template<bool useTable>
+void BenchmarkPortDispatch(benchmark::State& state)
+{
+    int32_t streams = static_cast<int32_t>(state.range(0));
+    FakeNode node(streams);
+    node.Start();
+    for (auto _ : state) {
+        for (int32_t i = 0; i < streams; i++) {
+            if (useTable) {
+                node.DeliverTable(FIRST_STREAM_ID + i);
+            } else {
+                node.DeliverScan(FIRST_STREAM_ID + i);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * streams);
+}
+
+void BenchmarkPortDispatchScan(benchmark::State& state)
+{
+    BenchmarkPortDispatch<false>(state);
+}
+
+void BenchmarkPortDispatchTable(benchmark::State& state)
+{
+    BenchmarkPortDispatch<true>(state);
+}
+} // namespace
+
+BENCHMARK(BenchmarkPortDispatchScan)->DenseRange(MIN_STREAMS, MAX_STREAMS);
+BENCHMARK(BenchmarkPortDispatchTable)->DenseRange(MIN_STREAMS, MAX_STREAMS);
+} // namespace OHOS::Camera
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_IPP_BENCH_H
+#define HOS_CAMERA_IPP_BENCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ipp_algo.h"
+
+namespace OHOS::Camera {
+enum class BenchFormat : int32_t {
+    YUYV = 0,
+    NV12,
+    RGBA8888,
+};
+
+struct BenchConfig {
+    std::string plugin;
+    std::vector<std::string> inputFiles;    // raw frames, one file per input, cycled; empty: synthetic
+    std::string dumpPath;                   // the last output of the first thread
+    BenchFormat format = BenchFormat::YUYV;
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t stride = 0;                    // bytes, 0: the row rounded up to align
+    uint32_t align = 64;
+    int32_t inputs = 2;
+    bool inPlace = false;                   // no output buffer, the plugin writes the first input
+    uint32_t threads = 1;
+    uint32_t warmup = 10;
+    uint32_t iterations = 300;
+    bool cold = false;                      // evict the caches before every call
+    bool perf = true;
+    bool conformance = false;
+    std::string jsonPath;                   // the report as json as well, "-": stdout
+    int32_t mergeLayout = -1;               // IppMergeConfigure when the plugin has it, -1: leave it
+    int32_t mergeFormat = -1;
+    uint32_t mergeWeight = 128;
+    int32_t mergeThreads = -1;              // IppMergeConfigureBands when the plugin has it, -1: leave it
+    uint32_t mergeBandRows = 0;
+    double gateP99Us = 0.0;                 // fail when the p99 is above, 0: no gate
+    double gateFps = 0.0;                   // fail when the throughput is below, 0: no gate
+};
+
+// the ipp_algo.h entry points of one plugin, resolved by name like the IPP node does
+struct IppPluginApi {
+    using InitFunc = int (*)(const IppAlgoMeta*);
+    using LifecycleFunc = int (*)();
+    using ProcessFunc = int (*)(IppAlgoBuffer*[], int, IppAlgoBuffer*, const IppAlgoMeta*);
+    using ConfigureFunc = int (*)(int, int, unsigned int);
+    using ConfigureBandsFunc = int (*)(unsigned int, unsigned int);
+
+    void* handle = nullptr;
+    InitFunc init = nullptr;
+    LifecycleFunc start = nullptr;
+    ProcessFunc process = nullptr;
+    LifecycleFunc flush = nullptr;
+    LifecycleFunc stop = nullptr;
+    ConfigureFunc configure = nullptr;  // optional, see ipp_algo_merge.c
+    ConfigureBandsFunc configureBands = nullptr;
+
+    bool Load(const std::string& path, std::string& error);
+    void Unload();
+};
+
+/*
+ * The buffers of one caller: the inputs and an output, each with a guard zone on both sides that the
+ * plugin must leave alone.
+ */
+class BenchFrames {
+public:
+    bool Prepare(const BenchConfig& config, uint32_t seed, std::string& error);
+    void NextFrame();   // the next frame of the input files into the buffers, nothing when synthetic
+    IppAlgoBuffer** Inputs() { return inputPtrs_.data(); }
+    IppAlgoBuffer* Output() { return output_; }
+    int32_t InputCount() const { return static_cast<int32_t>(inputPtrs_.size()); }
+    bool GuardsIntact() const;
+    uint64_t OutputHash() const;
+    const uint8_t* OutputData() const;
+    size_t FrameSize() const { return frameSize_; }
+    size_t PixelBytes() const { return pixelBytes_; }
+    uint32_t Stride() const { return config_.stride; }
+
+private:
+    static constexpr size_t GUARD_SIZE = 4096;
+    static constexpr uint8_t GUARD_BYTE = 0xa5;
+
+    struct Slot {
+        std::vector<uint8_t> memory;    // guard, frame, guard
+        IppAlgoBuffer buffer = {};
+    };
+    void InitSlot(Slot& slot, int32_t id);
+
+    std::vector<Slot> slots_;   // inputs then the output
+    std::vector<IppAlgoBuffer*> inputPtrs_;
+    IppAlgoBuffer* output_ = nullptr;
+    std::vector<std::vector<uint8_t>> files_;
+    size_t fileFrame_ = 0;
+    size_t frameSize_ = 0;
+    size_t pixelBytes_ = 0;
+    BenchConfig config_;
+};
+
+// hardware counters of the calling thread from perf_event_open, where the kernel allows it
+enum PerfCounter : uint32_t {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_REFERENCES,
+    PERF_CACHE_MISSES,
+    PERF_L1D_READ_MISSES,
+    PERF_COUNTER_COUNT,
+};
+
+struct PerfSample {
+    uint32_t valid = 0;     // bit per PerfCounter the kernel let us open
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cacheReferences = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t l1dReadMisses = 0;
+};
+
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool Open(std::string& error);
+    void Enable();
+    void Disable();
+    bool Read(PerfSample& sample);
+
+private:
+    int fds_[PERF_COUNTER_COUNT] = {-1, -1, -1, -1, -1};
+};
+
+struct LatencySummary {
+    size_t count = 0;
+    double minUs = 0.0;
+    double meanUs = 0.0;
+    double p50Us = 0.0;
+    double p90Us = 0.0;
+    double p99Us = 0.0;
+    double p999Us = 0.0;
+    double maxUs = 0.0;
+};
+
+// nearest rank percentiles, sorts ns
+LatencySummary SummarizeLatency(std::vector<uint64_t>& ns);
+
+size_t BenchFrameSize(BenchFormat format, uint32_t width, uint32_t height, uint32_t stride);
+uint32_t BenchRowBytes(BenchFormat format, uint32_t width);
+bool ParseBenchFormat(const std::string& name, BenchFormat& format);
+const char* BenchFormatName(BenchFormat format);
+
+// both return the process exit code
+int RunIppBenchmark(const BenchConfig& config, IppPluginApi& plugin);
+int RunIppConformance(const BenchConfig& config, IppPluginApi& plugin);
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ipp_bench.h"
+#include <dlfcn.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t YUYV_BPP = 2;
+constexpr uint32_t RGBA_BPP = 4;
+constexpr uint32_t NV12_CHROMA_DIV = 2;
+constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+uint32_t Rows(BenchFormat format, uint32_t height)
+{
+    return format == BenchFormat::NV12 ? height + height / NV12_CHROMA_DIV : height;
+}
+
+template<typename F>
+bool Resolve(void* handle, const char* name, F& func)
+{
+    func = reinterpret_cast<F>(dlsym(handle, name));
+    return func != nullptr;
+}
+} // namespace
+
+uint32_t BenchRowBytes(BenchFormat format, uint32_t width)
+{
+    switch (format) {
+        case BenchFormat::YUYV:
+            return width * YUYV_BPP;
+        case BenchFormat::RGBA8888:
+            return width * RGBA_BPP;
+        default:
+            return width;
+    }
+}
+
+size_t BenchFrameSize(BenchFormat format, uint32_t width, uint32_t height, uint32_t stride)
+{
+    (void)width;
+    return static_cast<size_t>(stride) * Rows(format, height);
+}
+
+bool ParseBenchFormat(const std::string& name, BenchFormat& format)
+{
+    if (name == "yuyv" || name == "yuv422") {
+        format = BenchFormat::YUYV;
+    } else if (name == "nv12") {
+        format = BenchFormat::NV12;
+    } else if (name == "rgba" || name == "rgba8888") {
+        format = BenchFormat::RGBA8888;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* BenchFormatName(BenchFormat format)
+{
+    switch (format) {
+        case BenchFormat::YUYV:
+            return "yuyv";
+        case BenchFormat::NV12:
+            return "nv12";
+        default:
+            return "rgba8888";
+    }
+}
+
+bool IppPluginApi::Load(const std::string& path, std::string& error)
+{
+    handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        const char* reason = dlerror();
+        error = reason != nullptr ? reason : "dlopen failed";
+        return false;
+    }
+    bool complete = Resolve(handle, "Init", init) && Resolve(handle, "Start", start) &&
+        Resolve(handle, "Process", process) && Resolve(handle, "Flush", flush) && Resolve(handle, "Stop", stop);
+    Resolve(handle, "IppMergeConfigure", configure);
+    Resolve(handle, "IppMergeConfigureBands", configureBands);
+    if (!complete) {
+        error = path + " misses one of Init, Start, Process, Flush, Stop";
+        Unload();
+        return false;
+    }
+    return true;
+}
+
+void IppPluginApi::Unload()
+{
+    if (handle != nullptr) {
+        dlclose(handle);
+    }
+    *this = IppPluginApi {};
+}
+
+void BenchFrames::InitSlot(Slot& slot, int32_t id)
+{
+    slot.memory.assign(GUARD_SIZE + frameSize_ + GUARD_SIZE, GUARD_BYTE);
+    slot.buffer.addr = slot.memory.data() + GUARD_SIZE;
+    slot.buffer.width = config_.width;
+    slot.buffer.height = config_.height;
+    slot.buffer.stride = config_.stride;
+    slot.buffer.size = static_cast<unsigned int>(frameSize_);
+    slot.buffer.id = id;
+}
+
+bool BenchFrames::Prepare(const BenchConfig& config, uint32_t seed, std::string& error)
+{
+    config_ = config;
+    uint32_t rowBytes = BenchRowBytes(config.format, config.width);
+    if (config_.stride == 0) {
+        uint32_t align = std::max(config.align, 1u);
+        config_.stride = (rowBytes + align - 1) / align * align;
+    }
+    if (config_.stride < rowBytes || config.inputs < 1) {
+        error = "stride below the row or no inputs";
+        return false;
+    }
+    frameSize_ = BenchFrameSize(config.format, config.width, config.height, config_.stride);
+    pixelBytes_ = static_cast<size_t>(rowBytes) * Rows(config.format, config.height);
+
+    slots_.resize(static_cast<size_t>(config.inputs) + 1);
+    for (size_t i = 0; i < slots_.size(); i++) {
+        InitSlot(slots_[i], static_cast<int32_t>(i));
+        uint8_t* frame = static_cast<uint8_t*>(slots_[i].buffer.addr);
+        uint32_t state = seed + static_cast<uint32_t>(i) * 7919;    // 7919: keeps the inputs apart
+        for (size_t b = 0; b < frameSize_; b++) {
+            state = state * 1103515245 + 12345;     // 1103515245, 12345: lcg
+            frame[b] = static_cast<uint8_t>(state >> 16);   // 16: the better bits
+        }
+    }
+    inputPtrs_.clear();
+    for (int32_t i = 0; i < config.inputs; i++) {
+        inputPtrs_.push_back(&slots_[i].buffer);
+    }
+    output_ = config.inPlace ? nullptr : &slots_.back().buffer;
+
+    files_.clear();
+    for (const std::string& path : config.inputFiles) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (data.size() < pixelBytes_) {
+            error = path + " holds less than one " + std::to_string(config.width) + "x" +
+                std::to_string(config.height) + " " + BenchFormatName(config.format) + " frame";
+            return false;
+        }
+        files_.push_back(std::move(data));
+    }
+    fileFrame_ = 0;
+    NextFrame();
+    return true;
+}
+
+// the files hold packed rows, the buffers have the stride
+void BenchFrames::NextFrame()
+{
+    if (files_.empty()) {
+        return;
+    }
+    uint32_t rowBytes = BenchRowBytes(config_.format, config_.width);
+    uint32_t rows = Rows(config_.format, config_.height);
+    for (size_t i = 0; i < inputPtrs_.size(); i++) {
+        const std::vector<uint8_t>& file = files_[i % files_.size()];
+        size_t frames = file.size() / pixelBytes_;
+        const uint8_t* src = file.data() + (fileFrame_ % frames) * pixelBytes_;
+        uint8_t* dst = static_cast<uint8_t*>(inputPtrs_[i]->addr);
+        for (uint32_t r = 0; r < rows; r++) {
+            memcpy(dst + static_cast<size_t>(r) * config_.stride, src + static_cast<size_t>(r) * rowBytes, rowBytes);
+        }
+    }
+    fileFrame_++;
+}
+
+bool BenchFrames::GuardsIntact() const
+{
+    for (const Slot& slot : slots_) {
+        auto isGuard = [](uint8_t b) { return b == GUARD_BYTE; };
+        if (!std::all_of(slot.memory.begin(), slot.memory.begin() + GUARD_SIZE, isGuard) ||
+            !std::all_of(slot.memory.end() - GUARD_SIZE, slot.memory.end(), isGuard)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const uint8_t* BenchFrames::OutputData() const
+{
+    const IppAlgoBuffer& out = output_ != nullptr ? *output_ : *inputPtrs_[0];
+    return static_cast<const uint8_t*>(out.addr);
+}
+
+// FNV-1a over the pixels of the output, the stride padding left out
+uint64_t BenchFrames::OutputHash() const
+{
+    const uint8_t* data = OutputData();
+    uint32_t rowBytes = BenchRowBytes(config_.format, config_.width);
+    uint64_t hash = FNV_OFFSET;
+    for (uint32_t r = 0; r < Rows(config_.format, config_.height); r++) {
+        const uint8_t* row = data + static_cast<size_t>(r) * config_.stride;
+        for (uint32_t i = 0; i < rowBytes; i++) {
+            hash = (hash ^ row[i]) * FNV_PRIME;
+        }
+    }
+    return hash;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * camera_ipp_bench drives one IPP plugin the way the IPP node does, Init, Start, Process per frame, Flush and
+ * Stop, and reports what a Process call costs. It only needs dlopen, so it also builds on a linux host:
+ *     g++ -std=c++17 -O2 -Iinclude -I$camera_path/pipeline_core/ipp/include src/ipp_bench_*.cpp -ldl -lpthread
+ * Exits nonzero when a call fails, a gate is missed or conformance fails, so a change can be gated on it.
+ */
+
+#include <getopt.h>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include "ipp_bench.h"
+
+namespace {
+using namespace OHOS::Camera;
+
+enum Option : int {
+    OPT_PLUGIN = 'p',
+    OPT_WIDTH = 'w',
+    OPT_HEIGHT = 'h',
+    OPT_FORMAT = 'f',
+    OPT_INPUTS = 'n',
+    OPT_THREADS = 't',
+    OPT_ITERATIONS = 'i',
+    OPT_STRIDE = 256,   // 256: past the characters of the short options
+    OPT_HELP,
+    OPT_ALIGN,
+    OPT_IN_PLACE,
+    OPT_WARMUP,
+    OPT_INPUT,
+    OPT_DUMP,
+    OPT_COLD,
+    OPT_NO_PERF,
+    OPT_CONFORMANCE,
+    OPT_JSON,
+    OPT_MERGE_LAYOUT,
+    OPT_MERGE_FORMAT,
+    OPT_MERGE_WEIGHT,
+    OPT_MERGE_THREADS,
+    OPT_MERGE_BAND_ROWS,
+    OPT_GATE_P99,
+    OPT_GATE_FPS,
+};
+
+const struct option OPTIONS[] = {
+    {"plugin", required_argument, nullptr, OPT_PLUGIN},
+    {"width", required_argument, nullptr, OPT_WIDTH},
+    {"height", required_argument, nullptr, OPT_HEIGHT},
+    {"format", required_argument, nullptr, OPT_FORMAT},
+    {"inputs", required_argument, nullptr, OPT_INPUTS},
+    {"threads", required_argument, nullptr, OPT_THREADS},
+    {"iterations", required_argument, nullptr, OPT_ITERATIONS},
+    {"help", no_argument, nullptr, OPT_HELP},
+    {"stride", required_argument, nullptr, OPT_STRIDE},
+    {"align", required_argument, nullptr, OPT_ALIGN},
+    {"in-place", no_argument, nullptr, OPT_IN_PLACE},
+    {"warmup", required_argument, nullptr, OPT_WARMUP},
+    {"input", required_argument, nullptr, OPT_INPUT},
+    {"dump", required_argument, nullptr, OPT_DUMP},
+    {"cold", no_argument, nullptr, OPT_COLD},
+    {"no-perf", no_argument, nullptr, OPT_NO_PERF},
+    {"conformance", no_argument, nullptr, OPT_CONFORMANCE},
+    {"json", required_argument, nullptr, OPT_JSON},
+    {"merge-layout", required_argument, nullptr, OPT_MERGE_LAYOUT},
+    {"merge-format", required_argument, nullptr, OPT_MERGE_FORMAT},
+    {"merge-weight", required_argument, nullptr, OPT_MERGE_WEIGHT},
+    {"merge-threads", required_argument, nullptr, OPT_MERGE_THREADS},
+    {"merge-band-rows", required_argument, nullptr, OPT_MERGE_BAND_ROWS},
+    {"gate-p99-us", required_argument, nullptr, OPT_GATE_P99},
+    {"gate-fps", required_argument, nullptr, OPT_GATE_FPS},
+    {nullptr, 0, nullptr, 0},
+};
+
+void Usage(const char* name)
+{
+    printf("usage: %s --plugin <lib.so> [options]\n"
+        "  -w, --width N            frame width, default 1920\n"
+        "  -h, --height N           frame height, default 1080\n"
+        "  -f, --format F           yuyv, nv12 or rgba8888, default yuyv\n"
+        "      --stride N           row pitch in bytes, default the row rounded up to --align\n"
+        "      --align N            default 64\n"
+        "  -n, --inputs N           input buffers per call, default 2\n"
+        "      --in-place           no output buffer, the plugin writes the first input\n"
+        "      --input a.yuv,b.yuv  packed raw frames per input, cycled, instead of noise\n"
+        "      --dump out.yuv       the last output of the first thread, with its stride\n"
+        "  -t, --threads N          callers at once, the plugin has to be re-entrant, default 1\n"
+        "  -i, --iterations N       timed calls per thread, default 300\n"
+        "      --warmup N           untimed calls per thread first, default 10\n"
+        "      --cold               evict the caches before every call\n"
+        "      --no-perf            no hardware counters\n"
+        "      --json FILE          the report as json as well, - for stdout\n"
+        "      --merge-layout L     IppMergeConfigure after Init: 0 side by side, 1 picture in picture, 2 blend\n"
+        "      --merge-format F     0 yuyv, 1 nv12\n"
+        "      --merge-weight W     blend weight of the second input out of 256, default 128\n"
+        "      --merge-threads N    IppMergeConfigureBands: threads a frame is split over, 0 one per big core\n"
+        "      --merge-band-rows N  rows of a band, a multiple of 4, 0 picks it\n"
+        "      --gate-p99-us US     fail when the p99 latency is above\n"
+        "      --gate-fps FPS       fail when the throughput is below\n"
+        "      --conformance        check the plugin against what the IPP node expects instead\n", name);
+}
+
+bool ParseUnsigned(const char* text, uint32_t& value)
+{
+    char* end = nullptr;
+    unsigned long parsed = strtoul(text, &end, 0);
+    if (end == text || *end != '\0' || parsed > UINT32_MAX) {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+bool ParseOption(int opt, const char* arg, BenchConfig& config)
+{
+    uint32_t value = 0;
+    switch (opt) {
+        case OPT_PLUGIN: config.plugin = arg; return true;
+        case OPT_WIDTH: return ParseUnsigned(arg, config.width) && config.width != 0;
+        case OPT_HEIGHT: return ParseUnsigned(arg, config.height) && config.height != 0;
+        case OPT_FORMAT: return ParseBenchFormat(arg, config.format);
+        case OPT_STRIDE: return ParseUnsigned(arg, config.stride);
+        case OPT_ALIGN: return ParseUnsigned(arg, config.align);
+        case OPT_INPUTS:
+            if (!ParseUnsigned(arg, value) || value == 0) {
+                return false;
+            }
+            config.inputs = static_cast<int32_t>(value);
+            return true;
+        case OPT_IN_PLACE: config.inPlace = true; return true;
+        case OPT_THREADS: return ParseUnsigned(arg, config.threads) && config.threads != 0;
+        case OPT_ITERATIONS: return ParseUnsigned(arg, config.iterations) && config.iterations != 0;
+        case OPT_WARMUP: return ParseUnsigned(arg, config.warmup);
+        case OPT_INPUT: {
+            std::stringstream list(arg);
+            std::string path;
+            while (std::getline(list, path, ',')) {
+                config.inputFiles.push_back(path);
+            }
+            return !config.inputFiles.empty();
+        }
+        case OPT_DUMP: config.dumpPath = arg; return true;
+        case OPT_COLD: config.cold = true; return true;
+        case OPT_NO_PERF: config.perf = false; return true;
+        case OPT_CONFORMANCE: config.conformance = true; return true;
+        case OPT_JSON: config.jsonPath = arg; return true;
+        case OPT_MERGE_LAYOUT:
+        case OPT_MERGE_FORMAT:
+            if (!ParseUnsigned(arg, value)) {
+                return false;
+            }
+            (opt == OPT_MERGE_LAYOUT ? config.mergeLayout : config.mergeFormat) = static_cast<int32_t>(value);
+            return true;
+        case OPT_MERGE_WEIGHT: return ParseUnsigned(arg, config.mergeWeight);
+        case OPT_MERGE_THREADS:
+            if (!ParseUnsigned(arg, value)) {
+                return false;
+            }
+            config.mergeThreads = static_cast<int32_t>(value);
+            return true;
+        case OPT_MERGE_BAND_ROWS: return ParseUnsigned(arg, config.mergeBandRows);
+        case OPT_GATE_P99: config.gateP99Us = atof(arg); return true;
+        case OPT_GATE_FPS: config.gateFps = atof(arg); return true;
+        default: return false;
+    }
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BenchConfig config;
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "p:w:h:f:n:t:i:", OPTIONS, nullptr)) != -1) {
+        if (opt == OPT_HELP) {
+            Usage(argv[0]);
+            return 0;
+        }
+        if (opt == '?') {
+            return 2;   // 2: usage error, getopt has said what was wrong
+        }
+        if (!ParseOption(opt, optarg, config)) {
+            const struct option* o = OPTIONS;
+            while (o->name != nullptr && o->val != opt) {
+                o++;
+            }
+            fprintf(stderr, "bad value \"%s\" for --%s\n", optarg != nullptr ? optarg : "", o->name);
+            return 2;
+        }
+    }
+    if (config.plugin.empty()) {
+        Usage(argv[0]);
+        return 2;
+    }
+    // the merge plugin takes the picture format from IppMergeConfigure, follow --format unless told otherwise
+    if (config.mergeLayout >= 0 && config.mergeFormat < 0) {
+        config.mergeFormat = config.format == BenchFormat::NV12 ? 1 : 0;
+    }
+
+    IppPluginApi plugin;
+    std::string error;
+    if (!plugin.Load(config.plugin, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    int ret = config.conformance ? RunIppConformance(config, plugin) : RunIppBenchmark(config, plugin);
+    plugin.Unload();
+    return ret;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ipp_bench.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace OHOS::Camera {
+namespace {
+struct CounterSpec {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t CACHE_OP_SHIFT = 8;
+constexpr uint64_t CACHE_RESULT_SHIFT = 16;
+
+const CounterSpec COUNTER_SPECS[PERF_COUNTER_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << CACHE_OP_SHIFT) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << CACHE_RESULT_SHIFT)},
+};
+
+// user space of the calling thread on any cpu, which a perf_event_paranoid of 2 still allows; it opens
+// disabled at zero and only counts between Enable and Disable, so cache eviction can be left out
+int OpenCounter(const CounterSpec& spec)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = spec.type;
+    attr.config = spec.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+} // namespace
+
+PerfCounters::~PerfCounters()
+{
+    for (int& fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+bool PerfCounters::Open(std::string& error)
+{
+    bool any = false;
+    for (uint32_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+        fds_[i] = OpenCounter(COUNTER_SPECS[i]);
+        if (fds_[i] >= 0) {
+            any = true;
+        } else if (error.empty()) {
+            error = std::string("perf_event_open: ") + strerror(errno);
+        }
+    }
+    return any;
+}
+
+void PerfCounters::Enable()
+{
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void PerfCounters::Disable()
+{
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+}
+
+bool PerfCounters::Read(PerfSample& sample)
+{
+    uint64_t* values[PERF_COUNTER_COUNT] = {&sample.cycles, &sample.instructions, &sample.cacheReferences,
+        &sample.cacheMisses, &sample.l1dReadMisses};
+    sample.valid = 0;
+    for (uint32_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+        uint64_t value = 0;
+        if (fds_[i] >= 0 && read(fds_[i], &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value))) {
+            *values[i] = value;
+            sample.valid |= 1u << i;
+        }
+    }
+    return sample.valid != 0;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ipp_bench.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace OHOS::Camera {
+namespace {
+constexpr size_t EVICT_SIZE = 64 << 20;     // 64 MiB: many times the L3 of any host this runs on
+constexpr size_t CACHE_LINE = 64;
+constexpr double NS_PER_US = 1000.0;
+constexpr double US_PER_S = 1e6;
+constexpr double BYTES_PER_MB = 1e6;
+
+struct ThreadResult {
+    std::vector<uint64_t> latencyNs;
+    PerfSample perf;
+    bool perfOpened = false;
+    std::string perfError;
+    uint32_t failures = 0;
+    bool guardsIntact = true;
+    std::string error;
+};
+
+// reads through a buffer far larger than the caches, the plugin then starts from dram
+void EvictCaches(const std::vector<uint8_t>& evict)
+{
+    uint8_t sum = 0;
+    for (size_t i = 0; i < evict.size(); i += CACHE_LINE) {
+        sum += evict[i];
+    }
+    volatile uint8_t sink = sum;
+    (void)sink;
+}
+
+void RunThread(const BenchConfig& config, IppPluginApi& plugin, uint32_t index, const std::vector<uint8_t>& evict,
+    std::atomic<uint32_t>& ready, ThreadResult& result)
+{
+    BenchFrames frames;
+    if (!frames.Prepare(config, index + 1, result.error)) {
+        ready++;
+        return;
+    }
+    PerfCounters counters;
+    result.perfOpened = config.perf && counters.Open(result.perfError);
+    IppAlgoMeta meta = {};
+
+    for (uint32_t i = 0; i < config.warmup; i++) {
+        frames.NextFrame();
+        plugin.process(frames.Inputs(), frames.InputCount(), frames.Output(), &meta);
+    }
+    // all threads start timing together, so the throughput is that of a loaded system
+    ready++;
+    while (ready.load() < config.threads) {
+        std::this_thread::yield();
+    }
+
+    result.latencyNs.reserve(config.iterations);
+    for (uint32_t i = 0; i < config.iterations; i++) {
+        frames.NextFrame();
+        if (config.cold) {
+            EvictCaches(evict);
+        }
+        counters.Enable();
+        auto begin = std::chrono::steady_clock::now();
+        int ret = plugin.process(frames.Inputs(), frames.InputCount(), frames.Output(), &meta);
+        auto end = std::chrono::steady_clock::now();
+        counters.Disable();
+        result.latencyNs.push_back(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+        if (ret != 0) {
+            result.failures++;
+        }
+    }
+    if (result.perfOpened) {
+        counters.Read(result.perf);
+    }
+    result.guardsIntact = frames.GuardsIntact();
+
+    if (index == 0 && !config.dumpPath.empty()) {
+        std::ofstream dump(config.dumpPath, std::ios::binary);
+        dump.write(reinterpret_cast<const char*>(frames.OutputData()),
+            static_cast<std::streamsize>(frames.FrameSize()));
+        if (!dump) {
+            result.error = "cannot write " + config.dumpPath;
+        }
+    }
+}
+
+double PerCall(uint64_t value, size_t calls)
+{
+    return calls == 0 ? 0.0 : static_cast<double>(value) / static_cast<double>(calls);
+}
+
+void PrintTable(const BenchConfig& config, const LatencySummary& latency, double fps, double mbps,
+    const PerfSample& perf, size_t calls)
+{
+    printf("%s %ux%u %s, %d input(s)%s, %u thread(s), %zu calls%s\n", config.plugin.c_str(), config.width,
+        config.height, BenchFormatName(config.format), config.inputs, config.inPlace ? " in place" : "",
+        config.threads, calls, config.cold ? ", cold caches" : "");
+    printf("  latency us   min %.1f  mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", latency.minUs,
+        latency.meanUs, latency.p50Us, latency.p90Us, latency.p99Us, latency.p999Us, latency.maxUs);
+    printf("  throughput   %.1f frames/s  %.1f MB/s in\n", fps, mbps);
+    if (perf.valid == 0) {
+        return;
+    }
+    const char* names[PERF_COUNTER_COUNT] = {"cycles", "instructions", "cache refs", "cache misses", "l1d read misses"};
+    const uint64_t values[PERF_COUNTER_COUNT] = {perf.cycles, perf.instructions, perf.cacheReferences,
+        perf.cacheMisses, perf.l1dReadMisses};
+    printf("  per call    ");
+    for (uint32_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if ((perf.valid & (1u << i)) != 0) {
+            printf(" %s %.0f ", names[i], PerCall(values[i], calls));
+        }
+    }
+    if ((perf.valid & (1u << PERF_CYCLES)) != 0 && (perf.valid & (1u << PERF_INSTRUCTIONS)) != 0 && perf.cycles != 0) {
+        printf(" ipc %.2f", static_cast<double>(perf.instructions) / static_cast<double>(perf.cycles));
+    }
+    printf("\n");
+}
+
+void WriteJson(FILE* out, const BenchConfig& config, const LatencySummary& latency, double fps, double mbps,
+    const PerfSample& perf, size_t calls, uint32_t failures, bool passed)
+{
+    fprintf(out, "{\"plugin\": \"%s\", \"width\": %u, \"height\": %u, \"format\": \"%s\", \"inputs\": %d, "
+        "\"in_place\": %s, \"threads\": %u, \"cold\": %s, \"calls\": %zu, \"failures\": %u,\n", config.plugin.c_str(),
+        config.width, config.height, BenchFormatName(config.format), config.inputs, config.inPlace ? "true" : "false",
+        config.threads, config.cold ? "true" : "false", calls, failures);
+    fprintf(out, " \"latency_us\": {\"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+        "\"p999\": %.3f, \"max\": %.3f},\n", latency.minUs, latency.meanUs, latency.p50Us, latency.p90Us,
+        latency.p99Us, latency.p999Us, latency.maxUs);
+    fprintf(out, " \"fps\": %.3f, \"mb_per_s\": %.3f, \"perf_per_call\": {", fps, mbps);
+    const char* names[PERF_COUNTER_COUNT] = {"cycles", "instructions", "cache_references", "cache_misses",
+        "l1d_read_misses"};
+    const uint64_t values[PERF_COUNTER_COUNT] = {perf.cycles, perf.instructions, perf.cacheReferences,
+        perf.cacheMisses, perf.l1dReadMisses};
+    const char* separator = "";
+    for (uint32_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if ((perf.valid & (1u << i)) != 0) {
+            fprintf(out, "%s\"%s\": %.1f", separator, names[i], PerCall(values[i], calls));
+            separator = ", ";
+        }
+    }
+    fprintf(out, "},\n \"passed\": %s}\n", passed ? "true" : "false");
+}
+
+// Init loads the settings from the system parameters, the command line wins over them
+bool ConfigureMerge(const BenchConfig& config, IppPluginApi& plugin)
+{
+    if (plugin.configure != nullptr && config.mergeLayout >= 0 &&
+        plugin.configure(config.mergeLayout, config.mergeFormat, config.mergeWeight) != 0) {
+        fprintf(stderr, "IppMergeConfigure(%d, %d, %u) refused\n", config.mergeLayout, config.mergeFormat,
+            config.mergeWeight);
+        return false;
+    }
+    if (plugin.configureBands != nullptr && config.mergeThreads >= 0 &&
+        plugin.configureBands(static_cast<unsigned int>(config.mergeThreads), config.mergeBandRows) != 0) {
+        fprintf(stderr, "IppMergeConfigureBands(%d, %u) refused\n", config.mergeThreads, config.mergeBandRows);
+        return false;
+    }
+    return true;
+}
+
+bool Lifecycle(const char* name, int ret)
+{
+    if (ret != 0) {
+        printf("FAIL %s returned %d\n", name, ret);
+        return false;
+    }
+    return true;
+}
+
+// one call on fresh buffers of the given seed, the output hash when it succeeded
+bool ProcessOnce(const BenchConfig& config, IppPluginApi& plugin, uint32_t seed, uint64_t& hash, std::string& error)
+{
+    BenchFrames frames;
+    if (!frames.Prepare(config, seed, error)) {
+        return false;
+    }
+    IppAlgoMeta meta = {};
+    std::vector<uint8_t> before(frames.OutputData(), frames.OutputData() + frames.FrameSize());
+    int ret = plugin.process(frames.Inputs(), frames.InputCount(), frames.Output(), &meta);
+    if (ret != 0) {
+        error = "Process returned " + std::to_string(ret);
+        return false;
+    }
+    if (!frames.GuardsIntact()) {
+        error = "Process wrote outside its buffers";
+        return false;
+    }
+    hash = frames.OutputHash();
+
+    const uint8_t* after = frames.OutputData();
+    uint32_t rowBytes = BenchRowBytes(config.format, config.width);
+    bool padding = false;
+    for (size_t offset = 0; offset < frames.FrameSize() && !padding; offset += frames.Stride()) {
+        size_t end = std::min(offset + frames.Stride(), frames.FrameSize());
+        padding = !std::equal(before.begin() + offset + std::min<size_t>(rowBytes, end - offset),
+            before.begin() + end, after + offset + std::min<size_t>(rowBytes, end - offset));
+    }
+    if (padding) {
+        printf("WARN Process wrote into the stride padding\n");
+    }
+    if (std::equal(before.begin(), before.end(), after)) {
+        printf("WARN Process left the output as it was\n");
+    }
+    return true;
+}
+} // namespace
+
+LatencySummary SummarizeLatency(std::vector<uint64_t>& ns)
+{
+    LatencySummary summary;
+    summary.count = ns.size();
+    if (ns.empty()) {
+        return summary;
+    }
+    std::sort(ns.begin(), ns.end());
+    auto rank = [&ns](double p) {
+        size_t r = static_cast<size_t>(p * static_cast<double>(ns.size()) + 0.999999);    // ceil, nearest rank
+        return static_cast<double>(ns[std::min(std::max<size_t>(r, 1), ns.size()) - 1]) / NS_PER_US;
+    };
+    double total = 0.0;
+    for (uint64_t v : ns) {
+        total += static_cast<double>(v);
+    }
+    summary.minUs = static_cast<double>(ns.front()) / NS_PER_US;
+    summary.meanUs = total / static_cast<double>(ns.size()) / NS_PER_US;
+    summary.p50Us = rank(0.50);     // 0.50: median
+    summary.p90Us = rank(0.90);     // 0.90: p90
+    summary.p99Us = rank(0.99);     // 0.99: p99
+    summary.p999Us = rank(0.999);   // 0.999: p99.9
+    summary.maxUs = static_cast<double>(ns.back()) / NS_PER_US;
+    return summary;
+}
+
+int RunIppBenchmark(const BenchConfig& config, IppPluginApi& plugin)
+{
+    IppAlgoMeta meta = {};
+    if (plugin.init(&meta) != 0) {
+        fprintf(stderr, "%s: Init failed\n", config.plugin.c_str());
+        return 1;
+    }
+    if (!ConfigureMerge(config, plugin)) {
+        return 1;
+    }
+    if (plugin.start() != 0) {
+        fprintf(stderr, "%s: Start failed\n", config.plugin.c_str());
+        return 1;
+    }
+
+    std::vector<uint8_t> evict(config.cold ? EVICT_SIZE : 0, 1);
+    std::vector<ThreadResult> results(config.threads);
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> ready(0);
+    // the wall clock starts when the last thread is through its warmup
+    for (uint32_t i = 0; i < config.threads; i++) {
+        threads.emplace_back(RunThread, std::cref(config), std::ref(plugin), i, std::cref(evict), std::ref(ready),
+            std::ref(results[i]));
+    }
+    while (ready.load() < config.threads) {
+        std::this_thread::yield();
+    }
+    auto begin = std::chrono::steady_clock::now();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    int flushed = plugin.flush();
+    int stopped = plugin.stop();
+
+    std::vector<uint64_t> latency;
+    PerfSample perf;
+    perf.valid = ~0u;
+    uint32_t failures = 0;
+    bool passed = flushed == 0 && stopped == 0;
+    for (ThreadResult& r : results) {
+        if (!r.error.empty()) {
+            fprintf(stderr, "%s\n", r.error.c_str());
+            passed = false;
+        }
+        if (!r.guardsIntact) {
+            fprintf(stderr, "the plugin wrote outside its buffers\n");
+            passed = false;
+        }
+        if (config.perf && !r.perfOpened && &r == &results.front()) {
+            fprintf(stderr, "no hardware counters (%s), see /proc/sys/kernel/perf_event_paranoid\n",
+                r.perfError.c_str());
+        }
+        latency.insert(latency.end(), r.latencyNs.begin(), r.latencyNs.end());
+        perf.valid &= r.perfOpened ? r.perf.valid : 0;
+        perf.cycles += r.perf.cycles;
+        perf.instructions += r.perf.instructions;
+        perf.cacheReferences += r.perf.cacheReferences;
+        perf.cacheMisses += r.perf.cacheMisses;
+        perf.l1dReadMisses += r.perf.l1dReadMisses;
+        failures += r.failures;
+    }
+    if (!config.perf) {
+        perf.valid = 0;
+    }
+    size_t calls = latency.size();
+    LatencySummary summary = SummarizeLatency(latency);
+    // cold runs spend most of the wall clock evicting, the throughput is then that of the calls alone
+    double busy = config.cold ? summary.meanUs * static_cast<double>(calls) / US_PER_S / config.threads : seconds;
+    double fps = busy > 0.0 ? static_cast<double>(calls) / busy : 0.0;
+    double mbps = fps * static_cast<double>(BenchFrameSize(config.format, config.width, config.height,
+        BenchRowBytes(config.format, config.width))) * config.inputs / BYTES_PER_MB;
+
+    if (failures != 0) {
+        fprintf(stderr, "%u of %zu Process calls failed\n", failures, calls);
+        passed = false;
+    }
+    if (config.gateP99Us > 0.0 && summary.p99Us > config.gateP99Us) {
+        fprintf(stderr, "gate: p99 %.1f us above %.1f us\n", summary.p99Us, config.gateP99Us);
+        passed = false;
+    }
+    if (config.gateFps > 0.0 && fps < config.gateFps) {
+        fprintf(stderr, "gate: %.1f frames/s below %.1f\n", fps, config.gateFps);
+        passed = false;
+    }
+    PrintTable(config, summary, fps, mbps, perf, calls);
+    if (!config.jsonPath.empty()) {
+        FILE* out = config.jsonPath == "-" ? stdout : fopen(config.jsonPath.c_str(), "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", config.jsonPath.c_str());
+            return 1;
+        }
+        WriteJson(out, config, summary, fps, mbps, perf, calls, failures, passed);
+        if (out != stdout) {
+            fclose(out);
+        }
+    }
+    return passed ? 0 : 1;
+}
+
+// what the IPP node relies on, in the order it calls the plugin
+int RunIppConformance(const BenchConfig& config, IppPluginApi& plugin)
+{
+    IppAlgoMeta meta = {};
+    bool passed = true;
+    printf("%s: IppMergeConfigure %s, IppMergeConfigureBands %s\n", config.plugin.c_str(),
+        plugin.configure != nullptr ? "present" : "absent", plugin.configureBands != nullptr ? "present" : "absent");
+    passed &= Lifecycle("Init", plugin.init(&meta));
+    passed &= ConfigureMerge(config, plugin);
+    passed &= Lifecycle("Start", plugin.start());
+
+    BenchFrames frames;
+    std::string error;
+    if (!frames.Prepare(config, 1, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (plugin.process(nullptr, frames.InputCount(), frames.Output(), &meta) == 0) {
+        printf("FAIL Process accepted a null input array\n");
+        passed = false;
+    }
+    if (plugin.process(frames.Inputs(), 0, frames.Output(), &meta) == 0) {
+        printf("WARN Process accepted no inputs\n");
+    }
+    if (!frames.GuardsIntact()) {
+        printf("FAIL Process wrote outside its buffers on bad arguments\n");
+        passed = false;
+    }
+
+    // the same inputs give the same picture, whatever ran before
+    uint64_t first = 0;
+    uint64_t second = 0;
+    uint64_t other = 0;
+    if (!ProcessOnce(config, plugin, 1, first, error) || !ProcessOnce(config, plugin, 2, other, error) ||
+        !ProcessOnce(config, plugin, 1, second, error)) {
+        printf("FAIL %s\n", error.c_str());
+        passed = false;
+    } else if (first != second) {
+        printf("FAIL the output differs between two calls on the same inputs\n");
+        passed = false;
+    }
+
+    passed &= Lifecycle("Flush", plugin.flush());
+    passed &= Lifecycle("Stop", plugin.stop());
+    // a stream that is started again after it stopped
+    passed &= Lifecycle("Start after Stop", plugin.start());
+    if (ProcessOnce(config, plugin, 1, second, error) && first != 0 && first != second) {
+        printf("FAIL the output differs after Stop and Start\n");
+        passed = false;
+    }
+    passed &= Lifecycle("Stop", plugin.stop());
+    printf("%s: %s\n", config.plugin.c_str(), passed ? "PASS" : "FAIL");
+    return passed ? 0 : 1;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// included by the board nodes, RGA and MPP are replaced by the software shims of the bench on the host
+#ifndef HOS_CAMERA_PIPELINE_BENCH_HOST_RGAAPI_H
+#define HOS_CAMERA_PIPELINE_BENCH_HOST_RGAAPI_H
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Host stand-ins for the camera framework headers the board nodes include, just what the nodes use. They
+ * let camera_pipeline_bench build RKScaleNode, RKCodecNode, RKFaceNode and RKExifNode on a linux box
+ * without the HDF, hilog or the metadata manager; nothing on the device includes them.
+ */
+
+#ifndef HOS_CAMERA_PIPELINE_BENCH_HOST_CAMERA_H
+#define HOS_CAMERA_PIPELINE_BENCH_HOST_CAMERA_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "camera_metadata_operator.h"
+
+// the nodes log with hilog's %{public} formats, the bench prints its own report instead
+#define CAMERA_LOGE(...) ((void)0)
+#define CAMERA_LOGW(...) ((void)0)
+#define CAMERA_LOGI(...) ((void)0)
+#define CAMERA_LOGD(...) ((void)0)
+#define CAMERA_LOGV(...) ((void)0)
+
+namespace OHOS::Camera {
+enum RetCode {
+    RC_OK = 0,
+    RC_ERROR = -1,
+};
+
+enum EncodeType {
+    ENCODE_TYPE_NULL = 0,
+    ENCODE_TYPE_H264 = 1,
+    ENCODE_TYPE_H265 = 2,
+    ENCODE_TYPE_JPEG = 3,
+};
+
+enum CameraBufferFormat {
+    CAMERA_FORMAT_INVALID,
+    CAMERA_FORMAT_RGB_565,
+    CAMERA_FORMAT_RGBA_5658,
+    CAMERA_FORMAT_RGBX_4444,
+    CAMERA_FORMAT_RGBA_4444,
+    CAMERA_FORMAT_RGB_444,
+    CAMERA_FORMAT_RGBX_5551,
+    CAMERA_FORMAT_RGBA_5551,
+    CAMERA_FORMAT_RGB_555,
+    CAMERA_FORMAT_RGBX_8888,
+    CAMERA_FORMAT_RGBA_8888,
+    CAMERA_FORMAT_RGB_888,
+    CAMERA_FORMAT_BGR_565,
+    CAMERA_FORMAT_BGRX_4444,
+    CAMERA_FORMAT_BGRA_4444,
+    CAMERA_FORMAT_BGRX_5551,
+    CAMERA_FORMAT_BGRA_5551,
+    CAMERA_FORMAT_BGRX_8888,
+    CAMERA_FORMAT_BGRA_8888,
+    CAMERA_FORMAT_YUV_422_I,
+    CAMERA_FORMAT_YCBCR_422_SP,
+    CAMERA_FORMAT_YCRCB_422_SP,
+    CAMERA_FORMAT_YCBCR_420_SP,
+    CAMERA_FORMAT_YCRCB_420_SP,
+    CAMERA_FORMAT_YCBCR_422_P,
+    CAMERA_FORMAT_YCRCB_422_P,
+    CAMERA_FORMAT_YCBCR_420_P,
+    CAMERA_FORMAT_YCRCB_420_P,
+    CAMERA_FORMAT_YUYV_422_PKG,
+    CAMERA_FORMAT_UYVY_422_PKG,
+    CAMERA_FORMAT_YVYU_422_PKG,
+    CAMERA_FORMAT_VYUY_422_PKG,
+};
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_PIPELINE_BENCH_HOST_CAMERA_DUMP_H
+#define HOS_CAMERA_PIPELINE_BENCH_HOST_CAMERA_DUMP_H
+
+#include <memory>
+#include <string>
+#include "source_node.h"
+
+#define ENABLE_RKCODEC_NODE_CONVERTED "rkcodec"
+#define ENABLE_RKFACE_NODE_CONVERTED "rkface"
+#define ENABLE_RKEXIF_NODE_CONVERTED "rkexif"
+
+namespace OHOS::Camera {
+// dumping is switched off on the host
+class CameraDumper {
+public:
+    static CameraDumper& GetInstance()
+    {
+        static CameraDumper dumper;
+        return dumper;
+    }
+    bool DumpBuffer(const std::string& name, const std::string& type, const std::shared_ptr<IBuffer>& buffer)
+    {
+        return false;
+    }
+};
+} // namespace OHOS::Camera
+#endif
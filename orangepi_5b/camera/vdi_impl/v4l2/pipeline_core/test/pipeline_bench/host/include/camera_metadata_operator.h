@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_PIPELINE_BENCH_HOST_METADATA_H
+#define HOS_CAMERA_PIPELINE_BENCH_HOST_METADATA_H
+
+#include <cstddef>
+#include <cstdint>
+
+// the tags the board nodes read or write, the values only have to be distinct on the host
+enum camera_metadata_tag : uint32_t {
+    OHOS_JPEG_ORIENTATION = 0x100,
+    OHOS_JPEG_QUALITY,
+    OHOS_JPEG_GPS_COORDINATES,
+    OHOS_CONTROL_CAPTURE_MIRROR,
+    OHOS_CONTROL_ZOOM_RATIO,
+    OHOS_CONTROL_FPS_RANGES,
+    OHOS_SENSOR_EXPOSURE_TIME,
+    OHOS_STATISTICS_FACE_DETECT_SWITCH,
+    OHOS_STATISTICS_FACE_RECTANGLES,
+    OHOS_STATISTICS_FACE_IDS,
+};
+
+enum {
+    OHOS_VENDOR_SECTION = 0x8000,
+};
+
+enum {
+    OHOS_CAMERA_JPEG_ROTATION_0 = 0,
+    OHOS_CAMERA_JPEG_ROTATION_90 = 90,
+    OHOS_CAMERA_JPEG_ROTATION_180 = 180,
+    OHOS_CAMERA_JPEG_ROTATION_270 = 270,
+};
+
+enum {
+    OHOS_CAMERA_JPEG_LEVEL_LOW = 0,
+    OHOS_CAMERA_JPEG_LEVEL_MIDDLE,
+    OHOS_CAMERA_JPEG_LEVEL_HIGH,
+};
+
+enum {
+    OHOS_CAMERA_FACE_DETECT_MODE_OFF = 0,
+    OHOS_CAMERA_FACE_DETECT_MODE_SIMPLE,
+};
+
+// one block like the real metadata: this header, item_capacity items, then data_capacity bytes of data
+typedef struct common_metadata_header_t {
+    uint32_t size;
+    uint32_t item_count;
+    uint32_t item_capacity;
+    uint32_t data_count;
+    uint32_t data_capacity;
+} common_metadata_header_t;
+
+typedef struct camera_metadata_item_t {
+    uint32_t index;
+    uint32_t item;
+    uint32_t count;
+    union {
+        uint8_t* u8;
+        int32_t* i32;
+        uint32_t* ui32;
+        float* f;
+        int64_t* i64;
+        double* d;
+    } data;
+} camera_metadata_item_t;
+
+int FindCameraMetadataItem(const common_metadata_header_t* src, uint32_t item, camera_metadata_item_t* metadataItem);
+
+namespace OHOS::Camera {
+class CameraMetadata {
+public:
+    CameraMetadata(size_t itemCapacity, size_t dataCapacity);
+    ~CameraMetadata();
+    CameraMetadata(const CameraMetadata&) = delete;
+    CameraMetadata& operator=(const CameraMetadata&) = delete;
+
+    bool addEntry(uint32_t item, const void* data, size_t dataCount);
+    bool updateEntry(uint32_t item, const void* data, size_t dataCount);
+    common_metadata_header_t* get();
+    const common_metadata_header_t* get() const;
+
+private:
+    common_metadata_header_t* metadata_ = nullptr;
+};
+} // namespace OHOS::Camera
+using CameraSetting = OHOS::Camera::CameraMetadata;
+#endif
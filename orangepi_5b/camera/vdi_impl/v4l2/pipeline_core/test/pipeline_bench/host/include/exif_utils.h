@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_PIPELINE_BENCH_HOST_EXIF_UTILS_H
+#define HOS_CAMERA_PIPELINE_BENCH_HOST_EXIF_UTILS_H
+
+#include <cstdint>
+
+typedef struct {
+    double latitude;
+    double longitude;
+    double altitude;
+    int32_t frame_size;
+} exif_data;
+
+namespace OHOS::Camera {
+// libexif is not on the host, the jpeg is left as it is
+class ExifUtils {
+public:
+    static uint32_t AddCustomExifInfo(exif_data info, void* address, int32_t& outPutSize);
+};
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_PIPELINE_BENCH_HOST_SECUREC_H
+#define HOS_CAMERA_PIPELINE_BENCH_HOST_SECUREC_H
+
+#include <stddef.h>
+#include <string.h>
+
+typedef int errno_t;
+
+static inline errno_t memcpy_s(void* dest, size_t destMax, const void* src, size_t count)
+{
+    if (dest == NULL || src == NULL || count > destMax) {
+        return -1;
+    }
+    memcpy(dest, src, count);
+    return 0;
+}
+
+static inline errno_t memset_s(void* dest, size_t destMax, int c, size_t count)
+{
+    if (dest == NULL || count > destMax) {
+        return -1;
+    }
+    memset(dest, c, count);
+    return 0;
+}
+#endif
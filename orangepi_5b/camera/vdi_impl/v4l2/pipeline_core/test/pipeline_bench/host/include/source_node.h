@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_PIPELINE_BENCH_HOST_SOURCE_NODE_H
+#define HOS_CAMERA_PIPELINE_BENCH_HOST_SOURCE_NODE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "camera.h"
+
+namespace OHOS::Camera {
+struct EsFrameInfo {
+    int32_t size = -1;
+    int32_t align = -1;
+    int32_t headerSize = -1;
+    int32_t frameSize = -1;
+    int32_t isKey = -1;
+    int64_t timestamp = -1;
+};
+
+// the part of the framework buffer the board nodes use, camera_pipeline_bench implements it
+class IBuffer {
+public:
+    virtual ~IBuffer() = default;
+    virtual int32_t GetIndex() const = 0;
+    virtual uint32_t GetWidth() const = 0;
+    virtual uint32_t GetHeight() const = 0;
+    virtual uint32_t GetStride() const = 0;
+    virtual int32_t GetFormat() const = 0;
+    virtual uint32_t GetSize() const = 0;
+    virtual void* GetVirAddress() const = 0;
+    virtual int32_t GetFileDescriptor() const = 0;
+    virtual uint64_t GetTimestamp() const = 0;
+    virtual int32_t GetCaptureId() const = 0;
+    virtual int32_t GetEncodeType() const = 0;
+    virtual int32_t GetStreamId() const = 0;
+    virtual EsFrameInfo GetEsFrameInfo() const = 0;
+    virtual void SetSize(uint32_t size) = 0;
+    virtual void SetVirAddress(void* addr) = 0;
+    virtual void SetEsFrameSize(int32_t size) = 0;
+    virtual void SetEsTimestamp(int64_t timestamp) = 0;
+    virtual void SetEsKeyFrame(int32_t isKey) = 0;
+    virtual void SetEsFrameNum(int32_t frameNum) = 0;
+};
+
+struct PortFormat {
+    uint32_t w_ = 0;
+    uint32_t h_ = 0;
+    uint32_t format_ = 0;
+    uint64_t usage_ = 0;
+    uint32_t bufferCount_ = 0;
+    uint64_t bufferPoolId_ = 0;
+    int32_t streamId_ = 0;
+};
+
+class IPort {
+public:
+    virtual ~IPort() = default;
+    virtual void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) = 0;
+    PortFormat format_;
+};
+
+class IBufferPool {
+public:
+    virtual ~IBufferPool() = default;
+    // size -> address of the surface buffer behind a buffer index
+    virtual std::map<int32_t, uint8_t*> getSFBuffer(int32_t index) = 0;
+    virtual int32_t GetForkBufferId() = 0;
+};
+
+class BufferManager {
+public:
+    static BufferManager* GetInstance();
+    std::shared_ptr<IBufferPool> GetBufferPool(uint64_t id);
+    // host only, what the stream operator does when it creates the pool of a stream
+    void AddBufferPool(uint64_t id, std::shared_ptr<IBufferPool> pool);
+    void RemoveBufferPool(uint64_t id);
+
+private:
+    std::map<uint64_t, std::shared_ptr<IBufferPool>> pools_;
+};
+
+using CaptureMeta = std::shared_ptr<CameraSetting>;
+
+class NodeBase {
+public:
+    NodeBase(const std::string& name, const std::string& type, const std::string& cameraId)
+        : name_(name), type_(type), cameraId_(cameraId)
+    {
+    }
+    virtual ~NodeBase() = default;
+    virtual RetCode Start(const int32_t streamId)
+    {
+        return RC_OK;
+    }
+    virtual RetCode Stop(const int32_t streamId)
+    {
+        return RC_OK;
+    }
+    virtual void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) {}
+    virtual RetCode Capture(const int32_t streamId, const int32_t captureId)
+    {
+        return RC_OK;
+    }
+    virtual RetCode CancelCapture(const int32_t streamId)
+    {
+        return RC_OK;
+    }
+    virtual RetCode Config(const int32_t streamId, const CaptureMeta& meta)
+    {
+        return RC_OK;
+    }
+    std::vector<std::shared_ptr<IPort>> GetOutPorts()
+    {
+        return outPorts_;
+    }
+    std::vector<std::shared_ptr<IPort>> GetInPorts()
+    {
+        return inPorts_;
+    }
+
+    // host only, what the pipeline builder does from the stream and sensor formats
+    void AddInPort(const std::shared_ptr<IPort>& port)
+    {
+        inPorts_.push_back(port);
+    }
+    void AddOutPort(const std::shared_ptr<IPort>& port)
+    {
+        outPorts_.push_back(port);
+    }
+    void SetSourceSize(uint32_t width, uint32_t height)
+    {
+        wide_ = width;
+        high_ = height;
+    }
+
+protected:
+    std::string name_;
+    std::string type_;
+    std::string cameraId_;
+    uint32_t wide_ = 0;
+    uint32_t high_ = 0;
+
+private:
+    std::vector<std::shared_ptr<IPort>> inPorts_;
+    std::vector<std::shared_ptr<IPort>> outPorts_;
+};
+
+// the node factory is not there on the host, the bench constructs the nodes itself
+#define REGISTERNODE(cls, ...)
+} // namespace OHOS::Camera
+#endif
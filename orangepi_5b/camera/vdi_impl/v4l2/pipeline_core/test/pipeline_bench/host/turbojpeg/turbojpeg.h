@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_PIPELINE_BENCH_HOST_TURBOJPEG_H
+#define HOS_CAMERA_PIPELINE_BENCH_HOST_TURBOJPEG_H
+
+/*
+ * The calls of the libjpeg-turbo TurboJPEG api rk_jpeg_encoder.cpp makes, for hosts with libjpeg but without
+ * libturbojpeg. pipeline_bench_turbojpeg_shim.cpp implements them on libjpeg; only this directory goes on the
+ * include path then, the real header is used wherever it is installed.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void* tjhandle;
+
+enum TJSAMP {
+    TJSAMP_444 = 0,
+    TJSAMP_422,
+    TJSAMP_420,
+    TJSAMP_GRAY,
+    TJSAMP_440,
+    TJSAMP_411,
+};
+
+#define TJFLAG_NOREALLOC 1024
+#define TJFLAG_FASTDCT 2048
+
+tjhandle tjInitCompress(void);
+int tjDestroy(tjhandle handle);
+unsigned long tjBufSize(int width, int height, int jpegSubsamp);
+int tjCompressFromYUVPlanes(tjhandle handle, const unsigned char** srcPlanes, int width, const int* strides,
+    int height, int subsamp, unsigned char** jpegBuf, unsigned long* jpegSize, int jpegQual, int flags);
+char* tjGetErrorStr2(tjhandle handle);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
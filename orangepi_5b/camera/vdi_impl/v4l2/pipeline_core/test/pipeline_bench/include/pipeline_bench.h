@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOS_CAMERA_PIPELINE_BENCH_H
+#define HOS_CAMERA_PIPELINE_BENCH_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "camera.h"
+#include "source_node.h"
+
+namespace OHOS::Camera {
+enum class BenchNodeType : int32_t {
+    SCALE = 0,
+    CODEC,
+    FACE,
+    EXIF,
+};
+
+struct PipelineBenchConfig {
+    std::string graphName = "video";
+    std::vector<BenchNodeType> graph = {BenchNodeType::SCALE, BenchNodeType::CODEC};  // in delivery order
+    EncodeType encode = ENCODE_TYPE_H264;       // of the stream, picks the path through scale and codec
+    uint32_t sensorWidth = 1920;                // frames as the source hands them to the first node
+    uint32_t sensorHeight = 1080;
+    int32_t sensorFormat = CAMERA_FORMAT_YCBCR_420_P;
+    uint32_t width = 1280;                      // of the stream
+    uint32_t height = 720;
+    int32_t format = CAMERA_FORMAT_YCBCR_420_P;
+    uint32_t buffers = 6;                       // of the stream pool, the frames in flight at most
+    uint32_t frames = 300;
+    uint32_t warmup = 10;
+    uint32_t fps = 0;                           // source pacing, 0: as fast as the graph takes the frames
+    int32_t jpegRotation = 0;                   // OHOS_JPEG_ORIENTATION sent with the capture settings
+    std::string cascadePath;                    // opencv haar cascade for RKFaceNode, empty: a synthetic one
+    std::vector<std::pair<std::string, std::string>> params;   // GetParameter() answers, after the defaults
+    std::string jsonPath;                       // the report as json as well, "-": stdout
+    double gateFps = 0.0;                       // fail when the throughput is below, 0: no gate
+    double gateP99Us = 0.0;                     // fail when the end to end p99 is above, 0: no gate
+};
+
+bool ParseBenchGraph(const std::string& spec, PipelineBenchConfig& config);
+bool ParseBenchEncode(const std::string& name, EncodeType& encode);
+bool ParseBenchPixelFormat(const std::string& name, int32_t& format);
+const char* BenchNodeName(BenchNodeType type);
+const char* BenchEncodeName(EncodeType encode);
+const char* BenchPixelFormatName(int32_t format);
+// the layout a picture leaves the graph in: the RGBA RKCodec makes of a preview, else the I420 the nodes pass on
+int32_t BenchPictureFormat(const PipelineBenchConfig& config);
+
+// the table behind the host GetParameter(), the node tunables of rk_node_params.h
+void SetBenchParameter(const std::string& key, const std::string& value);
+
+// operator new calls of the whole process and of the calling thread, see pipeline_bench_alloc.cpp
+struct BenchAllocCount {
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+};
+BenchAllocCount GetProcessAllocs();
+BenchAllocCount GetThreadAllocs();
+
+// libjpeg compressing an I420 frame from its planes, the software stand-in for the MPP jpeg encoder
+int32_t EncodeI420Jpeg(const uint8_t* const planes[3], const int32_t strides[3], uint32_t width, uint32_t height,
+    uint32_t quality, uint8_t* out, size_t capacity, size_t& size);
+// libjpeg decoding a jpeg to interleaved full resolution Y, Cb, Cr samples
+bool DecodeJpegYcc(const uint8_t* data, size_t size, std::vector<uint8_t>& ycc, uint32_t& width, uint32_t& height);
+
+// a stream buffer: a memfd standing in for the dma buffer, mapped like the surface buffer behind it
+class BenchBuffer : public IBuffer {
+public:
+    int32_t GetIndex() const override { return index_; }
+    uint32_t GetWidth() const override { return width_; }
+    uint32_t GetHeight() const override { return height_; }
+    uint32_t GetStride() const override { return stride_; }
+    int32_t GetFormat() const override { return format_; }
+    uint32_t GetSize() const override { return size_; }
+    void* GetVirAddress() const override { return virAddr_; }
+    int32_t GetFileDescriptor() const override { return fd_; }
+    uint64_t GetTimestamp() const override { return timestamp_; }
+    int32_t GetCaptureId() const override { return captureId_; }
+    int32_t GetEncodeType() const override { return encodeType_; }
+    int32_t GetStreamId() const override { return streamId_; }
+    EsFrameInfo GetEsFrameInfo() const override { return es_; }
+    void SetSize(uint32_t size) override { size_ = size; }
+    void SetVirAddress(void* addr) override { virAddr_ = addr; }
+    void SetEsFrameSize(int32_t size) override { es_.size = size; }
+    void SetEsTimestamp(int64_t timestamp) override { es_.timestamp = timestamp; }
+    void SetEsKeyFrame(int32_t isKey) override { es_.isKey = isKey; }
+    void SetEsFrameNum(int32_t frameNum) override { es_.frameSize = frameNum; }
+
+private:
+    friend class BenchBufferPool;
+    int32_t index_ = -1;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    uint32_t stride_ = 0;
+    int32_t format_ = 0;
+    uint32_t size_ = 0;
+    void* virAddr_ = nullptr;
+    int32_t fd_ = -1;
+    uint64_t timestamp_ = 0;
+    int32_t captureId_ = -1;
+    int32_t encodeType_ = ENCODE_TYPE_NULL;
+    int32_t streamId_ = -1;
+    EsFrameInfo es_;
+};
+
+/*
+ * The stream pool and what the v4l2 source would hand over. The source frame of an encoded stream is the
+ * fork buffer past the stream buffers, a preview frame arrives in capture memory of its own and RKScaleNode
+ * writes it into the surface buffer. Without a scale node the stream frame is copied in for every frame,
+ * as the nodes after it work in place.
+ */
+class BenchBufferPool : public IBufferPool {
+public:
+    ~BenchBufferPool() override;
+    bool Init(const PipelineBenchConfig& config, std::string& error);
+    std::map<int32_t, uint8_t*> getSFBuffer(int32_t index) override;
+    int32_t GetForkBufferId() override;
+
+    // a free buffer, nullptr when none came back in time
+    std::shared_ptr<IBuffer> Acquire(int64_t timeoutMs);
+    void Prepare(const std::shared_ptr<IBuffer>& buffer, int32_t streamId, int32_t captureId, uint64_t timestamp);
+    void Release(int32_t index);
+    // until every buffer is back, false when one was lost in the graph
+    bool WaitIdle(int64_t timeoutMs);
+    uint32_t InFlight();
+    // the source scaled to the stream size by the software backend, tight I420, what the nodes should make of it
+    const std::vector<uint8_t>& GetReference() const
+    {
+        return reference_;
+    }
+
+private:
+    struct Slot {
+        std::shared_ptr<BenchBuffer> buffer = std::make_shared<BenchBuffer>();
+        int32_t fd = -1;
+        uint8_t* map = nullptr;
+        size_t size = 0;
+        bool busy = false;
+    };
+    bool MakeFrames(std::string& error);
+    bool MakeReference();
+    static bool MapFrame(size_t size, Slot& slot);
+
+    PipelineBenchConfig config_;
+    bool scaleFirst_ = false;
+    std::vector<Slot> slots_;
+    Slot fork_;                         // the source frame of encoded streams
+    std::vector<uint8_t> capture_;      // the source frame of preview streams
+    std::vector<uint8_t> streamFrame_;  // what a stream buffer holds when no scale node writes it
+    std::vector<uint8_t> reference_;
+    size_t captureSize_ = 0;
+    std::mutex lock_;
+    std::condition_variable freeCv_;
+    uint32_t inFlight_ = 0;
+    size_t next_ = 0;                   // handed out in turn like the queue of a real pool
+};
+
+// returns the process exit code
+int RunPipelineBench(const PipelineBenchConfig& config);
+} // namespace OHOS::Camera
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Counts every operator new of the process, the nodes allocate through it (containers, shared_ptr, the
+ * std::function of a task). malloc() calls of C code are not seen. Deleting goes straight to free().
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "pipeline_bench.h"
+
+namespace {
+std::atomic<uint64_t> g_calls {0};
+std::atomic<uint64_t> g_bytes {0};
+thread_local uint64_t t_calls = 0;
+thread_local uint64_t t_bytes = 0;
+
+void* CountedAlloc(size_t size, size_t align)
+{
+    g_calls.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+    t_calls++;
+    t_bytes += size;
+    if (size == 0) {
+        size = 1;
+    }
+    if (align <= alignof(std::max_align_t)) {
+        return malloc(size);
+    }
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, align, size) == 0 ? ptr : nullptr;
+}
+
+void* CountedNew(size_t size, size_t align)
+{
+    void* ptr = CountedAlloc(size, align);
+    if (ptr == nullptr) {
+        abort();    // built without exceptions, there is no bad_alloc to throw
+    }
+    return ptr;
+}
+} // namespace
+
+namespace OHOS::Camera {
+BenchAllocCount GetProcessAllocs()
+{
+    return {g_calls.load(std::memory_order_relaxed), g_bytes.load(std::memory_order_relaxed)};
+}
+
+BenchAllocCount GetThreadAllocs()
+{
+    return {t_calls, t_bytes};
+}
+} // namespace OHOS::Camera
+
+void* operator new(size_t size)
+{
+    return CountedNew(size, 0);
+}
+
+void* operator new[](size_t size)
+{
+    return CountedNew(size, 0);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAlloc(size, 0);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAlloc(size, 0);
+}
+
+void* operator new(size_t size, std::align_val_t align)
+{
+    return CountedNew(size, static_cast<size_t>(align));
+}
+
+void* operator new[](size_t size, std::align_val_t align)
+{
+    return CountedNew(size, static_cast<size_t>(align));
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept
+{
+    free(ptr);
+}
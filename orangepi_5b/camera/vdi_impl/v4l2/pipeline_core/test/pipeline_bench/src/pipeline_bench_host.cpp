@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Definitions behind the host stand-in headers: the buffer manager registry, a flat metadata block laid
+ * out like the real one (RKFaceNode copies it into the buffer byte for byte), GetParameter() and ExifUtils.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include "camera_metadata_operator.h"
+#include "exif_utils.h"
+#include "parameter.h"
+#include "pipeline_bench.h"
+#include "rk_vendor_tags.h"
+#include "source_node.h"
+
+namespace {
+struct MetadataItem {
+    uint32_t tag;
+    uint32_t count;
+    uint32_t offset;    // into the data area
+    uint32_t bytes;
+};
+
+constexpr size_t DATA_ALIGN = 8;     // every value starts aligned for its type, as in the real metadata
+
+std::mutex g_paramLock;
+std::map<std::string, std::string> g_params;
+
+// element size of a tag, as the metadata manager knows it from the tag's type
+size_t TagElementSize(uint32_t tag)
+{
+    switch (tag) {
+        case OHOS_JPEG_QUALITY:
+        case OHOS_CONTROL_CAPTURE_MIRROR:
+        case OHOS_STATISTICS_FACE_DETECT_SWITCH:
+            return sizeof(uint8_t);
+        case OHOS_JPEG_GPS_COORDINATES:
+            return sizeof(double);
+        case OHOS_SENSOR_EXPOSURE_TIME:
+        case OHOS::Camera::RK_VENDOR_FACE_FRAME_TIMESTAMP:
+            return sizeof(int64_t);
+        case OHOS_CONTROL_ZOOM_RATIO:
+        case OHOS_STATISTICS_FACE_RECTANGLES:
+            return sizeof(float);
+        default:
+            return sizeof(int32_t);
+    }
+}
+
+MetadataItem* Items(const common_metadata_header_t* header)
+{
+    return reinterpret_cast<MetadataItem*>(const_cast<common_metadata_header_t*>(header) + 1);
+}
+
+size_t AlignData(size_t bytes)
+{
+    return (bytes + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+}
+
+uint8_t* DataArea(const common_metadata_header_t* header)
+{
+    size_t offset = AlignData(sizeof(common_metadata_header_t) + header->item_capacity * sizeof(MetadataItem));
+    return reinterpret_cast<uint8_t*>(const_cast<common_metadata_header_t*>(header)) + offset;
+}
+} // namespace
+
+int FindCameraMetadataItem(const common_metadata_header_t* src, uint32_t item, camera_metadata_item_t* metadataItem)
+{
+    if (src == nullptr || metadataItem == nullptr) {
+        return -1;
+    }
+    const MetadataItem* items = Items(src);
+    for (uint32_t i = 0; i < src->item_count; i++) {
+        if (items[i].tag == item) {
+            metadataItem->index = i;
+            metadataItem->item = item;
+            metadataItem->count = items[i].count;
+            metadataItem->data.u8 = DataArea(src) + items[i].offset;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+extern "C" int GetParameter(const char* key, const char* def, char* value, uint32_t len)
+{
+    std::unique_lock<std::mutex> l(g_paramLock);
+    auto it = g_params.find(key);
+    const char* found = it != g_params.end() ? it->second.c_str() : def;
+    if (found == nullptr || found[0] == '\0' || value == nullptr || strlen(found) >= len) {
+        return -1;
+    }
+    strcpy(value, found);
+    return static_cast<int>(strlen(found));
+}
+
+namespace OHOS::Camera {
+void SetBenchParameter(const std::string& key, const std::string& value)
+{
+    std::unique_lock<std::mutex> l(g_paramLock);
+    g_params[key] = value;
+}
+
+BufferManager* BufferManager::GetInstance()
+{
+    static BufferManager manager;
+    return &manager;
+}
+
+std::shared_ptr<IBufferPool> BufferManager::GetBufferPool(uint64_t id)
+{
+    auto it = pools_.find(id);
+    return it == pools_.end() ? nullptr : it->second;
+}
+
+void BufferManager::AddBufferPool(uint64_t id, std::shared_ptr<IBufferPool> pool)
+{
+    pools_[id] = pool;
+}
+
+void BufferManager::RemoveBufferPool(uint64_t id)
+{
+    pools_.erase(id);
+}
+
+CameraMetadata::CameraMetadata(size_t itemCapacity, size_t dataCapacity)
+{
+    size_t size = AlignData(sizeof(common_metadata_header_t) + itemCapacity * sizeof(MetadataItem)) +
+        AlignData(dataCapacity);
+    metadata_ = static_cast<common_metadata_header_t*>(calloc(1, size));
+    if (metadata_ != nullptr) {
+        metadata_->size = static_cast<uint32_t>(size);
+        metadata_->item_capacity = static_cast<uint32_t>(itemCapacity);
+        metadata_->data_capacity = static_cast<uint32_t>(dataCapacity);
+    }
+}
+
+CameraMetadata::~CameraMetadata()
+{
+    free(metadata_);
+}
+
+bool CameraMetadata::addEntry(uint32_t item, const void* data, size_t dataCount)
+{
+    size_t bytes = TagElementSize(item) * dataCount;
+    if (metadata_ == nullptr || metadata_->item_count == metadata_->item_capacity ||
+        metadata_->data_count + AlignData(bytes) > metadata_->data_capacity) {
+        return false;
+    }
+    MetadataItem& entry = Items(metadata_)[metadata_->item_count++];
+    entry = {item, static_cast<uint32_t>(dataCount), metadata_->data_count, static_cast<uint32_t>(bytes)};
+    memcpy(DataArea(metadata_) + entry.offset, data, bytes);
+    metadata_->data_count += static_cast<uint32_t>(AlignData(bytes));
+    return true;
+}
+
+// in place while the new value fits where the old one is, the metadata manager moves the data otherwise
+bool CameraMetadata::updateEntry(uint32_t item, const void* data, size_t dataCount)
+{
+    camera_metadata_item_t found;
+    if (FindCameraMetadataItem(metadata_, item, &found) != 0) {
+        return false;
+    }
+    MetadataItem& entry = Items(metadata_)[found.index];
+    size_t bytes = TagElementSize(item) * dataCount;
+    if (bytes > entry.bytes) {
+        if (metadata_->data_count + AlignData(bytes) > metadata_->data_capacity) {
+            return false;
+        }
+        entry.offset = metadata_->data_count;
+        entry.bytes = static_cast<uint32_t>(bytes);
+        metadata_->data_count += static_cast<uint32_t>(AlignData(bytes));
+    }
+    entry.count = static_cast<uint32_t>(dataCount);
+    memcpy(DataArea(metadata_) + entry.offset, data, bytes);
+    return true;
+}
+
+common_metadata_header_t* CameraMetadata::get()
+{
+    return metadata_;
+}
+
+const common_metadata_header_t* CameraMetadata::get() const
+{
+    return metadata_;
+}
+
+uint32_t ExifUtils::AddCustomExifInfo(exif_data info, void* address, int32_t& outPutSize)
+{
+    (void)address;
+    outPutSize = info.frame_size;
+    return 0;
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * camera_pipeline_bench pushes synthetic frames through RKScaleNode, RKCodecNode, RKFaceNode and RKExifNode
+ * wired like a stream pipeline, with RGA, MPP and the framework buffers replaced by software, and reports
+ * what every node costs per frame. It needs no camera and builds on a linux host from this directory:
+ *     g++ -std=c++17 -O2 -Ihost/include -Iinclude -I../../src/node \
+ *         src/pipeline_bench_{alloc,host,main,pool,runner,soft_codec}.cpp \
+ *         ../../src/node/rk_{buffer_import_cache,codec_node,exif_node,face_detector,face_node,jpeg_encoder}.cpp \
+ *         ../../src/node/rk_{jpeg_exif,latency_histogram,nal_indexer,rga_session,rga_soft_backend}.cpp \
+ *         ../../src/node/rk_{scale_fanout,scale_node,scale_roi,sf_buffer_cache,video_enc_config}.cpp \
+ *         ../../src/node/rk_{video_encoder,worker_pool}.cpp -lturbojpeg -ljpeg -lpthread
+ * Without libturbojpeg add src/pipeline_bench_turbojpeg_shim.cpp and -Ihost/turbojpeg and drop -lturbojpeg,
+ * the shim is the part of the TurboJPEG api rk_jpeg_encoder.cpp uses, on libjpeg.
+ * Exits nonzero when a frame comes out broken, a buffer is lost or a gate is missed.
+ */
+
+#include <getopt.h>
+#include <cstdio>
+#include <cstdlib>
+#include "pipeline_bench.h"
+
+namespace {
+using namespace OHOS::Camera;
+
+enum Option : int {
+    OPT_GRAPH = 'g',
+    OPT_ENCODE = 'e',
+    OPT_WIDTH = 'w',
+    OPT_HEIGHT = 'h',
+    OPT_FORMAT = 'f',
+    OPT_BUFFERS = 'b',
+    OPT_FRAMES = 'n',
+    OPT_HELP = 256,     // 256: past the characters of the short options
+    OPT_SENSOR_WIDTH,
+    OPT_SENSOR_HEIGHT,
+    OPT_SENSOR_FORMAT,
+    OPT_WARMUP,
+    OPT_FPS,
+    OPT_ROTATION,
+    OPT_PARAM,
+    OPT_CASCADE,
+    OPT_JSON,
+    OPT_GATE_P99,
+    OPT_GATE_FPS,
+};
+
+const struct option OPTIONS[] = {
+    {"graph", required_argument, nullptr, OPT_GRAPH},
+    {"encode", required_argument, nullptr, OPT_ENCODE},
+    {"width", required_argument, nullptr, OPT_WIDTH},
+    {"height", required_argument, nullptr, OPT_HEIGHT},
+    {"format", required_argument, nullptr, OPT_FORMAT},
+    {"buffers", required_argument, nullptr, OPT_BUFFERS},
+    {"frames", required_argument, nullptr, OPT_FRAMES},
+    {"help", no_argument, nullptr, OPT_HELP},
+    {"sensor-width", required_argument, nullptr, OPT_SENSOR_WIDTH},
+    {"sensor-height", required_argument, nullptr, OPT_SENSOR_HEIGHT},
+    {"sensor-format", required_argument, nullptr, OPT_SENSOR_FORMAT},
+    {"warmup", required_argument, nullptr, OPT_WARMUP},
+    {"fps", required_argument, nullptr, OPT_FPS},
+    {"rotation", required_argument, nullptr, OPT_ROTATION},
+    {"param", required_argument, nullptr, OPT_PARAM},
+    {"cascade", required_argument, nullptr, OPT_CASCADE},
+    {"json", required_argument, nullptr, OPT_JSON},
+    {"gate-p99-us", required_argument, nullptr, OPT_GATE_P99},
+    {"gate-fps", required_argument, nullptr, OPT_GATE_FPS},
+    {nullptr, 0, nullptr, 0},
+};
+
+void Usage(const char* name)
+{
+    printf("usage: %s [options]\n"
+        "  -g, --graph G            preview (scale,codec), video (scale,codec h264), still (scale,codec,exif\n"
+        "                           jpeg), face (scale,face,codec) or the nodes in order, default video\n"
+        "  -e, --encode E           none, h264, h265 or jpeg, default the one of the graph\n"
+        "  -w, --width N            stream width, default 1280\n"
+        "  -h, --height N           stream height, default 720\n"
+        "  -f, --format F           yuv420p, nv12, nv21, yuyv or rgba8888 of the stream, default the one the\n"
+        "                           graph makes: rgba8888 for a preview through RKCodec, else yuv420p\n"
+        "      --sensor-width N     width of the frames the source delivers, default 1920\n"
+        "      --sensor-height N    default 1080\n"
+        "      --sensor-format F    default yuv420p\n"
+        "  -b, --buffers N          stream buffers, the frames in flight at most, default 6\n"
+        "  -n, --frames N           timed frames, default 300\n"
+        "      --warmup N           untimed frames first, default 10\n"
+        "      --fps N              source rate, default 0: as fast as the graph takes them\n"
+        "      --rotation D         OHOS_JPEG_ORIENTATION 0, 90, 180 or 270\n"
+        "      --param KEY=VALUE    a node tunable of rk_node_params.h, may be repeated,\n"
+        "                           persist.camera.rkcodec.jpeg_workers defaults to 0 here\n"
+        "      --cascade FILE       opencv haar cascade for RKFace, default a synthetic one\n"
+        "      --json FILE          the report as json as well, - for stdout\n"
+        "      --gate-p99-us US     fail when the end to end p99 is above\n"
+        "      --gate-fps FPS       fail when the throughput is below\n", name);
+}
+
+bool ParseUnsigned(const char* text, uint32_t& value)
+{
+    char* end = nullptr;
+    unsigned long parsed = strtoul(text, &end, 0);
+    if (end == text || *end != '\0' || parsed > UINT32_MAX) {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+bool ParseOption(int opt, const char* arg, PipelineBenchConfig& config, std::string& encode, std::string& format)
+{
+    uint32_t value = 0;
+    switch (opt) {
+        case OPT_GRAPH: return ParseBenchGraph(arg, config);
+        case OPT_ENCODE: encode = arg; return true;
+        case OPT_WIDTH: return ParseUnsigned(arg, config.width) && config.width != 0;
+        case OPT_HEIGHT: return ParseUnsigned(arg, config.height) && config.height != 0;
+        case OPT_FORMAT: format = arg; return true;
+        case OPT_SENSOR_WIDTH: return ParseUnsigned(arg, config.sensorWidth) && config.sensorWidth != 0;
+        case OPT_SENSOR_HEIGHT: return ParseUnsigned(arg, config.sensorHeight) && config.sensorHeight != 0;
+        case OPT_SENSOR_FORMAT: return ParseBenchPixelFormat(arg, config.sensorFormat);
+        case OPT_BUFFERS: return ParseUnsigned(arg, config.buffers) && config.buffers != 0;
+        case OPT_FRAMES: return ParseUnsigned(arg, config.frames) && config.frames != 0;
+        case OPT_WARMUP: return ParseUnsigned(arg, config.warmup);
+        case OPT_FPS: return ParseUnsigned(arg, config.fps);
+        case OPT_ROTATION:
+            if (!ParseUnsigned(arg, value) || value % 90 != 0 || value >= 360) {    // 90, 360: quarter turns
+                return false;
+            }
+            config.jpegRotation = static_cast<int32_t>(value);
+            return true;
+        case OPT_PARAM: {
+            std::string param(arg);
+            size_t split = param.find('=');
+            if (split == 0 || split == std::string::npos) {
+                return false;
+            }
+            config.params.emplace_back(param.substr(0, split), param.substr(split + 1));
+            return true;
+        }
+        case OPT_CASCADE: config.cascadePath = arg; return true;
+        case OPT_JSON: config.jsonPath = arg; return true;
+        case OPT_GATE_P99: config.gateP99Us = atof(arg); return true;
+        case OPT_GATE_FPS: config.gateFps = atof(arg); return true;
+        default: return false;
+    }
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    PipelineBenchConfig config;
+    std::string encode;
+    std::string format;
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "g:e:w:h:f:b:n:", OPTIONS, nullptr)) != -1) {
+        if (opt == OPT_HELP) {
+            Usage(argv[0]);
+            return 0;
+        }
+        if (opt == '?') {
+            return 2;   // 2: usage error, getopt has said what was wrong
+        }
+        if (!ParseOption(opt, optarg, config, encode, format)) {
+            const struct option* o = OPTIONS;
+            while (o->name != nullptr && o->val != opt) {
+                o++;
+            }
+            fprintf(stderr, "bad value \"%s\" for --%s\n", optarg != nullptr ? optarg : "", o->name);
+            return 2;
+        }
+    }
+    // a preset picks the encoding of its stream, --encode wins wherever it is given
+    if (!encode.empty() && !ParseBenchEncode(encode, config.encode)) {
+        fprintf(stderr, "bad value \"%s\" for --encode\n", encode.c_str());
+        return 2;
+    }
+    // the stream gets the layout the graph makes unless --format asks for another, which the sink then rejects
+    if (format.empty()) {
+        config.format = BenchPictureFormat(config);
+    } else if (!ParseBenchPixelFormat(format, config.format)) {
+        fprintf(stderr, "bad value \"%s\" for --format\n", format.c_str());
+        return 2;
+    }
+    return RunPipelineBench(config);
+}
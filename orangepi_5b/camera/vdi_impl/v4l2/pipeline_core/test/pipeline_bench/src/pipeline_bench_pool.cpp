@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pipeline_bench.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "rk_jpeg_encoder.h"
+#include "rk_rga_session.h"
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t CHROMA_DIV = 2;
+constexpr uint32_t RGBA_BPP = 4;
+constexpr uint32_t RGB_BPP = 3;
+constexpr uint32_t YUYV_BPP = 2;
+constexpr size_t PAGE = 4096;
+constexpr uint32_t FACE_WINDOW = 24;    // the window of the synthetic cascade, see pipeline_bench_runner.cpp
+
+uint32_t RowBytes(RgaPixelFormat format, uint32_t width)
+{
+    switch (format) {
+        case RgaPixelFormat::RGBA8888:
+            return width * RGBA_BPP;
+        case RgaPixelFormat::RGB888:
+            return width * RGB_BPP;
+        case RgaPixelFormat::YUYV:
+            return width * YUYV_BPP;
+        default:
+            return width;
+    }
+}
+
+/*
+ * A noisy gradient with three faces like the ones of rk_face_detector_benchmark, at the same places relative
+ * to the frame so every size finds them. The chroma is flat apart from the gradient.
+ */
+std::vector<uint8_t> MakePattern(uint32_t width, uint32_t height)
+{
+    size_t luma = static_cast<size_t>(width) * height;
+    std::vector<uint8_t> frame(luma + 2 * (luma / (CHROMA_DIV * CHROMA_DIV)));  // 2: u and v
+    uint32_t seed = 1;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            seed = seed * 1103515245 + 12345;   // 1103515245, 12345: lcg
+            frame[static_cast<size_t>(y) * width + x] =
+                static_cast<uint8_t>(80 + x * 40 / width + y * 20 / height + ((seed >> 16) % 40));  // 80..179
+        }
+    }
+    const float faces[][3] = {{0.10f, 0.18f, 0.28f}, {0.47f, 0.28f, 0.17f}, {0.78f, 0.55f, 0.11f}};  // x, y, size
+    for (const auto& face : faces) {
+        uint32_t size = std::max(static_cast<uint32_t>(face[2] * height), FACE_WINDOW);   // 2: of the height
+        uint32_t left = static_cast<uint32_t>(face[0] * width);
+        uint32_t top = static_cast<uint32_t>(face[1] * height);
+        for (uint32_t v = 0; v < size && top + v < height; v++) {
+            for (uint32_t u = 0; u < size && left + u < width; u++) {
+                uint32_t pu = u * FACE_WINDOW / size;
+                uint32_t pv = v * FACE_WINDOW / size;
+                bool eyes = pv >= 6 && pv < 12 && (pu < 10 || pu >= 14);   // 6, 12, 10, 14: eye band, bridge
+                frame[static_cast<size_t>(top + v) * width + left + u] = eyes ? 40 : 170;  // 40, 170: grey
+            }
+        }
+    }
+    uint8_t* u = frame.data() + luma;
+    uint8_t* v = u + luma / (CHROMA_DIV * CHROMA_DIV);
+    uint32_t chromaWidth = width / CHROMA_DIV;
+    uint32_t chromaHeight = height / CHROMA_DIV;
+    for (uint32_t y = 0; y < chromaHeight; y++) {
+        for (uint32_t x = 0; x < chromaWidth; x++) {
+            size_t i = static_cast<size_t>(y) * chromaWidth + x;
+            u[i] = static_cast<uint8_t>(108 + x * 40 / chromaWidth);    // 108, 40: around the grey of 128
+            v[i] = static_cast<uint8_t>(148 - y * 40 / chromaHeight);   // 148, 40: around the grey of 128
+        }
+    }
+    return frame;
+}
+
+// the pattern in format, converted by RGA like the isp output it stands for
+bool RenderPattern(uint32_t width, uint32_t height, int32_t cameraFormat, std::vector<uint8_t>& out)
+{
+    RgaPixelFormat format = RgaPixelFormat::YUV420P;
+    if (!ToRgaPixelFormat(cameraFormat, format)) {
+        return false;
+    }
+    std::vector<uint8_t> pattern = MakePattern(width, height);
+    if (format == RgaPixelFormat::YUV420P) {
+        out = std::move(pattern);
+        return true;
+    }
+    out.assign(RgaFrameSize(format, width, height), 0);
+    std::shared_ptr<RKRgaSession> session = RKRgaSession::Create();
+    if (session == nullptr) {
+        return false;
+    }
+    RgaJob job;
+    job.src = MakeRgaSurface(-1, pattern.data(), width, height, RgaPixelFormat::YUV420P);
+    job.dst = MakeRgaSurface(-1, out.data(), width, height, format);
+    return session->Sync(session->Queue(job)) == 0;
+}
+} // namespace
+
+BenchBufferPool::~BenchBufferPool()
+{
+    auto unmap = [](Slot& slot) {
+        if (slot.map != nullptr) {
+            munmap(slot.map, slot.size);
+        }
+        if (slot.fd >= 0) {
+            close(slot.fd);
+        }
+    };
+    for (Slot& slot : slots_) {
+        unmap(slot);
+    }
+    unmap(fork_);
+}
+
+bool BenchBufferPool::MapFrame(size_t size, Slot& slot)
+{
+    slot.fd = memfd_create("camera_pipeline_bench", MFD_CLOEXEC);
+    if (slot.fd < 0 || ftruncate(slot.fd, static_cast<off_t>(size)) != 0) {
+        return false;
+    }
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, slot.fd, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    slot.map = static_cast<uint8_t*>(map);
+    slot.size = size;
+    return true;
+}
+
+bool BenchBufferPool::Init(const PipelineBenchConfig& config, std::string& error)
+{
+    config_ = config;
+    scaleFirst_ = !config.graph.empty() && config.graph.front() == BenchNodeType::SCALE;
+    RgaPixelFormat format = RgaPixelFormat::YUV420P;
+    RgaPixelFormat sensorFormat = RgaPixelFormat::YUV420P;
+    if (!ToRgaPixelFormat(config.format, format) || !ToRgaPixelFormat(config.sensorFormat, sensorFormat)) {
+        error = "no RGA layout for the stream or the sensor format";
+        return false;
+    }
+    // room for the RGBA the codec node turns a preview frame into and for a jpeg of the frame
+    size_t frameSize = std::max({RgaFrameSize(format, config.width, config.height),
+        static_cast<size_t>(config.width) * config.height * RGBA_BPP, JpegWorstCaseSize(config.width, config.height)});
+    frameSize = (frameSize + PAGE - 1) / PAGE * PAGE;
+    slots_.resize(config.buffers);
+    for (size_t i = 0; i < slots_.size(); i++) {
+        Slot& slot = slots_[i];
+        if (!MapFrame(frameSize, slot)) {
+            error = "memfd of " + std::to_string(frameSize) + " bytes failed";
+            return false;
+        }
+        BenchBuffer& buffer = *slot.buffer;
+        buffer.index_ = static_cast<int32_t>(i);
+        buffer.width_ = config.width;
+        buffer.height_ = config.height;
+        buffer.stride_ = RowBytes(format, config.width);
+        buffer.format_ = config.format;
+        buffer.fd_ = slot.fd;
+    }
+    // the strides of the source are inferred from the size of its buffer, it has to be exact
+    captureSize_ = RgaFrameSize(sensorFormat, config.sensorWidth, config.sensorHeight);
+    if (!MapFrame(captureSize_, fork_)) {
+        error = "memfd of the source frame failed";
+        return false;
+    }
+    fork_.buffer->index_ = static_cast<int32_t>(slots_.size());
+    return MakeFrames(error);
+}
+
+bool BenchBufferPool::MakeFrames(std::string& error)
+{
+    if (!RenderPattern(config_.sensorWidth, config_.sensorHeight, config_.sensorFormat, capture_)) {
+        error = "cannot render the source frame";
+        return false;
+    }
+    (void)memcpy(fork_.map, capture_.data(), captureSize_);
+    // the nodes pass frames on as tightly packed I420, the stream format is only what the codec node makes of them
+    if (!scaleFirst_ && !RenderPattern(config_.width, config_.height, CAMERA_FORMAT_YCBCR_420_P, streamFrame_)) {
+        error = "cannot render the stream frame";
+        return false;
+    }
+    if (!MakeReference()) {
+        error = "cannot scale the reference frame";
+        return false;
+    }
+    return true;
+}
+
+bool BenchBufferPool::MakeReference()
+{
+    if (!scaleFirst_) {
+        reference_ = streamFrame_;
+        return true;
+    }
+    // the software backend whatever the sessions run on, the reference does not go through what it checks
+    RgaPixelFormat sensorFormat = RgaPixelFormat::YUV420P;
+    ToRgaPixelFormat(config_.sensorFormat, sensorFormat);
+    reference_.assign(RgaFrameSize(RgaPixelFormat::YUV420P, config_.width, config_.height), 0);
+    RgaJob job;
+    job.src = MakeRgaSurface(-1, capture_.data(), config_.sensorWidth, config_.sensorHeight, sensorFormat);
+    job.dst = MakeRgaSurface(-1, reference_.data(), config_.width, config_.height, RgaPixelFormat::YUV420P);
+    return CreateRgaSoftBackend()->Run({job}) == 0;
+}
+
+std::map<int32_t, uint8_t*> BenchBufferPool::getSFBuffer(int32_t index)
+{
+    if (index == fork_.buffer->index_) {
+        return {{static_cast<int32_t>(fork_.size), fork_.map}};
+    }
+    if (index < 0 || static_cast<size_t>(index) >= slots_.size()) {
+        return {};
+    }
+    return {{static_cast<int32_t>(slots_[index].size), slots_[index].map}};
+}
+
+int32_t BenchBufferPool::GetForkBufferId()
+{
+    return fork_.buffer->index_;
+}
+
+std::shared_ptr<IBuffer> BenchBufferPool::Acquire(int64_t timeoutMs)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    auto free = [this] { return inFlight_ < slots_.size(); };
+    if (!freeCv_.wait_for(l, std::chrono::milliseconds(timeoutMs), free)) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < slots_.size(); i++) {
+        Slot& slot = slots_[(next_ + i) % slots_.size()];
+        if (!slot.busy) {
+            slot.busy = true;
+            inFlight_++;
+            next_ = (next_ + i + 1) % slots_.size();
+            return slot.buffer;
+        }
+    }
+    return nullptr;
+}
+
+void BenchBufferPool::Prepare(const std::shared_ptr<IBuffer>& buffer, int32_t streamId, int32_t captureId,
+    uint64_t timestamp)
+{
+    BenchBuffer& b = static_cast<BenchBuffer&>(*buffer);
+    Slot& slot = slots_[b.index_];
+    bool encoded = config_.encode != ENCODE_TYPE_NULL;
+    if (scaleFirst_ && !encoded) {
+        // the preview frame RKScaleNode reads and then points the buffer at the surface memory
+        b.virAddr_ = capture_.data();
+        b.size_ = static_cast<uint32_t>(captureSize_);
+    } else {
+        b.virAddr_ = slot.map;
+        b.size_ = static_cast<uint32_t>(slot.size);
+        if (!scaleFirst_) {
+            (void)memcpy(slot.map, streamFrame_.data(), streamFrame_.size());
+        }
+    }
+    b.encodeType_ = config_.encode;
+    b.streamId_ = streamId;
+    b.captureId_ = captureId;
+    b.timestamp_ = timestamp;
+    b.es_ = EsFrameInfo {};
+}
+
+void BenchBufferPool::Release(int32_t index)
+{
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        if (index < 0 || static_cast<size_t>(index) >= slots_.size() || !slots_[index].busy) {
+            return;
+        }
+        slots_[index].busy = false;
+        inFlight_--;
+    }
+    freeCv_.notify_all();
+}
+
+bool BenchBufferPool::WaitIdle(int64_t timeoutMs)
+{
+    std::unique_lock<std::mutex> l(lock_);
+    return freeCv_.wait_for(l, std::chrono::milliseconds(timeoutMs), [this] { return inFlight_ == 0; });
+}
+
+uint32_t BenchBufferPool::InFlight()
+{
+    std::unique_lock<std::mutex> l(lock_);
+    return inFlight_;
+}
+} // namespace OHOS::Camera
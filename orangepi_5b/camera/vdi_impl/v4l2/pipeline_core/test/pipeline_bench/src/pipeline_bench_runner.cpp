@@ -0,0 +1,877 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pipeline_bench.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include "rk_codec_node.h"
+#include "rk_exif_node.h"
+#include "rk_face_detector.h"
+#include "rk_face_node.h"
+#include "rk_jpeg_exif.h"
+#include "rk_latency_histogram.h"
+#include "rk_node_params.h"
+#include "rk_rga_session.h"
+#include "rk_scale_node.h"
+#include "rk_vendor_tags.h"
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint64_t POOL_ID = 1;
+constexpr int32_t STREAM_ID = 1;
+constexpr int64_t BUFFER_TIMEOUT_MS = 5000;     // a frame stuck that long is lost in the graph
+constexpr uint32_t RGBA_BPP = 4;
+constexpr uint32_t CHROMA_DIV = 2;
+constexpr uint32_t YCC_SAMPLES = 3;             // y cb cr of a decoded jpeg pixel
+constexpr uint32_t QUARTER_TURNS = 4;
+constexpr uint64_t PIXEL_CHECK_INTERVAL = 8;    // every 8th frame is compared with the source, each one for form
+constexpr double MAX_PICTURE_ERROR = 2.0;       // mean absolute difference per sample, the same software csc
+constexpr double MAX_JPEG_ERROR = 4.0;          // the same, after the jpeg round trip
+constexpr uint8_t JPEG_QUALITY = 95;
+constexpr double GPS[3] = {31.2304, 121.4737, 4.5};    // 3: latitude, longitude, altitude
+constexpr int64_t EXPOSURE_NS = 16600000;
+constexpr int32_t ISO = 200;
+constexpr int32_t FOCAL_LENGTH_UM = 4200;
+constexpr int32_t FPS_RANGE[2] = {30, 30};
+constexpr uint32_t META_ITEMS = 16;
+constexpr uint32_t META_DATA = 256;
+constexpr size_t MEMCPY_BYTES = 64 << 20;       // 64 MiB, well past the caches
+constexpr uint32_t MEMCPY_ROUNDS = 4;
+constexpr double NS_PER_S = 1e9;
+constexpr double NS_PER_US = 1e3;
+constexpr double BYTES_PER_MIB = 1024.0 * 1024.0;
+constexpr double BYTES_PER_GB = 1e9;
+constexpr uint32_t WINDOW = 24;
+
+struct Preset {
+    const char* name;
+    std::vector<BenchNodeType> graph;
+    EncodeType encode;
+};
+
+const Preset PRESETS[] = {
+    {"preview", {BenchNodeType::SCALE, BenchNodeType::CODEC}, ENCODE_TYPE_NULL},
+    {"video", {BenchNodeType::SCALE, BenchNodeType::CODEC}, ENCODE_TYPE_H264},
+    {"still", {BenchNodeType::SCALE, BenchNodeType::CODEC, BenchNodeType::EXIF}, ENCODE_TYPE_JPEG},
+    {"face", {BenchNodeType::SCALE, BenchNodeType::FACE, BenchNodeType::CODEC}, ENCODE_TYPE_NULL},
+};
+
+const std::pair<const char*, int32_t> PIXEL_FORMATS[] = {
+    {"yuv420p", CAMERA_FORMAT_YCBCR_420_P},
+    {"nv12", CAMERA_FORMAT_YCBCR_420_SP},
+    {"nv21", CAMERA_FORMAT_YCRCB_420_SP},
+    {"yuyv", CAMERA_FORMAT_YUYV_422_PKG},
+    {"rgba8888", CAMERA_FORMAT_RGBA_8888},
+};
+
+uint64_t NowNs()
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);  // ns per s
+}
+
+HaarFeature MakeFeature(std::initializer_list<HaarRect> rects)
+{
+    HaarFeature feature;
+    for (const HaarRect& r : rects) {
+        feature.rects[feature.count++] = r;
+    }
+    return feature;
+}
+
+// the cascade of rk_face_detector_benchmark, it finds the faces pipeline_bench_pool.cpp draws
+HaarCascade MakeSyntheticCascade()
+{
+    HaarCascade cascade;
+    cascade.windowWidth = WINDOW;
+    cascade.windowHeight = WINDOW;
+    cascade.features = {
+        MakeFeature({{2, 6, 20, 12, -1.0f}, {2, 12, 20, 6, 2.0f}}),
+        MakeFeature({{2, 6, 20, 6, -1.0f}, {10, 6, 4, 6, 5.0f}}),
+        MakeFeature({{2, 0, 20, 12, -1.0f}, {2, 0, 20, 6, 2.0f}}),
+        MakeFeature({{0, 0, 12, 24, -1.0f}, {12, 0, 12, 24, 1.0f}}),
+    };
+    constexpr float threshold = 0.25f;
+    constexpr float symmetry = 0.05f;
+    cascade.stages = {
+        {1.5f, {{0, threshold, -1.0f, 1.0f}, {1, threshold, -1.0f, 1.0f}}},    // 1.5: both
+        {0.5f, {{2, threshold, -1.0f, 1.0f}}},                                  // 0.5: the one
+        {1.5f, {{3, -symmetry, -1.0f, 1.0f}, {3, symmetry, 1.0f, -1.0f}}},      // 3: the symmetry feature
+    };
+    return cascade;
+}
+
+// mean absolute difference of the samples of two pictures in the same layout
+double MeanError(const uint8_t* a, const uint8_t* b, size_t size)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += static_cast<uint64_t>(std::abs(static_cast<int32_t>(a[i]) - static_cast<int32_t>(b[i])));
+    }
+    return size == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(size);
+}
+
+/*
+ * A decoded still against the I420 reference turned by quarter turns clockwise. The orientation is in the
+ * pixels or only in the Exif tag depending on the stream settings, so every turn that fits the size is tried.
+ */
+double JpegError(const std::vector<uint8_t>& ycc, uint32_t width, uint32_t height, const std::vector<uint8_t>& ref,
+    uint32_t refWidth, uint32_t refHeight)
+{
+    const uint8_t* refY = ref.data();
+    const uint8_t* refCb = refY + static_cast<size_t>(refWidth) * refHeight;
+    const uint8_t* refCr = refCb + static_cast<size_t>(refWidth / CHROMA_DIV) * (refHeight / CHROMA_DIV);
+    double best = std::numeric_limits<double>::max();
+    for (uint32_t turns = 0; turns < QUARTER_TURNS; turns++) {
+        bool swapped = turns % 2 != 0;  // 2: a quarter or three quarters swap the sides
+        if (width != (swapped ? refHeight : refWidth) || height != (swapped ? refWidth : refHeight)) {
+            continue;
+        }
+        uint64_t sum = 0;
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                uint32_t rx = x;
+                uint32_t ry = y;
+                if (turns == 1) {
+                    rx = y;
+                    ry = refHeight - 1 - x;
+                } else if (turns == 2) {    // 2: half a turn
+                    rx = refWidth - 1 - x;
+                    ry = refHeight - 1 - y;
+                } else if (turns == 3) {    // 3: three quarters
+                    rx = refWidth - 1 - y;
+                    ry = x;
+                }
+                const uint8_t* sample = &ycc[(static_cast<size_t>(y) * width + x) * YCC_SAMPLES];
+                size_t chroma = static_cast<size_t>(ry / CHROMA_DIV) * (refWidth / CHROMA_DIV) + rx / CHROMA_DIV;
+                sum += static_cast<uint64_t>(std::abs(sample[0] - refY[static_cast<size_t>(ry) * refWidth + rx]) +
+                    std::abs(sample[1] - refCb[chroma]) + std::abs(sample[2] - refCr[chroma]));    // 2: cr
+            }
+        }
+        best = std::min(best, static_cast<double>(sum) / (static_cast<double>(width) * height * YCC_SAMPLES));
+    }
+    return best;
+}
+
+// what one node costs on the thread that delivers to it, the nodes it delivers to on that thread left out
+struct NodeStats {
+    RKLatencyHistogram latency;
+    std::atomic<uint64_t> frames {0};
+    std::atomic<uint64_t> totalNs {0};
+    std::atomic<uint64_t> allocCalls {0};
+    std::atomic<uint64_t> allocBytes {0};
+
+    void Reset()
+    {
+        latency.Reset();
+        frames = 0;
+        totalNs = 0;
+        allocCalls = 0;
+        allocBytes = 0;
+    }
+};
+
+// time and allocations of the deliveries further down the graph, nested on the current thread
+thread_local uint64_t t_downstreamNs = 0;
+thread_local BenchAllocCount t_downstreamAllocs;
+
+class BenchPort : public IPort {
+public:
+    BenchPort(const PortFormat& format, std::function<void(std::shared_ptr<IBuffer>&)> next) : next_(std::move(next))
+    {
+        format_ = format;
+    }
+
+    void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override
+    {
+        next_(buffer);
+    }
+
+private:
+    std::function<void(std::shared_ptr<IBuffer>&)> next_;
+};
+
+struct SinkStats {
+    RKLatencyHistogram latency;     // capture time to the end of the graph
+    std::atomic<uint64_t> frames {0};
+    std::atomic<uint64_t> badFrames {0};
+    std::atomic<uint64_t> wrongFormat {0};  // pictures in another layout than their stream's
+    std::atomic<uint64_t> pixelChecks {0};
+    std::atomic<uint64_t> esBytes {0};
+    std::atomic<uint64_t> jpegFrames {0};
+
+    void Reset()
+    {
+        latency.Reset();
+        frames = 0;
+        badFrames = 0;
+        wrongFormat = 0;
+        pixelChecks = 0;
+        esBytes = 0;
+        jpegFrames = 0;
+    }
+};
+
+struct NodeReport {
+    const char* name;
+    LatencySummary latency;
+    double meanUs;
+    double allocsPerFrame;
+    double allocBytesPerFrame;
+    double trafficPerFrame;     // estimated bytes read and written
+};
+
+class PipelineBench {
+public:
+    explicit PipelineBench(const PipelineBenchConfig& config) : config_(config) {}
+    int Run();
+
+private:
+    bool Setup(std::string& error);
+    void Teardown();
+    void RunNode(size_t index, std::shared_ptr<IBuffer>& buffer);
+    void Sink(std::shared_ptr<IBuffer>& buffer);
+    bool CheckPicture(const IBuffer& buffer, bool comparePixels);
+    bool CheckJpeg(const uint8_t* data, size_t size);
+    bool Source(uint32_t frames);
+    void ResetStats();
+    std::vector<NodeReport> Report(double wallNs, uint64_t frames);
+    double EstimateTraffic(BenchNodeType type, uint64_t frames);
+    void PrintNodeDetails();
+    void WriteJson(FILE* out, const std::vector<NodeReport>& reports, double fps, double wallNs, uint64_t frames,
+        const BenchAllocCount& allocs, double memcpyGbps, bool passed);
+
+    PipelineBenchConfig config_;
+    std::shared_ptr<BenchBufferPool> pool_;
+    std::vector<std::shared_ptr<NodeBase>> nodes_;
+    std::vector<std::unique_ptr<NodeStats>> stats_;
+    std::shared_ptr<RKScaleNode> scale_;
+    std::shared_ptr<RKCodecNode> codec_;
+    std::shared_ptr<RKFaceNode> face_;
+    std::shared_ptr<RKExifNode> exif_;
+    SinkStats sink_;
+    int32_t pictureFormat_ = CAMERA_FORMAT_YCBCR_420_P;
+    std::vector<uint8_t> referenceRgba_;    // the reference as RKCodec should turn a preview into RGBA
+    ScaleTrafficStats scaleBase_;
+    uint64_t rgbaCopyBase_ = 0;
+    VideoEncoderPoolStats videoBase_;
+    WorkerPoolStats jpegBase_;
+    FaceDetectStats faceBase_;
+    int32_t captureId_ = 0;
+};
+
+double PerFrame(double value, uint64_t frames)
+{
+    return frames == 0 ? 0.0 : value / static_cast<double>(frames);
+}
+
+double MeasureMemcpyGbps()
+{
+    std::vector<uint8_t> src(MEMCPY_BYTES, 1);
+    std::vector<uint8_t> dst(MEMCPY_BYTES, 0);
+    (void)memcpy(dst.data(), src.data(), MEMCPY_BYTES);
+    uint64_t start = NowNs();
+    for (uint32_t i = 0; i < MEMCPY_ROUNDS; i++) {
+        (void)memcpy(dst.data(), src.data(), MEMCPY_BYTES);
+        src[i] = dst[MEMCPY_BYTES - 1 - i];
+    }
+    double ns = static_cast<double>(NowNs() - start);
+    // read and write, like the traffic estimates of the nodes
+    return 2.0 * MEMCPY_BYTES * MEMCPY_ROUNDS / (ns / NS_PER_S) / BYTES_PER_GB;     // 2.0: read and write
+}
+} // namespace
+
+bool ParseBenchGraph(const std::string& spec, PipelineBenchConfig& config)
+{
+    for (const Preset& preset : PRESETS) {
+        if (spec == preset.name) {
+            config.graphName = spec;
+            config.graph = preset.graph;
+            config.encode = preset.encode;
+            return true;
+        }
+    }
+    std::vector<BenchNodeType> graph;
+    std::stringstream list(spec);
+    std::string name;
+    while (std::getline(list, name, ',')) {
+        BenchNodeType type = BenchNodeType::SCALE;
+        if (name == "scale") {
+            type = BenchNodeType::SCALE;
+        } else if (name == "codec") {
+            type = BenchNodeType::CODEC;
+        } else if (name == "face") {
+            type = BenchNodeType::FACE;
+        } else if (name == "exif") {
+            type = BenchNodeType::EXIF;
+        } else {
+            return false;
+        }
+        // one node of a kind, the stream has one port per node
+        if (std::find(graph.begin(), graph.end(), type) != graph.end()) {
+            return false;
+        }
+        graph.push_back(type);
+    }
+    if (graph.empty()) {
+        return false;
+    }
+    config.graphName = spec;
+    config.graph = graph;
+    return true;
+}
+
+bool ParseBenchEncode(const std::string& name, EncodeType& encode)
+{
+    if (name == "none" || name == "preview") {
+        encode = ENCODE_TYPE_NULL;
+    } else if (name == "h264") {
+        encode = ENCODE_TYPE_H264;
+    } else if (name == "h265") {
+        encode = ENCODE_TYPE_H265;
+    } else if (name == "jpeg") {
+        encode = ENCODE_TYPE_JPEG;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ParseBenchPixelFormat(const std::string& name, int32_t& format)
+{
+    for (const auto& it : PIXEL_FORMATS) {
+        if (name == it.first) {
+            format = it.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* BenchNodeName(BenchNodeType type)
+{
+    switch (type) {
+        case BenchNodeType::SCALE:
+            return "RKScale";
+        case BenchNodeType::CODEC:
+            return "RKCodec";
+        case BenchNodeType::FACE:
+            return "RKFace";
+        default:
+            return "RKExif";
+    }
+}
+
+const char* BenchEncodeName(EncodeType encode)
+{
+    switch (encode) {
+        case ENCODE_TYPE_H264:
+            return "h264";
+        case ENCODE_TYPE_H265:
+            return "h265";
+        case ENCODE_TYPE_JPEG:
+            return "jpeg";
+        default:
+            return "none";
+    }
+}
+
+int32_t BenchPictureFormat(const PipelineBenchConfig& config)
+{
+    bool codec = std::find(config.graph.begin(), config.graph.end(), BenchNodeType::CODEC) != config.graph.end();
+    return codec && config.encode == ENCODE_TYPE_NULL ? CAMERA_FORMAT_RGBA_8888 : CAMERA_FORMAT_YCBCR_420_P;
+}
+
+const char* BenchPixelFormatName(int32_t format)
+{
+    for (const auto& it : PIXEL_FORMATS) {
+        if (format == it.second) {
+            return it.first;
+        }
+    }
+    return "unknown";
+}
+
+bool PipelineBench::Setup(std::string& error)
+{
+    RKRgaSession::SetBackendFactory(CreateRgaSoftBackend);
+    // the jpeg is encoded on the delivering thread unless asked otherwise, so RKCodec is timed with it
+    SetBenchParameter(RK_PARAM_JPEG_WORKERS, "0");
+    if (!config_.cascadePath.empty()) {
+        SetBenchParameter(RK_PARAM_FACE_CASCADE, config_.cascadePath);
+    } else {
+        RKFaceNode::SetDetectorFactory([] { return CreateCascadeFaceDetector(MakeSyntheticCascade(), {}); });
+    }
+    for (const auto& param : config_.params) {
+        SetBenchParameter(param.first, param.second);
+    }
+
+    pool_ = std::make_shared<BenchBufferPool>();
+    if (!pool_->Init(config_, error)) {
+        return false;
+    }
+    BufferManager::GetInstance()->AddBufferPool(POOL_ID, pool_);
+    pictureFormat_ = BenchPictureFormat(config_);
+    if (pictureFormat_ == CAMERA_FORMAT_RGBA_8888) {
+        std::vector<uint8_t> yuv = pool_->GetReference();
+        referenceRgba_.assign(static_cast<size_t>(config_.width) * config_.height * RGBA_BPP, 0);
+        RgaJob csc;
+        csc.src = MakeRgaSurface(-1, yuv.data(), config_.width, config_.height, RgaPixelFormat::YUV420P);
+        csc.dst = MakeRgaSurface(-1, referenceRgba_.data(), config_.width, config_.height, RgaPixelFormat::RGBA8888);
+        if (CreateRgaSoftBackend()->Run({csc}) != 0) {
+            error = "cannot convert the reference frame";
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < config_.graph.size(); i++) {
+        std::string type = BenchNodeName(config_.graph[i]);
+        std::string name = type + "#" + std::to_string(i);
+        std::shared_ptr<NodeBase> node;
+        switch (config_.graph[i]) {
+            case BenchNodeType::SCALE:
+                node = scale_ = std::make_shared<RKScaleNode>(name, type, "0");
+                break;
+            case BenchNodeType::CODEC:
+                node = codec_ = std::make_shared<RKCodecNode>(name, type, "0");
+                break;
+            case BenchNodeType::FACE:
+                node = face_ = std::make_shared<RKFaceNode>(name, type, "0");
+                break;
+            default:
+                node = exif_ = std::make_shared<RKExifNode>(name, type, "0");
+                break;
+        }
+        nodes_.push_back(node);
+        stats_.push_back(std::make_unique<NodeStats>());
+    }
+    if (scale_ != nullptr) {
+        PortFormat sensor;
+        sensor.w_ = config_.sensorWidth;
+        sensor.h_ = config_.sensorHeight;
+        sensor.format_ = static_cast<uint32_t>(config_.sensorFormat);
+        scale_->SetSourceSize(config_.sensorWidth, config_.sensorHeight);
+        scale_->AddInPort(std::make_shared<BenchPort>(sensor, [](std::shared_ptr<IBuffer>&) {}));
+    }
+    PortFormat stream;
+    stream.w_ = config_.width;
+    stream.h_ = config_.height;
+    stream.format_ = static_cast<uint32_t>(config_.format);
+    stream.bufferCount_ = config_.buffers;
+    stream.bufferPoolId_ = POOL_ID;
+    stream.streamId_ = STREAM_ID;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        std::function<void(std::shared_ptr<IBuffer>&)> next = [this](std::shared_ptr<IBuffer>& b) { Sink(b); };
+        if (i + 1 < nodes_.size()) {
+            next = [this, i](std::shared_ptr<IBuffer>& b) { RunNode(i + 1, b); };
+        }
+        nodes_[i]->AddOutPort(std::make_shared<BenchPort>(stream, next));
+    }
+
+    auto meta = std::make_shared<CameraSetting>(META_ITEMS, META_DATA);
+    uint8_t quality = JPEG_QUALITY;
+    meta->addEntry(OHOS_JPEG_QUALITY, &quality, 1);
+    meta->addEntry(OHOS_JPEG_ORIENTATION, &config_.jpegRotation, 1);
+    meta->addEntry(OHOS_JPEG_GPS_COORDINATES, GPS, sizeof(GPS) / sizeof(GPS[0]));
+    meta->addEntry(OHOS_SENSOR_EXPOSURE_TIME, &EXPOSURE_NS, 1);
+    meta->addEntry(OHOS_CONTROL_FPS_RANGES, FPS_RANGE, sizeof(FPS_RANGE) / sizeof(FPS_RANGE[0]));
+    meta->addEntry(RK_VENDOR_EXIF_ISO, &ISO, 1);
+    meta->addEntry(RK_VENDOR_EXIF_FOCAL_LENGTH, &FOCAL_LENGTH_UM, 1);
+    for (auto& node : nodes_) {
+        node->Config(STREAM_ID, meta);
+        if (node->Start(STREAM_ID) != RC_OK) {
+            error = "Start failed";
+            return false;
+        }
+    }
+    return true;
+}
+
+void PipelineBench::Teardown()
+{
+    for (auto& node : nodes_) {
+        node->Stop(STREAM_ID);
+    }
+    nodes_.clear();
+    scale_ = nullptr;
+    codec_ = nullptr;
+    face_ = nullptr;
+    exif_ = nullptr;
+    BufferManager::GetInstance()->RemoveBufferPool(POOL_ID);
+}
+
+void PipelineBench::RunNode(size_t index, std::shared_ptr<IBuffer>& buffer)
+{
+    uint64_t outerNs = t_downstreamNs;
+    BenchAllocCount outerAllocs = t_downstreamAllocs;
+    t_downstreamNs = 0;
+    t_downstreamAllocs = {};
+    BenchAllocCount before = GetThreadAllocs();
+    uint64_t start = NowNs();
+
+    nodes_[index]->DeliverBuffer(buffer);
+
+    uint64_t ns = NowNs() - start;
+    BenchAllocCount after = GetThreadAllocs();
+    NodeStats& stats = *stats_[index];
+    uint64_t selfNs = ns - std::min(ns, t_downstreamNs);
+    stats.latency.Record(static_cast<uint64_t>(selfNs / NS_PER_US));
+    stats.totalNs += selfNs;
+    stats.frames++;
+    stats.allocCalls += after.calls - before.calls - t_downstreamAllocs.calls;
+    stats.allocBytes += after.bytes - before.bytes - t_downstreamAllocs.bytes;
+
+    t_downstreamNs = outerNs + ns;
+    t_downstreamAllocs.calls = outerAllocs.calls + after.calls - before.calls;
+    t_downstreamAllocs.bytes = outerAllocs.bytes + after.bytes - before.bytes;
+}
+
+// the picture is in the layout the graph makes and, when compared, close to the reference
+bool PipelineBench::CheckPicture(const IBuffer& buffer, bool comparePixels)
+{
+    if (buffer.GetFormat() != pictureFormat_) {
+        sink_.wrongFormat++;
+        return false;
+    }
+    if (!comparePixels) {
+        return true;
+    }
+    const std::vector<uint8_t>& expected =
+        pictureFormat_ == CAMERA_FORMAT_RGBA_8888 ? referenceRgba_ : pool_->GetReference();
+    if (buffer.GetVirAddress() == nullptr || buffer.GetSize() < expected.size()) {
+        return false;
+    }
+    sink_.pixelChecks++;
+    return MeanError(static_cast<const uint8_t*>(buffer.GetVirAddress()), expected.data(), expected.size()) <=
+        MAX_PICTURE_ERROR;
+}
+
+bool PipelineBench::CheckJpeg(const uint8_t* data, size_t size)
+{
+    // the sink may run on several jpeg workers at once
+    static thread_local std::vector<uint8_t> ycc;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (!DecodeJpegYcc(data, size, ycc, width, height)) {
+        return false;
+    }
+    sink_.pixelChecks++;
+    return JpegError(ycc, width, height, pool_->GetReference(), config_.width, config_.height) <= MAX_JPEG_ERROR;
+}
+
+void PipelineBench::Sink(std::shared_ptr<IBuffer>& buffer)
+{
+    uint64_t now = NowNs();
+    BenchAllocCount allocs = GetThreadAllocs();
+    sink_.latency.Record(static_cast<uint64_t>((now - std::min(now, buffer->GetTimestamp())) / NS_PER_US));
+    const uint8_t* data = static_cast<const uint8_t*>(buffer->GetVirAddress());
+    EsFrameInfo es = buffer->GetEsFrameInfo();
+    bool comparePixels = sink_.frames++ % PIXEL_CHECK_INTERVAL == 0;
+    bool good = true;
+    // without a codec node the stream still holds the picture
+    switch (codec_ == nullptr ? ENCODE_TYPE_NULL : buffer->GetEncodeType()) {
+        case ENCODE_TYPE_JPEG:
+            good = es.size > 1 && data[0] == 0xff && data[1] == 0xd8;   // 0xff 0xd8: SOI
+            good = good && (!comparePixels || CheckJpeg(data, static_cast<size_t>(es.size)));
+            sink_.jpegFrames++;
+            break;
+        case ENCODE_TYPE_H264:
+        case ENCODE_TYPE_H265:
+            // 3: the shortest start code; the soft encoder's access units carry no picture to compare
+            good = es.size > 3 && data[0] == 0 && data[1] == 0 && (data[2] == 1 || (data[2] == 0 && data[3] == 1));
+            break;
+        default:
+            good = CheckPicture(*buffer, comparePixels);
+            break;
+    }
+    if (es.size > 0) {
+        sink_.esBytes += static_cast<uint64_t>(es.size);
+    }
+    if (!good) {
+        sink_.badFrames++;
+    }
+    // the checks are the sink's, they are not put on the node that delivered here
+    BenchAllocCount after = GetThreadAllocs();
+    t_downstreamAllocs.calls += after.calls - allocs.calls;
+    t_downstreamAllocs.bytes += after.bytes - allocs.bytes;
+    t_downstreamNs += NowNs() - now;
+    pool_->Release(buffer->GetIndex());
+}
+
+// hands frames to the first node like the v4l2 source, paced to --fps when given
+bool PipelineBench::Source(uint32_t frames)
+{
+    uint64_t period = config_.fps == 0 ? 0 : static_cast<uint64_t>(NS_PER_S / config_.fps);
+    uint64_t start = NowNs();
+    for (uint32_t i = 0; i < frames; i++) {
+        if (period != 0) {
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+                std::chrono::nanoseconds(start + i * period)));
+        }
+        std::shared_ptr<IBuffer> buffer = pool_->Acquire(BUFFER_TIMEOUT_MS);
+        if (buffer == nullptr) {
+            fprintf(stderr, "no buffer came back in %lld ms, %u in flight\n",
+                static_cast<long long>(BUFFER_TIMEOUT_MS), pool_->InFlight());
+            return false;
+        }
+        int32_t captureId = captureId_++;
+        pool_->Prepare(buffer, STREAM_ID, captureId, NowNs());
+        if (config_.encode == ENCODE_TYPE_JPEG) {
+            for (auto& node : nodes_) {
+                node->Capture(STREAM_ID, captureId);
+            }
+        }
+        RunNode(0, buffer);
+        t_downstreamNs = 0;
+        t_downstreamAllocs = {};
+    }
+    return pool_->WaitIdle(BUFFER_TIMEOUT_MS);
+}
+
+void PipelineBench::ResetStats()
+{
+    for (auto& stats : stats_) {
+        stats->Reset();
+    }
+    sink_.Reset();
+    if (scale_ != nullptr) {
+        scaleBase_ = scale_->GetScaleTraffic();
+    }
+    if (codec_ != nullptr) {
+        rgbaCopyBase_ = codec_->GetRgbaCopyBytes(STREAM_ID);
+        videoBase_ = codec_->GetVideoPoolStats(STREAM_ID);
+        jpegBase_ = codec_->GetJpegQueueStats();
+    }
+    if (face_ != nullptr) {
+        faceBase_ = face_->GetDetectStats();
+    }
+}
+
+/*
+ * Bytes a node moves through memory per frame, estimated from what it reads and writes: RKScale's own
+ * estimate, the codec reading the stream frame and writing the access unit or the RGBA picture, the face
+ * detector sampling the luma, the Exif segment rewritten in place.
+ */
+double PipelineBench::EstimateTraffic(BenchNodeType type, uint64_t frames)
+{
+    // the nodes pass the frame on as I420 whatever the stream format
+    double frameBytes = static_cast<double>(RgaFrameSize(RgaPixelFormat::YUV420P, config_.width, config_.height));
+    double luma = static_cast<double>(config_.width) * config_.height;
+    switch (type) {
+        case BenchNodeType::SCALE:
+            return PerFrame(static_cast<double>(scale_->GetScaleTraffic().totalBytes - scaleBase_.totalBytes), frames);
+        case BenchNodeType::CODEC: {
+            if (config_.encode != ENCODE_TYPE_NULL) {
+                return frameBytes + PerFrame(static_cast<double>(sink_.esBytes), frames);
+            }
+            double copy = static_cast<double>(codec_->GetRgbaCopyBytes(STREAM_ID) - rgbaCopyBase_);
+            return frameBytes + luma * RGBA_BPP + PerFrame(2.0 * copy, frames);     // 2.0: read and write
+        }
+        case BenchNodeType::FACE:
+            return PerFrame(luma * static_cast<double>(face_->GetDetectStats().detections - faceBase_.detections),
+                frames);
+        default:
+            return PerFrame(2.0 * ExifApp1Size() * sink_.jpegFrames, frames);  // 2.0: read and write
+    }
+}
+
+std::vector<NodeReport> PipelineBench::Report(double wallNs, uint64_t frames)
+{
+    std::vector<NodeReport> reports;
+    for (size_t i = 0; i < nodes_.size(); i++) {
+        const NodeStats& stats = *stats_[i];
+        NodeReport report;
+        report.name = BenchNodeName(config_.graph[i]);
+        report.latency = stats.latency.Summarize();
+        report.meanUs = PerFrame(static_cast<double>(stats.totalNs) / NS_PER_US, stats.frames);
+        report.allocsPerFrame = PerFrame(static_cast<double>(stats.allocCalls), stats.frames);
+        report.allocBytesPerFrame = PerFrame(static_cast<double>(stats.allocBytes), stats.frames);
+        report.trafficPerFrame = EstimateTraffic(config_.graph[i], frames);
+        reports.push_back(report);
+    }
+    printf("%s: %s %ux%u %s from %ux%u %s, %u buffers, %llu frames in %.3f s\n", config_.graphName.c_str(),
+        BenchEncodeName(config_.encode), config_.width, config_.height, BenchPixelFormatName(config_.format),
+        config_.sensorWidth, config_.sensorHeight, BenchPixelFormatName(config_.sensorFormat), config_.buffers,
+        static_cast<unsigned long long>(frames), wallNs / NS_PER_S);
+    printf("  %-8s %10s %8s %8s %8s %10s %12s %12s\n", "node", "mean us", "p50", "p99", "max", "allocs/f",
+        "alloc B/f", "est MiB/f");
+    for (const NodeReport& r : reports) {
+        printf("  %-8s %10.1f %8llu %8llu %8llu %10.2f %12.0f %12.2f\n", r.name, r.meanUs,
+            static_cast<unsigned long long>(r.latency.p50Us), static_cast<unsigned long long>(r.latency.p99Us),
+            static_cast<unsigned long long>(r.latency.maxUs), r.allocsPerFrame, r.allocBytesPerFrame,
+            r.trafficPerFrame / BYTES_PER_MIB);
+    }
+    return reports;
+}
+
+void PipelineBench::PrintNodeDetails()
+{
+    if (scale_ != nullptr) {
+        ScaleTrafficStats t = scale_->GetScaleTraffic();
+        printf("  RKScale  dram estimate %.2f MiB/frame, %llu fan-outs, %llu staged copies\n",
+            PerFrame(static_cast<double>(t.totalBytes - scaleBase_.totalBytes) / BYTES_PER_MIB, t.frames -
+            scaleBase_.frames), static_cast<unsigned long long>(t.fanOuts - scaleBase_.fanOuts),
+            static_cast<unsigned long long>(t.stagedCopies - scaleBase_.stagedCopies));
+    }
+    if (codec_ != nullptr && config_.encode != ENCODE_TYPE_NULL && config_.encode != ENCODE_TYPE_JPEG) {
+        LatencySummary encode = codec_->GetLatency(STREAM_ID, LatencyStage::ENCODE);
+        VideoEncoderPoolStats v = codec_->GetVideoPoolStats(STREAM_ID);
+        printf("  RKCodec  encode p50 %llu p99 %llu us, %llu access units, %llu did not fit, %.1f KiB/frame\n",
+            static_cast<unsigned long long>(encode.p50Us), static_cast<unsigned long long>(encode.p99Us),
+            static_cast<unsigned long long>(v.esFrames - videoBase_.esFrames),
+            static_cast<unsigned long long>(v.esOverflows - videoBase_.esOverflows),
+            PerFrame(static_cast<double>(sink_.esBytes) / 1024.0, sink_.frames));  // 1024.0: KiB
+    }
+    if (codec_ != nullptr && config_.encode == ENCODE_TYPE_JPEG) {
+        WorkerPoolStats q = codec_->GetJpegQueueStats();
+        printf("  RKCodec  %.1f KiB/jpeg, %llu queued to workers, %llu blocked\n",
+            PerFrame(static_cast<double>(sink_.esBytes) / 1024.0, sink_.frames),  // 1024.0: KiB
+            static_cast<unsigned long long>(q.submitted - jpegBase_.submitted),
+            static_cast<unsigned long long>(q.blocked - jpegBase_.blocked));
+    }
+    if (face_ != nullptr) {
+        FaceDetectStats f = face_->GetDetectStats();
+        uint64_t detections = f.detections - faceBase_.detections;
+        printf("  RKFace   %llu detections, %.1f us each, %llu skipped busy, %u faces in the last\n",
+            static_cast<unsigned long long>(detections),
+            PerFrame(static_cast<double>(f.totalDetectUs - faceBase_.totalDetectUs), detections),
+            static_cast<unsigned long long>(f.skippedBusy - faceBase_.skippedBusy), f.faces);
+    }
+}
+
+void PipelineBench::WriteJson(FILE* out, const std::vector<NodeReport>& reports, double fps, double wallNs,
+    uint64_t frames, const BenchAllocCount& allocs, double memcpyGbps, bool passed)
+{
+    LatencySummary e2e = sink_.latency.Summarize();
+    fprintf(out, "{\"graph\": \"%s\", \"encode\": \"%s\", \"width\": %u, \"height\": %u, \"format\": \"%s\", "
+        "\"sensor_width\": %u, \"sensor_height\": %u, \"sensor_format\": \"%s\", \"buffers\": %u, "
+        "\"frames\": %llu, \"seconds\": %.6f,\n", config_.graphName.c_str(), BenchEncodeName(config_.encode),
+        config_.width, config_.height, BenchPixelFormatName(config_.format), config_.sensorWidth,
+        config_.sensorHeight, BenchPixelFormatName(config_.sensorFormat), config_.buffers,
+        static_cast<unsigned long long>(frames), wallNs / NS_PER_S);
+    fprintf(out, " \"fps\": %.3f, \"allocs_per_frame\": %.3f, \"alloc_bytes_per_frame\": %.1f, "
+        "\"memcpy_gb_per_s\": %.3f,\n", fps, PerFrame(static_cast<double>(allocs.calls), frames),
+        PerFrame(static_cast<double>(allocs.bytes), frames), memcpyGbps);
+    fprintf(out, " \"end_to_end_us\": {\"mean\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu},\n",
+        static_cast<unsigned long long>(e2e.meanUs), static_cast<unsigned long long>(e2e.p50Us),
+        static_cast<unsigned long long>(e2e.p90Us), static_cast<unsigned long long>(e2e.p99Us),
+        static_cast<unsigned long long>(e2e.maxUs));
+    fprintf(out, " \"nodes\": [");
+    for (size_t i = 0; i < reports.size(); i++) {
+        const NodeReport& r = reports[i];
+        fprintf(out, "%s\n  {\"name\": \"%s\", \"mean_us\": %.3f, \"p50_us\": %llu, \"p90_us\": %llu, "
+            "\"p99_us\": %llu, \"max_us\": %llu, \"allocs_per_frame\": %.3f, \"alloc_bytes_per_frame\": %.1f, "
+            "\"est_bytes_per_frame\": %.0f}", i == 0 ? "" : ",", r.name, r.meanUs,
+            static_cast<unsigned long long>(r.latency.p50Us), static_cast<unsigned long long>(r.latency.p90Us),
+            static_cast<unsigned long long>(r.latency.p99Us), static_cast<unsigned long long>(r.latency.maxUs),
+            r.allocsPerFrame, r.allocBytesPerFrame, r.trafficPerFrame);
+    }
+    fprintf(out, "],\n \"bad_frames\": %llu, \"passed\": %s}\n", static_cast<unsigned long long>(sink_.badFrames),
+        passed ? "true" : "false");
+}
+
+int PipelineBench::Run()
+{
+    std::string error;
+    if (!Setup(error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        Teardown();
+        return 1;
+    }
+    bool drained = Source(config_.warmup);
+    ResetStats();
+    BenchAllocCount allocsBefore = GetProcessAllocs();
+    uint64_t start = NowNs();
+    drained = drained && Source(config_.frames);
+    double wallNs = static_cast<double>(NowNs() - start);
+    BenchAllocCount allocsAfter = GetProcessAllocs();
+    BenchAllocCount allocs = {allocsAfter.calls - allocsBefore.calls, allocsAfter.bytes - allocsBefore.bytes};
+    uint64_t frames = sink_.frames;
+
+    std::vector<NodeReport> reports = Report(wallNs, frames);
+    double fps = wallNs > 0 ? static_cast<double>(frames) * NS_PER_S / wallNs : 0.0;
+    double traffic = 0.0;
+    for (const NodeReport& r : reports) {
+        traffic += r.trafficPerFrame;
+    }
+    double memcpyGbps = MeasureMemcpyGbps();
+    LatencySummary e2e = sink_.latency.Summarize();
+    printf("  end to end     p50 %llu  p90 %llu  p99 %llu  max %llu us\n",
+        static_cast<unsigned long long>(e2e.p50Us), static_cast<unsigned long long>(e2e.p90Us),
+        static_cast<unsigned long long>(e2e.p99Us), static_cast<unsigned long long>(e2e.maxUs));
+    printf("  throughput     %.1f frames/s, %.2f allocs and %.0f bytes allocated per frame\n", fps,
+        PerFrame(static_cast<double>(allocs.calls), frames), PerFrame(static_cast<double>(allocs.bytes), frames));
+    printf("  bandwidth      %.3f GB/s estimated for the nodes, memcpy does %.1f GB/s here\n",
+        traffic * fps / BYTES_PER_GB, memcpyGbps);
+    PrintNodeDetails();
+
+    bool passed = drained;
+    if (!drained) {
+        fprintf(stderr, "buffers were lost in the graph\n");
+    }
+    if (frames != config_.frames) {
+        fprintf(stderr, "%llu of %u frames reached the end of the graph\n", static_cast<unsigned long long>(frames),
+            config_.frames);
+        passed = false;
+    }
+    if (sink_.wrongFormat != 0) {
+        fprintf(stderr, "%llu pictures on a %s stream, the graph makes %s\n",
+            static_cast<unsigned long long>(sink_.wrongFormat), BenchPixelFormatName(config_.format),
+            BenchPixelFormatName(pictureFormat_));
+    }
+    if (sink_.badFrames != 0) {
+        fprintf(stderr, "%llu frames came out without a valid %s picture, %llu compared with the source\n",
+            static_cast<unsigned long long>(sink_.badFrames), BenchEncodeName(config_.encode),
+            static_cast<unsigned long long>(sink_.pixelChecks));
+        passed = false;
+    }
+    if (config_.gateP99Us > 0 && static_cast<double>(e2e.p99Us) > config_.gateP99Us) {
+        fprintf(stderr, "gate: end to end p99 %llu us above %.1f us\n", static_cast<unsigned long long>(e2e.p99Us),
+            config_.gateP99Us);
+        passed = false;
+    }
+    if (config_.gateFps > 0 && fps < config_.gateFps) {
+        fprintf(stderr, "gate: %.1f frames/s below %.1f\n", fps, config_.gateFps);
+        passed = false;
+    }
+    if (!config_.jsonPath.empty()) {
+        FILE* out = config_.jsonPath == "-" ? stdout : fopen(config_.jsonPath.c_str(), "w");
+        if (out == nullptr) {
+            fprintf(stderr, "cannot write %s\n", config_.jsonPath.c_str());
+            passed = false;
+        } else {
+            WriteJson(out, reports, fps, wallNs, frames, allocs, memcpyGbps, passed);
+            if (out != stdout) {
+                fclose(out);
+            }
+        }
+    }
+    Teardown();
+    return passed ? 0 : 1;
+}
+
+int RunPipelineBench(const PipelineBenchConfig& config)
+{
+    PipelineBench bench(config);
+    return bench.Run();
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * What the host build links in place of the hardware: RGA runs in rk_rga_soft_backend.cpp, the MPP jpeg
+ * encoder is libjpeg fed with the I420 planes, and the MPP video encoder is a stand-in that reads the whole
+ * frame and writes an Annex-B access unit of the size the rate control asks for. The stand-in gives the
+ * nodes around the encoder realistic work (NAL indexing, parameter sets, copies); its own cost is not that
+ * of a real encoder and is left out when comparing against the board.
+ */
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <securec.h>
+#include <vector>
+#include "pipeline_bench.h"
+#include "rk_jpeg_encoder.h"
+#include "rk_rga_session.h"
+#include "rk_video_encoder.h"
+
+extern "C" {
+#include <jpeglib.h>
+}
+
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t MCU_SIZE = 16;           // 4:2:0, two 8x8 blocks each way
+constexpr uint32_t CHROMA_DIV = 2;
+constexpr int32_t SOFT_ENC_FPS = 30;        // the rate control has no frame rate, the board streams run at 30
+constexpr int32_t KEY_FRAME_SCALE = 4;      // an IDR costs about as much as four P frames
+constexpr int32_t BITS_PER_BYTE = 8;
+constexpr uint8_t H264_SPS = 0x67;          // nal_ref_idc 3 and the type
+constexpr uint8_t H264_PPS = 0x68;
+constexpr uint8_t H264_IDR = 0x65;
+constexpr uint8_t H264_SLICE = 0x41;        // nal_ref_idc 2, non-IDR slice
+constexpr uint8_t H265_VPS = 32;
+constexpr uint8_t H265_SPS = 33;
+constexpr uint8_t H265_PPS = 34;
+constexpr uint8_t H265_IDR_W_RADL = 19;
+constexpr uint8_t H265_TRAIL_R = 1;
+constexpr size_t PARAMETER_SET_PAYLOAD = 12;
+const uint8_t START_CODE[] = {0, 0, 0, 1};
+
+struct JpegErrorJump {
+    struct jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+
+void JpegErrorExit(j_common_ptr info)
+{
+    longjmp(reinterpret_cast<JpegErrorJump*>(info->err)->jump, 1);
+}
+
+// the rows of one MCU band, copied out when the width is not a whole number of MCUs as libjpeg reads whole blocks
+struct RawBand {
+    JSAMPROW rows[3][MCU_SIZE];     // 3: y u v
+    std::vector<uint8_t> padded;
+};
+
+void FillBand(const uint8_t* const planes[3], const int32_t strides[3], uint32_t width, uint32_t height, uint32_t row,
+    RawBand& band)
+{
+    uint32_t paddedWidth = (width + MCU_SIZE - 1) / MCU_SIZE * MCU_SIZE;
+    bool pad = paddedWidth != width;
+    if (pad) {
+        band.padded.resize(static_cast<size_t>(paddedWidth) * (MCU_SIZE + MCU_SIZE));   // 16 luma, 2 x 8 chroma
+    }
+    uint8_t* scratch = band.padded.data();
+    for (uint32_t plane = 0; plane < 3; plane++) {      // 3: y u v
+        uint32_t div = plane == 0 ? 1 : CHROMA_DIV;
+        uint32_t rows = MCU_SIZE / div;
+        uint32_t planeWidth = (width + div - 1) / div;
+        uint32_t planeHeight = (height + div - 1) / div;
+        for (uint32_t i = 0; i < rows; i++) {
+            uint32_t y = std::min(row / div + i, planeHeight - 1);
+            const uint8_t* src = planes[plane] + static_cast<size_t>(y) * strides[plane];
+            if (!pad) {
+                band.rows[plane][i] = const_cast<uint8_t*>(src);
+                continue;
+            }
+            uint32_t paddedPlane = paddedWidth / div;
+            memcpy(scratch, src, planeWidth);
+            memset(scratch + planeWidth, src[planeWidth - 1], paddedPlane - planeWidth);
+            band.rows[plane][i] = scratch;
+            scratch += paddedPlane;
+        }
+    }
+}
+
+class SoftMppJpegEncoder : public IJpegEncoder {
+public:
+    JpegBackendType GetType() const override
+    {
+        return JpegBackendType::MPP;
+    }
+
+    const char* GetName() const override
+    {
+        return "mpp (soft)";
+    }
+
+    int32_t Encode(const JpegInput& in, JpegOutput& out) override
+    {
+        if (in.yuv == nullptr || out.data == nullptr) {
+            return -1;
+        }
+        uint32_t ws = in.wstride == 0 ? in.width : in.wstride;
+        uint32_t hs = in.hstride == 0 ? in.height : in.hstride;
+        const uint8_t* planes[3];   // 3: y u v
+        planes[0] = in.yuv;
+        planes[1] = in.yuv + static_cast<size_t>(ws) * hs;
+        planes[2] = planes[1] + static_cast<size_t>(ws / CHROMA_DIV) * (hs / CHROMA_DIV);
+        int32_t strides[3] = {static_cast<int32_t>(ws), static_cast<int32_t>(ws / CHROMA_DIV),
+            static_cast<int32_t>(ws / CHROMA_DIV)};
+        return EncodeI420Jpeg(planes, strides, in.width, in.height, in.quality, out.data, out.capacity, out.size);
+    }
+};
+
+class SoftVideoEncoder : public IVideoEncoder {
+public:
+    SoftVideoEncoder(NalCodec codec, uint32_t width, uint32_t height)
+        : codec_(codec), width_(width), height_(height)
+    {
+        size_t frameBytes = static_cast<size_t>(width) * height * 3 / CHROMA_DIV;     // 3 / 2: I420
+        es_.reserve(frameBytes);
+        blocks_.reserve(static_cast<size_t>((width + MCU_SIZE - 1) / MCU_SIZE) * ((height + MCU_SIZE - 1) / MCU_SIZE));
+    }
+
+    bool SetRateControl(const VideoRateControl& rc) override
+    {
+        rc_ = rc;
+        return true;
+    }
+
+    int32_t Encode(const VideoFrame& frame, size_t& esSize) override
+    {
+        esSize = 0;
+        size_t frameBytes = static_cast<size_t>(width_) * height_ * 3 / CHROMA_DIV;  // 3 / 2: I420
+        if (frame.addr == nullptr || frame.size < frameBytes) {
+            return -1;
+        }
+        bool key = rc_.gop <= 0 ? frames_ == 0 : frames_ % static_cast<uint64_t>(rc_.gop) == 0;
+        SummarizeBlocks(frame.addr);
+
+        es_.clear();
+        if (key) {
+            AppendParameterSets();
+        }
+        AppendNal(key ? (codec_ == NalCodec::H264 ? H264_IDR : H265_IDR_W_RADL) :
+            (codec_ == NalCodec::H264 ? H264_SLICE : H265_TRAIL_R));
+        size_t target = static_cast<size_t>(std::max(rc_.bpsTarget, 0)) / BITS_PER_BYTE / SOFT_ENC_FPS;
+        target = std::min(target * (key ? KEY_FRAME_SCALE : 1), es_.capacity() - es_.size());
+        // no zero bytes, so nothing in the payload looks like a start code
+        for (size_t i = 0; i < target; i++) {
+            es_.push_back(static_cast<uint8_t>(blocks_[i % blocks_.size()] ^ (i * 131)) | 1);   // 131: spreads it
+        }
+
+        frames_++;
+        if (memcpy_s(frame.addr, frame.size, es_.data(), es_.size()) != 0) {
+            stats_.esOverflows++;
+            return -1;
+        }
+        stats_.esFrames++;
+        esSize = es_.size();
+        return 0;
+    }
+
+    VideoEncoderPoolStats GetPoolStats() override
+    {
+        return stats_;
+    }
+
+private:
+    // mean of every 16x16 luma block and a pass over the chroma, about what motion estimation reads
+    void SummarizeBlocks(const uint8_t* frame)
+    {
+        blocks_.clear();
+        for (uint32_t by = 0; by < height_; by += MCU_SIZE) {
+            for (uint32_t bx = 0; bx < width_; bx += MCU_SIZE) {
+                uint32_t sum = 0;
+                uint32_t count = 0;
+                for (uint32_t y = by; y < std::min(by + MCU_SIZE, height_); y++) {
+                    const uint8_t* row = frame + static_cast<size_t>(y) * width_;
+                    for (uint32_t x = bx; x < std::min(bx + MCU_SIZE, width_); x++) {
+                        sum += row[x];
+                        count++;
+                    }
+                }
+                blocks_.push_back(static_cast<uint8_t>(sum / count));
+            }
+        }
+        const uint8_t* chroma = frame + static_cast<size_t>(width_) * height_;
+        size_t chromaBytes = static_cast<size_t>(width_) * height_ / CHROMA_DIV;
+        uint8_t mix = 0;
+        for (size_t i = 0; i < chromaBytes; i++) {
+            mix ^= chroma[i];
+        }
+        blocks_[0] ^= mix;
+    }
+
+    void AppendNal(uint8_t type)
+    {
+        es_.insert(es_.end(), START_CODE, START_CODE + sizeof(START_CODE));
+        if (codec_ == NalCodec::H264) {
+            es_.push_back(type);
+        } else {
+            es_.push_back(static_cast<uint8_t>(type << 1));
+            es_.push_back(1);   // 1: nuh_temporal_id_plus1
+        }
+    }
+
+    void AppendParameterSets()
+    {
+        std::vector<uint8_t> types = codec_ == NalCodec::H264 ? std::vector<uint8_t> {H264_SPS, H264_PPS} :
+            std::vector<uint8_t> {H265_VPS, H265_SPS, H265_PPS};
+        for (uint8_t type : types) {
+            AppendNal(type);
+            for (size_t i = 0; i < PARAMETER_SET_PAYLOAD; i++) {
+                es_.push_back(static_cast<uint8_t>(type + i + width_ + height_) | 1);
+            }
+        }
+    }
+
+    NalCodec codec_;
+    uint32_t width_;
+    uint32_t height_;
+    VideoRateControl rc_;
+    uint64_t frames_ = 0;
+    std::vector<uint8_t> es_;
+    std::vector<uint8_t> blocks_;
+    VideoEncoderPoolStats stats_;
+};
+} // namespace
+
+int32_t EncodeI420Jpeg(const uint8_t* const planes[3], const int32_t strides[3], uint32_t width, uint32_t height,
+    uint32_t quality, uint8_t* out, size_t capacity, size_t& size)
+{
+    static thread_local RawBand band;
+    struct jpeg_compress_struct info;
+    JpegErrorJump error;
+    unsigned char* jpegBuf = out;
+    unsigned long jpegSize = capacity;
+    info.err = jpeg_std_error(&error.mgr);
+    error.mgr.error_exit = JpegErrorExit;
+    jpeg_create_compress(&info);
+    if (setjmp(error.jump) != 0) {
+        jpeg_destroy_compress(&info);
+        if (jpegBuf != out) {
+            free(jpegBuf);
+        }
+        return -1;
+    }
+    jpeg_mem_dest(&info, &jpegBuf, &jpegSize);
+    info.image_width = width;
+    info.image_height = height;
+    info.input_components = 3;  // 3: y u v
+    info.in_color_space = JCS_YCbCr;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, static_cast<int>(quality), TRUE);
+    info.raw_data_in = TRUE;
+    info.dct_method = JDCT_IFAST;
+    info.comp_info[0].h_samp_factor = CHROMA_DIV;
+    info.comp_info[0].v_samp_factor = CHROMA_DIV;
+    for (int32_t c = 1; c < 3; c++) {   // 3: y u v
+        info.comp_info[c].h_samp_factor = 1;
+        info.comp_info[c].v_samp_factor = 1;
+    }
+    jpeg_start_compress(&info, TRUE);
+    JSAMPARRAY data[3] = {band.rows[0], band.rows[1], band.rows[2]};    // 2: v
+    for (uint32_t row = 0; row < height; row += MCU_SIZE) {
+        FillBand(planes, strides, width, height, row, band);
+        jpeg_write_raw_data(&info, data, MCU_SIZE);
+    }
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+
+    int32_t ret = 0;
+    if (jpegBuf != out) {
+        // libjpeg ran out of the output and moved to its own allocation
+        ret = memcpy_s(out, capacity, jpegBuf, jpegSize) == 0 ? 0 : -1;
+        free(jpegBuf);
+    }
+    size = ret == 0 ? jpegSize : 0;
+    return ret;
+}
+
+bool DecodeJpegYcc(const uint8_t* data, size_t size, std::vector<uint8_t>& ycc, uint32_t& width, uint32_t& height)
+{
+    struct jpeg_decompress_struct info;
+    JpegErrorJump error;
+    info.err = jpeg_std_error(&error.mgr);
+    error.mgr.error_exit = JpegErrorExit;
+    jpeg_create_decompress(&info);
+    if (setjmp(error.jump) != 0) {
+        jpeg_destroy_decompress(&info);
+        return false;
+    }
+    jpeg_mem_src(&info, data, static_cast<unsigned long>(size));
+    jpeg_read_header(&info, TRUE);
+    info.out_color_space = JCS_YCbCr;
+    jpeg_start_decompress(&info);
+    width = info.output_width;
+    height = info.output_height;
+    size_t rowBytes = static_cast<size_t>(width) * 3;   // 3: y cb cr
+    ycc.resize(rowBytes * height);
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW row = ycc.data() + rowBytes * info.output_scanline;
+        jpeg_read_scanlines(&info, &row, 1);
+    }
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    return true;
+}
+
+std::shared_ptr<IRgaBackend> CreateRgaHwBackend()
+{
+    return CreateRgaSoftBackend();
+}
+
+std::unique_ptr<IJpegEncoder> CreateMppJpegEncoder()
+{
+    return std::make_unique<SoftMppJpegEncoder>();
+}
+
+std::unique_ptr<IVideoEncoder> CreateMppVideoEncoder(NalCodec codec, uint32_t width, uint32_t height)
+{
+    return std::make_unique<SoftVideoEncoder>(codec, width, height);
+}
+} // namespace OHOS::Camera
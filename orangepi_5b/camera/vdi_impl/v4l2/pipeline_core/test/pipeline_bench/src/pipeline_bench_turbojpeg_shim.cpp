@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <turbojpeg.h>
+#include <cstdlib>
+#include "pipeline_bench.h"
+
+// the TurboJPEG calls of rk_jpeg_encoder.cpp on plain libjpeg, see host/turbojpeg/turbojpeg.h
+namespace {
+constexpr int MCU_SIZE = 16;
+constexpr unsigned long HEADER_BYTES = 2048;    // 2048: markers and tables, as tjBufSize() reserves
+constexpr int YUV_PLANES = 3;
+char g_noPlanes[] = "only 4:2:0 planes with TJFLAG_NOREALLOC";
+char g_encodeFailed[] = "libjpeg failed or the jpeg did not fit";
+
+struct ShimHandle {
+    char* error = nullptr;
+};
+} // namespace
+
+extern "C" {
+tjhandle tjInitCompress(void)
+{
+    return new ShimHandle;
+}
+
+int tjDestroy(tjhandle handle)
+{
+    delete static_cast<ShimHandle*>(handle);
+    return 0;
+}
+
+unsigned long tjBufSize(int width, int height, int jpegSubsamp)
+{
+    if (width <= 0 || height <= 0 || jpegSubsamp != TJSAMP_420) {
+        return static_cast<unsigned long>(-1);
+    }
+    unsigned long mcuWidth = (static_cast<unsigned long>(width) + MCU_SIZE - 1) / MCU_SIZE * MCU_SIZE;
+    unsigned long mcuHeight = (static_cast<unsigned long>(height) + MCU_SIZE - 1) / MCU_SIZE * MCU_SIZE;
+    return mcuWidth * mcuHeight * YUV_PLANES + HEADER_BYTES;
+}
+
+int tjCompressFromYUVPlanes(tjhandle handle, const unsigned char** srcPlanes, int width, const int* strides,
+    int height, int subsamp, unsigned char** jpegBuf, unsigned long* jpegSize, int jpegQual, int flags)
+{
+    ShimHandle* shim = static_cast<ShimHandle*>(handle);
+    if (shim == nullptr || srcPlanes == nullptr || strides == nullptr || jpegBuf == nullptr ||
+        *jpegBuf == nullptr || jpegSize == nullptr || subsamp != TJSAMP_420 || (flags & TJFLAG_NOREALLOC) == 0) {
+        if (shim != nullptr) {
+            shim->error = g_noPlanes;
+        }
+        return -1;
+    }
+    size_t size = 0;
+    if (OHOS::Camera::EncodeI420Jpeg(srcPlanes, strides, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+        static_cast<uint32_t>(jpegQual), *jpegBuf, *jpegSize, size) != 0) {
+        shim->error = g_encodeFailed;
+        return -1;
+    }
+    *jpegSize = size;
+    return 0;
+}
+
+char* tjGetErrorStr2(tjhandle handle)
+{
+    ShimHandle* shim = static_cast<ShimHandle*>(handle);
+    return shim != nullptr && shim->error != nullptr ? shim->error : g_encodeFailed;
+}
+} // extern "C"
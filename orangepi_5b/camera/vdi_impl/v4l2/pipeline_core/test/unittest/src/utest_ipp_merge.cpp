@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "ipp_merge_compose.h"
+#include "ipp_merge_kernels.h"
+#include "ipp_merge_pool.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr uint8_t PADDING = 0xee;
+constexpr uint32_t WEIGHTS[] = {0, 1, 77, 128, 255, 256, 300};
+
+struct Picture {
+    std::vector<uint8_t> bytes;
+    IppMergeImage image = {};
+};
+
+uint32_t RowBytes(uint32_t width, IppMergeFormat format)
+{
+    return format == IPP_MERGE_YUYV ? width * 2 : width;    // 2: bytes of a packed 4:2:2 pixel
+}
+
+uint32_t Rows(uint32_t height, IppMergeFormat format)
+{
+    return format == IPP_MERGE_NV12 ? height + height / 2 : height;
+}
+
+Picture MakePicture(uint32_t width, uint32_t height, uint32_t stride, IppMergeFormat format)
+{
+    Picture p;
+    p.bytes.assign(static_cast<size_t>(stride) * Rows(height, format), PADDING);
+    p.image = {p.bytes.data(), width, height, stride, static_cast<uint32_t>(p.bytes.size())};
+    return p;
+}
+
+// every pixel the same colour, the padding past the row left as it is
+void Fill(Picture& p, IppMergeFormat format, uint8_t y, uint8_t u, uint8_t v)
+{
+    uint32_t rowBytes = RowBytes(p.image.width, format);
+    for (uint32_t r = 0; r < Rows(p.image.height, format); r++) {
+        uint8_t* row = p.bytes.data() + r * p.image.stride;
+        for (uint32_t i = 0; i < rowBytes; i++) {
+            if (format == IPP_MERGE_YUYV) {
+                const uint8_t macropixel[] = {y, u, y, v};
+                row[i] = macropixel[i % 4];     // 4: Y U Y V
+            } else {
+                row[i] = r < p.image.height ? y : (i % 2 == 0 ? u : v);
+            }
+        }
+    }
+}
+
+void FillRandom(std::vector<uint8_t>& bytes, uint32_t& seed)
+{
+    for (auto& b : bytes) {
+        seed = seed * 1103515245 + 12345;   // 1103515245, 12345: lcg
+        b = static_cast<uint8_t>(seed >> 16);   // 16: the better bits
+    }
+}
+
+uint8_t At(const Picture& p, uint32_t row, uint32_t byte)
+{
+    return p.bytes[static_cast<size_t>(row) * p.image.stride + byte];
+}
+
+int Merge(IppMergeLayout layout, const IppMergeImage& out, const IppMergeImage& a, const IppMergeImage& b,
+    IppMergeFormat format, IppMergeScratch& scratch)
+{
+    if (layout == IPP_MERGE_SIDE_BY_SIDE) {
+        return IppMergeSideBySide(&out, &a, &b, format, &scratch);
+    } else if (layout == IPP_MERGE_PICTURE_IN_PICTURE) {
+        return IppMergePictureInPicture(&out, &a, &b, format, &scratch);
+    }
+    return IppMergeBlend(&out, &a, &b, format, 96);     // 96: any weight off the end points
+}
+
+struct BandRun {
+    const IppMergePlan* plan;
+    uint32_t phase;
+    uint32_t bandRows;
+    uint8_t* scratch;
+};
+
+void RunBand(void* context, uint32_t band, uint32_t worker)
+{
+    const BandRun* run = static_cast<const BandRun*>(context);
+    IppMergeRunBand(run->plan, run->phase, band * run->bandRows, (band + 1) * run->bandRows,
+        run->scratch + worker * run->plan->bandScratch);
+}
+
+// the merge in bands of bandRows on the pool, or backwards on this thread without one
+int MergeInBands(IppMergeLayout layout, const IppMergeImage& out, const IppMergeImage& a, const IppMergeImage& b,
+    IppMergeFormat format, uint32_t bandRows, IppMergePool* pool)
+{
+    IppMergePlan plan;
+    if (IppMergePlanMerge(&plan, layout, format, &out, &a, &b, 96) != 0) {     // 96: as Merge
+        return -1;
+    }
+    uint32_t threads = IppMergePoolThreads(pool);
+    std::vector<uint8_t> scratch(plan.bandScratch * threads + plan.sharedScratch + 1);
+    plan.shared = scratch.data() + plan.bandScratch * threads;
+    BandRun run = {&plan, 0, bandRows, scratch.data()};
+    uint32_t bands = (out.height + bandRows - 1) / bandRows;
+    for (run.phase = 0; run.phase < plan.phases; run.phase++) {
+        if (pool != nullptr) {
+            IppMergePoolRun(pool, bands, RunBand, &run);
+            continue;
+        }
+        for (uint32_t band = bands; band > 0; band--) {
+            RunBand(&run, band - 1, 0);
+        }
+    }
+    return 0;
+}
+} // namespace
+
+HWTEST(UtestIppMerge, KernelsMatchScalar, TestSize.Level0)
+{
+    // one group of 16 counting bytes shows which two bytes each pairing averages
+    uint8_t group[16];
+    for (uint8_t i = 0; i < sizeof(group); i++) {
+        group[i] = i;
+    }
+    const uint8_t expected[IPP_MERGE_PAIR_COUNT][8] = {
+        {1, 3, 5, 7, 9, 11, 13, 15},
+        {1, 2, 5, 6, 9, 10, 13, 14},
+        {1, 3, 5, 5, 9, 11, 13, 13},
+    };
+    uint8_t half[8];
+    for (int pairing = 0; pairing < IPP_MERGE_PAIR_COUNT; pairing++) {
+        IppMergeHalveRowScalar(half, group, sizeof(group), static_cast<IppMergePairing>(pairing));
+        EXPECT_EQ(0, memcmp(expected[pairing], half, sizeof(half))) << pairing;
+    }
+
+    uint32_t seed = 7;
+    std::vector<uint8_t> a(1024);
+    std::vector<uint8_t> b(1024);
+    FillRandom(a, seed);
+    FillRandom(b, seed);
+    for (int pairing = 0; pairing < IPP_MERGE_PAIR_COUNT; pairing++) {
+        IppMergePairing pair = static_cast<IppMergePairing>(pairing);
+        size_t period = IppMergePairingPeriod(pair);
+        for (size_t bytes = period; bytes <= 264; bytes += period) {    // 264: a few vector steps and every tail
+            std::vector<uint8_t> scalar(bytes / 2);
+            std::vector<uint8_t> simd(bytes / 2);
+            IppMergeHalveRowScalar(scalar.data(), a.data(), bytes, pair);
+            IppMergeHalveRowSimd(simd.data(), a.data(), bytes, pair);
+            ASSERT_EQ(scalar, simd) << IppMergeSimdName() << " pairing " << pairing << " bytes " << bytes;
+            std::vector<uint8_t> inPlace(a.begin(), a.begin() + bytes);
+            IppMergeHalveRowSimd(inPlace.data(), inPlace.data(), bytes, pair);
+            ASSERT_EQ(0, memcmp(scalar.data(), inPlace.data(), scalar.size())) << pairing << " " << bytes;
+        }
+    }
+    for (size_t bytes = 0; bytes <= 100; bytes++) {
+        std::vector<uint8_t> scalar(bytes);
+        std::vector<uint8_t> simd(bytes);
+        IppMergeAverageRowsScalar(scalar.data(), a.data(), b.data(), bytes);
+        IppMergeAverageRowsSimd(simd.data(), a.data(), b.data(), bytes);
+        ASSERT_EQ(scalar, simd) << bytes;
+        for (uint32_t weight : WEIGHTS) {
+            IppMergeBlendRowScalar(scalar.data(), a.data(), b.data(), bytes, weight);
+            IppMergeBlendRowSimd(simd.data(), a.data(), b.data(), bytes, weight);
+            ASSERT_EQ(scalar, simd) << bytes << " weight " << weight;
+        }
+    }
+    IppMergeBlendRowSimd(half, group, group + 8, sizeof(half), 256);    // 256: all of the second
+    EXPECT_EQ(0, memcmp(group + 8, half, sizeof(half)));
+}
+
+HWTEST(UtestIppMerge, SideBySideHalvesBothPictures, TestSize.Level0)
+{
+    constexpr uint32_t width = 16;
+    constexpr uint32_t height = 8;
+    IppMergeScratch scratch = {nullptr, 0};
+    for (IppMergeFormat format : {IPP_MERGE_YUYV, IPP_MERGE_NV12}) {
+        uint32_t rowBytes = RowBytes(width, format);
+        uint32_t stride = rowBytes + 8;     // 8: padding that has to stay untouched
+        Picture left = MakePicture(width, height, stride, format);
+        Picture right = MakePicture(width, height, stride, format);
+        Picture out = MakePicture(width, height, stride, format);
+        Fill(left, format, 10, 20, 30);
+        Fill(right, format, 100, 110, 120);
+        ASSERT_EQ(0, IppMergeSideBySide(&out.image, &left.image, &right.image, format, &scratch));
+        for (uint32_t r = 0; r < Rows(height, format); r++) {
+            for (uint32_t i = 0; i < stride; i++) {
+                uint8_t want = i < rowBytes / 2 ? At(left, r, i) : (i < rowBytes ? At(right, r, i) : PADDING);
+                ASSERT_EQ(want, At(out, r, i)) << format << " row " << r << " byte " << i;
+            }
+        }
+    }
+
+    // a horizontal ramp: each output pixel is the rounded mean of the two it covers
+    Picture ramp = MakePicture(width, height, width, IPP_MERGE_NV12);
+    for (uint32_t x = 0; x < width; x++) {
+        ramp.bytes[x] = static_cast<uint8_t>(x * 3);  // 3: odd steps so the rounding shows
+    }
+    Picture out = MakePicture(width, height, width, IPP_MERGE_NV12);
+    ASSERT_EQ(0, IppMergeSideBySide(&out.image, &ramp.image, &ramp.image, IPP_MERGE_NV12, &scratch));
+    for (uint32_t x = 0; x < width / 2; x++) {
+        EXPECT_EQ((x * 12 + 3 + 1) / 2, out.bytes[x]);   // (3 * 2x + 3 * (2x + 1) + 1) / 2
+    }
+    IppMergeReleaseScratch(&scratch);
+}
+
+HWTEST(UtestIppMerge, PictureInPictureInsetsTheSecond, TestSize.Level0)
+{
+    constexpr uint32_t width = 64;
+    constexpr uint32_t height = 32;
+    constexpr uint32_t stride = 72;
+    uint32_t x = 0;
+    uint32_t y = 0;
+    IppMergeInsetOrigin(width, height, &x, &y);
+    EXPECT_EQ(28u, x);      // 28: 64 / 2 less a margin of 4
+    EXPECT_EQ(16u, y);
+
+    IppMergeScratch scratch = {nullptr, 0};
+    Picture base = MakePicture(width, height, stride, IPP_MERGE_NV12);
+    Picture inset = MakePicture(width, height, stride, IPP_MERGE_NV12);
+    Picture out = MakePicture(width, height, stride, IPP_MERGE_NV12);
+    Fill(base, IPP_MERGE_NV12, 10, 20, 30);
+    Fill(inset, IPP_MERGE_NV12, 100, 110, 120);
+    ASSERT_EQ(0, IppMergePictureInPicture(&out.image, &base.image, &inset.image, IPP_MERGE_NV12, &scratch));
+    for (uint32_t r = 0; r < height + height / 2; r++) {
+        bool chroma = r >= height;
+        uint32_t top = chroma ? height + y / 2 : y;
+        uint32_t rows = chroma ? height / 4 : height / 2;
+        for (uint32_t i = 0; i < stride; i++) {
+            bool inside = r >= top && r < top + rows && i >= x && i < x + width / 2;
+            uint8_t want = i >= width ? PADDING : (inside ? At(inset, r, i) : At(base, r, i));
+            ASSERT_EQ(want, At(out, r, i)) << "row " << r << " byte " << i;
+        }
+    }
+    IppMergeReleaseScratch(&scratch);
+}
+
+HWTEST(UtestIppMerge, InPlaceMatchesACopy, TestSize.Level0)
+{
+    constexpr uint32_t width = 48;
+    constexpr uint32_t height = 16;
+    IppMergeScratch scratch = {nullptr, 0};
+    uint32_t seed = 11;
+    for (IppMergeFormat format : {IPP_MERGE_YUYV, IPP_MERGE_NV12}) {
+        uint32_t stride = RowBytes(width, format) + 16;     // 16: padding
+        Picture a = MakePicture(width, height, stride, format);
+        Picture b = MakePicture(width, height, stride, format);
+        FillRandom(a.bytes, seed);
+        FillRandom(b.bytes, seed);
+        for (IppMergeLayout layout : {IPP_MERGE_SIDE_BY_SIDE, IPP_MERGE_PICTURE_IN_PICTURE, IPP_MERGE_BLEND}) {
+            Picture reference = MakePicture(width, height, stride, format);
+            reference.bytes = a.bytes;  // the padding of an in place output is the input's
+            ASSERT_EQ(0, Merge(layout, reference.image, a.image, b.image, format, scratch));
+
+            Picture first = a;
+            first.image.addr = first.bytes.data();
+            Picture second = b;
+            second.image.addr = second.bytes.data();
+            ASSERT_EQ(0, Merge(layout, first.image, first.image, b.image, format, scratch));
+            EXPECT_EQ(reference.bytes, first.bytes) << format << " layout " << layout << " over the first";
+            first.bytes = a.bytes;
+            ASSERT_EQ(0, Merge(layout, second.image, first.image, second.image, format, scratch));
+            // second kept its own padding
+            for (uint32_t r = 0; r < Rows(height, format); r++) {
+                ASSERT_EQ(0, memcmp(&reference.bytes[r * stride], &second.bytes[r * stride], RowBytes(width, format)))
+                    << format << " layout " << layout << " over the second, row " << r;
+            }
+        }
+    }
+    IppMergeReleaseScratch(&scratch);
+}
+
+HWTEST(UtestIppMerge, RejectsWhatDoesNotFit, TestSize.Level0)
+{
+    IppMergeScratch scratch = {nullptr, 0};
+    Picture a = MakePicture(16, 8, 32, IPP_MERGE_YUYV);
+    Picture b = MakePicture(16, 8, 32, IPP_MERGE_YUYV);
+    EXPECT_EQ(0, IppMergeCheckImage(&a.image, IPP_MERGE_YUYV));
+    EXPECT_EQ(-1, IppMergeCheckImage(nullptr, IPP_MERGE_YUYV));
+
+    Picture bad = a;
+    bad.image.addr = bad.bytes.data();
+    bad.image.width = 18;   // 18: off the 4 pixel grid
+    EXPECT_EQ(-1, IppMergeCheckImage(&bad.image, IPP_MERGE_YUYV));
+    bad.image.width = 16;
+    bad.image.stride = 24;  // 24: shorter than a 16 pixel packed row
+    EXPECT_EQ(-1, IppMergeCheckImage(&bad.image, IPP_MERGE_YUYV));
+    bad.image.stride = 32;
+    EXPECT_EQ(-1, IppMergeCheckImage(&bad.image, IPP_MERGE_NV12));     // room for the luma only
+    EXPECT_EQ(-1, IppMergeCheckImage(&bad.image, static_cast<IppMergeFormat>(7)));
+
+    bad.image.height = 4;
+    EXPECT_EQ(-1, IppMergeSideBySide(&a.image, &bad.image, &b.image, IPP_MERGE_YUYV, &scratch));
+    EXPECT_EQ(-1, IppMergeBlend(&a.image, &a.image, &bad.image, IPP_MERGE_YUYV, 128));
+    // the same memory read with another stride
+    Picture wide = MakePicture(16, 8, 40, IPP_MERGE_YUYV);
+    IppMergeImage narrow = wide.image;
+    narrow.stride = 32;
+    EXPECT_EQ(0, IppMergeCopy(&narrow, &b.image, IPP_MERGE_YUYV));
+    EXPECT_EQ(-1, IppMergeCopy(&wide.image, &narrow, IPP_MERGE_YUYV));
+    IppMergeReleaseScratch(&scratch);
+}
+
+HWTEST(UtestIppMerge, BandsMatchOnePiece, TestSize.Level0)
+{
+    constexpr uint32_t width = 64;
+    constexpr uint32_t height = 40;
+    IppMergeScratch scratch = {nullptr, 0};
+    IppMergePool* pool = IppMergePoolCreate(4, nullptr, 0);    // 4: the A76 cores
+    ASSERT_NE(nullptr, pool);
+    uint32_t seed = 13;
+    for (IppMergeFormat format : {IPP_MERGE_YUYV, IPP_MERGE_NV12}) {
+        uint32_t stride = RowBytes(width, format) + 8;  // 8: padding
+        Picture a = MakePicture(width, height, stride, format);
+        Picture b = MakePicture(width, height, stride, format);
+        FillRandom(a.bytes, seed);
+        FillRandom(b.bytes, seed);
+        for (IppMergeLayout layout : {IPP_MERGE_SIDE_BY_SIDE, IPP_MERGE_PICTURE_IN_PICTURE, IPP_MERGE_BLEND,
+            IPP_MERGE_COPY}) {
+            // into a picture of its own, over the first input and over the second
+            for (int target = 0; target < 3; target++) {    // 3: the three outputs
+                Picture reference = target == 2 ? b : a;    // 2: over the second
+                reference.image.addr = reference.bytes.data();
+                Picture refFirst = a;
+                refFirst.image.addr = target == 1 ? reference.image.addr : refFirst.bytes.data();
+                Picture refSecond = b;
+                refSecond.image.addr = target == 2 ? reference.image.addr : refSecond.bytes.data();
+                int ret = layout == IPP_MERGE_COPY ? IppMergeCopy(&reference.image, &refFirst.image, format) :
+                    Merge(layout, reference.image, refFirst.image, refSecond.image, format, scratch);
+                ASSERT_EQ(0, ret);
+
+                for (uint32_t bandRows : {4u, 8u, 12u, 64u}) {
+                    for (IppMergePool* p : {static_cast<IppMergePool*>(nullptr), pool}) {
+                        Picture out = target == 2 ? b : a;
+                        out.image.addr = out.bytes.data();
+                        Picture first = a;
+                        first.image.addr = target == 1 ? out.image.addr : first.bytes.data();
+                        Picture second = b;
+                        second.image.addr = target == 2 ? out.image.addr : second.bytes.data();
+                        ASSERT_EQ(0, MergeInBands(layout, out.image, first.image, second.image, format, bandRows, p));
+                        ASSERT_EQ(reference.bytes, out.bytes) << format << " layout " << layout << " target " <<
+                            target << " bands of " << bandRows << (p != nullptr ? " on the pool" : " backwards");
+                    }
+                }
+            }
+        }
+    }
+    IppMergePoolDestroy(pool);
+    IppMergeReleaseScratch(&scratch);
+}
+
+HWTEST(UtestIppMerge, PoolRunsEveryBandOnce, TestSize.Level0)
+{
+    constexpr uint32_t bands = 1000;
+    struct Tally {
+        std::atomic<uint32_t> runs[bands];
+        std::atomic<uint32_t> badWorker;
+        uint32_t threads;
+    };
+    for (uint32_t threads : {1u, 2u, 4u, 7u}) {
+        IppMergePool* pool = IppMergePoolCreate(threads, nullptr, 0);
+        ASSERT_NE(nullptr, pool);
+        EXPECT_EQ(threads, IppMergePoolThreads(pool));
+        Tally tally;
+        tally.threads = threads;
+        // several runs in a row, and empty ones, reuse the same workers
+        for (uint32_t count : {bands, 0u, 1u, bands}) {
+            for (auto& r : tally.runs) {
+                r = 0;
+            }
+            tally.badWorker = 0;
+            IppMergePoolRun(pool, count, [](void* context, uint32_t band, uint32_t worker) {
+                Tally* t = static_cast<Tally*>(context);
+                t->runs[band]++;
+                if (worker >= t->threads) {
+                    t->badWorker++;
+                }
+            }, &tally);
+            for (uint32_t i = 0; i < bands; i++) {
+                ASSERT_EQ(i < count ? 1u : 0u, tally.runs[i].load()) << threads << " threads, band " << i;
+            }
+            EXPECT_EQ(0u, tally.badWorker.load());
+        }
+        IppMergePoolDestroy(pool);
+    }
+    EXPECT_EQ(nullptr, IppMergePoolCreate(0, nullptr, 0));
+
+    uint32_t cpus[IPP_MERGE_POOL_MAX_THREADS];
+    uint32_t count = IppMergeBigCores(cpus, IPP_MERGE_POOL_MAX_THREADS);
+    EXPECT_LE(count, static_cast<uint32_t>(IPP_MERGE_POOL_MAX_THREADS));
+    EXPECT_TRUE(std::is_sorted(cpus, cpus + count));
+}
+} // namespace OHOS::Camera
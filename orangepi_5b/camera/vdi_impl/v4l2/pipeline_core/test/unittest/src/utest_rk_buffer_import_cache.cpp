@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <set>
+
+#include "rk_buffer_import_cache.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr size_t CACHE_SIZE = 4;
+constexpr size_t FRAME_SIZE = 1920 * 1080 * 3 / 2;
+
+// hands out fake handles and tracks which are still imported
+class FakeImporter {
+public:
+    RKBufferImportCache::ImportFunc Importer()
+    {
+        return [this](const ImportKey& key) -> void* {
+            imports++;
+            if (fail) {
+                return nullptr;
+            }
+            void* handle = reinterpret_cast<void*>(static_cast<uintptr_t>(++next_));
+            live.insert(handle);
+            return handle;
+        };
+    }
+    RKBufferImportCache::ReleaseFunc Releaser()
+    {
+        return [this](void* handle) {
+            EXPECT_EQ(1u, live.erase(handle));
+        };
+    }
+
+    std::set<void*> live;
+    uint32_t imports = 0;
+    bool fail = false;
+
+private:
+    uintptr_t next_ = 0;
+};
+
+ImportKey MakeKey(int32_t fd, int32_t index)
+{
+    static uint8_t frames[8][1];  // 8: distinct addresses for the buffers of the test
+    ImportKey key;
+    key.fd = fd;
+    key.index = index;
+    key.addr = frames[index % 8];   // 8: see above
+    key.size = FRAME_SIZE;
+    return key;
+}
+} // namespace
+
+HWTEST(UtestRKBufferImportCache, EachBufferIsImportedOnce, TestSize.Level0)
+{
+    FakeImporter fake;
+    {
+        RKBufferImportCache cache(CACHE_SIZE, fake.Importer(), fake.Releaser());
+        const uint32_t rounds = 30;
+        for (uint32_t frame = 0; frame < rounds * CACHE_SIZE; frame++) {
+            int32_t index = static_cast<int32_t>(frame % CACHE_SIZE);
+            ASSERT_NE(nullptr, cache.Get(MakeKey(100 + index, index)));   // 100: first fd
+        }
+        BufferImportStats stats = cache.GetStats();
+        EXPECT_EQ(CACHE_SIZE, stats.misses);
+        EXPECT_EQ((rounds - 1) * CACHE_SIZE, stats.hits);
+        EXPECT_EQ(0u, stats.evictions);
+        EXPECT_EQ(CACHE_SIZE, stats.cached);
+        EXPECT_EQ(CACHE_SIZE, fake.imports);
+    }
+    EXPECT_TRUE(fake.live.empty());
+}
+
+HWTEST(UtestRKBufferImportCache, ReusedFdIsImportedAgain, TestSize.Level0)
+{
+    FakeImporter fake;
+    RKBufferImportCache cache(CACHE_SIZE, fake.Importer(), fake.Releaser());
+    void* first = cache.Get(MakeKey(7, 0));
+    ImportKey other = MakeKey(7, 0);
+    other.addr = MakeKey(7, 1).addr;    // same fd and index, another mapping
+    void* second = cache.Get(other);
+    ASSERT_NE(nullptr, second);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(1u, fake.live.size());
+    EXPECT_EQ(1u, cache.GetStats().evictions);
+
+    other.size = FRAME_SIZE / 2;
+    EXPECT_NE(second, cache.Get(other));
+    EXPECT_EQ(3u, cache.GetStats().misses);
+}
+
+HWTEST(UtestRKBufferImportCache, LeastRecentlyUsedGoesFirst, TestSize.Level0)
+{
+    FakeImporter fake;
+    RKBufferImportCache cache(CACHE_SIZE, fake.Importer(), fake.Releaser());
+    for (int32_t i = 0; i < static_cast<int32_t>(CACHE_SIZE); i++) {
+        cache.Get(MakeKey(i, i));
+    }
+    cache.Get(MakeKey(0, 0));   // 1 is now the oldest
+    cache.Get(MakeKey(5, 5));
+    EXPECT_EQ(1u, cache.GetStats().evictions);
+    EXPECT_EQ(CACHE_SIZE, fake.live.size());
+
+    uint64_t misses = cache.GetStats().misses;
+    cache.Get(MakeKey(0, 0));
+    EXPECT_EQ(misses, cache.GetStats().misses);
+    cache.Get(MakeKey(1, 1));
+    EXPECT_EQ(misses + 1, cache.GetStats().misses);
+
+    cache.Clear();
+    EXPECT_TRUE(fake.live.empty());
+    EXPECT_EQ(0u, cache.GetStats().cached);
+}
+
+HWTEST(UtestRKBufferImportCache, FailedImportIsNotCached, TestSize.Level0)
+{
+    FakeImporter fake;
+    RKBufferImportCache cache(CACHE_SIZE, fake.Importer(), fake.Releaser());
+    fake.fail = true;
+    EXPECT_EQ(nullptr, cache.Get(MakeKey(3, 0)));
+    fake.fail = false;
+    EXPECT_NE(nullptr, cache.Get(MakeKey(3, 0)));
+    BufferImportStats stats = cache.GetStats();
+    EXPECT_EQ(1u, stats.failures);
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ(1u, stats.cached);
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "pipeline_bench.h"
+#include "rk_codec_node.h"
+#include "rk_node_params.h"
+#include "rk_rga_session.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr int32_t STREAM_ID = 1;
+constexpr uint32_t WIDTH = 64;
+constexpr uint32_t HEIGHT = 32;
+constexpr uint32_t RGBA_BPP = 4;
+constexpr int64_t TIMEOUT_MS = 1000;
+
+// the software backend, with every job it ran kept for the test to look at
+class RecordingBackend : public IRgaBackend {
+public:
+    int32_t Run(const std::vector<RgaJob>& batch) override
+    {
+        {
+            std::unique_lock<std::mutex> l(lock_);
+            jobs_.insert(jobs_.end(), batch.begin(), batch.end());
+        }
+        return soft_->Run(batch);
+    }
+    int32_t AllocBuffer(uint32_t width, uint32_t height, RgaPixelFormat format, RgaBuffer& buffer) override
+    {
+        return soft_->AllocBuffer(width, height, format, buffer);
+    }
+    void FreeBuffer(RgaBuffer& buffer) override
+    {
+        soft_->FreeBuffer(buffer);
+    }
+
+    static std::vector<RgaJob> TakeJobs()
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        std::vector<RgaJob> jobs;
+        jobs.swap(jobs_);
+        return jobs;
+    }
+
+private:
+    std::shared_ptr<IRgaBackend> soft_ = CreateRgaSoftBackend();
+    static std::mutex lock_;
+    static std::vector<RgaJob> jobs_;
+};
+
+std::mutex RecordingBackend::lock_;
+std::vector<RgaJob> RecordingBackend::jobs_;
+
+class SinkPort : public IPort {
+public:
+    explicit SinkPort(const PortFormat& format)
+    {
+        format_ = format;
+    }
+    void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override
+    {
+        delivered.push_back(buffer);
+    }
+
+    std::vector<std::shared_ptr<IBuffer>> delivered;
+};
+
+class UtestRKCodecNode : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        RKRgaSession::SetBackendFactory([] { return std::make_shared<RecordingBackend>(); });
+        SetBenchParameter(RK_PARAM_JPEG_WORKERS, "0");
+    }
+
+    void SetUp() override
+    {
+        config_.graph = {BenchNodeType::CODEC};
+        config_.encode = ENCODE_TYPE_NULL;
+        config_.width = WIDTH;
+        config_.height = HEIGHT;
+        config_.buffers = 1;
+        std::string error;
+        ASSERT_TRUE(pool_.Init(config_, error)) << error;
+
+        PortFormat stream;
+        stream.w_ = WIDTH;
+        stream.h_ = HEIGHT;
+        stream.format_ = static_cast<uint32_t>(config_.format);
+        stream.streamId_ = STREAM_ID;
+        sink_ = std::make_shared<SinkPort>(stream);
+        node_ = std::make_shared<RKCodecNode>("RKCodec#0", "RKCodec", "0");
+        node_->AddOutPort(sink_);
+    }
+
+    void TearDown() override
+    {
+        node_->Stop(STREAM_ID);
+        RecordingBackend::TakeJobs();
+    }
+
+    // one frame of the stream through the node, the I420 it held before is returned in yuv
+    std::shared_ptr<IBuffer> DeliverFrame(std::vector<uint8_t>& yuv)
+    {
+        std::shared_ptr<IBuffer> buffer = pool_.Acquire(TIMEOUT_MS);
+        if (buffer == nullptr) {
+            return nullptr;
+        }
+        pool_.Prepare(buffer, STREAM_ID, 0, 0);
+        const uint8_t* data = static_cast<const uint8_t*>(buffer->GetVirAddress());
+        yuv.assign(data, data + RgaFrameSize(RgaPixelFormat::YUV420P, WIDTH, HEIGHT));
+        node_->DeliverBuffer(buffer);
+        pool_.Release(buffer->GetIndex());
+        return buffer;
+    }
+
+    static std::vector<uint8_t> ToRgba(std::vector<uint8_t>& yuv)
+    {
+        std::vector<uint8_t> rgba(WIDTH * HEIGHT * RGBA_BPP, 0);
+        RgaJob job;
+        job.src = MakeRgaSurface(-1, yuv.data(), WIDTH, HEIGHT, RgaPixelFormat::YUV420P);
+        job.dst = MakeRgaSurface(-1, rgba.data(), WIDTH, HEIGHT, RgaPixelFormat::RGBA8888);
+        EXPECT_EQ(0, CreateRgaSoftBackend()->Run({job}));
+        return rgba;
+    }
+
+    PipelineBenchConfig config_;
+    BenchBufferPool pool_;
+    std::shared_ptr<SinkPort> sink_ = nullptr;
+    std::shared_ptr<RKCodecNode> node_ = nullptr;
+};
+} // namespace
+
+HWTEST_F(UtestRKCodecNode, ZeroCopyRgbaJobsAreOrdered, TestSize.Level0)
+{
+    ASSERT_EQ(RC_OK, node_->Start(STREAM_ID));
+    std::vector<uint8_t> yuv;
+    std::shared_ptr<IBuffer> buffer = DeliverFrame(yuv);
+    ASSERT_NE(nullptr, buffer);
+    ASSERT_EQ(1u, sink_->delivered.size());
+    EXPECT_EQ(0u, node_->GetRgbaCopyBytes(STREAM_ID));
+
+    // staging reads the frame and the csc writes it back, neither may start before the one ahead of it is done
+    std::vector<RgaJob> jobs = RecordingBackend::TakeJobs();
+    ASSERT_EQ(2u, jobs.size());
+    EXPECT_EQ(buffer->GetFileDescriptor(), jobs[0].src.fd);
+    EXPECT_TRUE(jobs[0].waitPrevious);
+    EXPECT_EQ(jobs[0].dst.fd, jobs[1].src.fd);
+    EXPECT_EQ(buffer->GetFileDescriptor(), jobs[1].dst.fd);
+    EXPECT_EQ(RgaPixelFormat::RGBA8888, jobs[1].dst.format);
+    EXPECT_TRUE(jobs[1].waitPrevious);
+
+    std::vector<uint8_t> expected = ToRgba(yuv);
+    EXPECT_EQ(0, memcmp(expected.data(), buffer->GetVirAddress(), expected.size()));
+}
+
+HWTEST_F(UtestRKCodecNode, CopyRgbaMatchesZeroCopy, TestSize.Level0)
+{
+    ASSERT_EQ(RC_OK, node_->Start(STREAM_ID));
+    node_->SetRgbaZeroCopy(STREAM_ID, false);
+    std::vector<uint8_t> yuv;
+    std::shared_ptr<IBuffer> buffer = DeliverFrame(yuv);
+    ASSERT_NE(nullptr, buffer);
+    EXPECT_EQ(buffer->GetSize(), node_->GetRgbaCopyBytes(STREAM_ID));
+
+    std::vector<uint8_t> expected = ToRgba(yuv);
+    EXPECT_EQ(0, memcmp(expected.data(), buffer->GetVirAddress(), expected.size()));
+}
+HWTEST_F(UtestRKCodecNode, SettingsOutliveStopAndStart, TestSize.Level0)
+{
+    VideoEncConfig config;
+    config.bitrate = 2000000;   // 2000000: 2 Mbps
+    config.gop = 30;            // 30: a keyframe per second
+    ASSERT_TRUE(node_->SetVideoEncConfig(STREAM_ID, config));
+    ASSERT_TRUE(node_->SetRgbaZeroCopy(STREAM_ID, false));
+
+    ASSERT_EQ(RC_OK, node_->Start(STREAM_ID));
+    ASSERT_EQ(RC_OK, node_->Stop(STREAM_ID));
+    ASSERT_EQ(RC_OK, node_->Start(STREAM_ID));
+    EXPECT_EQ(config.bitrate, node_->GetVideoEncConfig(STREAM_ID).bitrate);
+    EXPECT_EQ(config.gop, node_->GetVideoEncConfig(STREAM_ID).gop);
+
+    // the copy path is still taken after the restart
+    std::vector<uint8_t> yuv;
+    std::shared_ptr<IBuffer> buffer = DeliverFrame(yuv);
+    ASSERT_NE(nullptr, buffer);
+    EXPECT_EQ(buffer->GetSize(), node_->GetRgbaCopyBytes(STREAM_ID));
+}
+
+HWTEST_F(UtestRKCodecNode, UnknownStreamIsRejected, TestSize.Level0)
+{
+    constexpr int32_t otherStream = STREAM_ID + 1;
+    EXPECT_FALSE(node_->SetRgbaZeroCopy(otherStream, false));
+    EXPECT_FALSE(node_->SetJpegBackend(otherStream, JpegBackendType::LIBJPEG));
+    EXPECT_FALSE(node_->SetJpegExifOrientation(otherStream, true));
+    EXPECT_FALSE(node_->SetVideoEncConfig(otherStream, VideoEncConfig()));
+    EXPECT_NE(RC_OK, node_->Start(otherStream));
+    EXPECT_EQ(0u, node_->GetRgbaCopyBytes(otherStream));
+}
+} // namespace OHOS::Camera
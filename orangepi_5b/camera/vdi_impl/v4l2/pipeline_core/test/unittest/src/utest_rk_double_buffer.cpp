@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "rk_double_buffer.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr size_t WORDS = 64;    // large enough that a torn read would show
+using Block = std::array<uint64_t, WORDS>;
+} // namespace
+
+HWTEST(UtestRKDoubleBuffer, ReadSeesThePublishedSlot, TestSize.Level0)
+{
+    RKDoubleBuffer<int32_t> buffer;
+    int32_t seen = -1;
+    buffer.Read([&seen](const int32_t& v) { seen = v; });
+    EXPECT_EQ(0, seen);
+
+    // written but not published
+    buffer.Back() = 1;
+    buffer.Read([&seen](const int32_t& v) { seen = v; });
+    EXPECT_EQ(0, seen);
+    buffer.Publish();
+    buffer.Read([&seen](const int32_t& v) { seen = v; });
+    EXPECT_EQ(1, seen);
+
+    // the back slot is the older value, written over in place
+    EXPECT_EQ(0, buffer.Back());
+    buffer.Back() = 2;
+    buffer.Publish();
+    buffer.Read([&seen](const int32_t& v) { seen = v; });
+    EXPECT_EQ(2, seen);
+    EXPECT_EQ(1, buffer.Back());
+    EXPECT_EQ(2u, buffer.GetPublishCount());
+}
+
+HWTEST(UtestRKDoubleBuffer, ReadersNeverSeeAPartialWrite, TestSize.Level0)
+{
+    constexpr uint64_t publishes = 20000;
+    constexpr uint32_t readers = 3;
+    RKDoubleBuffer<Block> buffer;
+    std::atomic<bool> done {false};
+    std::atomic<uint64_t> torn {0};
+    std::atomic<uint64_t> backwards {0};
+
+    std::vector<std::thread> threads;
+    for (uint32_t r = 0; r < readers; r++) {
+        threads.emplace_back([&] {
+            uint64_t last = 0;
+            while (!done.load()) {
+                buffer.Read([&](const Block& block) {
+                    for (uint64_t word : block) {
+                        if (word != block[0]) {
+                            torn++;
+                            break;
+                        }
+                    }
+                    if (block[0] < last) {
+                        backwards++;
+                    }
+                    last = block[0];
+                });
+            }
+        });
+    }
+    for (uint64_t i = 1; i <= publishes; i++) {
+        buffer.Back().fill(i);
+        buffer.Publish();
+    }
+    done = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(0u, torn.load());
+    EXPECT_EQ(0u, backwards.load());
+    buffer.Read([&](const Block& block) { EXPECT_EQ(publishes, block[0]); });
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "rk_face_detector.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t WINDOW = 24;
+constexpr uint32_t IMAGE_WIDTH = 160;
+constexpr uint32_t IMAGE_HEIGHT = 120;
+constexpr uint8_t BRIGHT = 170;
+constexpr uint8_t DARK = 40;
+
+/*
+ * A cascade for a drawn face: eyes darker than the cheeks, the nose bridge brighter than the eyes,
+ * the forehead brighter than the eyes, and both halves alike; in units of the window standard deviation.
+ */
+std::string MakeTestCascade(const std::string& extraNode = "", const std::string& tilted = "")
+{
+    return "<?xml version=\"1.0\"?>\n<opencv_storage>\n<cascade>\n"
+        "  <stageType>BOOST</stageType>\n  <featureType>HAAR</featureType>\n"
+        "  <height>24</height>\n  <width>24</width>\n  <stageNum>3</stageNum>\n"
+        "  <stages>\n"
+        "    <!-- stage 0 -->\n"
+        "    <_>\n      <maxWeakCount>2</maxWeakCount>\n      <stageThreshold>1.5</stageThreshold>\n"
+        "      <weakClassifiers>\n"
+        "        <_>\n          <internalNodes>0 -1 0 0.25" + extraNode + "</internalNodes>\n"
+        "          <leafValues>-1. 1.</leafValues></_>\n"
+        "        <_>\n          <internalNodes>0 -1 1 0.25</internalNodes>\n"
+        "          <leafValues>-1. 1.</leafValues></_></weakClassifiers></_>\n"
+        "    <_>\n      <maxWeakCount>1</maxWeakCount>\n      <stageThreshold>0.5</stageThreshold>\n"
+        "      <weakClassifiers>\n"
+        "        <_>\n          <internalNodes>0 -1 2 0.25</internalNodes>\n"
+        "          <leafValues>-1. 1.</leafValues></_></weakClassifiers></_>\n"
+        "    <_>\n      <maxWeakCount>2</maxWeakCount>\n      <stageThreshold>1.5</stageThreshold>\n"
+        "      <weakClassifiers>\n"
+        "        <_>\n          <internalNodes>0 -1 3 -0.05</internalNodes>\n"
+        "          <leafValues>-1. 1.</leafValues></_>\n"
+        "        <_>\n          <internalNodes>0 -1 3 0.05</internalNodes>\n"
+        "          <leafValues>1. -1.</leafValues></_></weakClassifiers></_></stages>\n"
+        "  <features>\n"
+        "    <_>\n      <rects>\n        <_>2 6 20 12 -1.</_>\n        <_>2 12 20 6 2.</_></rects>" + tilted +
+        "</_>\n"
+        "    <_>\n      <rects>\n        <_>2 6 20 6 -1.</_>\n        <_>10 6 4 6 5.</_></rects></_>\n"
+        "    <_>\n      <rects>\n        <_>2 0 20 12 -1.</_>\n        <_>2 0 20 6 2.</_></rects></_>\n"
+        "    <_>\n      <rects>\n        <_>0 0 12 24 -1.</_>\n        <_>12 0 12 24 1.</_></rects></_>\n"
+        "  </features></cascade>\n</opencv_storage>\n";
+}
+
+uint8_t FacePattern(uint32_t u, uint32_t v)
+{
+    constexpr uint32_t eyesTop = 6;
+    constexpr uint32_t eyesBottom = 12;
+    constexpr uint32_t bridgeLeft = 10;
+    constexpr uint32_t bridgeRight = 14;
+    if (v >= eyesTop && v < eyesBottom && (u < bridgeLeft || u >= bridgeRight)) {
+        return DARK;
+    }
+    return BRIGHT;
+}
+
+// mid grey noise, so blank areas have some variance like a real scene
+LumaImage MakeNoise(uint32_t seed)
+{
+    LumaImage image;
+    image.width = IMAGE_WIDTH;
+    image.height = IMAGE_HEIGHT;
+    image.data.resize(IMAGE_WIDTH * IMAGE_HEIGHT);
+    for (uint8_t& p : image.data) {
+        seed = seed * 1103515245 + 12345;   // 1103515245, 12345: lcg
+        p = static_cast<uint8_t>(100 + ((seed >> 16) % 40));    // 100, 16, 40: 100..139
+    }
+    return image;
+}
+
+void DrawFace(LumaImage& image, uint32_t x, uint32_t y, uint32_t size)
+{
+    for (uint32_t v = 0; v < size; v++) {
+        for (uint32_t u = 0; u < size; u++) {
+            image.data[(y + v) * image.width + x + u] = FacePattern(u * WINDOW / size, v * WINDOW / size);
+        }
+    }
+}
+
+FaceBox Box(float x, float y, float width, float height)
+{
+    FaceBox box;
+    box.x = x;
+    box.y = y;
+    box.width = width;
+    box.height = height;
+    return box;
+}
+
+// the drawn face in fractions of the image
+FaceBox Truth(uint32_t x, uint32_t y, uint32_t size)
+{
+    return Box(static_cast<float>(x) / IMAGE_WIDTH, static_cast<float>(y) / IMAGE_HEIGHT,
+        static_cast<float>(size) / IMAGE_WIDTH, static_cast<float>(size) / IMAGE_HEIGHT);
+}
+
+bool Near(const FaceBox& face, const FaceBox& truth)
+{
+    constexpr float tolerance = 0.25f;  // of the face size
+    return std::abs(face.x - truth.x) < truth.width * tolerance &&
+        std::abs(face.y - truth.y) < truth.height * tolerance &&
+        std::abs(face.width - truth.width) < truth.width * tolerance;
+}
+} // namespace
+
+HWTEST(UtestRKFaceDetector, ParsesOpenCvHaarCascade, TestSize.Level0)
+{
+    HaarCascade cascade;
+    ASSERT_TRUE(ParseOpenCvCascade(MakeTestCascade(), cascade));
+    EXPECT_EQ(WINDOW, cascade.windowWidth);
+    EXPECT_EQ(WINDOW, cascade.windowHeight);
+    ASSERT_EQ(3u, cascade.stages.size());
+    EXPECT_EQ(2u, cascade.stages[0].stumps.size());
+    EXPECT_FLOAT_EQ(1.5f, cascade.stages[0].threshold);
+    EXPECT_EQ(1u, cascade.stages[0].stumps[1].feature);
+    EXPECT_FLOAT_EQ(-1.0f, cascade.stages[1].stumps[0].left);
+    ASSERT_EQ(4u, cascade.features.size());
+    EXPECT_EQ(2u, cascade.features[1].count);
+    EXPECT_EQ(10, cascade.features[1].rects[1].x);
+    EXPECT_FLOAT_EQ(5.0f, cascade.features[1].rects[1].weight);
+
+    // deeper trees, tilted features and other feature types are refused rather than misread
+    EXPECT_FALSE(ParseOpenCvCascade(MakeTestCascade(" 1 2"), cascade));
+    EXPECT_FALSE(ParseOpenCvCascade(MakeTestCascade("", "\n      <tilted>1</tilted>"), cascade));
+    std::string lbp = MakeTestCascade();
+    lbp.replace(lbp.find("HAAR"), 4, "LBP");  // 4: HAAR
+    EXPECT_FALSE(ParseOpenCvCascade(lbp, cascade));
+    EXPECT_FALSE(LoadOpenCvCascade("/nonexistent/cascade.xml", cascade));
+    EXPECT_EQ(nullptr, CreateCascadeFaceDetector(cascade, CascadeParams {}));
+}
+
+HWTEST(UtestRKFaceDetector, FindsDrawnFaces, TestSize.Level0)
+{
+    HaarCascade cascade;
+    ASSERT_TRUE(ParseOpenCvCascade(MakeTestCascade(), cascade));
+    CascadeParams params;
+    params.minNeighbors = 2;
+    std::unique_ptr<IFaceDetector> detector = CreateCascadeFaceDetector(cascade, params);
+    ASSERT_NE(nullptr, detector);
+
+    std::vector<FaceBox> faces;
+    LumaImage image = MakeNoise(1);
+    EXPECT_EQ(0, detector->Detect(image, faces));
+    EXPECT_TRUE(faces.empty());
+
+    DrawFace(image, 16, 16, 48);    // 16, 48: twice the cascade window
+    DrawFace(image, 100, 60, 36);   // 100, 60, 36: one and a half times
+    EXPECT_EQ(0, detector->Detect(image, faces));
+    ASSERT_EQ(2u, faces.size());
+    FaceBox big = Truth(16, 16, 48);
+    FaceBox small = Truth(100, 60, 36);
+    EXPECT_TRUE((Near(faces[0], big) && Near(faces[1], small)) || (Near(faces[0], small) && Near(faces[1], big)));
+    for (const FaceBox& face : faces) {
+        EXPECT_GT(face.score, 2.0f);
+        EXPECT_EQ(-1, face.id);
+    }
+
+    // too small for minSize
+    params.minSize = 64;
+    detector = CreateCascadeFaceDetector(cascade, params);
+    EXPECT_EQ(0, detector->Detect(image, faces));
+    EXPECT_TRUE(faces.empty());
+}
+
+HWTEST(UtestRKFaceDetector, DownscalesLumaOfEachFormat, TestSize.Level0)
+{
+    constexpr uint32_t width = 8;
+    constexpr uint32_t height = 4;
+    constexpr uint32_t stride = 16;     // 16: padded rows
+
+    // nv12: the luma plane only, 2x2 boxes
+    std::vector<uint8_t> nv12(stride * height * 3 / 2, 0xee);   // 3 / 2: with the chroma plane
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            nv12[y * stride + x] = static_cast<uint8_t>(x < width / 2 ? 10 : 30 + y);   // 10, 30: left, right
+        }
+    }
+    LumaImage out;
+    ASSERT_TRUE(DownscaleLuma(nv12.data(), RgaPixelFormat::NV12, width, height, stride, width / 2, out));
+    ASSERT_EQ(width / 2, out.width);
+    ASSERT_EQ(height / 2, out.height);
+    EXPECT_EQ(10, out.data[0]);
+    EXPECT_EQ(31, out.data[3]);     // 31: (30 + 30 + 31 + 31) / 4 rounded
+    EXPECT_EQ(33, out.data[7]);     // 33: (32 + 32 + 33 + 33) / 4 rounded
+
+    // yuyv: every other byte is luma
+    std::vector<uint8_t> yuyv(stride * 2 * height, 200);    // 2: bytes per pixel, 200: chroma
+    for (size_t i = 0; i < yuyv.size(); i += 2) {
+        yuyv[i] = 50;   // 50: luma
+    }
+    ASSERT_TRUE(DownscaleLuma(yuyv.data(), RgaPixelFormat::YUYV, width, height, stride, width, out));
+    EXPECT_EQ(width, out.width);
+    EXPECT_EQ(std::vector<uint8_t>(width * height, 50), out.data);
+
+    // rgba: white stays white, pure green is bt.601 luma
+    std::vector<uint8_t> rgba(width * height * 4, 255);     // 4: bytes per pixel
+    ASSERT_TRUE(DownscaleLuma(rgba.data(), RgaPixelFormat::RGBA8888, width, height, width, 2, out));
+    EXPECT_EQ(2u, out.width);
+    EXPECT_EQ(1u, out.height);
+    EXPECT_EQ(255, out.data[0]);
+    for (size_t i = 0; i < rgba.size(); i += 4) {   // 4: bytes per pixel
+        rgba[i] = 0;
+        rgba[i + 2] = 0;    // 2: blue
+    }
+    ASSERT_TRUE(DownscaleLuma(rgba.data(), RgaPixelFormat::RGBA8888, width, height, width, width, out));
+    EXPECT_EQ(149, out.data[0]);    // 149: 150 * 255 >> 8
+
+    EXPECT_FALSE(DownscaleLuma(nullptr, RgaPixelFormat::NV12, width, height, stride, width, out));
+    EXPECT_FALSE(DownscaleLuma(nv12.data(), RgaPixelFormat::NV12, width, height, width / 2, width, out));
+}
+
+HWTEST(UtestRKFaceDetector, GroupsDetectionsAndKeepsIds, TestSize.Level0)
+{
+    // four hits around one face, one stray hit
+    std::vector<FaceBox> boxes = {Box(10, 10, 24, 24), Box(12, 10, 24, 24), Box(10, 12, 26, 26),
+        Box(11, 11, 24, 24), Box(100, 100, 24, 24)};
+    GroupFaceBoxes(boxes, 3);
+    ASSERT_EQ(1u, boxes.size());
+    EXPECT_FLOAT_EQ(4.0f, boxes[0].score);
+    EXPECT_FLOAT_EQ(10.75f, boxes[0].x);    // 10.75: mean of 10, 12, 10, 11
+    EXPECT_FLOAT_EQ(24.5f, boxes[0].width);
+
+    int32_t nextId = 0;
+    std::vector<FaceBox> previous;
+    std::vector<FaceBox> faces = {Box(0.1f, 0.1f, 0.2f, 0.2f), Box(0.6f, 0.5f, 0.2f, 0.2f)};
+    AssignFaceIds(previous, faces, nextId);
+    EXPECT_EQ(0, faces[0].id);
+    EXPECT_EQ(1, faces[1].id);
+
+    // the faces moved a little and swapped order, a third one appeared
+    previous = faces;
+    faces = {Box(0.62f, 0.52f, 0.2f, 0.2f), Box(0.3f, 0.7f, 0.1f, 0.1f), Box(0.12f, 0.1f, 0.2f, 0.2f)};
+    AssignFaceIds(previous, faces, nextId);
+    EXPECT_EQ(1, faces[0].id);
+    EXPECT_EQ(2, faces[1].id);
+    EXPECT_EQ(0, faces[2].id);
+    EXPECT_EQ(3, nextId);
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "rk_jpeg_exif.h"
+
+extern "C" {
+#include <jpeglib.h>
+}
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t IMAGE_SIZE = 16;
+
+std::vector<uint8_t> EncodeGray(uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t> pixels(width * height, 128);
+    struct jpeg_compress_struct cInfo;
+    struct jpeg_error_mgr jErr;
+    unsigned char* jpegBuf = nullptr;
+    unsigned long jpegSize = 0;
+
+    cInfo.err = jpeg_std_error(&jErr);
+    jpeg_create_compress(&cInfo);
+    cInfo.image_width = width;
+    cInfo.image_height = height;
+    cInfo.input_components = 1;
+    cInfo.in_color_space = JCS_GRAYSCALE;
+    jpeg_set_defaults(&cInfo);
+    jpeg_mem_dest(&cInfo, &jpegBuf, &jpegSize);
+    jpeg_start_compress(&cInfo, TRUE);
+    while (cInfo.next_scanline < cInfo.image_height) {
+        JSAMPROW row = &pixels[cInfo.next_scanline * width];
+        jpeg_write_scanlines(&cInfo, &row, 1);
+    }
+    jpeg_finish_compress(&cInfo);
+    jpeg_destroy_compress(&cInfo);
+
+    std::vector<uint8_t> jpeg(jpegBuf, jpegBuf + jpegSize);
+    free(jpegBuf);
+    return jpeg;
+}
+
+uint32_t Get32(const uint8_t* p)
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];    // 24, 16, 8: big endian
+}
+
+// the 12 byte entry of a tag in the IFD at offset of the tiff data, big endian
+const uint8_t* FindTag(const uint8_t* tiff, uint32_t offset, uint16_t tag)
+{
+    uint16_t count = static_cast<uint16_t>((tiff[offset] << 8) | tiff[offset + 1]);
+    for (uint16_t i = 0; i < count; i++) {
+        const uint8_t* e = tiff + offset + 2 + i * 12;  // 2: entry count, 12: entry size
+        if (((e[0] << 8) | e[1]) == tag) {
+            return e;
+        }
+    }
+    return nullptr;
+}
+
+ExifFields FullFields()
+{
+    ExifFields fields;
+    fields.orientation = ExifOrientation::ROT_180;
+    fields.width = IMAGE_SIZE;
+    fields.height = IMAGE_SIZE * 2;
+    fields.exposureNs = 10000000;   // 10000000: 1/100 s
+    fields.iso = 400;
+    fields.focalLengthUm = 4500;
+    FormatExifDateTime(31579200, fields.dateTime);  // 31579200: noon of 1971-01-01 UTC, the same day in any zone
+    fields.hasGps = true;
+    fields.latitude = -31.5;
+    fields.longitude = 121.25;
+    fields.altitude = -12.5;
+    return fields;
+}
+
+bool DecodesWithApp1(const std::vector<uint8_t>& jpeg, size_t app1Size)
+{
+    struct jpeg_decompress_struct dInfo;
+    struct jpeg_error_mgr jErr;
+    dInfo.err = jpeg_std_error(&jErr);
+    jpeg_create_decompress(&dInfo);
+    jpeg_save_markers(&dInfo, JPEG_APP0 + 1, 0xffff);
+    jpeg_mem_src(&dInfo, jpeg.data(), jpeg.size());
+    bool ok = jpeg_read_header(&dInfo, TRUE) == JPEG_HEADER_OK && dInfo.marker_list != nullptr &&
+        dInfo.marker_list->data_length == app1Size - 4;     // 4: marker and length
+    if (ok) {
+        std::vector<uint8_t> row(dInfo.image_width * dInfo.num_components);
+        JSAMPROW rows[] = {row.data()};
+        jpeg_start_decompress(&dInfo);
+        while (dInfo.output_scanline < dInfo.output_height) {
+            jpeg_read_scanlines(&dInfo, rows, 1);
+        }
+        jpeg_finish_decompress(&dInfo);
+    }
+    jpeg_destroy_decompress(&dInfo);
+    return ok;
+}
+} // namespace
+
+HWTEST(UtestRKJpegExif, RotationMapsToOrientation, TestSize.Level0)
+{
+    EXPECT_EQ(ExifOrientation::NORMAL, ToExifOrientation(RgaRotation::ROT_0));
+    EXPECT_EQ(ExifOrientation::ROT_90, ToExifOrientation(RgaRotation::ROT_90));
+    EXPECT_EQ(ExifOrientation::ROT_180, ToExifOrientation(RgaRotation::ROT_180));
+    EXPECT_EQ(ExifOrientation::ROT_270, ToExifOrientation(RgaRotation::ROT_270));
+}
+
+HWTEST(UtestRKJpegExif, OrientationSegmentLayout, TestSize.Level0)
+{
+    std::vector<uint8_t> app1(ExifOrientationApp1Size(), 0);
+    ASSERT_EQ(app1.size(), WriteExifOrientationApp1(app1.data(), app1.size(), ExifOrientation::ROT_90));
+    EXPECT_EQ(0u, WriteExifOrientationApp1(app1.data(), app1.size() - 1, ExifOrientation::ROT_90));
+
+    EXPECT_EQ(0xff, app1[0]);
+    EXPECT_EQ(0xe1, app1[1]);
+    EXPECT_EQ(app1.size() - 2, static_cast<size_t>((app1[2] << 8) | app1[3]));
+    EXPECT_EQ(0, memcmp(&app1[4], "Exif\0\0MM\0\x2a\0\0\0\x08", 14));
+    // IFD0: one entry, tag 0x0112, SHORT, count 1, value 6
+    const uint8_t ifd[] = {0, 1, 0x01, 0x12, 0, 3, 0, 0, 0, 1, 0, 6, 0, 0, 0, 0, 0, 0};
+    EXPECT_EQ(0, memcmp(&app1[18], ifd, sizeof(ifd)));
+}
+
+HWTEST(UtestRKJpegExif, SegmentAfterSoiDecodes, TestSize.Level0)
+{
+    std::vector<uint8_t> jpeg = EncodeGray(IMAGE_SIZE, IMAGE_SIZE);
+    std::vector<uint8_t> tagged(jpeg.begin(), jpeg.begin() + 2);
+    std::vector<uint8_t> app1(ExifOrientationApp1Size());
+    WriteExifOrientationApp1(app1.data(), app1.size(), ExifOrientation::ROT_270);
+    tagged.insert(tagged.end(), app1.begin(), app1.end());
+    tagged.insert(tagged.end(), jpeg.begin() + 2, jpeg.end());
+
+    struct jpeg_decompress_struct dInfo;
+    struct jpeg_error_mgr jErr;
+    dInfo.err = jpeg_std_error(&jErr);
+    jpeg_create_decompress(&dInfo);
+    jpeg_save_markers(&dInfo, JPEG_APP0 + 1, 0xffff);
+    jpeg_mem_src(&dInfo, tagged.data(), tagged.size());
+    ASSERT_EQ(JPEG_HEADER_OK, jpeg_read_header(&dInfo, TRUE));
+    EXPECT_EQ(IMAGE_SIZE, dInfo.image_width);
+    EXPECT_EQ(IMAGE_SIZE, dInfo.image_height);
+
+    jpeg_saved_marker_ptr marker = dInfo.marker_list;
+    ASSERT_NE(nullptr, marker);
+    EXPECT_EQ(JPEG_APP0 + 1, marker->marker);
+    ASSERT_EQ(app1.size() - 4, marker->data_length);
+    EXPECT_EQ(0, memcmp(marker->data, "Exif", 4));
+    EXPECT_EQ(static_cast<uint8_t>(ExifOrientation::ROT_270), marker->data[25]);
+    jpeg_destroy_decompress(&dInfo);
+}
+
+HWTEST(UtestRKJpegExif, FullSegmentLayout, TestSize.Level0)
+{
+    ExifFields fields = FullFields();
+    std::vector<uint8_t> app1(ExifApp1Size(), 0xaa);
+    EXPECT_EQ(0u, WriteExifApp1(app1.data(), app1.size() - 1, fields));
+    ASSERT_EQ(app1.size(), WriteExifApp1(app1.data(), app1.size(), fields));
+    EXPECT_EQ(app1.size() - 2, static_cast<size_t>((app1[2] << 8) | app1[3]));
+    EXPECT_EQ(0, app1.back());
+
+    const uint8_t* tiff = &app1[10];    // 10: marker, length and Exif header
+    const uint8_t* e = FindTag(tiff, 8, 0x0132);    // 8: IFD0 right after the tiff header
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(0, memcmp(tiff + Get32(e + 8), "1971:01:01", 10)) << tiff + Get32(e + 8);
+
+    const uint8_t* exifIfd = FindTag(tiff, 8, 0x8769);
+    ASSERT_NE(nullptr, exifIfd);
+    uint32_t exifOffset = Get32(exifIfd + 8);
+    e = FindTag(tiff, exifOffset, 0x829a);
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(1u, Get32(tiff + Get32(e + 8)));
+    EXPECT_EQ(100u, Get32(tiff + Get32(e + 8) + 4));
+    e = FindTag(tiff, exifOffset, 0x8827);
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(400, (e[8] << 8) | e[9]);
+    e = FindTag(tiff, exifOffset, 0x920a);
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(9u, Get32(tiff + Get32(e + 8)));      // 4500 um is 9/2 mm
+    EXPECT_EQ(2u, Get32(tiff + Get32(e + 8) + 4));
+
+    const uint8_t* gpsIfd = FindTag(tiff, 8, 0x8825);
+    ASSERT_NE(nullptr, gpsIfd);
+    uint32_t gpsOffset = Get32(gpsIfd + 8);
+    e = FindTag(tiff, gpsOffset, 0x0001);
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ('S', e[8]);
+    e = FindTag(tiff, gpsOffset, 0x0002);
+    ASSERT_NE(nullptr, e);
+    const uint8_t* dms = tiff + Get32(e + 8);
+    EXPECT_EQ(31u, Get32(dms));
+    EXPECT_EQ(30u, Get32(dms + 8));     // 8: one rational
+    EXPECT_EQ(0u, Get32(dms + 16));
+    e = FindTag(tiff, gpsOffset, 0x0003);
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ('E', e[8]);
+    e = FindTag(tiff, gpsOffset, 0x0005);
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(1, e[8]);     // below sea level
+    e = FindTag(tiff, gpsOffset, 0x0006);
+    ASSERT_NE(nullptr, e);
+    EXPECT_EQ(1250u, Get32(tiff + Get32(e + 8)));
+    EXPECT_EQ(100u, Get32(tiff + Get32(e + 8) + 4));
+
+    // what is not known is left out
+    ExifFields bare;
+    ASSERT_EQ(app1.size(), WriteExifApp1(app1.data(), app1.size(), bare));
+    EXPECT_EQ(nullptr, FindTag(tiff, 8, 0x0132));
+    EXPECT_EQ(nullptr, FindTag(tiff, 8, 0x8825));
+    ASSERT_NE(nullptr, FindTag(tiff, 8, 0x8769));
+    exifOffset = Get32(FindTag(tiff, 8, 0x8769) + 8);
+    EXPECT_EQ(nullptr, FindTag(tiff, exifOffset, 0x829a));
+    EXPECT_NE(nullptr, FindTag(tiff, exifOffset, 0x9000));
+}
+
+HWTEST(UtestRKJpegExif, FullSegmentIsRewrittenInPlace, TestSize.Level0)
+{
+    std::vector<uint8_t> jpeg = EncodeGray(IMAGE_SIZE, IMAGE_SIZE * 2);
+    std::vector<uint8_t> tagged(jpeg.begin(), jpeg.begin() + 2);
+    std::vector<uint8_t> app1(ExifApp1Size());
+    ExifFields codec;
+    codec.orientation = ExifOrientation::ROT_90;
+    codec.width = IMAGE_SIZE;
+    codec.height = IMAGE_SIZE * 2;
+    WriteExifApp1(app1.data(), app1.size(), codec);
+    tagged.insert(tagged.end(), app1.begin(), app1.end());
+    tagged.insert(tagged.end(), jpeg.begin() + 2, jpeg.end());
+    EXPECT_TRUE(DecodesWithApp1(tagged, app1.size()));
+
+    // a plain jpeg, or one cut short, has no segment to fill in
+    EXPECT_EQ(0u, FindExifApp1(jpeg.data(), jpeg.size()));
+    EXPECT_EQ(0u, FindExifApp1(tagged.data(), app1.size()));
+    size_t offset = FindExifApp1(tagged.data(), tagged.size());
+    ASSERT_EQ(2u, offset);
+
+    // what RKExifNode does: keep what the encoder knew, add the capture settings
+    ExifFields fields = FullFields();
+    ASSERT_TRUE(ParseExifApp1(tagged.data() + offset, app1.size(), fields));
+    EXPECT_EQ(ExifOrientation::ROT_90, fields.orientation);
+    EXPECT_EQ(IMAGE_SIZE, fields.width);
+    EXPECT_EQ(IMAGE_SIZE * 2, fields.height);
+    size_t size = tagged.size();
+    ASSERT_EQ(app1.size(), WriteExifApp1(tagged.data() + offset, app1.size(), fields));
+    EXPECT_EQ(size, tagged.size());
+    EXPECT_EQ(0, memcmp(tagged.data() + offset + app1.size(), jpeg.data() + 2, jpeg.size() - 2));
+    EXPECT_TRUE(DecodesWithApp1(tagged, app1.size()));
+
+    ExifFields parsed;
+    ASSERT_TRUE(ParseExifApp1(tagged.data() + offset, app1.size(), parsed));
+    EXPECT_EQ(ExifOrientation::ROT_90, parsed.orientation);
+    EXPECT_EQ(IMAGE_SIZE * 2, parsed.height);
+    tagged[offset + 10] = 'I';  // 10: the tiff byte order, only big endian is ours
+    EXPECT_FALSE(ParseExifApp1(tagged.data() + offset, app1.size(), parsed));
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "rk_latency_histogram.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+HWTEST(UtestRKLatencyHistogram, BucketsCoverEveryValueOnce, TestSize.Level0)
+{
+    for (size_t i = 0; i + 1 < RKLatencyHistogram::BUCKET_COUNT; i++) {
+        uint64_t lower = RKLatencyHistogram::BucketLowerBound(i);
+        uint64_t next = RKLatencyHistogram::BucketLowerBound(i + 1);
+        ASSERT_LT(lower, next);
+        EXPECT_EQ(i, RKLatencyHistogram::BucketIndex(lower));
+        EXPECT_EQ(i, RKLatencyHistogram::BucketIndex(next - 1));
+        // four buckets per octave keep the error under a quarter
+        if (lower >= 4) {
+            EXPECT_LE((next - lower) * 4, lower);
+        }
+    }
+    EXPECT_EQ(RKLatencyHistogram::BUCKET_COUNT - 1, RKLatencyHistogram::BucketIndex(UINT64_MAX));
+}
+
+HWTEST(UtestRKLatencyHistogram, PercentilesOfAKnownDistribution, TestSize.Level0)
+{
+    RKLatencyHistogram histogram;
+    EXPECT_EQ(0u, histogram.Summarize().count);
+    EXPECT_EQ(0u, histogram.Percentile(0.5));
+
+    // 1..1000 us
+    for (uint64_t us = 1; us <= 1000; us++) {
+        histogram.Record(us);
+    }
+    LatencySummary summary = histogram.Summarize();
+    EXPECT_EQ(1000u, summary.count);
+    EXPECT_EQ(500u, summary.meanUs);
+    EXPECT_EQ(1000u, summary.maxUs);
+    EXPECT_GE(summary.p50Us, 500u);
+    EXPECT_LE(summary.p50Us, 500u * 5 / 4);
+    EXPECT_GE(summary.p90Us, 900u);
+    EXPECT_LE(summary.p99Us, 1000u);
+    EXPECT_GE(summary.p99Us, 990u);
+
+    histogram.Reset();
+    histogram.Record(33333);
+    EXPECT_EQ(33333u, histogram.Summarize().p99Us);
+}
+
+HWTEST(UtestRKLatencyHistogram, StagesSkipMissingStamps, TestSize.Level0)
+{
+    const int64_t ms = 1000000;
+    RKPipelineLatency latency;
+    FrameTimes times;
+    times.captureNs = 100 * ms;
+    times.encodeStartNs = 110 * ms;
+    times.encodeEndNs = 118 * ms;
+    times.deliveredNs = 119 * ms;
+    latency.Record(times);
+    EXPECT_EQ(10000u, latency.Summarize(LatencyStage::CAPTURE_TO_ENCODE).maxUs);
+    EXPECT_EQ(8000u, latency.Summarize(LatencyStage::ENCODE).maxUs);
+    EXPECT_EQ(1000u, latency.Summarize(LatencyStage::ENCODE_TO_DELIVERY).maxUs);
+    EXPECT_EQ(19000u, latency.Summarize(LatencyStage::CAPTURE_TO_DELIVERY).maxUs);
+
+    // no capture stamp, and one from another clock that lies in the future
+    times.captureNs = 0;
+    latency.Record(times);
+    times.captureNs = 200 * ms;
+    latency.Record(times);
+    EXPECT_EQ(1u, latency.Summarize(LatencyStage::CAPTURE_TO_ENCODE).count);
+    EXPECT_EQ(3u, latency.Summarize(LatencyStage::ENCODE).count);
+    EXPECT_EQ(0u, latency.Summarize(LatencyStage::COUNT).count);
+    EXPECT_STREQ("encode", RKPipelineLatency::StageName(LatencyStage::ENCODE));
+}
+
+HWTEST(UtestRKLatencyHistogram, ConcurrentRecordsAreCounted, TestSize.Level0)
+{
+    const uint32_t threads = 4;
+    const uint32_t perThread = 10000;
+    RKLatencyHistogram histogram;
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; t++) {
+        workers.emplace_back([&histogram, t] {
+            for (uint32_t i = 0; i < perThread; i++) {
+                histogram.Record(t * perThread + i);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    LatencySummary summary = histogram.Summarize();
+    EXPECT_EQ(threads * perThread, summary.count);
+    EXPECT_EQ(threads * perThread - 1, summary.maxUs);
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "rk_nal_indexer.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+void Append(std::vector<uint8_t>& stream, std::initializer_list<uint8_t> bytes)
+{
+    stream.insert(stream.end(), bytes);
+}
+} // namespace
+
+HWTEST(UtestRKNalIndexer, H264KeyFrameWithMixedStartCodes, TestSize.Level0)
+{
+    std::vector<uint8_t> stream;
+    Append(stream, {0, 0, 0, 1, 0x67, 0x42, 0x00, 0x1f});     // SPS
+    Append(stream, {0, 0, 0, 1, 0x68, 0xce, 0x3c});           // PPS
+    Append(stream, {0, 0, 1, 0x65, 0x88, 0x80, 0x40, 0x10});  // IDR slice behind a 3 byte start code
+
+    NalIndex index;
+    ASSERT_EQ(3u, IndexNalUnits(stream.data(), stream.size(), NalCodec::H264, index));
+    EXPECT_TRUE(index.keyFrame);
+    EXPECT_TRUE(index.hasParameterSets);
+
+    EXPECT_EQ(4u, index.units[0].offset);
+    EXPECT_EQ(4u, index.units[0].size);
+    EXPECT_EQ(4u, index.units[0].startCodeSize);
+    EXPECT_EQ(7u, index.units[0].type);
+    EXPECT_EQ(12u, index.units[1].offset);
+    EXPECT_EQ(3u, index.units[1].size);
+    EXPECT_EQ(8u, index.units[1].type);
+    EXPECT_EQ(18u, index.units[2].offset);
+    EXPECT_EQ(5u, index.units[2].size);
+    EXPECT_EQ(3u, index.units[2].startCodeSize);
+    EXPECT_EQ(5u, index.units[2].type);
+
+    std::vector<uint8_t> sets;
+    ASSERT_EQ(15u, ExtractParameterSets(stream.data(), index, NalCodec::H264, sets));
+    EXPECT_TRUE(std::equal(sets.begin(), sets.end(), stream.begin()));
+}
+
+HWTEST(UtestRKNalIndexer, H264PFrameIsNotKey, TestSize.Level0)
+{
+    std::vector<uint8_t> stream;
+    Append(stream, {0, 0, 0, 1, 0x41, 0x9a, 0x02, 0x04});
+    NalIndex index;
+    ASSERT_EQ(1u, IndexNalUnits(stream.data(), stream.size(), NalCodec::H264, index));
+    EXPECT_EQ(1u, index.units[0].type);
+    EXPECT_FALSE(index.keyFrame);
+    EXPECT_FALSE(index.hasParameterSets);
+}
+
+HWTEST(UtestRKNalIndexer, H265IrapAndParameterSets, TestSize.Level0)
+{
+    std::vector<uint8_t> stream;
+    Append(stream, {0, 0, 0, 1, 0x40, 0x01, 0x0c});   // VPS
+    Append(stream, {0, 0, 0, 1, 0x42, 0x01, 0x01});   // SPS
+    Append(stream, {0, 0, 0, 1, 0x44, 0x01, 0xc1});   // PPS
+    Append(stream, {0, 0, 0, 1, 0x2a, 0x01, 0xaf});   // CRA
+    NalIndex index;
+    ASSERT_EQ(4u, IndexNalUnits(stream.data(), stream.size(), NalCodec::H265, index));
+    EXPECT_EQ(32u, index.units[0].type);
+    EXPECT_EQ(33u, index.units[1].type);
+    EXPECT_EQ(34u, index.units[2].type);
+    EXPECT_EQ(21u, index.units[3].type);
+    EXPECT_TRUE(index.keyFrame);
+
+    std::vector<uint8_t> sets;
+    EXPECT_EQ(21u, ExtractParameterSets(stream.data(), index, NalCodec::H265, sets));
+
+    // TRAIL_R, and an H.264 reading of the same bytes must not see an IDR
+    std::vector<uint8_t> trail;
+    Append(trail, {0, 0, 1, 0x02, 0x01, 0xd0});
+    ASSERT_EQ(1u, IndexNalUnits(trail.data(), trail.size(), NalCodec::H265, index));
+    EXPECT_EQ(1u, index.units[0].type);
+    EXPECT_FALSE(index.keyFrame);
+    EXPECT_TRUE(IsKeyFrameNal(NalCodec::H265, 19));     // IDR_W_RADL
+    EXPECT_FALSE(IsKeyFrameNal(NalCodec::H265, 5));
+}
+
+HWTEST(UtestRKNalIndexer, ShortAndEmptyBuffers, TestSize.Level0)
+{
+    NalIndex index;
+    EXPECT_EQ(0u, IndexNalUnits(nullptr, 16, NalCodec::H264, index));
+    const uint8_t two[] = {0, 0};
+    EXPECT_EQ(0u, IndexNalUnits(two, sizeof(two), NalCodec::H264, index));
+    const uint8_t bare[] = {0, 0, 1};
+    EXPECT_EQ(0u, IndexNalUnits(bare, sizeof(bare), NalCodec::H264, index));
+    const uint8_t noStart[] = {1, 2, 3, 0, 0, 2, 0, 0, 0, 0};
+    EXPECT_EQ(0u, IndexNalUnits(noStart, sizeof(noStart), NalCodec::H264, index));
+}
+
+HWTEST(UtestRKNalIndexer, SimdMatchesScalar, TestSize.Level0)
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> byte(0, 3);  // lots of 0 and 1 to stress the near misses
+    for (size_t length = 0; length < 80; length++) {
+        for (uint32_t round = 0; round < 50; round++) {
+            std::vector<uint8_t> data(length);
+            for (auto& b : data) {
+                b = static_cast<uint8_t>(byte(rng));
+            }
+            const uint8_t* end = data.data() + data.size();
+            const uint8_t* p = data.data();
+            while (true) {
+                const uint8_t* scalar = FindStartCodeScalar(p, end);
+                const uint8_t* simd = FindStartCodeSimd(p, end);
+                ASSERT_EQ(scalar, simd) << "length " << length << " round " << round;
+                if (scalar == end) {
+                    break;
+                }
+                p = scalar + 1;
+            }
+        }
+    }
+}
+} // namespace OHOS::Camera
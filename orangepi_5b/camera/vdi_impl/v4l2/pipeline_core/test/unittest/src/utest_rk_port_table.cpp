@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "rk_port_table.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+struct FakeFormat {
+    int32_t streamId_ = 0;
+};
+
+struct FakePort {
+    explicit FakePort(int32_t streamId)
+    {
+        format_.streamId_ = streamId;
+    }
+    FakeFormat format_;
+};
+
+std::vector<std::shared_ptr<FakePort>> MakePorts(int32_t first, int32_t count)
+{
+    std::vector<std::shared_ptr<FakePort>> ports;
+    for (int32_t id = first; id < first + count; id++) {
+        ports.push_back(std::make_shared<FakePort>(id));
+    }
+    return ports;
+}
+} // namespace
+
+HWTEST(UtestRKPortTable, FindsEveryStream, TestSize.Level0)
+{
+    RKPortTable<FakePort> table;
+    EXPECT_EQ(nullptr, table.Find(0));
+
+    auto ports = MakePorts(0, 8);
+    ports.insert(ports.begin() + 2, nullptr);
+    ASSERT_TRUE(table.Build(ports));
+    for (const auto& port : ports) {
+        if (port != nullptr) {
+            EXPECT_EQ(port.get(), table.Find(port->format_.streamId_));
+        }
+    }
+    EXPECT_EQ(nullptr, table.Find(8));
+    EXPECT_EQ(nullptr, table.Find(-1));
+
+    // the same ports again publish nothing
+    EXPECT_FALSE(table.Build(ports));
+    EXPECT_EQ(1u, table.GetVersionCount());
+}
+
+HWTEST(UtestRKPortTable, FirstPortOfAStreamWins, TestSize.Level0)
+{
+    RKPortTable<FakePort> table;
+    auto ports = MakePorts(5, 1);
+    ports.push_back(std::make_shared<FakePort>(5));
+    ASSERT_TRUE(table.Build(ports));
+    EXPECT_EQ(ports[0].get(), table.Find(5));
+}
+
+HWTEST(UtestRKPortTable, CollidingAndLargeIdsProbe, TestSize.Level0)
+{
+    RKPortTable<FakePort> table;
+    // sparse ids, negative ones and far more ports than the minimum table size
+    std::vector<std::shared_ptr<FakePort>> ports;
+    for (int32_t i = 0; i < 100; i++) {
+        ports.push_back(std::make_shared<FakePort>(i * 65536 - 50 * 65536));
+    }
+    ASSERT_TRUE(table.Build(ports));
+    for (const auto& port : ports) {
+        EXPECT_EQ(port.get(), table.Find(port->format_.streamId_));
+    }
+    EXPECT_EQ(nullptr, table.Find(1));
+}
+
+HWTEST(UtestRKPortTable, UnknownStreamReloadsThePorts, TestSize.Level0)
+{
+    RKPortTable<FakePort> table;
+    auto ports = MakePorts(0, 2);
+    ASSERT_TRUE(table.Build(ports));
+
+    int loads = 0;
+    auto getPorts = [&ports, &loads] {
+        loads++;
+        return ports;
+    };
+    EXPECT_EQ(ports[1].get(), table.Find(1, getPorts));
+    EXPECT_EQ(0, loads);
+
+    // still unknown after the reload, nothing new is published
+    EXPECT_EQ(nullptr, table.Find(2, getPorts));
+    EXPECT_EQ(1, loads);
+    EXPECT_EQ(1u, table.GetVersionCount());
+
+    // a port linked after Start is picked up on its first frame
+    ports.push_back(std::make_shared<FakePort>(2));
+    EXPECT_EQ(ports[2].get(), table.Find(2, getPorts));
+    EXPECT_EQ(2, loads);
+    EXPECT_EQ(2u, table.GetVersionCount());
+    EXPECT_EQ(ports[0].get(), table.Find(0));
+}
+
+HWTEST(UtestRKPortTable, FindWhileRebuilding, TestSize.Level0)
+{
+    constexpr int32_t rebuilds = 200;
+    RKPortTable<FakePort> table;
+    auto base = MakePorts(0, 4);
+    ASSERT_TRUE(table.Build(base));
+
+    std::atomic<bool> done {false};
+    std::atomic<uint32_t> misses {0};
+    std::vector<std::thread> readers;
+    for (int32_t r = 0; r < 2; r++) {
+        readers.emplace_back([&table, &base, &done, &misses] {
+            while (!done.load()) {
+                for (const auto& port : base) {
+                    if (table.Find(port->format_.streamId_) != port.get()) {
+                        misses++;
+                    }
+                }
+            }
+        });
+    }
+    // the first four ports stay linked while others come and go
+    for (int32_t i = 0; i < rebuilds; i++) {
+        auto ports = base;
+        auto extra = MakePorts(4, i % 8);
+        ports.insert(ports.end(), extra.begin(), extra.end());
+        table.Build(ports);
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(0u, misses.load());
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "camera.h"
+#include "rk_rga_session.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+// the host build has no RGA, every session runs on the software stand-in
+std::shared_ptr<IRgaBackend> CreateRgaHwBackend()
+{
+    return CreateRgaSoftBackend();
+}
+
+namespace {
+class CountingBackend : public IRgaBackend {
+public:
+    int32_t Run(const std::vector<RgaJob>& batch) override
+    {
+        batchSizes.push_back(batch.size());
+        return soft->Run(batch);
+    }
+    int32_t AllocBuffer(uint32_t width, uint32_t height, RgaPixelFormat format, RgaBuffer& buffer) override
+    {
+        return soft->AllocBuffer(width, height, format, buffer);
+    }
+    void FreeBuffer(RgaBuffer& buffer) override
+    {
+        soft->FreeBuffer(buffer);
+    }
+
+    std::shared_ptr<IRgaBackend> soft = CreateRgaSoftBackend();
+    std::vector<size_t> batchSizes;
+};
+
+std::vector<uint8_t> MakeI420(uint32_t width, uint32_t height, uint8_t y, uint8_t u, uint8_t v)
+{
+    size_t luma = width * height;
+    std::vector<uint8_t> frame(luma * 3 / 2, y);
+    std::fill(frame.begin() + luma, frame.begin() + luma + luma / 4, u);
+    std::fill(frame.begin() + luma + luma / 4, frame.end(), v);
+    return frame;
+}
+
+class UtestRKRgaSession : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        RKRgaSession::SetBackendFactory(CreateRgaSoftBackend);
+    }
+};
+} // namespace
+
+HWTEST_F(UtestRKRgaSession, SoftCscGrayToRgba, TestSize.Level0)
+{
+    constexpr uint32_t width = 16;
+    constexpr uint32_t height = 8;
+    std::vector<uint8_t> src = MakeI420(width, height, 126, 128, 128);
+    std::vector<uint8_t> dst(width * height * 4, 0);
+
+    RgaJob job;
+    job.src = MakeRgaSurface(-1, src.data(), width, height, RgaPixelFormat::YUV420P);
+    job.dst = MakeRgaSurface(-1, dst.data(), width, height, RgaPixelFormat::RGBA8888);
+    EXPECT_EQ(0, CreateRgaSoftBackend()->Run({job}));
+
+    for (size_t i = 0; i < dst.size(); i += 4) {
+        EXPECT_EQ(128, dst[i]);
+        EXPECT_EQ(128, dst[i + 1]);
+        EXPECT_EQ(128, dst[i + 2]);
+        EXPECT_EQ(255, dst[i + 3]);
+    }
+}
+
+HWTEST_F(UtestRKRgaSession, SoftScaleDown, TestSize.Level0)
+{
+    // 4x4 luma with a distinct value per 2x2 block, scaled to 2x2
+    std::vector<uint8_t> src = MakeI420(4, 4, 0, 128, 128);
+    const uint8_t blocks[4] = {10, 20, 30, 40};
+    for (uint32_t y = 0; y < 4; y++) {
+        for (uint32_t x = 0; x < 4; x++) {
+            src[y * 4 + x] = blocks[(y / 2) * 2 + x / 2];
+        }
+    }
+    std::vector<uint8_t> dst = MakeI420(2, 2, 0, 0, 0);
+
+    RgaJob job;
+    job.src = MakeRgaSurface(-1, src.data(), 4, 4, RgaPixelFormat::YUV420P);
+    job.dst = MakeRgaSurface(-1, dst.data(), 2, 2, RgaPixelFormat::YUV420P);
+    EXPECT_EQ(0, CreateRgaSoftBackend()->Run({job}));
+    EXPECT_EQ(10, dst[0]);
+    EXPECT_EQ(20, dst[1]);
+    EXPECT_EQ(30, dst[2]);
+    EXPECT_EQ(40, dst[3]);
+    EXPECT_EQ(128, dst[4]);
+    EXPECT_EQ(128, dst[5]);
+}
+
+HWTEST_F(UtestRKRgaSession, SoftRotate90, TestSize.Level0)
+{
+    // 4x2 luma rotated clockwise into 2x4
+    std::vector<uint8_t> src = MakeI420(4, 2, 0, 128, 128);
+    for (uint32_t i = 0; i < 8; i++) {
+        src[i] = static_cast<uint8_t>(i + 1);
+    }
+    std::vector<uint8_t> dst = MakeI420(2, 4, 0, 0, 0);
+
+    RgaJob job;
+    job.src = MakeRgaSurface(-1, src.data(), 4, 2, RgaPixelFormat::YUV420P);
+    job.dst = MakeRgaSurface(-1, dst.data(), 2, 4, RgaPixelFormat::YUV420P);
+    job.rotation = RgaRotation::ROT_90;
+    EXPECT_EQ(0, CreateRgaSoftBackend()->Run({job}));
+
+    const uint8_t expected[8] = {5, 1, 6, 2, 7, 3, 8, 4};
+    for (uint32_t i = 0; i < 8; i++) {
+        EXPECT_EQ(expected[i], dst[i]);
+    }
+}
+
+HWTEST_F(UtestRKRgaSession, CameraFormatsAndStrides, TestSize.Level0)
+{
+    RgaPixelFormat format = RgaPixelFormat::YUV420P;
+    EXPECT_TRUE(ToRgaPixelFormat(CAMERA_FORMAT_YCBCR_420_SP, format));
+    EXPECT_EQ(RgaPixelFormat::NV12, format);
+    EXPECT_TRUE(ToRgaPixelFormat(CAMERA_FORMAT_YCRCB_420_SP, format));
+    EXPECT_EQ(RgaPixelFormat::NV21, format);
+    EXPECT_TRUE(ToRgaPixelFormat(CAMERA_FORMAT_YUYV_422_PKG, format));
+    EXPECT_EQ(RgaPixelFormat::YUYV, format);
+    EXPECT_FALSE(ToRgaPixelFormat(CAMERA_FORMAT_RGB_565, format));
+    EXPECT_EQ(RgaPixelFormat::YUYV, format);
+
+    EXPECT_EQ(1024u, RgaStrideFromBytes(RgaPixelFormat::NV12, 1000, 1024));
+    EXPECT_EQ(1024u, RgaStrideFromBytes(RgaPixelFormat::YUYV, 1000, 2048));
+    EXPECT_EQ(1000u, RgaStrideFromBytes(RgaPixelFormat::YUYV, 1000, 0));
+    EXPECT_EQ(1000u, RgaStrideFromBytes(RgaPixelFormat::RGBA8888, 1000, 3000));
+
+}
+
+HWTEST_F(UtestRKRgaSession, SoftScalesStridedSemiPlanar, TestSize.Level0)
+{
+    // the same 8x4 nv12 picture tightly packed and with 16 pixel rows
+    constexpr uint32_t width = 8;
+    constexpr uint32_t height = 4;
+    constexpr uint32_t stride = 16;
+    std::vector<uint8_t> tight(width * height * 3 / 2);
+    std::vector<uint8_t> padded(stride * height * 3 / 2, 0xee);
+    for (uint32_t row = 0; row < height + height / 2; row++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t value = static_cast<uint8_t>(row * width + x);
+            tight[row * width + x] = value;
+            padded[row * stride + x] = value;
+        }
+    }
+
+    std::vector<uint8_t> fromTight(4 * 2 * 3 / 2, 0);
+    std::vector<uint8_t> fromPadded(fromTight.size(), 0);
+    RgaJob job;
+    job.src = MakeRgaSurface(-1, tight.data(), width, height, RgaPixelFormat::NV12);
+    job.dst = MakeRgaSurface(-1, fromTight.data(), 4, 2, RgaPixelFormat::YUV420P);
+    ASSERT_EQ(0, CreateRgaSoftBackend()->Run({job}));
+
+    job.src = MakeRgaSurface(-1, padded.data(), width, height, RgaPixelFormat::NV12);
+    job.src.wstride = RgaStrideFromBytes(RgaPixelFormat::NV12, width, stride);
+    ASSERT_EQ(stride, job.src.wstride);
+    job.dst.virAddr = fromPadded.data();
+    ASSERT_EQ(0, CreateRgaSoftBackend()->Run({job}));
+    EXPECT_EQ(fromTight, fromPadded);
+}
+
+HWTEST_F(UtestRKRgaSession, QueuedJobsRunAsOneBatch, TestSize.Level0)
+{
+    auto backend = std::make_shared<CountingBackend>();
+    RKRgaSession session(backend);
+    std::vector<uint8_t> a = MakeI420(8, 8, 50, 60, 70);
+    std::vector<uint8_t> b = MakeI420(8, 8, 0, 0, 0);
+    std::vector<uint8_t> c(8 * 8 * 4, 0);
+
+    RgaJob copy;
+    copy.src = MakeRgaSurface(-1, a.data(), 8, 8, RgaPixelFormat::YUV420P);
+    copy.dst = MakeRgaSurface(-1, b.data(), 8, 8, RgaPixelFormat::YUV420P);
+    RgaJob csc;
+    csc.src = copy.dst;
+    csc.dst = MakeRgaSurface(-1, c.data(), 8, 8, RgaPixelFormat::RGBA8888);
+
+    session.Queue(copy);
+    session.Queue(csc);
+    EXPECT_TRUE(backend->batchSizes.empty());
+    EXPECT_EQ(0, session.Sync());
+
+    ASSERT_EQ(1u, backend->batchSizes.size());
+    EXPECT_EQ(2u, backend->batchSizes[0]);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(255, c[3]);
+
+    EXPECT_EQ(0, session.Sync());
+    EXPECT_EQ(1u, backend->batchSizes.size());
+
+    RgaSessionStats stats = session.GetStats();
+    EXPECT_EQ(2u, stats.jobs);
+    EXPECT_EQ(1u, stats.batches);
+    EXPECT_EQ(0u, stats.errors);
+}
+
+HWTEST_F(UtestRKRgaSession, CommitRunsWithoutSync, TestSize.Level0)
+{
+    auto backend = std::make_shared<CountingBackend>();
+    RKRgaSession session(backend);
+    std::vector<uint8_t> a = MakeI420(8, 8, 90, 100, 110);
+    std::vector<uint8_t> b = MakeI420(8, 8, 0, 0, 0);
+
+    RgaJob copy;
+    copy.src = MakeRgaSurface(-1, a.data(), 8, 8, RgaPixelFormat::YUV420P);
+    copy.dst = MakeRgaSurface(-1, b.data(), 8, 8, RgaPixelFormat::YUV420P);
+    session.Queue(copy);
+    session.Commit();
+    session.Queue(copy);
+    EXPECT_EQ(0, session.Sync());
+
+    ASSERT_EQ(2u, backend->batchSizes.size());
+    EXPECT_EQ(a, b);
+}
+
+HWTEST_F(UtestRKRgaSession, FailedJobIsReportedBySync, TestSize.Level0)
+{
+    RKRgaSession session(CreateRgaSoftBackend());
+    RgaJob broken;
+    broken.src = MakeRgaSurface(-1, nullptr, 8, 8, RgaPixelFormat::YUV420P);
+    broken.dst = MakeRgaSurface(-1, nullptr, 8, 8, RgaPixelFormat::YUV420P);
+    session.Queue(broken);
+    EXPECT_NE(0, session.Sync());
+    EXPECT_EQ(0, session.Sync());
+    EXPECT_EQ(1u, session.GetStats().errors);
+}
+
+HWTEST_F(UtestRKRgaSession, ResultsStayWithTheirBatch, TestSize.Level0)
+{
+    RKRgaSession session(CreateRgaSoftBackend());
+    std::vector<uint8_t> a = MakeI420(8, 8, 90, 100, 110);
+    std::vector<uint8_t> b = MakeI420(8, 8, 0, 0, 0);
+    RgaJob broken;
+    broken.src = MakeRgaSurface(-1, nullptr, 8, 8, RgaPixelFormat::YUV420P);
+    broken.dst = MakeRgaSurface(-1, nullptr, 8, 8, RgaPixelFormat::YUV420P);
+    RgaJob copy;
+    copy.src = MakeRgaSurface(-1, a.data(), 8, 8, RgaPixelFormat::YUV420P);
+    copy.dst = MakeRgaSurface(-1, b.data(), 8, 8, RgaPixelFormat::YUV420P);
+
+    // one node's failed batch is committed, another node queues and syncs its own work after it
+    uint64_t failed = session.Queue(broken);
+    session.Commit();
+    uint64_t good = session.Queue(copy);
+    EXPECT_NE(failed, good);
+    EXPECT_EQ(0, session.Sync(good));
+    EXPECT_NE(0, session.Sync(failed));
+    EXPECT_NE(0, session.Sync(failed));
+    // nothing left to commit, nothing to report
+    EXPECT_EQ(0, session.Sync());
+    EXPECT_EQ(a, b);
+}
+
+HWTEST_F(UtestRKRgaSession, GroupedJobsShareOneBatch, TestSize.Level0)
+{
+    auto backend = std::make_shared<CountingBackend>();
+    RKRgaSession session(backend);
+    std::vector<uint8_t> a = MakeI420(8, 8, 90, 100, 110);
+    std::vector<uint8_t> b = MakeI420(8, 8, 0, 0, 0);
+    RgaJob copy;
+    copy.src = MakeRgaSurface(-1, a.data(), 8, 8, RgaPixelFormat::YUV420P);
+    copy.dst = MakeRgaSurface(-1, b.data(), 8, 8, RgaPixelFormat::YUV420P);
+
+    uint64_t upstream = session.Queue(copy);
+    uint64_t ticket = session.Queue({copy, copy});
+    EXPECT_EQ(upstream, ticket);
+    EXPECT_EQ(0, session.Sync(ticket));
+    ASSERT_EQ(1u, backend->batchSizes.size());
+    EXPECT_EQ(3u, backend->batchSizes[0]);
+}
+
+HWTEST_F(UtestRKRgaSession, SessionIsSharedPerStream, TestSize.Level0)
+{
+    constexpr int32_t streamId = 7;
+    std::shared_ptr<RKRgaSession> scale = RKRgaSession::Acquire(streamId);
+    std::shared_ptr<RKRgaSession> codec = RKRgaSession::Acquire(streamId);
+    std::shared_ptr<RKRgaSession> other = RKRgaSession::Acquire(streamId + 1);
+    ASSERT_NE(nullptr, scale);
+    EXPECT_EQ(scale, codec);
+    EXPECT_NE(scale, other);
+
+    codec->SetDeferredConsumer(true);
+    EXPECT_TRUE(scale->HasDeferredConsumer());
+
+    RKRgaSession::Release(streamId);
+    EXPECT_EQ(scale, RKRgaSession::Acquire(streamId));
+    RKRgaSession::Release(streamId);
+    RKRgaSession::Release(streamId);
+    RKRgaSession::Release(streamId + 1);
+
+    std::shared_ptr<RKRgaSession> fresh = RKRgaSession::Acquire(streamId);
+    EXPECT_NE(scale, fresh);
+    EXPECT_FALSE(fresh->HasDeferredConsumer());
+    RKRgaSession::Release(streamId);
+}
+
+HWTEST_F(UtestRKRgaSession, AllocatedBufferRoundTrip, TestSize.Level0)
+{
+    RKRgaSession session(CreateRgaSoftBackend());
+    RgaBuffer staging;
+    ASSERT_EQ(0, session.AllocBuffer(16, 16, RgaPixelFormat::YUV420P, staging));
+    EXPECT_EQ(RgaFrameSize(RgaPixelFormat::YUV420P, 16, 16), staging.size);
+
+    std::vector<uint8_t> frame = MakeI420(16, 16, 200, 90, 30);
+    std::vector<uint8_t> original = frame;
+    RgaJob stage;
+    stage.src = MakeRgaSurface(-1, frame.data(), 16, 16, RgaPixelFormat::YUV420P);
+    stage.dst = MakeRgaSurface(staging.fd, staging.virAddr, 16, 16, RgaPixelFormat::YUV420P);
+    RgaJob back;
+    back.src = stage.dst;
+    back.dst = stage.src;
+    session.Queue(stage);
+    session.Queue(back);
+    EXPECT_EQ(0, session.Sync());
+    EXPECT_EQ(original, frame);
+
+    session.FreeBuffer(staging);
+    EXPECT_EQ(nullptr, staging.handle);
+}
+} // namespace OHOS::Camera
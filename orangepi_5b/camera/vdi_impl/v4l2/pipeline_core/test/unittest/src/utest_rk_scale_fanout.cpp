@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "rk_scale_fanout.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t SRC_WIDTH = 3840;
+constexpr uint32_t SRC_HEIGHT = 2160;
+
+std::vector<RgaSurface> MakeOutputs()
+{
+    // added smallest first, the plan has to order them itself
+    return {
+        MakeRgaSurface(-1, nullptr, 640, 480, RgaPixelFormat::YUV420P),     // 640, 480: analysis
+        MakeRgaSurface(-1, nullptr, 1920, 1080, RgaPixelFormat::YUV420P),   // 1920, 1080: video
+        MakeRgaSurface(-1, nullptr, 1280, 720, RgaPixelFormat::NV12),       // 1280, 720: preview
+    };
+}
+
+std::vector<uint8_t> MakePattern(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    uint32_t seed = 7;
+    for (auto& b : data) {
+        seed = seed * 1103515245 + 12345;   // 1103515245, 12345: lcg
+        b = static_cast<uint8_t>(seed >> 16);   // 16: the better bits of the lcg
+    }
+    return data;
+}
+} // namespace
+
+HWTEST(UtestRKScaleFanOut, SharedPlanReadsTheSourceOnce, TestSize.Level0)
+{
+    RgaSurface src = MakeRgaSurface(-1, nullptr, SRC_WIDTH, SRC_HEIGHT, RgaPixelFormat::YUV420P);
+    std::vector<RgaSurface> dsts = MakeOutputs();
+    uint64_t srcBytes = RgaSurfaceBytes(src);
+    uint64_t writeBytes = 0;
+    for (auto& dst : dsts) {
+        writeBytes += RgaSurfaceBytes(dst);
+    }
+
+    std::vector<RgaJob> jobs;
+    FanOutTraffic traffic = PlanFanOut(src, dsts, FanOutMode::SHARED, true, jobs);
+    ASSERT_EQ(3u, jobs.size());
+    EXPECT_EQ(1920u, jobs[0].dst.width);
+    EXPECT_EQ(1280u, jobs[1].dst.width);
+    EXPECT_EQ(640u, jobs[2].dst.width);
+    for (auto& job : jobs) {
+        EXPECT_EQ(SRC_WIDTH, job.src.width);
+        EXPECT_FALSE(job.waitPrevious);
+    }
+    EXPECT_EQ(srcBytes, traffic.readBytes);
+    EXPECT_EQ(writeBytes, traffic.writeBytes);
+    EXPECT_EQ(srcBytes * 3 + writeBytes, traffic.naiveBytes);
+
+    // a backend that reads the source per job gets no discount
+    traffic = PlanFanOut(src, dsts, FanOutMode::SHARED, false, jobs);
+    EXPECT_EQ(srcBytes * 3, traffic.readBytes);
+
+    // cropped sources count their rect only
+    src.rect = {0, 0, SRC_WIDTH / 2, SRC_HEIGHT / 2};
+    EXPECT_EQ(srcBytes / 4, RgaSurfaceBytes(src));
+}
+
+HWTEST(UtestRKScaleFanOut, CascadeScalesFromTheSmallestLargerOutput, TestSize.Level0)
+{
+    RgaSurface src = MakeRgaSurface(-1, nullptr, SRC_WIDTH, SRC_HEIGHT, RgaPixelFormat::YUV420P);
+    std::vector<RgaSurface> dsts = MakeOutputs();
+    std::vector<RgaJob> jobs;
+    FanOutTraffic traffic = PlanFanOut(src, dsts, FanOutMode::CASCADE, false, jobs);
+    ASSERT_EQ(3u, jobs.size());
+    EXPECT_EQ(SRC_WIDTH, jobs[0].src.width);
+    EXPECT_EQ(1920u, jobs[0].dst.width);
+    EXPECT_FALSE(jobs[0].waitPrevious);
+    EXPECT_EQ(1920u, jobs[1].src.width);
+    EXPECT_EQ(1280u, jobs[1].dst.width);
+    EXPECT_TRUE(jobs[1].waitPrevious);
+    EXPECT_EQ(1280u, jobs[2].src.width);
+    EXPECT_EQ(RgaPixelFormat::NV12, jobs[2].src.format);
+    EXPECT_EQ(640u, jobs[2].dst.width);
+    EXPECT_TRUE(jobs[2].waitPrevious);
+    EXPECT_EQ(RgaSurfaceBytes(src) + RgaSurfaceBytes(dsts[1]) + RgaSurfaceBytes(dsts[2]), traffic.readBytes);
+    EXPECT_LT(traffic.readBytes + traffic.writeBytes, traffic.naiveBytes);
+
+    // an output taller than every other one comes from the source
+    dsts.push_back(MakeRgaSurface(-1, nullptr, 320, 2000, RgaPixelFormat::YUV420P));  // 320, 2000: portrait strip
+    PlanFanOut(src, dsts, FanOutMode::CASCADE, false, jobs);
+    ASSERT_EQ(4u, jobs.size());
+    EXPECT_EQ(SRC_WIDTH, jobs[1].src.width);
+    EXPECT_EQ(320u, jobs[1].dst.width);
+}
+
+HWTEST(UtestRKScaleFanOut, SoftBandedPassMatchesSeparateJobs, TestSize.Level0)
+{
+    constexpr uint32_t width = 640;
+    constexpr uint32_t height = 480;
+    std::vector<uint8_t> src = MakePattern(RgaFrameSize(RgaPixelFormat::YUV420P, width, height));
+    RgaSurface source = MakeRgaSurface(-1, src.data(), width, height, RgaPixelFormat::YUV420P);
+    source.rect = {16, 8, 600, 460};    // 16, 8, 600, 460: a crop, odd scale factors
+
+    std::vector<RgaSurface> shapes = {
+        MakeRgaSurface(-1, nullptr, 320, 240, RgaPixelFormat::NV12),        // 320, 240: half
+        MakeRgaSurface(-1, nullptr, 202, 150, RgaPixelFormat::YUV420P),     // 202, 150: odd ratio
+        MakeRgaSurface(-1, nullptr, 600, 460, RgaPixelFormat::RGBA8888),    // 600, 460: csc only
+        MakeRgaSurface(-1, nullptr, 1280, 960, RgaPixelFormat::YUYV),       // 1280, 960: upscale
+    };
+    std::vector<std::vector<uint8_t>> banded;
+    std::vector<std::vector<uint8_t>> separate;
+    std::vector<RgaJob> batch;
+    for (auto& shape : shapes) {
+        size_t size = RgaFrameSize(shape.format, shape.width, shape.height);
+        banded.emplace_back(size, 0);
+        separate.emplace_back(size, 0);
+    }
+    for (size_t i = 0; i < shapes.size(); i++) {
+        RgaJob job;
+        job.src = source;
+        job.dst = shapes[i];
+        job.dst.virAddr = banded[i].data();
+        batch.push_back(job);
+    }
+
+    auto soft = CreateRgaSoftBackend();
+    ASSERT_TRUE(soft->SharesSourceReads());
+    ASSERT_EQ(0, soft->Run(batch));
+    for (size_t i = 0; i < shapes.size(); i++) {
+        RgaJob job = batch[i];
+        job.dst.virAddr = separate[i].data();
+        ASSERT_EQ(0, soft->Run({job}));
+        EXPECT_EQ(separate[i], banded[i]) << "output " << i;
+    }
+}
+} // namespace OHOS::Camera
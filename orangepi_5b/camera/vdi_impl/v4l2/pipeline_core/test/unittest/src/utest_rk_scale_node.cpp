@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "pipeline_bench.h"
+#include "rk_codec_node.h"
+#include "rk_node_params.h"
+#include "rk_rga_session.h"
+#include "rk_scale_node.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr uint64_t POOL_ID = 1;
+constexpr int32_t STREAM_ID = 1;
+constexpr uint32_t SENSOR_WIDTH = 128;
+constexpr uint32_t SENSOR_HEIGHT = 64;
+constexpr uint32_t WIDTH = 64;
+constexpr uint32_t HEIGHT = 32;
+constexpr uint32_t RGBA_BPP = 4;
+constexpr int64_t TIMEOUT_MS = 1000;
+constexpr int32_t WARMUP_FRAMES = 4;
+constexpr int32_t FRAMES = 200;
+
+// the software backend, with the size of every batch it ran kept for the test to look at
+class BatchRecordingBackend : public IRgaBackend {
+public:
+    int32_t Run(const std::vector<RgaJob>& batch) override
+    {
+        {
+            std::unique_lock<std::mutex> l(lock_);
+            batches_.push_back(batch.size());
+        }
+        return soft_->Run(batch);
+    }
+    int32_t AllocBuffer(uint32_t width, uint32_t height, RgaPixelFormat format, RgaBuffer& buffer) override
+    {
+        return soft_->AllocBuffer(width, height, format, buffer);
+    }
+    void FreeBuffer(RgaBuffer& buffer) override
+    {
+        soft_->FreeBuffer(buffer);
+    }
+
+    static std::vector<size_t> TakeBatches()
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        std::vector<size_t> batches;
+        batches.swap(batches_);
+        return batches;
+    }
+
+private:
+    std::shared_ptr<IRgaBackend> soft_ = CreateRgaSoftBackend();
+    static std::mutex lock_;
+    static std::vector<size_t> batches_;
+};
+
+std::mutex BatchRecordingBackend::lock_;
+std::vector<size_t> BatchRecordingBackend::batches_;
+
+class ForwardPort : public IPort {
+public:
+    ForwardPort(const PortFormat& format, std::function<void(std::shared_ptr<IBuffer>&)> next)
+        : next_(std::move(next))
+    {
+        format_ = format;
+    }
+    void DeliverBuffer(std::shared_ptr<IBuffer>& buffer) override
+    {
+        next_(buffer);
+    }
+
+private:
+    std::function<void(std::shared_ptr<IBuffer>&)> next_;
+};
+
+class UtestRKScaleNode : public testing::Test {
+public:
+    static void SetUpTestCase()
+    {
+        RKRgaSession::SetBackendFactory([] { return std::make_shared<BatchRecordingBackend>(); });
+        SetBenchParameter(RK_PARAM_JPEG_WORKERS, "0");
+    }
+
+    // RKScaleNode, then RKCodecNode when withCodec, then the sink, like the pipeline bench wires them;
+    // the sensor frame is in config_.sensorFormat
+    void Build(EncodeType encode, int32_t format, bool withCodec)
+    {
+        config_.graph = {BenchNodeType::SCALE};
+        if (withCodec) {
+            config_.graph.push_back(BenchNodeType::CODEC);
+        }
+        config_.encode = encode;
+        config_.sensorWidth = SENSOR_WIDTH;
+        config_.sensorHeight = SENSOR_HEIGHT;
+        config_.width = WIDTH;
+        config_.height = HEIGHT;
+        config_.format = format;
+        config_.buffers = 1;
+        pool_ = std::make_shared<BenchBufferPool>();
+        std::string error;
+        ASSERT_TRUE(pool_->Init(config_, error)) << error;
+        BufferManager::GetInstance()->AddBufferPool(POOL_ID, pool_);
+
+        PortFormat sensor;
+        sensor.w_ = SENSOR_WIDTH;
+        sensor.h_ = SENSOR_HEIGHT;
+        sensor.format_ = static_cast<uint32_t>(config_.sensorFormat);
+        PortFormat stream;
+        stream.w_ = WIDTH;
+        stream.h_ = HEIGHT;
+        stream.format_ = static_cast<uint32_t>(format);
+        stream.bufferCount_ = config_.buffers;
+        stream.bufferPoolId_ = POOL_ID;
+        stream.streamId_ = STREAM_ID;
+
+        auto sink = [this](std::shared_ptr<IBuffer>& buffer) { delivered_.push_back(buffer); };
+        scale_ = std::make_shared<RKScaleNode>("RKScale#0", "RKScale", "0");
+        scale_->SetSourceSize(SENSOR_WIDTH, SENSOR_HEIGHT);
+        scale_->AddInPort(std::make_shared<ForwardPort>(sensor, [](std::shared_ptr<IBuffer>&) {}));
+        if (withCodec) {
+            codec_ = std::make_shared<RKCodecNode>("RKCodec#1", "RKCodec", "0");
+            codec_->AddOutPort(std::make_shared<ForwardPort>(stream, sink));
+            scale_->AddOutPort(std::make_shared<ForwardPort>(stream,
+                [this](std::shared_ptr<IBuffer>& buffer) { codec_->DeliverBuffer(buffer); }));
+        } else {
+            scale_->AddOutPort(std::make_shared<ForwardPort>(stream, sink));
+        }
+        ASSERT_EQ(RC_OK, scale_->Start(STREAM_ID));
+        if (codec_ != nullptr) {
+            ASSERT_EQ(RC_OK, codec_->Start(STREAM_ID));
+        }
+        BatchRecordingBackend::TakeBatches();
+    }
+
+    void TearDown() override
+    {
+        if (codec_ != nullptr) {
+            codec_->Stop(STREAM_ID);
+        }
+        if (scale_ != nullptr) {
+            scale_->Stop(STREAM_ID);
+        }
+        BufferManager::GetInstance()->RemoveBufferPool(POOL_ID);
+        BatchRecordingBackend::TakeBatches();
+    }
+
+    std::shared_ptr<IBuffer> DeliverFrame()
+    {
+        std::shared_ptr<IBuffer> buffer = pool_->Acquire(TIMEOUT_MS);
+        if (buffer == nullptr) {
+            return nullptr;
+        }
+        pool_->Prepare(buffer, STREAM_ID, 0, 0);
+        scale_->DeliverBuffer(buffer);
+        pool_->Release(buffer->GetIndex());
+        return buffer;
+    }
+
+    // the sensor frame scaled to tight I420 and that turned into RGBA, by the software backend
+    void ExpectedFrame(std::vector<uint8_t>& yuv, std::vector<uint8_t>& rgba)
+    {
+        std::map<int32_t, uint8_t*> fork = pool_->getSFBuffer(pool_->GetForkBufferId());
+        RgaPixelFormat sensor = RgaPixelFormat::YUV420P;
+        ASSERT_FALSE(fork.empty());
+        ASSERT_TRUE(ToRgaPixelFormat(config_.sensorFormat, sensor));
+        yuv.assign(RgaFrameSize(RgaPixelFormat::YUV420P, WIDTH, HEIGHT), 0);
+        rgba.assign(WIDTH * HEIGHT * RGBA_BPP, 0);
+        RgaJob scale;
+        scale.src = MakeRgaSurface(-1, fork.begin()->second, SENSOR_WIDTH, SENSOR_HEIGHT, sensor);
+        scale.dst = MakeRgaSurface(-1, yuv.data(), WIDTH, HEIGHT, RgaPixelFormat::YUV420P);
+        RgaJob csc;
+        csc.src = scale.dst;
+        csc.dst = MakeRgaSurface(-1, rgba.data(), WIDTH, HEIGHT, RgaPixelFormat::RGBA8888);
+        std::shared_ptr<IRgaBackend> soft = CreateRgaSoftBackend();
+        ASSERT_EQ(0, soft->Run({scale}));
+        ASSERT_EQ(0, soft->Run({csc}));
+    }
+
+    // a preview frame through the scale and the codec node comes out as the RGBA of the scaled frame
+    void CheckPreviewPixels(int32_t sensorFormat, int32_t streamFormat)
+    {
+        config_.sensorFormat = sensorFormat;
+        Build(ENCODE_TYPE_NULL, streamFormat, true);
+        std::shared_ptr<IBuffer> buffer = DeliverFrame();
+        ASSERT_NE(nullptr, buffer);
+        ASSERT_EQ(1u, delivered_.size());
+        std::vector<uint8_t> yuv;
+        std::vector<uint8_t> rgba;
+        ExpectedFrame(yuv, rgba);
+        EXPECT_EQ(0, memcmp(rgba.data(), delivered_[0]->GetVirAddress(), rgba.size()));
+    }
+
+    // operator new calls of this thread inside RKScaleNode::DeliverBuffer over that many frames
+    uint64_t CountDeliverAllocations(int32_t frames)
+    {
+        delivered_.reserve(delivered_.size() + static_cast<size_t>(frames));
+        uint64_t calls = 0;
+        for (int32_t n = 0; n < frames; n++) {
+            std::shared_ptr<IBuffer> buffer = pool_->Acquire(TIMEOUT_MS);
+            if (buffer == nullptr) {
+                ADD_FAILURE() << "no buffer for frame " << n;
+                break;
+            }
+            pool_->Prepare(buffer, STREAM_ID, 0, 0);
+            BenchAllocCount before = GetThreadAllocs();
+            scale_->DeliverBuffer(buffer);
+            calls += GetThreadAllocs().calls - before.calls;
+            pool_->Release(buffer->GetIndex());
+        }
+        return calls;
+    }
+
+    PipelineBenchConfig config_;
+    std::shared_ptr<BenchBufferPool> pool_ = nullptr;
+    std::shared_ptr<RKScaleNode> scale_ = nullptr;
+    std::shared_ptr<RKCodecNode> codec_ = nullptr;
+    std::vector<std::shared_ptr<IBuffer>> delivered_;
+};
+} // namespace
+
+HWTEST_F(UtestRKScaleNode, ScaleGoesOutInTheCodecBatch, TestSize.Level0)
+{
+    Build(ENCODE_TYPE_NULL, CAMERA_FORMAT_YCBCR_420_P, true);
+    ASSERT_NE(nullptr, DeliverFrame());
+    ASSERT_EQ(1u, delivered_.size());
+
+    // the scale waits in the stream session for the staging copy and the csc of the codec node
+    std::vector<size_t> batches = BatchRecordingBackend::TakeBatches();
+    ASSERT_EQ(1u, batches.size());
+    EXPECT_EQ(3u, batches[0]);
+}
+
+HWTEST_F(UtestRKScaleNode, ScaleWithoutConsumerIsSynced, TestSize.Level0)
+{
+    Build(ENCODE_TYPE_NULL, CAMERA_FORMAT_YCBCR_420_P, false);
+    ASSERT_NE(nullptr, DeliverFrame());
+    ASSERT_EQ(1u, delivered_.size());
+
+    std::vector<size_t> batches = BatchRecordingBackend::TakeBatches();
+    ASSERT_EQ(1u, batches.size());
+    EXPECT_EQ(1u, batches[0]);
+}
+
+// the sf buffer cache, the port table and the session keep what a frame needs once the first ones went through
+HWTEST_F(UtestRKScaleNode, PreviewFramesDoNotAllocate, TestSize.Level0)
+{
+    Build(ENCODE_TYPE_NULL, CAMERA_FORMAT_YCBCR_420_P, false);
+    CountDeliverAllocations(WARMUP_FRAMES);
+    EXPECT_EQ(0u, CountDeliverAllocations(FRAMES));
+    EXPECT_EQ(static_cast<size_t>(WARMUP_FRAMES + FRAMES), delivered_.size());
+}
+
+HWTEST_F(UtestRKScaleNode, EncodedFramesDoNotAllocate, TestSize.Level0)
+{
+    Build(ENCODE_TYPE_H264, CAMERA_FORMAT_YCBCR_420_P, false);
+    CountDeliverAllocations(WARMUP_FRAMES);
+    EXPECT_EQ(0u, CountDeliverAllocations(FRAMES));
+    EXPECT_EQ(static_cast<size_t>(WARMUP_FRAMES + FRAMES), delivered_.size());
+}
+
+HWTEST_F(UtestRKScaleNode, PreviewPixelsOfAnI420Stream, TestSize.Level0)
+{
+    CheckPreviewPixels(CAMERA_FORMAT_YCBCR_420_P, CAMERA_FORMAT_YCBCR_420_P);
+}
+
+HWTEST_F(UtestRKScaleNode, PreviewPixelsOfAnRgbaStream, TestSize.Level0)
+{
+    CheckPreviewPixels(CAMERA_FORMAT_YCBCR_420_P, CAMERA_FORMAT_RGBA_8888);
+}
+
+HWTEST_F(UtestRKScaleNode, PreviewPixelsOfAnNv12Stream, TestSize.Level0)
+{
+    CheckPreviewPixels(CAMERA_FORMAT_YCBCR_420_P, CAMERA_FORMAT_YCBCR_420_SP);
+}
+
+HWTEST_F(UtestRKScaleNode, PreviewPixelsOfAnNv21Stream, TestSize.Level0)
+{
+    CheckPreviewPixels(CAMERA_FORMAT_YCBCR_420_P, CAMERA_FORMAT_YCRCB_420_SP);
+}
+
+HWTEST_F(UtestRKScaleNode, PreviewPixelsFromAnNv12Sensor, TestSize.Level0)
+{
+    CheckPreviewPixels(CAMERA_FORMAT_YCBCR_420_SP, CAMERA_FORMAT_RGBA_8888);
+}
+
+HWTEST_F(UtestRKScaleNode, PreviewPixelsFromAYuyvSensor, TestSize.Level0)
+{
+    CheckPreviewPixels(CAMERA_FORMAT_YUYV_422_PKG, CAMERA_FORMAT_RGBA_8888);
+}
+
+// the video encoder and the jpeg backends get tight I420 whatever the stream format says
+HWTEST_F(UtestRKScaleNode, EncodedFrameIsI420ForEveryStreamFormat, TestSize.Level0)
+{
+    Build(ENCODE_TYPE_H264, CAMERA_FORMAT_YCRCB_420_SP, false);
+    std::shared_ptr<IBuffer> buffer = DeliverFrame();
+    ASSERT_NE(nullptr, buffer);
+    std::vector<uint8_t> yuv;
+    std::vector<uint8_t> rgba;
+    ExpectedFrame(yuv, rgba);
+    EXPECT_EQ(0, memcmp(yuv.data(), buffer->GetVirAddress(), yuv.size()));
+}
+} // namespace OHOS::Camera
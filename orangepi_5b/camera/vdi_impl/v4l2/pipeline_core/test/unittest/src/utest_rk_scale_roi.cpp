@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "rk_scale_fanout.h"
+#include "rk_scale_roi.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t SRC_WIDTH = 1920;
+constexpr uint32_t SRC_HEIGHT = 1080;
+constexpr uint32_t DST_WIDTH = 1280;
+constexpr uint32_t DST_HEIGHT = 720;
+
+ScaleCrop Zoom(float zoom)
+{
+    ScaleCrop crop;
+    crop.zoom = zoom;
+    return crop;
+}
+
+ScaleCrop Region(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    ScaleCrop crop;
+    crop.region = {x, y, width, height};
+    return crop;
+}
+} // namespace
+
+HWTEST(UtestRKScaleRoi, NoZoomIsTheFullFrame, TestSize.Level0)
+{
+    RgaRect full;
+    EXPECT_EQ(full, ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, ScaleCrop {}, DST_WIDTH, DST_HEIGHT));
+    EXPECT_EQ(full, ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, Zoom(0.5f), DST_WIDTH, DST_HEIGHT));
+    EXPECT_EQ(full, ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, Region(0, 0, 4000, 3000), DST_WIDTH, DST_HEIGHT));
+    EXPECT_EQ(full, ResolveScaleRoi(0, 0, Zoom(2.0f), DST_WIDTH, DST_HEIGHT));
+}
+
+HWTEST(UtestRKScaleRoi, ZoomIsACentredWindow, TestSize.Level0)
+{
+    RgaRect roi = ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, Zoom(2.0f), DST_WIDTH, DST_HEIGHT);
+    EXPECT_EQ(RgaRect({480, 270 & ~1u, 960, 540}), roi);
+
+    // 3x does not divide evenly, edges stay even
+    roi = ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, Zoom(3.0f), DST_WIDTH, DST_HEIGHT);
+    EXPECT_EQ(640u, roi.width);
+    EXPECT_EQ(360u, roi.height);
+    EXPECT_EQ(0u, roi.x % 2);
+    EXPECT_EQ(0u, roi.y % 2);
+    EXPECT_EQ(640u, roi.x);
+    EXPECT_EQ(360u, roi.y);
+
+    // far past what RGA can upscale: held at 1/16 of the output
+    roi = ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, Zoom(1000.0f), DST_WIDTH, DST_HEIGHT);
+    EXPECT_EQ(DST_WIDTH / 16, roi.width);
+    EXPECT_EQ(46u, roi.height);     // 46: 720 / 16 rounded up to even
+    EXPECT_LE(roi.x + roi.width, SRC_WIDTH);
+
+    // the estimate follows the window
+    RgaSurface src = MakeRgaSurface(-1, nullptr, SRC_WIDTH, SRC_HEIGHT, RgaPixelFormat::NV12);
+    uint64_t fullBytes = RgaSurfaceBytes(src);
+    src.rect = ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, Zoom(4.0f), DST_WIDTH, DST_HEIGHT);
+    EXPECT_EQ(fullBytes / 16, RgaSurfaceBytes(src));
+}
+
+HWTEST(UtestRKScaleRoi, RegionIsClippedToTheFrame, TestSize.Level0)
+{
+    // odd edges are rounded to the chroma grid
+    RgaRect roi = ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, Region(101, 51, 641, 361), DST_WIDTH, DST_HEIGHT);
+    EXPECT_EQ(RgaRect({100, 50, 640, 360}), roi);
+
+    // hanging over the bottom right corner
+    roi = ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, Region(1600, 900, 800, 600), DST_WIDTH, DST_HEIGHT);
+    EXPECT_EQ(RgaRect({1600, 900, 320, 180}), roi);
+
+    // the region wins over the zoom ratio, and one outside the frame is ignored
+    ScaleCrop crop = Region(0, 0, 960, 540);
+    crop.zoom = 4.0f;
+    EXPECT_EQ(RgaRect({0, 0, 960, 540}), ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, crop, DST_WIDTH, DST_HEIGHT));
+    crop.region.x = SRC_WIDTH;
+    EXPECT_EQ(480u, ResolveScaleRoi(SRC_WIDTH, SRC_HEIGHT, crop, DST_WIDTH, DST_HEIGHT).width);
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <map>
+#include <vector>
+
+#include "rk_sf_buffer_cache.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr uint32_t BUFFER_COUNT = 4;
+constexpr int32_t FORK_INDEX = 10;
+constexpr int32_t FRAMES = 1000;
+
+class FakePool {
+public:
+    FakePool() : buffers_(FORK_INDEX + 1, std::vector<uint8_t>(64)) {}    // 64: any size
+
+    std::map<int32_t, uint8_t*> GetSFBuffer(int32_t index)
+    {
+        lookups_++;
+        std::map<int32_t, uint8_t*> sizeVirMap;
+        if (index >= 0 && static_cast<size_t>(index) < buffers_.size() && !missing_) {
+            sizeVirMap[static_cast<int32_t>(buffers_[index].size())] = buffers_[index].data();
+        }
+        return sizeVirMap;
+    }
+
+    uint8_t* Addr(int32_t index)
+    {
+        return buffers_[index].data();
+    }
+
+    uint32_t lookups_ = 0;
+    bool missing_ = false;
+
+private:
+    std::vector<std::vector<uint8_t>> buffers_;
+};
+} // namespace
+
+HWTEST(UtestRKSFBufferCache, ResolvedOnceAtReset, TestSize.Level0)
+{
+    FakePool pool;
+    RKSFBufferCache cache;
+    SFBufferView view;
+    EXPECT_FALSE(cache.Get(0, view));
+
+    auto lookup = [&pool](int32_t index) { return pool.GetSFBuffer(index); };
+    EXPECT_TRUE(cache.Reset(1, BUFFER_COUNT, lookup));
+    EXPECT_EQ(BUFFER_COUNT, pool.lookups_);
+    for (int32_t frame = 0; frame < FRAMES; frame++) {
+        int32_t index = frame % BUFFER_COUNT;
+        ASSERT_TRUE(cache.Get(index, view));
+        EXPECT_EQ(pool.Addr(index), view.addr);
+        EXPECT_EQ(64, view.size);   // 64: FakePool buffer size
+    }
+    EXPECT_EQ(BUFFER_COUNT, pool.lookups_);
+
+    // the fork buffer sits past the pool's buffers and is looked up on first use only
+    ASSERT_TRUE(cache.Get(FORK_INDEX, view));
+    ASSERT_TRUE(cache.Get(FORK_INDEX, view));
+    EXPECT_EQ(pool.Addr(FORK_INDEX), view.addr);
+    EXPECT_EQ(BUFFER_COUNT + 1, pool.lookups_);
+    EXPECT_FALSE(cache.Get(-1, view));
+
+    // the same pool again keeps the cache, another one or another count drops it
+    EXPECT_FALSE(cache.Reset(1, BUFFER_COUNT, lookup));
+    EXPECT_EQ(BUFFER_COUNT + 1, pool.lookups_);
+    EXPECT_TRUE(cache.Reset(1, BUFFER_COUNT - 1, lookup));
+    EXPECT_TRUE(cache.Reset(2, BUFFER_COUNT - 1, lookup));   // 2: another pool
+    EXPECT_EQ(3u, cache.GetStats().resets);
+
+    cache.Invalidate();
+    EXPECT_FALSE(cache.Get(0, view));
+}
+
+HWTEST(UtestRKSFBufferCache, MissingBufferIsRetried, TestSize.Level0)
+{
+    FakePool pool;
+    pool.missing_ = true;
+    RKSFBufferCache cache;
+    cache.Reset(1, BUFFER_COUNT, [&pool](int32_t index) { return pool.GetSFBuffer(index); });
+    SFBufferView view;
+    EXPECT_FALSE(cache.Get(0, view));
+
+    pool.missing_ = false;
+    ASSERT_TRUE(cache.Get(0, view));
+    EXPECT_EQ(pool.Addr(0), view.addr);
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "rk_snapshot_ring.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+// an exif snapshot in shape: doubles, flags and padding
+struct Settings {
+    double gps[3] = {};
+    bool hasGps = false;
+    uint8_t quality = 0;
+    int32_t orientation = 0;
+};
+
+Settings MakeSettings(int32_t n)
+{
+    Settings s;
+    for (double& v : s.gps) {
+        v = n;
+    }
+    s.hasGps = true;
+    s.quality = static_cast<uint8_t>(n);
+    s.orientation = n;
+    return s;
+}
+} // namespace
+
+HWTEST(UtestRKSnapshotRing, FindsTheSnapshotOfItsKey, TestSize.Level0)
+{
+    RKSnapshotRing<Settings, 4> ring;
+    Settings out;
+    EXPECT_FALSE(ring.Latest(out));
+    EXPECT_FALSE(ring.Find(0, out));
+
+    for (int32_t capture = 1; capture <= 3; capture++) {    // 3: fewer than the slots
+        ring.Publish(capture, MakeSettings(capture * 10));  // 10: settings differ from the key
+    }
+    ASSERT_TRUE(ring.Find(2, out));
+    EXPECT_EQ(20, out.orientation);
+    EXPECT_DOUBLE_EQ(20.0, out.gps[2]);
+    ASSERT_TRUE(ring.Latest(out));
+    EXPECT_EQ(30, out.orientation);
+    EXPECT_FALSE(ring.Find(4, out));
+
+    // the same key again, the newer one wins
+    ring.Publish(2, MakeSettings(21));
+    ASSERT_TRUE(ring.Find(2, out));
+    EXPECT_EQ(21, out.orientation);
+
+    // a fifth publish pushes out capture 1
+    ring.Publish(5, MakeSettings(50));
+    EXPECT_FALSE(ring.Find(1, out));
+    ASSERT_TRUE(ring.Find(3, out));
+    EXPECT_EQ(30, out.orientation);
+    EXPECT_EQ(5u, ring.GetPublishCount());
+}
+
+// one slot is a plain seqlock, the current settings beside the ring of captures
+HWTEST(UtestRKSnapshotRing, OneSlotKeepsTheNewest, TestSize.Level0)
+{
+    RKSnapshotRing<Settings, 1> current;
+    Settings out;
+    EXPECT_FALSE(current.Latest(out));
+    current.Publish(-1, MakeSettings(1));
+    current.Publish(-1, MakeSettings(2));
+    ASSERT_TRUE(current.Latest(out));
+    EXPECT_EQ(2, out.orientation);
+    ASSERT_TRUE(current.Find(-1, out));
+    EXPECT_EQ(2, out.orientation);
+}
+
+HWTEST(UtestRKSnapshotRing, ReadersNeverSeeAPartialSnapshot, TestSize.Level0)
+{
+    constexpr int32_t publishes = 50000;
+    constexpr uint32_t readers = 3;
+    RKSnapshotRing<Settings, 8> ring;
+    std::atomic<bool> done {false};
+    std::atomic<uint64_t> torn {0};
+
+    std::vector<std::thread> threads;
+    for (uint32_t r = 0; r < readers; r++) {
+        threads.emplace_back([&] {
+            Settings s;
+            int64_t key = 0;
+            while (!done.load()) {
+                if (ring.Latest(s) && (s.gps[0] != s.orientation || s.gps[2] != s.orientation ||   // 2: altitude
+                    s.quality != static_cast<uint8_t>(s.orientation))) {
+                    torn++;
+                }
+                // the key and its value come from the same write
+                if (ring.Find(++key % publishes, s) && s.orientation != key % publishes) {
+                    torn++;
+                }
+            }
+        });
+    }
+    for (int32_t i = 1; i <= publishes; i++) {
+        ring.Publish(i, MakeSettings(i));
+    }
+    done = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(0u, torn.load());
+}
+} // namespace OHOS::Camera
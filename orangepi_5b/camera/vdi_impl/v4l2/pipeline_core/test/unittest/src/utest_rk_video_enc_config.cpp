@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "rk_video_enc_config.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+HWTEST(UtestRKVideoEncConfig, DefaultsFollowTheFrameSize, TestSize.Level0)
+{
+    VideoEncConfig config;
+    VideoRateControl rc = ResolveVideoRateControl(config, 1920, 1080);
+    EXPECT_EQ(VideoRcMode::VBR, rc.mode);
+    EXPECT_EQ(1920 * 1080 * 30 / 8, rc.bpsTarget);
+    EXPECT_EQ(60, rc.gop);
+    EXPECT_EQ(10, rc.qpMin);
+    EXPECT_EQ(51, rc.qpMax);
+
+    config.fps = 60;
+    rc = ResolveVideoRateControl(config, 1920, 1080);
+    EXPECT_EQ(1920 * 1080 * 60 / 8, rc.bpsTarget);
+    EXPECT_EQ(120, rc.gop);
+}
+
+HWTEST(UtestRKVideoEncConfig, BoundsFollowTheMode, TestSize.Level0)
+{
+    VideoEncConfig config;
+    config.bitrate = 4000000;
+    config.rcMode = VideoRcMode::CBR;
+    VideoRateControl cbr = ResolveVideoRateControl(config, 1280, 720);
+    EXPECT_EQ(4000000, cbr.bpsTarget);
+    EXPECT_EQ(4250000, cbr.bpsMax);
+    EXPECT_EQ(3750000, cbr.bpsMin);
+
+    config.rcMode = VideoRcMode::AVBR;
+    VideoRateControl avbr = ResolveVideoRateControl(config, 1280, 720);
+    EXPECT_EQ(4250000, avbr.bpsMax);
+    EXPECT_EQ(250000, avbr.bpsMin);
+    EXPECT_TRUE(avbr != cbr);
+    EXPECT_TRUE(avbr == ResolveVideoRateControl(config, 1280, 720));
+}
+
+HWTEST(UtestRKVideoEncConfig, OutOfRangeValuesAreClamped, TestSize.Level0)
+{
+    VideoEncConfig config;
+    config.bitrate = 1000;
+    config.gop = 100000;
+    config.qpMin = 60;
+    config.qpMax = 20;
+    VideoRateControl rc = ResolveVideoRateControl(config, 640, 480);
+    EXPECT_EQ(64000, rc.bpsTarget);
+    EXPECT_EQ(1000, rc.gop);
+    EXPECT_EQ(20, rc.qpMin);
+    EXPECT_EQ(51, rc.qpMax);
+
+    config.bitrate = 0x7fffffff;
+    EXPECT_EQ(100000000, ResolveVideoRateControl(config, 640, 480).bpsTarget);
+
+    VideoRcMode mode = VideoRcMode::VBR;
+    EXPECT_TRUE(ToVideoRcMode(0, mode));
+    EXPECT_EQ(VideoRcMode::CBR, mode);
+    EXPECT_FALSE(ToVideoRcMode(3, mode));
+    EXPECT_FALSE(ToVideoRcMode(-1, mode));
+    EXPECT_EQ(VideoRcMode::CBR, mode);
+}
+} // namespace OHOS::Camera
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "rk_video_encoder.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+constexpr int32_t STREAM_ID = 3;
+constexpr uint32_t WIDTH = 64;
+constexpr uint32_t HEIGHT = 48;
+constexpr uint32_t ALIVE = 0x600dc0de;
+constexpr uint32_t DEAD = 0xdeadbeef;
+constexpr uint32_t STRESS_CYCLES = 5000;
+constexpr uint32_t STRESS_ENCODERS = 2;
+std::atomic<int32_t> g_liveEncoders {0};
+std::atomic<uint64_t> g_brokenEncodes {0};
+
+// stands in for the mpp context: any use after delete shows up as a broken encode
+class FakeVideoEncoder : public IVideoEncoder {
+public:
+    FakeVideoEncoder()
+    {
+        g_liveEncoders++;
+    }
+    ~FakeVideoEncoder() override
+    {
+        state_ = DEAD;
+        g_liveEncoders--;
+    }
+    bool SetRateControl(const VideoRateControl& rc) override
+    {
+        return state_ == ALIVE;
+    }
+    int32_t Encode(const VideoFrame& frame, size_t& esSize) override
+    {
+        if (state_ != ALIVE || busy_.exchange(true)) {
+            g_brokenEncodes++;
+            return -1;
+        }
+        std::this_thread::yield();
+        esSize = 1;
+        busy_ = false;
+        return state_ == ALIVE ? 0 : -1;
+    }
+
+private:
+    std::atomic<uint32_t> state_ {ALIVE};
+    std::atomic<bool> busy_ {false};
+};
+
+std::unique_ptr<IVideoEncoder> CreateFakeEncoder(NalCodec codec, uint32_t width, uint32_t height)
+{
+    return std::make_unique<FakeVideoEncoder>();
+}
+
+// the encode path of RKCodecNode: acquire, then encode under the session lock
+bool EncodeOne(RKVideoEncoderHandle& handle, NalCodec codec, uint32_t width)
+{
+    std::shared_ptr<VideoEncoderSession> session = handle.Acquire(STREAM_ID, codec, width, HEIGHT);
+    if (session == nullptr) {
+        return false;
+    }
+    std::unique_lock<std::mutex> l(session->encodeLock);
+    session->encoder->SetRateControl(session->rc);
+    size_t esSize = 0;
+    return session->encoder->Encode(VideoFrame(), esSize) == 0;
+}
+
+class UtestRKVideoEncoder : public testing::Test {
+public:
+    void SetUp() override
+    {
+        g_liveEncoders = 0;
+        g_brokenEncodes = 0;
+    }
+};
+} // namespace
+
+HWTEST_F(UtestRKVideoEncoder, SessionIsReusedUntilParametersChange, TestSize.Level0)
+{
+    RKVideoEncoderHandle handle(CreateFakeEncoder);
+    handle.Open(STREAM_ID);
+    auto first = handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT);
+    ASSERT_NE(nullptr, first);
+    EXPECT_EQ(first, handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT));
+
+    auto hevc = handle.Acquire(STREAM_ID, NalCodec::H265, WIDTH, HEIGHT);
+    ASSERT_NE(nullptr, hevc);
+    EXPECT_NE(first, hevc);
+    // the old context lives on while a frame holds it
+    EXPECT_EQ(2, g_liveEncoders.load());
+    first = nullptr;
+    EXPECT_EQ(1, g_liveEncoders.load());
+
+    auto resized = handle.Acquire(STREAM_ID, NalCodec::H265, WIDTH * 2, HEIGHT);
+    ASSERT_NE(nullptr, resized);
+    EXPECT_EQ(WIDTH * 2, resized->width);
+    VideoEncoderHandleStats stats = handle.GetStats();
+    EXPECT_EQ(3u, stats.created);
+    EXPECT_EQ(2u, stats.retired);
+}
+
+HWTEST_F(UtestRKVideoEncoder, CloseKeepsInFlightFramesAndBlocksLateOnes, TestSize.Level0)
+{
+    RKVideoEncoderHandle handle(CreateFakeEncoder);
+    handle.Open(STREAM_ID);
+    auto inFlight = handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT);
+    ASSERT_NE(nullptr, inFlight);
+
+    handle.Close(STREAM_ID);
+    EXPECT_EQ(1, g_liveEncoders.load());
+    size_t esSize = 0;
+    EXPECT_EQ(0, inFlight->encoder->Encode(VideoFrame(), esSize));
+    inFlight = nullptr;
+    EXPECT_EQ(0, g_liveEncoders.load());
+
+    // a frame arriving after Stop must not bring a context back
+    EXPECT_EQ(nullptr, handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT));
+    EXPECT_EQ(0, g_liveEncoders.load());
+
+    // closing another stream leaves this one alone
+    handle.Open(STREAM_ID);
+    auto session = handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT);
+    ASSERT_NE(nullptr, session);
+    handle.Close(STREAM_ID + 1);
+    EXPECT_EQ(session, handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT));
+}
+
+// a preview-sized and a recording-sized stream encoding side by side each keep their own context
+HWTEST_F(UtestRKVideoEncoder, StreamsKeepTheirOwnSessions, TestSize.Level0)
+{
+    constexpr int32_t otherStream = STREAM_ID + 1;
+    RKVideoEncoderHandle handle(CreateFakeEncoder);
+    handle.Open(STREAM_ID);
+    handle.Open(otherStream);
+    auto first = handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT);
+    auto second = handle.Acquire(otherStream, NalCodec::H265, WIDTH * 2, HEIGHT);
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    for (uint32_t frame = 0; frame < 4; frame++) {  // 4: a few interleaved frames
+        EXPECT_EQ(first, handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT));
+        EXPECT_EQ(second, handle.Acquire(otherStream, NalCodec::H265, WIDTH * 2, HEIGHT));
+    }
+    EXPECT_EQ(2u, handle.GetStats().created);
+    EXPECT_EQ(0u, handle.GetStats().retired);
+
+    // stopping one stream retires only its own context
+    handle.Close(otherStream);
+    second = nullptr;
+    EXPECT_EQ(1, g_liveEncoders.load());
+    EXPECT_EQ(nullptr, handle.Get(otherStream));
+    EXPECT_EQ(first, handle.Get(STREAM_ID));
+    EXPECT_EQ(first, handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT));
+    EXPECT_EQ(1u, handle.GetStats().retired);
+}
+
+HWTEST_F(UtestRKVideoEncoder, FailedCreateIsNotPublished, TestSize.Level0)
+{
+    RKVideoEncoderHandle handle([](NalCodec codec, uint32_t width, uint32_t height) {
+        return std::unique_ptr<IVideoEncoder>();
+    });
+    handle.Open(STREAM_ID);
+    EXPECT_EQ(nullptr, handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT));
+    EXPECT_EQ(nullptr, handle.Acquire(STREAM_ID, NalCodec::H264, WIDTH, HEIGHT));
+    EXPECT_EQ(2u, handle.GetStats().failed);
+}
+
+/*
+ * Start/Stop cycles racing frames from several delivery threads, with the occasional codec and size
+ * switch. A context used after it was deleted, or encoding on two threads at once, counts as broken.
+ */
+HWTEST_F(UtestRKVideoEncoder, StartStopStress, TestSize.Level0)
+{
+    std::atomic<bool> done {false};
+    std::atomic<uint64_t> encoded {0};
+    {
+        RKVideoEncoderHandle handle(CreateFakeEncoder);
+        std::vector<std::thread> encoders;
+        for (uint32_t i = 0; i < STRESS_ENCODERS; i++) {
+            encoders.emplace_back([&handle, &done, &encoded, i] {
+                uint32_t frame = 0;
+                while (!done) {
+                    frame++;
+                    NalCodec codec = (frame % 64 == 0) ? NalCodec::H265 : NalCodec::H264;    // 64: now and then
+                    uint32_t width = (i == 1 && frame % 128 == 0) ? WIDTH * 2 : WIDTH;     // 128: rarer still
+                    if (EncodeOne(handle, codec, width)) {
+                        encoded++;
+                    }
+                }
+            });
+        }
+
+        for (uint32_t cycle = 0; cycle < STRESS_CYCLES; cycle++) {
+            handle.Open(STREAM_ID);
+            std::this_thread::yield();
+            handle.Close(STREAM_ID);
+        }
+        done = true;
+        for (auto& t : encoders) {
+            t.join();
+        }
+
+        // nothing may survive the last Stop
+        EXPECT_EQ(0, g_liveEncoders.load());
+        VideoEncoderHandleStats stats = handle.GetStats();
+        EXPECT_EQ(stats.created, stats.retired);
+    }
+    EXPECT_EQ(0u, g_brokenEncodes.load());
+    EXPECT_EQ(0, g_liveEncoders.load());
+    EXPECT_GT(encoded.load(), 0u);
+}
+} // namespace OHOS::Camera
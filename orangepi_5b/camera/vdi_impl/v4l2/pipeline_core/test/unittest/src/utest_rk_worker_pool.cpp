@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rk_worker_pool.h"
+
+using namespace testing::ext;
+namespace OHOS::Camera {
+namespace {
+// holds the tasks that wait on it until Open()
+class Gate {
+public:
+    void Wait()
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        waiting_++;
+        cv_.notify_all();
+        cv_.wait(l, [this] { return open_; });
+    }
+    void WaitForWaiters(uint32_t count)
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        cv_.wait(l, [this, count] { return waiting_ >= count; });
+    }
+    void Open()
+    {
+        std::unique_lock<std::mutex> l(lock_);
+        open_ = true;
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex lock_;
+    std::condition_variable cv_;
+    uint32_t waiting_ = 0;
+    bool open_ = false;
+};
+} // namespace
+
+HWTEST(UtestRKWorkerPool, TasksRunOnAllWorkers, TestSize.Level0)
+{
+    constexpr uint32_t workers = 4;
+    RKWorkerPool pool("utest", workers, workers);
+    EXPECT_EQ(workers, pool.GetWorkerCount());
+
+    // every task blocks until all of them are running, which needs one worker each
+    Gate gate;
+    std::vector<std::atomic<uint32_t>> used(workers);
+    for (uint32_t i = 0; i < workers; i++) {
+        pool.Submit(1, [&gate, &used](uint32_t worker) {
+            used[worker]++;
+            gate.Wait();
+        });
+    }
+    gate.WaitForWaiters(workers);
+    gate.Open();
+    pool.Drain(1);
+    for (uint32_t i = 0; i < workers; i++) {
+        EXPECT_EQ(1u, used[i].load());
+    }
+}
+
+HWTEST(UtestRKWorkerPool, FullQueueBlocksSubmit, TestSize.Level0)
+{
+    RKWorkerPool pool("utest", 1, 1);
+    Gate gate;
+    pool.Submit(1, [&gate](uint32_t) { gate.Wait(); });
+    gate.WaitForWaiters(1);
+    pool.Submit(1, [](uint32_t) {});    // takes the only queue slot
+
+    std::atomic<bool> submitted {false};
+    std::thread producer([&pool, &submitted] {
+        pool.Submit(1, [](uint32_t) {});
+        submitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(submitted.load());
+
+    gate.Open();
+    producer.join();
+    EXPECT_TRUE(submitted.load());
+    pool.Drain(1);
+
+    WorkerPoolStats stats = pool.GetStats();
+    EXPECT_EQ(3u, stats.submitted);
+    EXPECT_EQ(3u, stats.completed);
+    EXPECT_EQ(1u, stats.blocked);
+    EXPECT_EQ(1u, stats.maxDepth);
+    EXPECT_EQ(0u, stats.depth);
+    EXPECT_GE(stats.maxLatencyUs, 50000u);
+}
+
+HWTEST(UtestRKWorkerPool, DrainWaitsForItsKeyOnly, TestSize.Level0)
+{
+    RKWorkerPool pool("utest", 2, 4);
+    Gate gate;
+    std::atomic<uint32_t> done {0};
+    pool.Submit(2, [&gate](uint32_t) { gate.Wait(); });
+    for (uint32_t i = 0; i < 3; i++) {
+        pool.Submit(1, [&done](uint32_t) { done++; });
+    }
+    pool.Drain(1);
+    EXPECT_EQ(3u, done.load());
+
+    gate.Open();
+    pool.Drain(2);
+    EXPECT_EQ(4u, pool.GetStats().completed);
+}
+
+HWTEST(UtestRKWorkerPool, DestructorRunsQueuedTasks, TestSize.Level0)
+{
+    std::atomic<uint32_t> done {0};
+    {
+        RKWorkerPool pool("utest", 1, 8);
+        for (uint32_t i = 0; i < 8; i++) {
+            pool.Submit(1, [&done](uint32_t) { done++; });
+        }
+    }
+    EXPECT_EQ(8u, done.load());
+}
+} // namespace OHOS::Camera